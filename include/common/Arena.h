@@ -0,0 +1,37 @@
+#pragma once
+/**
+ * Arena.h
+ *   region allocator
+ *
+ *   The memory is carved out of large blocks, and all of it is
+ *   released at once by delete_Arena. There is no free for each object.
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _Arena Arena;
+typedef struct _Arena_private Arena_private;
+struct _Arena {
+	void* (*Alloc)(Arena*, const size_t);
+	void* (*Calloc)(Arena*, const size_t);
+	/* instrumentation */
+	size_t (*allocs_get)(Arena*);	/* Alloc / Calloc calls */
+	size_t (*blocks_get)(Arena*);	/* heap allocations */
+	size_t (*bytes_get)(Arena*);	/* bytes handed out */
+	/* private members */
+	Arena_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Arena(const size_t blockSize)
+ *     blockSize - heap block size(0: default)
+ */
+Arena* new_Arena(const size_t);
+
+/**
+ * Destractor
+ *   All memory allocated from the arena is released.
+ */
+void delete_Arena(Arena**);
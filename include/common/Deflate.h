@@ -0,0 +1,48 @@
+#pragma once
+/**
+ * Deflate.h
+ *   raw deflate(RFC1951) stream encoder
+ *
+ *   If HAVE_ZLIB is defined, zlib does the work.
+ *   Otherwise the built-in encoder (LZ77 + fixed huffman codes) is used.
+ */
+
+/**
+ * output callback
+ *   args: (void* param, const uint8* data, const size_t len)
+ *   return:
+ *     If failed, return false.
+ */
+typedef bool (*DeflateOutput_t)(void*, const uint8*, const size_t);
+
+/**
+ * public accessor
+ */
+typedef struct _Deflate Deflate;
+typedef struct _Deflate_private Deflate_private;
+struct _Deflate {
+	bool (*Put)(Deflate*, const uint8*, const size_t);
+	bool (*Finish)(Deflate*);
+	/* private members */
+	Deflate_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Deflate(DeflateOutput_t out, void* param)
+ *     out   - compressed data writer
+ *     param - the first argument of out
+ */
+Deflate* new_Deflate(DeflateOutput_t, void*);
+
+/**
+ * Destractor
+ */
+void delete_Deflate(Deflate**);
+
+/**
+ * CRC-32 (used by gzip)
+ *   args: Deflate_Crc32(uint32 crc, const uint8* data, const size_t len)
+ *     crc - 0 or the result of the previous call
+ */
+uint32 Deflate_Crc32(uint32, const uint8*, const size_t);
@@ -3,6 +3,8 @@
  * Iterator.h
  */
 
+#include "common/Arena.h"
+
 /**
  * public accessor
  */
@@ -17,13 +19,40 @@ struct _Iterator {
 	Iterator_protected* pro;
 };
 
+/**
+ * Iterator links
+ *   It's public for the inline traversal macros.
+ *   Don't modify it except in Iterator / List.
+ */
+struct _Iterator_protected {
+	Iterator* prev;
+	Iterator* next;
+	void* data;
+	/* owner list(NULL: stand-alone) */
+	struct _List* owner;
+	Arena* arena;
+};
+
+/**
+ * inline accessors
+ *   They're same as the methods, without the indirect call.
+ */
+#define Iterator_Prev(it)	((it)->pro->prev)
+#define Iterator_Next(it)	((it)->pro->next)
+#define Iterator_Data(it)	((it)->pro->data)
+
 /**
  * Constructor
  */
 Iterator* new_Iterator(void*);
 
+/**
+ * Constructor(allocate from the arena)
+ *   The iterators inserted by it are also allocated from the arena.
+ */
+Iterator* new_IteratorEx(void*, Arena*);
+
 /**
  * Destractor
  */
 void delete_Iterator(Iterator**);
-
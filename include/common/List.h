@@ -32,11 +32,23 @@ struct _List {
 	List_protected* pro;
 };
 
+/**
+ * traversal from top to tail
+ *   List_Foreach(List* list, Iterator* it) { ... }
+ */
+#define List_Foreach(list, it)	for((it) = (list)->begin(list); NULL != (it); (it) = Iterator_Next(it))
+
 /**
  * Constructor
  */
 List* new_List(ListDataCloner_t, ListDataDeleter_t);
 
+/**
+ * Constructor(the nodes are allocated from the arena)
+ *   The deleter can be NULL when the data is owned by the arena.
+ */
+List* new_ListEx(ListDataCloner_t, ListDataDeleter_t, Arena*);
+
 /**
  * Destractor
  */
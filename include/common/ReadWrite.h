@@ -7,7 +7,9 @@
 
 uint16 read16(const uint8*);
 uint32 read24(const uint8*);
+uint32 read32(const uint8*);
 
 void write16(uint8*, const uint16);
 void write24(uint8*, const uint32);
+void write32(uint8*, const uint32);
 
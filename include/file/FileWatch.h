@@ -0,0 +1,46 @@
+#pragma once
+/**
+ * FileWatch.h
+ *   file change watcher
+ *
+ *   The directory of the file is watched(inotify on Linux), so the file
+ *   replaced by rename is also noticed. The changes are debounced, Wait
+ *   returns after the file isn't written for the quiet time.
+ *   On the other platforms, the modification time is polled.
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _FileWatch FileWatch;
+typedef struct _FileWatch_private FileWatch_private;
+struct _FileWatch {
+	/**
+	 * Wait for the change of the file
+	 *   args: Wait(FileWatch* self, const int quietMs)
+	 *     quietMs - debounce time(msec)
+	 *   return:
+	 *     If it's stopped(or it can't watch the file), return false.
+	 */
+	bool (*Wait)(FileWatch*, const int);
+
+	/**
+	 * Stop waiting
+	 *   It can be called from the signal handler.
+	 */
+	void (*Stop)(FileWatch*);
+
+	/* private members */
+	FileWatch_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_FileWatch(const char* path)
+ */
+FileWatch* new_FileWatch(const char*);
+
+/**
+ * Destractor
+ */
+void delete_FileWatch(FileWatch**);
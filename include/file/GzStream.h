@@ -0,0 +1,33 @@
+#pragma once
+/**
+ * GzStream.h
+ *   gzip(RFC1952) stream writer
+ *
+ *   The written data is compressed by the background thread,
+ *   while the caller fills the next buffer.
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _GzStream GzStream;
+typedef struct _GzStream_private GzStream_private;
+struct _GzStream {
+	bool (*Write)(GzStream*, const void*, const size_t);
+	bool (*Close)(GzStream*);
+	/* private members */
+	GzStream_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_GzStream(FILE* fp)
+ *     fp - binary output stream(it isn't owned by the object)
+ */
+GzStream* new_GzStream(FILE*);
+
+/**
+ * Destractor
+ *   If the stream isn't closed, it's closed.
+ */
+void delete_GzStream(GzStream**);
@@ -0,0 +1,52 @@
+#pragma once
+/**
+ * RomView.h
+ *   frozen rom view
+ *
+ *   It's the read-only snapshot of the opened RomFile. The address
+ *   conversion is done with the const tables built at the construction,
+ *   and the SA-1 slot configuration belongs to each view, so the worker
+ *   threads can share one view (or make their own views of one RomFile)
+ *   without any lock.
+ *
+ *   The view refers to the rom buffer of the RomFile. Don't close, reload
+ *   or write the RomFile while the view is alive.
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _RomView RomView;
+typedef struct _RomView_private RomView_private;
+struct _RomView {
+	const char* (*path_get)(const RomView*);
+	uint32 (*size_get)(const RomView*);
+	RomType (*type_get)(const RomView*);
+	MapMode (*mapmode_get)(const RomView*);
+	const uint8* (*GetSnesPtr)(const RomView*, const uint32);
+	const uint8* (*GetPcPtr)(const RomView*, const uint32);
+	uint32 (*Pc2SnesAdr)(const RomView*, const uint32);
+	uint32 (*Snes2PcAdr)(const RomView*, const uint32);
+	/* private members */
+	const RomView_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_RomView(RomFile* rom)
+ *     rom - opened RomFile. The SA-1 slots are copied from it.
+ */
+RomView* new_RomView(RomFile*);
+
+/**
+ * Constructor with the SA-1 map
+ *   args: new_RomViewSA1(RomFile* rom, const bool useHiRomMap)
+ *     useHiRomMap - the pc address is converted to the HiRom map($c0-$ff)
+ *                   in this view. (Same as RomFile's UseHiRomMapSA1)
+ */
+RomView* new_RomViewSA1(RomFile*, const bool);
+
+/**
+ * Destractor
+ */
+void delete_RomView(RomView**);
@@ -17,10 +17,20 @@ struct _TextFile {
 	uint (*row_get)(TextFile*);
 	const char* (*GetLine)(TextFile*);
 	void (*Printf)(TextFile*, const char*, ...);
+	bool (*Write)(TextFile*, const void*, const size_t);
+	bool (*Close)(TextFile*);
+	void (*compress_set)(TextFile*, const bool);
 	/* protected members */
 	TextFile_protected* pro;
 };
 
+/**
+ * Compressed output
+ *   The file opened for writing is gzip compressed when
+ *   compress_set(true) is called or its extension is ".gz".
+ *   Close it by TextFile::Close to complete the stream.
+ */
+
 /**
  * Constructor
  */
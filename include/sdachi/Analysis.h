@@ -0,0 +1,74 @@
+#pragma once
+/**
+ * Analysis.h
+ *   in-memory disassembly result
+ *
+ *   It's made by DisAsmContext's Analyze method, and keeps the sorted
+ *   instruction store. Nothing is changed by the queries, so one result
+ *   can be queried from the threads in parallel.
+ */
+
+/**
+ * range query visitor
+ *   args: visitor(void* param, const Instruction* ins)
+ *   return:
+ *     false to stop the query
+ */
+typedef bool (*AnalysisVisitor_t)(void*, const Instruction*);
+
+/**
+ * public accessor
+ */
+typedef struct _Analysis Analysis;
+typedef struct _Analysis_private Analysis_private;
+struct _Analysis {
+	/**
+	 * number of instructions
+	 */
+	uint32 (*count_get)(Analysis*);
+
+	/**
+	 * analyzed rom
+	 */
+	const RomView* (*view_get)(Analysis*);
+
+	/**
+	 * Decode the instruction at the pc address
+	 *   args: Decode(Analysis* self, const uint32 pcadr, Instruction* ins)
+	 *   return:
+	 *     If no instruction starts at the address, return false.
+	 */
+	bool (*Decode)(Analysis*, const uint32, Instruction*);
+
+	/**
+	 * Visit the instructions in the pc address range
+	 *   args: QueryRange(Analysis* self, const uint32 start, const uint32 end,
+	 *                    AnalysisVisitor_t visitor, void* param)
+	 *     start, end - pc address range [start, end)
+	 *   The instructions that overlap the range are visited in address
+	 *   order. The Instruction is on the stack, nothing is allocated.
+	 *   return:
+	 *     number of visited instructions
+	 */
+	uint32 (*QueryRange)(Analysis*, const uint32, const uint32, AnalysisVisitor_t, void*);
+
+	/**
+	 * Visit the instructions that refer to the snes address
+	 *   args: QueryXref(Analysis* self, const uint32 target,
+	 *                   AnalysisVisitor_t visitor, void* param)
+	 *   The branches, jumps and calls with the static destination are
+	 *   indexed. They're visited in address order.
+	 *   return:
+	 *     number of visited instructions
+	 */
+	uint32 (*QueryXref)(Analysis*, const uint32, AnalysisVisitor_t, void*);
+
+	/* private members */
+	Analysis_private* pri;
+};
+
+/**
+ * Destractor
+ *   The rom view isn't deleted.
+ */
+void delete_Analysis(Analysis**);
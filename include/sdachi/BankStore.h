@@ -0,0 +1,118 @@
+#pragma once
+/**
+ * BankStore.h
+ *   shared store of the bank-local traces
+ *
+ *   With the store, pass1 traces each snes bank separately. A trace is
+ *   started at the entry into the bank, and it follows the code only in
+ *   the bank. The transfers to the other banks are kept as the exits, and
+ *   they're traced as the entries of those banks.
+ *
+ *   A trace depends only on the bank data and the entry state, so it's
+ *   keyed by the hash of them, and reused for the same bank of the other
+ *   roms(the revisions / the hacks of the same game). The traces are kept
+ *   in memory for the contexts sharing the store(a batch run), and in the
+ *   files named by the key in the store directory(across the runs).
+ *
+ *   file :
+ *     "SDBK", version(4)
+ *     counts of the records, the groups and the exits(4 each)
+ *     records : snes address(3), psw(1), flags(1)
+ *     groups  : call from(4), depth(4)
+ *     exits   : snes address(4), call from(4), psw(2), depth(4)
+ */
+
+/**
+ * call from of the head group, it's replaced with the one of the entry
+ */
+#define BankTrace_Entry		0xffffffff
+
+typedef struct _BankTraceRec {
+	uint32		snesadr;
+	uint8		psw;
+	uint8		flags;		/* InsnRec_GroupHead */
+} BankTraceRec;
+
+typedef struct _BankTraceGroup {
+	uint32		callFrom;
+	int		depth;
+} BankTraceGroup;
+
+typedef struct _BankTraceExit {
+	uint32		snesadr;
+	uint32		callFrom;
+	uint16		psw;
+	int		depth;
+} BankTraceExit;
+
+/**
+ * bank-local trace(in the trace order)
+ */
+typedef struct _BankTrace {
+	BankTraceRec*	recs;
+	uint32		recCount;
+	BankTraceGroup*	groups;
+	uint32		groupCount;
+	BankTraceExit*	exits;
+	uint32		exitCount;
+} BankTrace;
+
+/**
+ * Make the empty trace with the sizes
+ */
+BankTrace* new_BankTrace(const uint32 recs, const uint32 groups, const uint32 exits);
+
+void delete_BankTrace(BankTrace**);
+
+/**
+ * public accessor
+ *   It can be shared by the threads.
+ */
+typedef struct _BankStore BankStore;
+typedef struct _BankStore_private BankStore_private;
+struct _BankStore {
+	/**
+	 * Find the trace
+	 *   args: Find(BankStore* self, const uint64 key)
+	 *   return:
+	 *     the trace(owned by the store), or NULL
+	 */
+	const BankTrace* (*Find)(BankStore*, const uint64);
+
+	/**
+	 * Add the trace(the store takes it)
+	 *   args: Add(BankStore* self, const uint64 key, BankTrace* trace)
+	 *   return:
+	 *     the stored trace(the other one if it's already added)
+	 */
+	const BankTrace* (*Add)(BankStore*, const uint64, BankTrace*);
+
+	/**
+	 * Number of the found / missed traces
+	 */
+	ulong (*hits_get)(BankStore*);
+	ulong (*misses_get)(BankStore*);
+
+	/* private members */
+	BankStore_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_BankStore(const char* dir)
+ *     dir - store directory, or NULL(in memory only)
+ */
+BankStore* new_BankStore(const char*);
+
+/**
+ * Destractor
+ */
+void delete_BankStore(BankStore**);
+
+/**
+ * 64bit FNV-1a
+ *   args: BankStore_Hash(uint64 hash, const void* data, const size_t len)
+ *     hash - the last hash, or BankStore_HashInit
+ */
+#define BankStore_HashInit	(((uint64)0xcbf29ce4 << 32) | 0x84222325)
+uint64 BankStore_Hash(uint64, const void*, const size_t);
@@ -0,0 +1,86 @@
+#pragma once
+/**
+ * Batch.h
+ *   batch disassembly from the manifest
+ *
+ *   The manifest is a JSON array of the flat job objects :
+ *     [
+ *       {"rom":"a.sfc", "output":"a.asm", "entry":"$808000:a,$809000"},
+ *       {"rom":"a.sfc", "output":"a-data.asm", "pc":"$80c000", "count":64},
+ *       {"rom":"b.sfc", "json":"b.jsonl", "full":true}
+ *     ]
+ *   members :
+ *     rom(required), output, json, csv, bin, export, cfg, trace, cdl, fingerprints, entry, label(string)
+ *     pc(address), depth, count, split, exec(number), a, x, upper, full, gzip, dataflow(bool)
+ *   The members which aren't given are taken from the command-line options.
+ *
+ *   The jobs are grouped by the rom. Each rom is loaded once, its view is
+ *   shared by the jobs on the worker threads, and it's released after its
+ *   last job.
+ */
+
+/**
+ * result of the job
+ */
+typedef struct _BatchResult {
+	const char*	rom;
+	const char*	output;		/* the assembly output */
+	bool		ok;
+	ulong		msec;		/* run time */
+	const char*	message;	/* the first error(or warning), or NULL */
+} BatchResult;
+
+/**
+ * public accessor
+ */
+struct _BankStore;	/* BankStore.h */
+typedef struct _Batch Batch;
+typedef struct _Batch_private Batch_private;
+struct _Batch {
+	/**
+	 * Load the manifest(the jobs are appended)
+	 *   args: Load(Batch* self, const char* path)
+	 */
+	bool (*Load)(Batch*, const char*);
+
+	/**
+	 * Use the shared store of the bank-local traces(BankStore.h)
+	 *   args: UseBankStore(Batch* self, BankStore* banks)
+	 *   The store isn't owned by the batch.
+	 */
+	void (*UseBankStore)(Batch*, struct _BankStore*);
+
+	/**
+	 * Run all jobs
+	 *   return:
+	 *     If any job failed, return false.
+	 */
+	bool (*Run)(Batch*);
+
+	/**
+	 * results accessors(in the manifest order)
+	 */
+	uint32 (*count_get)(Batch*);
+	const BatchResult* (*Result)(Batch*, const uint32);
+
+	/**
+	 * Write the status and the time of each job
+	 */
+	void (*PrintSummary)(Batch*);
+
+	/* private members */
+	Batch_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Batch(const DisAsmInf* inf, const int threads)
+ *     inf     - default options of the jobs(copied)
+ *     threads - worker threads
+ */
+Batch* new_Batch(const DisAsmInf*, const int);
+
+/**
+ * Destractor
+ */
+void delete_Batch(Batch**);
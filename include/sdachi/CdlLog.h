@@ -0,0 +1,93 @@
+#pragma once
+/**
+ * CdlLog.h
+ *   code / data log of the emulators
+ *
+ *   The log is a flag byte per rom byte, in the order of the pc address.
+ *   The flags are the ones of Mesen :
+ *     0x01 : code          0x02 : data
+ *     0x04 : jump target   0x08 : subroutine entry
+ *     0x10 : X is 8 bits   0x20 : M is 8 bits(set with the code)
+ *   The file is the flags as they are, or with the header("CDLv2" and
+ *   the crc32 of the rom). Its size must be the size of the rom.
+ *
+ *   The flags are scanned by 8 bytes in a word, and the runs of the code
+ *   / the data are made into the regions. A code region starts at the
+ *   byte after the other bytes, or at the jump target / the subroutine
+ *   entry, so the head of it is the head of the instruction.
+ */
+
+/**
+ * flags of the rom byte
+ */
+#define CdlLog_Code		0x01
+#define CdlLog_Data		0x02
+#define CdlLog_JumpTarget	0x04
+#define CdlLog_SubEntry		0x08
+#define CdlLog_X8		0x10
+#define CdlLog_M8		0x20
+
+/* the byte which is logged only as the data */
+#define CdlLog_IsData(flags)	(CdlLog_Data == ((flags) & (CdlLog_Code | CdlLog_Data)))
+
+/**
+ * run of the code or the data
+ */
+typedef struct _CdlRegion {
+	uint32		pcadr;
+	uint32		size;
+	uint8		flags;		/* CdlLog_Code(with M8 / X8 of the head), or CdlLog_Data */
+} CdlRegion;
+
+/**
+ * public accessor
+ */
+typedef struct _CdlLog CdlLog;
+typedef struct _CdlLog_private CdlLog_private;
+struct _CdlLog {
+	/**
+	 * Load the log(the loaded one is replaced)
+	 *   args: Load(CdlLog* self, const char* path)
+	 *   return:
+	 *     If the file can't be read, or the size isn't the rom's one, return false.
+	 */
+	bool (*Load)(CdlLog*, const char*);
+
+	/**
+	 * Flags of the rom byte(0 out of the rom)
+	 *   args: Flags(CdlLog* self, const uint32 pcadr)
+	 */
+	uint8 (*Flags)(CdlLog*, const uint32);
+
+	/**
+	 * regions in the order of the address
+	 */
+	uint32 (*regionCount_get)(CdlLog*);
+	const CdlRegion* (*Region)(CdlLog*, const uint32);
+
+	/**
+	 * Hash of the flags
+	 */
+	uint32 (*Hash)(CdlLog*);
+
+	/**
+	 * statistics
+	 */
+	uint32 (*codeBytes_get)(CdlLog*);
+	uint32 (*dataBytes_get)(CdlLog*);	/* the bytes logged only as the data */
+	size_t (*bytes_get)(CdlLog*);		/* heap memory in use */
+
+	/* private members */
+	CdlLog_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_CdlLog(const RomView* from)
+ */
+CdlLog* new_CdlLog(const RomView*);
+
+/**
+ * Destractor
+ */
+void delete_CdlLog(CdlLog**);
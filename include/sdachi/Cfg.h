@@ -0,0 +1,102 @@
+#pragma once
+/**
+ * Cfg.h
+ *   control-flow graph of the pass1 result
+ *
+ *   The instructions of the sorted store are split into the basic blocks.
+ *   A block starts at the group head, the destination of a branch / jump /
+ *   call, the instruction after a branch / jump / return, or the gap of
+ *   the code. (The calls don't end the block.)
+ *   The blocks are kept in one array in the address order, and the
+ *   successors / predecessors are kept in the CSR arrays. The memory is
+ *   linear in the number of the instructions.
+ *
+ *   The routine heads are the destinations of the calls, and the group
+ *   heads which aren't the destinations of the branches / jumps(the entry
+ *   points). Each of the other blocks belongs to the first routine(in the
+ *   address order) which reaches it by the successors.
+ */
+
+#define Cfg_NotFound		0xffffffff
+
+/**
+ * block flags
+ */
+#define CfgBlock_RoutineHead	0x01
+#define CfgBlock_Return		0x02	/* ends with rts / rtl / rti */
+#define CfgBlock_Indirect	0x04	/* ends with the indirect jump */
+
+typedef struct _CfgBlock {
+	uint32		first;		/* record index of the store */
+	uint32		count;		/* number of the records */
+	uint32		snesadr;
+	uint32		endSnes;	/* after the last instruction */
+	uint32		routine;
+	uint32		flags;
+} CfgBlock;
+
+/**
+ * public accessor
+ */
+typedef struct _Cfg Cfg;
+typedef struct _Cfg_private Cfg_private;
+struct _Cfg {
+	/**
+	 * blocks accessors(in the address order)
+	 */
+	uint32 (*blockCount_get)(Cfg*);
+	const CfgBlock* (*Block)(Cfg*, const uint32);
+
+	/**
+	 * Get the block of the instruction
+	 *   args: BlockOf(Cfg* self, const uint32 pcadr)
+	 *   return:
+	 *     block index, or Cfg_NotFound
+	 */
+	uint32 (*BlockOf)(Cfg*, const uint32);
+
+	/**
+	 * Get the edges of the block
+	 *   args: Successors(Cfg* self, const uint32 block, const uint32** list)
+	 *   return:
+	 *     number of the blocks in the list(the list is owned by the graph)
+	 */
+	uint32 (*Successors)(Cfg*, const uint32, const uint32**);
+	uint32 (*Predecessors)(Cfg*, const uint32, const uint32**);
+
+	/**
+	 * routines accessors
+	 *   args: RoutineBlocks(Cfg* self, const uint32 routine, const uint32** list)
+	 *   return:
+	 *     number of the blocks of the routine(the head is the first)
+	 */
+	uint32 (*routineCount_get)(Cfg*);
+	uint32 (*RoutineBlocks)(Cfg*, const uint32, const uint32**);
+
+	/**
+	 * Write the routines
+	 *   WriteJson : JSON Lines, one object per routine
+	 *     {"routine":"$008000","blocks":[{"id":0,"start":"$008000","end":"$008005",
+	 *      "insns":3,"succ":[1,2],"pred":[],"calls":["$008010"]}, ...]}
+	 *   WriteDot  : graphviz, one cluster per routine
+	 */
+	bool (*WriteJson)(Cfg*, TextFile*);
+	bool (*WriteDot)(Cfg*, TextFile*);
+
+	size_t (*bytes_get)(Cfg*);	/* heap memory in use */
+
+	/* private members */
+	Cfg_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Cfg(const RomView* from, InsnStore* store)
+ *     store - the sorted store(it must live while the graph is used)
+ */
+Cfg* new_Cfg(const RomView*, InsnStore*);
+
+/**
+ * Destractor
+ */
+void delete_Cfg(Cfg**);
@@ -0,0 +1,114 @@
+#pragma once
+/**
+ * Cpu.h
+ *   65816 interpreter for the code discovery
+ *
+ *   The rom is run from the reset vector(in the emulation mode) and each
+ *   executed instruction is logged with its M / X flags, so the code which
+ *   is reached only by the computed jumps is found as the proven code.
+ *     - the rom is read through the page table of the rom view
+ *     - WRAM is emulated, SRAM and the expansion area read as open bus
+ *     - the registers are stubbed : the APU ports echo the writes(after
+ *       $aa / $bb of the IPL), the multiplier / divider work, and the
+ *       other reads return $00 / $ff by turns(the wait loops exit).
+ *       DMA isn't run.
+ *     - NMI is raised at each frame while it's enabled by $4200, and the
+ *       wai waits for the next frame
+ *   If the cpu stops(stp / brk / the code out of the rom and WRAM) before
+ *   NMI, it's restarted from the NMI vector. brk is taken as the run into
+ *   the data(the zero-filled area), and isn't logged.
+ */
+
+/**
+ * executed instruction(in the order of the first execution)
+ */
+#define CpuLog_Head	0x01	/* reached by the branch / jump / return */
+#define CpuLog_Call	0x02	/* reached by the call / interrupt */
+
+typedef struct _CpuLog {
+	uint32		snesadr;
+	uint32		callFrom;	/* the instruction executed before */
+	int		depth;		/* call depth */
+	uint8		psw;		/* M / X at the first execution */
+	uint8		flags;
+} CpuLog;
+
+/**
+ * registers
+ */
+typedef struct _CpuRegs {
+	uint16		a;
+	uint16		x;
+	uint16		y;
+	uint16		s;
+	uint16		d;
+	uint32		pc;		/* with the program bank */
+	uint8		db;
+	uint8		p;
+	bool		e;
+} CpuRegs;
+
+/**
+ * public accessor
+ */
+typedef struct _Cpu Cpu;
+typedef struct _Cpu_private Cpu_private;
+struct _Cpu {
+	/**
+	 * Reset the registers(the pc is the reset vector)
+	 */
+	void (*Reset)(Cpu*);
+
+	/**
+	 * Run the instructions
+	 *   args: Run(Cpu* self, const uint32 steps)
+	 *   return:
+	 *     the number of the executed instructions
+	 *     (It's less than the steps if the cpu is stopped.)
+	 */
+	uint32 (*Run)(Cpu*, const uint32);
+
+	/**
+	 * Get the address where the cpu is stopped
+	 *   return:
+	 *     If the cpu is running, return false.
+	 */
+	bool (*Stopped)(Cpu*, uint32*);
+
+	void (*Registers)(Cpu*, CpuRegs*);
+
+	/**
+	 * executed instructions
+	 */
+	uint32 (*logCount_get)(Cpu*);
+	const CpuLog* (*Log)(Cpu*, const uint32);
+
+	/**
+	 * Add the executed instructions to the store
+	 *   return:
+	 *     number of the instructions added
+	 */
+	uint32 (*Emit)(Cpu*, InsnStore*);
+
+	/**
+	 * statistics
+	 */
+	uint32 (*steps_get)(Cpu*);		/* executed instructions */
+	uint32 (*conflicts_get)(Cpu*);		/* instructions executed with the other M / X */
+	size_t (*bytes_get)(Cpu*);		/* heap memory in use */
+
+	/* private members */
+	Cpu_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Cpu(const RomView* from)
+ *   The registers are reset.
+ */
+Cpu* new_Cpu(const RomView*);
+
+/**
+ * Destractor
+ */
+void delete_Cpu(Cpu**);
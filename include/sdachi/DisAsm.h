@@ -12,8 +12,147 @@ typedef struct _DisAsmInf {
 	char* dataLabel;
 	int   depthMax;
 	const char* outputPath;
+	const char* jsonPath;
+	const char* csvPath;
+	const char* binPath;
+	const char* exportBinPath;
+	const char* cfgPath;
+	const char* dbPath;
 	bool  enableUpper;
+	bool  fullListing;
+	bool  compressOutput;
+	bool  showStats;
+	bool  dataflow;
+	int   execSteps;
+	const char* tracePath;
+	const char* cdlPath;
+	const char* fingerprintPath;
+	const char* namesPath;
 } DisAsmInf;
 
-bool DisAsm(RomFile* from, TextFile* fasm, DisAsmInf* inf);
+/**
+ * diagnostic message
+ */
+typedef enum {
+	DisAsmDiag_Info,
+	DisAsmDiag_Warn,
+	DisAsmDiag_Error
+} DisAsmDiagLevel;
+
+typedef struct _DisAsmDiag {
+	DisAsmDiagLevel	level;
+	char*		message;
+} DisAsmDiag;
+
+/**
+ * Disassembly context
+ *   It owns all the state of one analysis (the options, the work memory,
+ *   the diagnostics and the output sinks). Nothing is shared between the
+ *   contexts, so each of them can run on its own thread.
+ */
+struct _BankStore;	/* BankStore.h */
+typedef struct _DisAsmContext DisAsmContext;
+typedef struct _DisAsmContext_private DisAsmContext_private;
+struct _DisAsmContext {
+	/**
+	 * Add output sink
+	 *   The sink is owned by the context.
+	 */
+	void (*AddSink)(DisAsmContext*, Sink*);
+
+	/**
+	 * Add entry point
+	 *   args: AddEntry(DisAsmContext* self, const uint32 snesadr, const uint16 psw)
+	 *   It's analyzed after the main entry(the reset vector or -p address).
+	 */
+	void (*AddEntry)(DisAsmContext*, const uint32, const uint16);
+
+	/**
+	 * Use the shared store of the bank-local traces(BankStore.h)
+	 *   args: UseBankStore(DisAsmContext* self, BankStore* banks)
+	 *   The store isn't owned by the context. With the store, each bank is
+	 *   traced separately, and the traces of the same banks are reused.
+	 */
+	void (*UseBankStore)(DisAsmContext*, struct _BankStore*);
+
+	/**
+	 * Analyze the rom, and write it to the sinks
+	 */
+	bool (*Run)(DisAsmContext*, RomFile*);
+
+	/**
+	 * Analyze the frozen rom view
+	 *   The view isn't changed, so one view can be shared by the contexts
+	 *   on the other threads.
+	 */
+	bool (*RunView)(DisAsmContext*, const RomView*);
+
+	/**
+	 * Analyze the rom, and keep the result in memory
+	 *   The sinks aren't used. The view must live while the result is used.
+	 *   return:
+	 *     the result(delete it with delete_Analysis), or NULL on the error.
+	 *     If pass1 stops on the way, the analyzed part is returned and
+	 *     the error is left in the diagnostics.
+	 */
+	Analysis* (*Analyze)(DisAsmContext*, const RomView*);
+
+	/**
+	 * Add diagnostic message
+	 *   args: Report(DisAsmContext* self, const DisAsmDiagLevel level, const char* fmt, ...)
+	 */
+	void (*Report)(DisAsmContext*, const DisAsmDiagLevel, const char*, ...);
+
+	/**
+	 * diagnostics accessors
+	 */
+	uint32 (*diagCount_get)(DisAsmContext*);
+	const DisAsmDiag* (*Diag)(DisAsmContext*, const uint32);
+
+	/**
+	 * Write the diagnostics to stdout / stderr, and clear them
+	 */
+	void (*PrintDiags)(DisAsmContext*);
+
+	/* private members */
+	DisAsmContext_private* pri;
+};
 
+/**
+ * Constructor
+ *   args: new_DisAsmContext(const DisAsmInf* inf)
+ *     inf - options(copied. The output paths aren't used.)
+ */
+DisAsmContext* new_DisAsmContext(const DisAsmInf*);
+
+/**
+ * Destractor
+ *   The sinks are deleted with the context.
+ */
+void delete_DisAsmContext(DisAsmContext**);
+
+/**
+ * Set the default options
+ *   args: DisAsm_InitInf(DisAsmInf* inf)
+ *   The reset vector is analyzed with 8bit registers(recursive depth 3,
+ *   16 data splits), and no outputs are written. Set the other options
+ *   after this.
+ */
+void DisAsm_InitInf(DisAsmInf*);
+
+/**
+ * Get the name of the rom mapping
+ *   return:
+ *     "LoRom", "HiRom", "SA-1", "SPC7110", "ExLoRom", "ExHiRom" or "Unknown"
+ */
+const char* DisAsm_MapModeString(const RomView*);
+
+/**
+ * Parse the entry point
+ *   args: DisAsm_ParseEntry(const char* arg, const DisAsmInf* inf, uint32* snesadr, uint16* psw)
+ *     arg - "0x808000", "$808000" or "32768", and ":a" / ":x" / ":ax"
+ *           suffix for 16bit registers(the default is -a / -x option)
+ *   return:
+ *     If the text is invalid, return false.
+ */
+bool DisAsm_ParseEntry(const char*, const DisAsmInf*, uint32*, uint16*);
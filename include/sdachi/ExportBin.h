@@ -0,0 +1,100 @@
+#pragma once
+/**
+ * ExportBin.h
+ *   columnar binary export of analysis results
+ *
+ *   The file is a header followed by fixed width column arrays.
+ *   All values are little-endian, and every column starts on
+ *   an 8 bytes boundary.
+ *
+ *   header (ExportBin_HeaderSize bytes) :
+ *      0 : magic "SDACHICB"
+ *      8 : version(16), header size(16)
+ *     12 : instruction count(32), group count(32), map mode(32)
+ *     24 : column offsets(32) * ExportBin_ColumnMax
+ *
+ *   columns :
+ *     Snes      uint32[insn]  instruction start address(SNES)
+ *     Pc        uint32[insn]  instruction start address(PC)
+ *     Op        uint8 [insn]  opcode
+ *     Arg       uint8 [insn*3] operand bytes(zero padded)
+ *     Len       uint8 [insn]  operand length
+ *     Psw       uint8 [insn]  register status(M:0x20, X:0x10)
+ *     Target    uint32[insn]  instruction index of static destination
+ *                             (ExportBin_NoTarget if none)
+ *     Group     uint32[group] instruction index of group head
+ *     GroupFrom uint32[group] call from address(SNES)
+ *     GroupDepth uint16[group] call depth
+ *     GroupPsw  uint8 [group] register status at the group head
+ */
+
+#define ExportBin_Magic		"SDACHICB"
+#define ExportBin_Version	1
+#define ExportBin_NoTarget	0xffffffff
+
+typedef enum ExportBinColumn {
+	ExportBin_Snes = 0,
+	ExportBin_Pc,
+	ExportBin_Op,
+	ExportBin_Arg,
+	ExportBin_Len,
+	ExportBin_Psw,
+	ExportBin_Target,
+	ExportBin_Group,
+	ExportBin_GroupFrom,
+	ExportBin_GroupDepth,
+	ExportBin_GroupPsw,
+	/*================*/
+	ExportBin_ColumnMax
+} ExportBinColumn;
+
+#define ExportBin_HeaderSize	(24 + 4*ExportBin_ColumnMax)
+
+/**
+ * mapped file view
+ */
+typedef struct _ExportBin {
+	const uint8*	base;
+	size_t		size;
+	uint32		insnCount;
+	uint32		groupCount;
+	uint32		mapMode;
+	const uint8*	col[ExportBin_ColumnMax];
+	/* platform handle */
+	void*		handle;
+} ExportBin;
+
+/**
+ * O(1) accessors
+ */
+#define ExportBin_Read16(p) \
+	((uint16)((p)[0] | ((uint16)(p)[1] << 8)))
+#define ExportBin_Read32(p) \
+	((uint32)((p)[0] | ((uint32)(p)[1] << 8) | ((uint32)(p)[2] << 16) | ((uint32)(p)[3] << 24)))
+
+#define ExportBin_SnesAt(v, i)		ExportBin_Read32(&(v)->col[ExportBin_Snes][4*(i)])
+#define ExportBin_PcAt(v, i)		ExportBin_Read32(&(v)->col[ExportBin_Pc][4*(i)])
+#define ExportBin_OpAt(v, i)		((v)->col[ExportBin_Op][(i)])
+#define ExportBin_ArgAt(v, i)		(&(v)->col[ExportBin_Arg][3*(i)])
+#define ExportBin_LenAt(v, i)		((v)->col[ExportBin_Len][(i)])
+#define ExportBin_PswAt(v, i)		((v)->col[ExportBin_Psw][(i)])
+#define ExportBin_TargetAt(v, i)	ExportBin_Read32(&(v)->col[ExportBin_Target][4*(i)])
+#define ExportBin_GroupAt(v, g)		ExportBin_Read32(&(v)->col[ExportBin_Group][4*(g)])
+#define ExportBin_GroupFromAt(v, g)	ExportBin_Read32(&(v)->col[ExportBin_GroupFrom][4*(g)])
+#define ExportBin_GroupDepthAt(v, g)	ExportBin_Read16(&(v)->col[ExportBin_GroupDepth][2*(g)])
+#define ExportBin_GroupPswAt(v, g)	((v)->col[ExportBin_GroupPsw][(g)])
+
+/**
+ * Map export file
+ *   args: ExportBin_Open(const char* path)
+ *     path - export file path
+ *   return:
+ *     If succeeded, return the view.
+ *     If the file is broken or can't open, return NULL.
+ */
+ExportBin* ExportBin_Open(const char*);
+
+/**
+ * Unmap export file
+ */
+void ExportBin_Close(ExportBin**);
@@ -0,0 +1,92 @@
+#pragma once
+/**
+ * Fingerprint.h
+ *   routine fingerprint database
+ *
+ *   A routine is fingerprinted by the hash(FNV-1a) of its instructions.
+ *   The opcodes, the operand lengths and the position independent operands
+ *   (the immediates, the direct page, the stack and the branches) are
+ *   hashed, and the absolute / long addresses are masked out except the
+ *   hardware registers. So the same library routine has the same
+ *   fingerprint at any address of any rom.
+ *
+ *   file format(all values are little-endian) :
+ *      0 : magic "SDACHIFP"
+ *      8 : version(16), reserved(16), count(32), names size(32)
+ *     20 : { hash(64), instructions(32), name offset(32) } * count
+ *          (sorted by the hash)
+ *        : names(NUL terminated)
+ */
+
+/* the routines shorter than this aren't fingerprinted */
+#define Fingerprint_MinInsns	4
+
+/**
+ * routine fingerprint
+ */
+typedef struct _FingerprintHash {
+	uint64		hash;
+	uint32		insns;		/* instructions in the routine */
+} FingerprintHash;
+
+/**
+ * public accessor
+ */
+typedef struct _Fingerprint Fingerprint;
+typedef struct _Fingerprint_private Fingerprint_private;
+struct _Fingerprint {
+	/**
+	 * Load the database file(the fingerprints are added)
+	 *   return:
+	 *     If the file can't be read, or it's broken, return false.
+	 */
+	bool (*Load)(Fingerprint*, const char*);
+
+	/**
+	 * Save the database file
+	 */
+	bool (*Save)(Fingerprint*, const char*);
+
+	/**
+	 * Add the named routine
+	 *   args: Add(Fingerprint* self, const FingerprintHash* fp, const char* name)
+	 *   If the fingerprint is already named, the first name is kept.
+	 *   return:
+	 *     If the routine is too short, return false.
+	 */
+	bool (*Add)(Fingerprint*, const FingerprintHash*, const char*);
+
+	/**
+	 * Search the name of the routine
+	 *   The index is sorted by the first search after Add.
+	 *   return:
+	 *     the name, or NULL
+	 */
+	const char* (*Find)(Fingerprint*, const FingerprintHash*);
+
+	uint32 (*count_get)(Fingerprint*);
+	uint32 (*conflicts_get)(Fingerprint*);	/* the fingerprints which had another name */
+	size_t (*bytes_get)(Fingerprint*);	/* heap memory in use */
+
+	/* private members */
+	Fingerprint_private* pri;
+};
+
+/**
+ * Constructor
+ */
+Fingerprint* new_Fingerprint(void);
+
+/**
+ * Destractor
+ */
+void delete_Fingerprint(Fingerprint**);
+
+/**
+ * Fingerprint the routines of the sorted store
+ *   args: Fingerprint_Routines(const RomView* from, InsnStore* store, FingerprintHash* hashes)
+ *     hashes - output(an entry per group, in the order of the groups)
+ *   A routine is the contiguous instructions from the head of the group
+ *   to the next group or the gap.
+ */
+void Fingerprint_Routines(const RomView*, InsnStore*, FingerprintHash*);
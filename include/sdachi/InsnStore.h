@@ -0,0 +1,127 @@
+#pragma once
+/**
+ * InsnStore.h
+ *   pass1 instruction store
+ *
+ *   An instruction is kept as an 8 bytes record. The opcode and the
+ *   operand aren't copied, they're read from the rom when the record is
+ *   decoded, and the length is derived from the opcode and the M/X flags.
+ *   The routine(group) information is kept in the side table, and the
+ *   head instruction of each group is flagged.
+ */
+
+/**
+ * instruction record
+ */
+#define InsnRec_GroupHead	0x01
+typedef struct _InsnRec {
+	uint8		pcadr[3];	/* little endian */
+	uint8		snesadr[3];	/* little endian */
+	uint8		psw;		/* register status at the instruction */
+	uint8		flags;
+} InsnRec;
+
+/**
+ * group record
+ *   The register status is the one of the head instruction.
+ */
+typedef struct _GroupRec {
+	uint32		pcadr;		/* head instruction */
+	uint32		callFrom;
+	int		depth;
+} GroupRec;
+
+#define InsnStore_NotFound	0xffffffff
+
+/* the longest instruction (opcode and 3 bytes operand) */
+#define InsnRec_MaxLength	4
+
+/**
+ * public accessor
+ */
+typedef struct _InsnStore InsnStore;
+typedef struct _InsnStore_private InsnStore_private;
+struct _InsnStore {
+	/**
+	 * Add instruction
+	 *   args: Add(InsnStore* self, const uint32 snesadr, const uint32 pcadr, const uint8 psw)
+	 *   return:
+	 *     If the instruction is already stored (or out of rom), return false.
+	 */
+	bool (*Add)(InsnStore*, const uint32, const uint32, const uint8);
+
+	/**
+	 * Make the last added instruction the head of the group
+	 *   args: AddGroup(InsnStore* self, const uint32 callFrom, const int depth)
+	 */
+	void (*AddGroup)(InsnStore*, const uint32, const int);
+
+	/**
+	 * Check whether the instruction is stored(it's available before Sort)
+	 *   args: Has(InsnStore* self, const uint32 pcadr)
+	 */
+	bool (*Has)(InsnStore*, const uint32);
+
+	/**
+	 * Remove all records and groups
+	 *   Only the bits of the stored records are cleared, so it's cheap for
+	 *   the small store of the large rom.
+	 */
+	void (*Clear)(InsnStore*);
+
+	/**
+	 * Sort the records in the address order
+	 *   Record / Group / Search are available after it.
+	 */
+	void (*Sort)(InsnStore*);
+
+	/**
+	 * Search the instruction by pc address
+	 *   return:
+	 *     record index, or InsnStore_NotFound
+	 */
+	uint32 (*Search)(InsnStore*, const uint32);
+
+	/**
+	 * Search the first instruction at or after the pc address
+	 *   return:
+	 *     record index, or count if there isn't it
+	 */
+	uint32 (*LowerBound)(InsnStore*, const uint32);
+
+	const InsnRec* (*Record)(InsnStore*, const uint32);
+	const GroupRec* (*Group)(InsnStore*, const uint32);
+	uint32 (*count_get)(InsnStore*);
+	uint32 (*groupCount_get)(InsnStore*);
+	size_t (*bytes_get)(InsnStore*);	/* heap memory in use */
+	/* private members */
+	InsnStore_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_InsnStore(const uint32 romSize)
+ */
+InsnStore* new_InsnStore(const uint32);
+
+/**
+ * Destractor
+ */
+void delete_InsnStore(InsnStore**);
+
+/**
+ * Record accessors
+ */
+uint32 InsnRec_Pc(const InsnRec*);
+uint32 InsnRec_Snes(const InsnRec*);
+
+/**
+ * Decode the record with the rom bytes
+ *   args: InsnRec_Decode(const InsnRec* rec, const RomView* from, Instruction* ins)
+ */
+void InsnRec_Decode(const InsnRec*, const RomView*, Instruction*);
+
+/**
+ * Instruction length(opcode and operand)
+ */
+uint32 InsnRec_Length(const InsnRec*, const RomView*);
@@ -0,0 +1,87 @@
+#pragma once
+/**
+ * MxFlow.h
+ *   register width(M / X / E flags) dataflow
+ *
+ *   The code is traced as the blocks which end at the branch / jump / call /
+ *   return. The flags at the start of each block are kept in the lattice
+ *   (per flag : "0", "1" and "the value at the routine entry"), and the
+ *   blocks are revisited by the worklist until nothing changes.
+ *     - rep / sep, clc / sec / xce, and php / plp(the stack of 3 states)
+ *     - the join at the branch destination
+ *     - the exit state of the called routine(the join of its returns)
+ *   The pointers of the indirect jumps which are stored from the immediate
+ *   values are followed(the known values are joined per block, in the fixed
+ *   size).
+ *   Each block is decoded once. The widths of the flags which are still
+ *   ambiguous are kept from the first decode, and the revisit only updates
+ *   the flags which flow out of the block.
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _MxFlow MxFlow;
+typedef struct _MxFlow_private MxFlow_private;
+struct _MxFlow {
+	/**
+	 * Add the entry point
+	 *   args: AddEntry(MxFlow* self, const uint32 snesadr, const uint16 psw, const uint32 callFrom, const bool emulation)
+	 *     psw       - M(0x20) / X(0x10) at the entry
+	 *     emulation - E flag at the entry(the reset vector)
+	 */
+	void (*AddEntry)(MxFlow*, const uint32, const uint16, const uint32, const bool);
+
+	/**
+	 * Trace from the entry points until the flags are fixed
+	 *   return:
+	 *     If an invalid pointer was reached, return false.
+	 *     (The other code is traced.)
+	 */
+	bool (*Run)(MxFlow*);
+
+	/**
+	 * Get the first invalid pointer
+	 *   args: Invalid(MxFlow* self, uint32* snesadr, uint32* callFrom)
+	 *   return:
+	 *     If there is no invalid pointer, return false.
+	 */
+	bool (*Invalid)(MxFlow*, uint32*, uint32*);
+
+	/**
+	 * Add the traced instructions to the store(in the trace order)
+	 *   return:
+	 *     number of the instructions added
+	 */
+	uint32 (*Emit)(MxFlow*, InsnStore*);
+
+	/**
+	 * Rom addresses(pc) of the pointer bytes read by the indirect jumps
+	 *   args: Pointer(MxFlow* self, const uint32 index)
+	 */
+	uint32 (*pointerCount_get)(MxFlow*);
+	uint32 (*Pointer)(MxFlow*, const uint32);
+
+	/**
+	 * statistics
+	 */
+	uint32 (*blockCount_get)(MxFlow*);
+	uint32 (*routineCount_get)(MxFlow*);
+	uint32 (*visits_get)(MxFlow*);		/* block visits of the worklist */
+	size_t (*bytes_get)(MxFlow*);		/* heap memory in use */
+
+	/* private members */
+	MxFlow_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_MxFlow(const RomView* from, const int depthMax)
+ *     depthMax - call depth limit(0: no limit)
+ */
+MxFlow* new_MxFlow(const RomView*, const int);
+
+/**
+ * Destractor
+ */
+void delete_MxFlow(MxFlow**);
@@ -0,0 +1,96 @@
+#pragma once
+/**
+ * Opcode.h
+ */
+
+typedef enum _AdrMode {
+	Adr_imm,
+	Adr_immM,
+	Adr_immX,
+	Adr_sr,
+	Adr_dp,
+	Adr_dpx,
+	Adr_dpy,
+	Adr_idp,
+	Adr_idx,
+	Adr_idy,
+	Adr_idl,
+	Adr_idly,
+	Adr_isy,
+	Adr_abs,
+	Adr_abx,
+	Adr_aby,
+	Adr_abl,
+	Adr_alx,
+	Adr_ind,
+	Adr_iax,
+	Adr_ial,
+	Adr_rel,
+	Adr_rell,
+	Adr_bm,
+	Adr_none
+} AdrMode;
+
+/**
+ * decoded instruction
+ */
+typedef struct _Instruction {
+	uint32		snesadr;
+	uint32		pcadr;
+	uint8		op;
+	uint8		arg[3];
+	int		arglen;
+	uint16		psw;	/* register status at the instruction */
+	bool		numeric;	/* render destination as address, not label */
+} Instruction;
+
+/**
+ * Opcode table accessors
+ */
+const char* Opcode_Mnemonic(const uint8);
+AdrMode Opcode_AdrMode(const uint8);
+int Opcode_ArgLength(const uint8, const uint16);
+
+/**
+ * Get size suffix of instruction
+ *   return:
+ *     ".b", ".w", ".l" or "" (label / branch / implied operand)
+ */
+const char* Opcode_SizeSuffix(const Instruction*);
+
+/**
+ * Render operand text
+ *   args: Opcode_Operand(const Instruction* ins, char* buf)
+ *     ins - instruction
+ *     buf - output buffer(16 bytes or more)
+ *   return:
+ *     length of rendered text
+ */
+int Opcode_Operand(const Instruction*, char*);
+
+/**
+ * Get branch / jump / call destination
+ *   return:
+ *     If the instruction has a static destination, return true.
+ */
+bool Opcode_Target(const Instruction*, uint32*);
+
+/**
+ * Decode the instruction bytes
+ *   args: Opcode_Decode(const uint8* code, const size_t len, const uint16 psw, Instruction* ins)
+ *     code - opcode and operand bytes
+ *     len  - available bytes
+ *     psw  - register status
+ *     ins  - output(op, arg, arglen and psw are set. The addresses aren't touched.)
+ *   return:
+ *     If the operand is cut, return false.
+ */
+bool Opcode_Decode(const uint8*, const size_t, const uint16, Instruction*);
+
+/**
+ * Render instruction text(mnemonic, size suffix and operand)
+ *   args: Opcode_Format(const Instruction* ins, const bool enableUpper, char* buf, const size_t size)
+ *   return:
+ *     length of rendered text. If the buffer is too small, return -1.
+ */
+int Opcode_Format(const Instruction*, const bool, char*, const size_t);
@@ -0,0 +1,83 @@
+#pragma once
+/**
+ * ResultCache.h
+ *   content-addressed cache of the output files
+ *
+ *   The key is the 64bit FNV-1a hash of the key material(the rom data and
+ *   the normalized options). Each entry is the directory named by the key
+ *   in the cache directory, and it has the output files in the given order.
+ *
+ *   An entry is made in the temporary directory and renamed into place,
+ *   and it's renamed away before it's removed, so the parallel jobs never
+ *   see the half-written / half-removed entry. If an entry is removed
+ *   while it's read, the fetch fails and the caller runs the analysis.
+ *
+ *   The least recently used entries are removed when the total size is
+ *   over the limit. (The modification time of the entry is updated by
+ *   each hit.)
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _ResultCache ResultCache;
+typedef struct _ResultCache_private ResultCache_private;
+struct _ResultCache {
+	/**
+	 * Add the key material
+	 *   args: AddKey(ResultCache* self, const void* data, const size_t len)
+	 */
+	void (*AddKey)(ResultCache*, const void*, const size_t);
+
+	/**
+	 * Add the string(with its terminator) to the key
+	 */
+	void (*AddKeyString)(ResultCache*, const char*);
+
+	/**
+	 * Add the file contents to the key
+	 *   return:
+	 *     If the file can't be read, return false.
+	 */
+	bool (*AddKeyFile)(ResultCache*, const char*);
+
+	/**
+	 * Get the key(16 hex digits)
+	 */
+	const char* (*key_get)(ResultCache*);
+
+	/**
+	 * Copy the cached files to the paths
+	 *   args: Fetch(ResultCache* self, const char* const* paths, const int count)
+	 *   return:
+	 *     If the entry isn't found(or it's broken), return false.
+	 */
+	bool (*Fetch)(ResultCache*, const char* const*, const int);
+
+	/**
+	 * Copy the files into the cache
+	 *   args: Store(ResultCache* self, const char* const* paths, const int count)
+	 */
+	bool (*Store)(ResultCache*, const char* const*, const int);
+
+	/**
+	 * Remove the least recently used entries over the size limit
+	 */
+	void (*Evict)(ResultCache*);
+
+	/* private members */
+	ResultCache_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_ResultCache(const char* dir, const ulong limit)
+ *     dir   - cache directory(made if it doesn't exist)
+ *     limit - total size limit in bytes
+ */
+ResultCache* new_ResultCache(const char*, const ulong);
+
+/**
+ * Destractor
+ */
+void delete_ResultCache(ResultCache**);
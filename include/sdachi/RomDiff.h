@@ -0,0 +1,75 @@
+#pragma once
+/**
+ * RomDiff.h
+ *   differential disassembly of two rom versions
+ *
+ *   Both roms are analyzed(pass1 only), and the routines(groups) are
+ *   matched by their head addresses. The roms are compared by 4KB blocks,
+ *   and the instruction bytes are compared only in the changed blocks.
+ *   Only the changed instructions are written to the report, the rest of
+ *   the roms isn't rendered.
+ *
+ *   report :
+ *     changed  $008000 (call from $00fffc)
+ *     -L008005:	lda.w #$1234       ; a9 34 12 (m16 x8)
+ *     +L008005:	lda.w #$1235       ; a9 35 12 (m16 x8)
+ *     affected $009000 (call from $008010) : reaches $008000
+ *     added / removed routines are written with all the instructions,
+ *     data     $00a000-$00a00f (16 bytes)   (the changed bytes out of the code)
+ */
+
+/**
+ * kind of the change
+ */
+typedef enum {
+	RomDiff_Changed,	/* the instructions are changed */
+	RomDiff_Affected,	/* it reaches the changed routine */
+	RomDiff_Added,
+	RomDiff_Removed,
+	RomDiff_Data,		/* the changed bytes out of the code */
+	RomDiff_Kinds
+} RomDiffKind;
+
+/**
+ * public accessor
+ */
+typedef struct _RomDiff RomDiff;
+typedef struct _RomDiff_private RomDiff_private;
+struct _RomDiff {
+	/**
+	 * Add entry point(it's analyzed in both roms)
+	 *   args: AddEntry(RomDiff* self, const uint32 snesadr, const uint16 psw)
+	 */
+	void (*AddEntry)(RomDiff*, const uint32, const uint16);
+
+	/**
+	 * Compare the roms, and write the report
+	 *   args: Run(RomDiff* self, const RomView* oldRom, const RomView* newRom, TextFile* out)
+	 */
+	bool (*Run)(RomDiff*, const RomView*, const RomView*, TextFile*);
+
+	/**
+	 * Number of the routines(or the data ranges) of the last run
+	 */
+	uint32 (*count_get)(RomDiff*, const RomDiffKind);
+
+	/**
+	 * Write the diagnostics of both analyses, and clear them
+	 */
+	void (*PrintDiags)(RomDiff*);
+
+	/* private members */
+	RomDiff_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_RomDiff(const DisAsmInf* inf)
+ *     inf - options of the analysis(copied)
+ */
+RomDiff* new_RomDiff(const DisAsmInf*);
+
+/**
+ * Destractor
+ */
+void delete_RomDiff(RomDiff**);
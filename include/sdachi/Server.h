@@ -0,0 +1,67 @@
+#pragma once
+/**
+ * Server.h
+ *   resident disassembly server
+ *
+ *   It keeps the loaded roms and their analysis results, and answers the
+ *   line-delimited JSON requests. A request is a JSON object in one line,
+ *   and one response line is returned for each request.
+ *
+ *   requests:
+ *     {"op":"load","path":"<rom>"}
+ *     {"op":"identify","rom":<id>}  or  {"op":"identify","path":"<rom>"}
+ *     {"op":"add-entry","rom":<id>,"snes":<address>[,"m":8|16][,"x":8|16]}
+ *     {"op":"disassemble-range","rom":<id>,"start":<snes>,"end":<snes>}
+ *     {"op":"xref","rom":<id>,"snes":<address>}
+ *   The addresses are numbers or hex strings("$8000", "0x8000"), and the
+ *   range end is exclusive. The "id" member of the request is copied to
+ *   the response, and the response has "ok"(and "error" if it failed).
+ */
+
+/**
+ * public accessor
+ */
+typedef struct _Server Server;
+typedef struct _Server_private Server_private;
+struct _Server {
+	/**
+	 * Handle one request line
+	 *   args: Handle(Server* self, const char* request)
+	 *   return:
+	 *     response line(without newline). It's freed by the caller.
+	 */
+	char* (*Handle)(Server*, const char*);
+
+	/**
+	 * Serve the clients on the unix domain socket until Stop is called
+	 *   args: Serve(Server* self, const char* path)
+	 *   The requests are read from all clients, and handled on the worker
+	 *   threads. A client's requests are handled one at a time, so its
+	 *   responses are in the order of the requests. Up to 64 clients are
+	 *   connected, and the others get the error response.
+	 */
+	bool (*Serve)(Server*, const char*);
+
+	/**
+	 * Stop serving
+	 *   It only sets the flag, so it can be called from the signal handler.
+	 */
+	void (*Stop)(Server*);
+
+	/* private members */
+	Server_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_Server(const DisAsmInf* inf, const int threads)
+ *     inf     - analysis options(copied)
+ *     threads - number of the worker threads
+ */
+Server* new_Server(const DisAsmInf*, const int);
+
+/**
+ * Destractor
+ *   The loaded roms are released.
+ */
+void delete_Server(Server**);
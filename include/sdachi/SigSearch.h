@@ -0,0 +1,70 @@
+#pragma once
+/**
+ * SigSearch.h
+ *   signature search over the roms
+ *
+ *   The roms(the files, and the files in the directories) are scanned by
+ *   one compiled signature set(Signature.h) on the worker threads. Each rom
+ *   is loaded, scanned and released by a worker, so only the roms on the
+ *   workers are in memory.
+ */
+
+/**
+ * result of the rom
+ */
+typedef struct _SigSearchResult {
+	const char*		rom;
+	bool			ok;		/* the rom is loaded */
+	uint32			count;
+	const SignatureMatch*	matches;	/* in the order of the address */
+} SigSearchResult;
+
+/**
+ * public accessor
+ */
+typedef struct _SigSearch SigSearch;
+typedef struct _SigSearch_private SigSearch_private;
+struct _SigSearch {
+	/**
+	 * Add the rom, or the files in the directory(not recursive, in the
+	 * order of the name)
+	 *   return:
+	 *     If the directory can't be read, return false.
+	 */
+	bool (*AddPath)(SigSearch*, const char*);
+
+	/**
+	 * Scan all roms
+	 *   return:
+	 *     If any rom can't be loaded, return false.
+	 */
+	bool (*Run)(SigSearch*);
+
+	/**
+	 * results accessors(in the order of the addition)
+	 */
+	uint32 (*count_get)(SigSearch*);
+	const SigSearchResult* (*Result)(SigSearch*, const uint32);
+
+	/**
+	 * Write a line per match(the rom, the snes / pc address and the
+	 * signature), and the summary
+	 */
+	void (*PrintResults)(SigSearch*);
+
+	/* private members */
+	SigSearch_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_SigSearch(Signature* sigs, const int threads)
+ *     sigs    - signature set(not owned)
+ *     threads - worker threads
+ */
+SigSearch* new_SigSearch(Signature*, const int);
+
+/**
+ * Destractor
+ */
+void delete_SigSearch(SigSearch**);
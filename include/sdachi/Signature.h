@@ -0,0 +1,98 @@
+#pragma once
+/**
+ * Signature.h
+ *   byte signatures of the known routines
+ *
+ *   The signature file has a signature per line(the text after "#" is a
+ *   comment) :
+ *     <name> <pattern>
+ *   The pattern is the hex bytes, "??" is any byte, and "?" in a byte is
+ *   any nibble(e.g. "a9 ?? 8d 0? 21"). The spaces in the pattern are
+ *   ignored.
+ *
+ *   The longest run of the fixed bytes of each signature(up to 8 bytes)
+ *   is its anchor. The anchors are compiled into an Aho-Corasick automaton
+ *   (the dense transition table), so the rom is scanned in one pass for all
+ *   signatures, and the whole pattern is compared only where its anchor is
+ *   found. The compiled set isn't changed by the scan, so it can be shared
+ *   by the threads.
+ */
+
+/**
+ * found signature
+ */
+typedef struct _SignatureMatch {
+	uint32		sig;		/* index of the signature */
+	uint32		pcadr;
+	uint32		snesadr;
+} SignatureMatch;
+
+/**
+ * public accessor
+ */
+typedef struct _Signature Signature;
+typedef struct _Signature_private Signature_private;
+struct _Signature {
+	/**
+	 * Add the signature
+	 *   args: Add(Signature* self, const char* name, const char* pattern)
+	 *   return:
+	 *     If the pattern is broken(or it has no fixed byte), return false.
+	 */
+	bool (*Add)(Signature*, const char*, const char*);
+
+	/**
+	 * Load the signature file(the signatures are added)
+	 *   return:
+	 *     If the file can't be read or a line is broken, return false.
+	 *     (See error_get.)
+	 */
+	bool (*Load)(Signature*, const char*);
+
+	/**
+	 * Compile the added signatures
+	 *   Scan compiles them if they aren't compiled, so call it before the
+	 *   set is shared by the threads.
+	 */
+	void (*Compile)(Signature*);
+
+	/**
+	 * Scan the rom
+	 *   args: Scan(Signature* self, const RomView* from, SignatureMatch** matches)
+	 *     matches - the found signatures in the order of the address(free it),
+	 *               or NULL
+	 *   return: the number of the matches
+	 */
+	uint32 (*Scan)(Signature*, const RomView*, SignatureMatch**);
+
+	/**
+	 * signatures
+	 */
+	uint32 (*count_get)(Signature*);
+	const char* (*Name)(Signature*, const uint32);
+	uint32 (*Length)(Signature*, const uint32);
+
+	/**
+	 * The last error of Add / Load
+	 */
+	const char* (*error_get)(Signature*);
+
+	/**
+	 * statistics
+	 */
+	uint32 (*stateCount_get)(Signature*);	/* states of the automaton */
+	size_t (*bytes_get)(Signature*);	/* heap memory in use */
+
+	/* private members */
+	Signature_private* pri;
+};
+
+/**
+ * Constructor
+ */
+Signature* new_Signature(void);
+
+/**
+ * Destractor
+ */
+void delete_Signature(Signature**);
@@ -0,0 +1,69 @@
+#pragma once
+/**
+ * Sink.h
+ */
+
+/**
+ * routine(group) head information
+ */
+typedef struct _GroupInfo {
+	uint32		snesadr;
+	uint32		callFrom;
+	int		depth;
+	uint16		psw;
+	uint32		hits;		/* executions of the head(trace log), or GroupInfo_NotTraced */
+	uint32		hitsMax;	/* the most executed instruction in the routine */
+} GroupInfo;
+
+#define GroupInfo_NotTraced	0xffffffff
+
+/**
+ * BinSink record format
+ *   header : "SDACHIRC", version(16), record size(16), reserved(32)
+ *   record : kind(8), length(8), psw(8), depth(8),
+ *            snesadr(32), pcadr / callFrom / name offset(32), bytes[4]
+ *   All values are little-endian.
+ *   The data and the label name are split into 4 bytes records, and
+ *   the name of the label starts at the record of the offset 0.
+ */
+#define BinSink_Magic		"SDACHIRC"
+#define BinSink_Version		2
+#define BinSink_RecordSize	16
+
+typedef enum BinRecordKind {
+	BinRecord_Insn = 0,
+	BinRecord_Group,
+	BinRecord_Data,
+	BinRecord_Label
+} BinRecordKind;
+
+/**
+ * public accessor
+ */
+typedef struct _Sink Sink;
+typedef struct _Sink_protected Sink_protected;
+struct _Sink {
+	void (*Begin)(Sink*, const RomView*, const char*);
+	void (*Label)(Sink*, const uint32, const char*);
+	void (*Org)(Sink*, const uint32);
+	void (*Group)(Sink*, const GroupInfo*);
+	void (*Insn)(Sink*, const Instruction*);
+	void (*Data)(Sink*, const uint32, const uint32, const uint8*, const size_t);
+	bool (*End)(Sink*);
+	/* protected members */
+	Sink_protected* pro;
+};
+
+/**
+ * Constructor
+ *   The output file isn't owned by the sink.
+ */
+Sink* new_AsmSink(TextFile*, const bool);
+Sink* new_JsonSink(TextFile*);
+Sink* new_CsvSink(TextFile*);
+Sink* new_BinSink(TextFile*);
+
+/**
+ * Destractor
+ */
+void delete_Sink(Sink**);
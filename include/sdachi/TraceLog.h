@@ -0,0 +1,84 @@
+#pragma once
+/**
+ * TraceLog.h
+ *   execution trace log of the emulators
+ *
+ *   The log is a text file with a line per executed instruction. The
+ *   address and the flags are taken from each line :
+ *     address : the first word of the line, "008000" / "00:8000" / "00/8000"
+ *               (with or without "$")
+ *     flags   : "P:34"(hex), or the letters "nvMXdIzc" / "envMXdIzc"
+ *               (with or without "P:", the upper case is set, "." / "-" is clear)
+ *   The other columns(the registers, the mnemonic) are ignored, so the logs
+ *   of bsnes / Mesen / snes9x are read as they are. The lines without them
+ *   and the addresses out of the rom(the code in RAM) are skipped.
+ *
+ *   The file is mapped, split into the chunks at the line breaks and parsed
+ *   on the threads. Each thread counts the (address, flags) pairs in its own
+ *   hash table, and they're merged into the hits of the rom addresses(the
+ *   mirrors of the address are merged).
+ */
+
+/**
+ * executed (address, flags) pair
+ */
+typedef struct _TraceHit {
+	uint32		pcadr;
+	uint32		snesadr;	/* the lowest one of the mirrors */
+	uint32		count;		/* executions(saturated) */
+	uint8		psw;		/* M / X */
+} TraceHit;
+
+/**
+ * public accessor
+ */
+typedef struct _TraceLog TraceLog;
+typedef struct _TraceLog_private TraceLog_private;
+struct _TraceLog {
+	/**
+	 * Load the log(the hits are added to the loaded ones)
+	 *   args: Load(TraceLog* self, const char* path, const int threads)
+	 *     threads - parser threads(0: the number of the processors)
+	 *   return:
+	 *     If the file can't be read, return false.
+	 */
+	bool (*Load)(TraceLog*, const char*, const int);
+
+	/**
+	 * hits in the order of the rom address(and the flags)
+	 */
+	uint32 (*count_get)(TraceLog*);
+	const TraceHit* (*Hit)(TraceLog*, const uint32);
+
+	/**
+	 * Executions at the rom address(with any flags)
+	 *   args: Hits(TraceLog* self, const uint32 pcadr)
+	 */
+	uint32 (*Hits)(TraceLog*, const uint32);
+
+	/**
+	 * Hash of the addresses and the flags(the counts aren't hashed)
+	 */
+	uint32 (*Hash)(TraceLog*);
+
+	/**
+	 * statistics
+	 */
+	ulong (*lines_get)(TraceLog*);
+	ulong (*skipped_get)(TraceLog*);	/* the lines without the address / flags, or out of the rom */
+	size_t (*bytes_get)(TraceLog*);		/* heap memory in use */
+
+	/* private members */
+	TraceLog_private* pri;
+};
+
+/**
+ * Constructor
+ *   args: new_TraceLog(const RomView* from)
+ */
+TraceLog* new_TraceLog(const RomView*);
+
+/**
+ * Destractor
+ */
+void delete_TraceLog(TraceLog**);
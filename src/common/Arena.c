@@ -0,0 +1,181 @@
+/**
+ * Arena.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <stddef.h>
+#include <memory.h>
+#include <assert.h>
+#include "common/Arena.h"
+
+#define DefaultBlockSize	(64*1024)
+
+/* alignment for any object type */
+typedef union _ArenaAlign {
+	long	l;
+	double	d;
+	void*	p;
+} ArenaAlign;
+#define AlignSize		sizeof(ArenaAlign)
+#define Align(n)		(((n) + AlignSize - 1) & ~(AlignSize - 1))
+
+typedef struct _ArenaBlock ArenaBlock;
+struct _ArenaBlock {
+	ArenaBlock*	next;
+	size_t		size;
+	size_t		used;
+	ArenaAlign	data[1];
+};
+#define BlockHeadSize		offsetof(ArenaBlock, data)
+
+/**
+ * Arena private members
+ */
+struct _Arena_private {
+	ArenaBlock*	top;
+	size_t		blockSize;
+	size_t		allocs;
+	size_t		blocks;
+	size_t		bytes;
+};
+
+/* prototypes */
+static void* Alloc(Arena*, const size_t);
+static void* Calloc(Arena*, const size_t);
+static size_t allocs_get(Arena*);
+static size_t blocks_get(Arena*);
+static size_t bytes_get(Arena*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Arena object
+ *
+ * @return the pointer of object
+ */
+Arena* new_Arena(const size_t blockSize)
+{
+	Arena* self;
+	Arena_private* pri;
+
+	/* make objects */
+	self = malloc(sizeof(Arena));
+	pri = malloc(sizeof(Arena_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->top = NULL;
+	pri->blockSize = (0 == blockSize) ? DefaultBlockSize : Align(blockSize);
+	pri->allocs = 0;
+	pri->blocks = 0;
+	pri->bytes = 0;
+
+	/*--- set public member ---*/
+	self->Alloc = Alloc;
+	self->Calloc = Calloc;
+	self->allocs_get = allocs_get;
+	self->blocks_get = blocks_get;
+	self->bytes_get = bytes_get;
+
+	/* init Arena object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Arena object
+ *
+ * @param the pointer of object
+ */
+void delete_Arena(Arena** self)
+{
+	ArenaBlock* blk;
+	ArenaBlock* nx;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	for(blk = (*self)->pri->top; NULL != blk; blk = nx)
+	{
+		nx = blk->next;
+		free(blk);
+	}
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void* Alloc(Arena* self, const size_t size)
+{
+	Arena_private* pri;
+	ArenaBlock* blk;
+	size_t len;
+	void* p;
+
+	assert(self);
+	pri = self->pri;
+	len = Align((0 == size) ? 1 : size);
+
+	blk = pri->top;
+	if((NULL == blk) || (blk->size - blk->used < len))
+	{
+		size_t bsz = (len > pri->blockSize) ? len : pri->blockSize;
+
+		blk = malloc(BlockHeadSize + bsz);
+		assert(blk);
+		blk->size = bsz;
+		blk->used = 0;
+
+		/* an oversized block doesn't replace the current one */
+		if((bsz > pri->blockSize) && (NULL != pri->top))
+		{
+			blk->next = pri->top->next;
+			pri->top->next = blk;
+		}
+		else
+		{
+			blk->next = pri->top;
+			pri->top = blk;
+		}
+		pri->blocks++;
+	}
+
+	p = (uint8*)blk->data + blk->used;
+	blk->used += len;
+	pri->allocs++;
+	pri->bytes += len;
+	return p;
+}
+
+static void* Calloc(Arena* self, const size_t size)
+{
+	void* p;
+
+	p = Alloc(self, size);
+	memset(p, 0, size);
+	return p;
+}
+
+static size_t allocs_get(Arena* self)
+{
+	assert(self);
+	return self->pri->allocs;
+}
+
+static size_t blocks_get(Arena* self)
+{
+	assert(self);
+	return self->pri->blocks;
+}
+
+static size_t bytes_get(Arena* self)
+{
+	assert(self);
+	return self->pri->bytes;
+}
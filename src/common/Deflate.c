@@ -0,0 +1,467 @@
+/**
+ * Deflate.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#ifdef HAVE_ZLIB
+#  include <zlib.h>
+#endif
+#include "common/Deflate.h"
+
+#define OutSize		16384
+
+#ifndef HAVE_ZLIB
+#define WindowSize	32768
+#define BlockSize	65536
+#define HashBits	15
+#define HashSize	(1 << HashBits)
+#define MinMatch	3
+#define MaxMatch	258
+#define MaxChain	32
+#define NoPos		(-1)
+
+/* length / distance code base and extra bits */
+static const uint16 lengthBase[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+static const uint8 lengthExtra[29] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+static const uint16 distBase[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+static const uint8 distExtra[30] = {
+	0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+#endif
+
+/**
+ * Deflate private members
+ */
+struct _Deflate_private {
+	DeflateOutput_t	out;
+	void*		param;
+	uint8		obuf[OutSize];
+	size_t		olen;
+	bool		failed;
+#ifdef HAVE_ZLIB
+	z_stream	zs;
+#else
+	/* history(WindowSize) + input block(BlockSize) */
+	uint8*		buf;
+	size_t		len;
+	size_t		hist;
+	int32*		head;
+	int32*		prev;
+	/* bit writer */
+	uint32		bits;
+	int		nbits;
+	/* reversed fixed huffman codes */
+	uint16		litCode[288];
+	uint8		litLen[288];
+	uint8		distCode[30];
+	/* code lookup */
+	uint8		lengthSym[MaxMatch+1];
+#endif
+};
+
+/* prototypes */
+static bool Put(Deflate*, const uint8*, const size_t);
+static bool Finish(Deflate*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+#ifndef HAVE_ZLIB
+static uint16 Reverse(uint16 code, int len)
+{
+	uint16 r = 0;
+	int i;
+
+	for(i=0; i<len; i++)
+	{
+		r = (uint16)((r << 1) | (code & 1));
+		code = (uint16)(code >> 1);
+	}
+	return r;
+}
+
+static void InitCodes(Deflate_private* pri)
+{
+	int i;
+	int s;
+
+	for(i=0; i<288; i++)
+	{
+		if(144 > i)
+		{
+			pri->litLen[i] = 8;
+			pri->litCode[i] = Reverse((uint16)(0x30 + i), 8);
+		}
+		else if(256 > i)
+		{
+			pri->litLen[i] = 9;
+			pri->litCode[i] = Reverse((uint16)(0x190 + i - 144), 9);
+		}
+		else if(280 > i)
+		{
+			pri->litLen[i] = 7;
+			pri->litCode[i] = Reverse((uint16)(i - 256), 7);
+		}
+		else
+		{
+			pri->litLen[i] = 8;
+			pri->litCode[i] = Reverse((uint16)(0xc0 + i - 280), 8);
+		}
+	}
+	for(i=0; i<30; i++)
+	{
+		pri->distCode[i] = (uint8)Reverse((uint16)i, 5);
+	}
+
+	for(s=0, i=MinMatch; i<=MaxMatch; i++)
+	{
+		while((28 > s) && (lengthBase[s+1] <= i)) s++;
+		pri->lengthSym[i] = (uint8)s;
+	}
+}
+#endif
+
+/**
+ * @brief Create Deflate object
+ *
+ * @return the pointer of object
+ */
+Deflate* new_Deflate(DeflateOutput_t out, void* param)
+{
+	Deflate* self;
+	Deflate_private* pri;
+
+	assert(out);
+
+	/* make objects */
+	self = malloc(sizeof(Deflate));
+	pri = malloc(sizeof(Deflate_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->out = out;
+	pri->param = param;
+	pri->olen = 0;
+	pri->failed = false;
+#ifdef HAVE_ZLIB
+	memset(&pri->zs, 0, sizeof(z_stream));
+	if(Z_OK != deflateInit2(&pri->zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY))
+	{
+		pri->failed = true;
+	}
+#else
+	pri->buf = malloc(WindowSize + BlockSize);
+	pri->head = malloc(sizeof(int32) * HashSize);
+	pri->prev = malloc(sizeof(int32) * (WindowSize + BlockSize));
+	assert(pri->buf);
+	assert(pri->head);
+	assert(pri->prev);
+	pri->len = 0;
+	pri->hist = 0;
+	pri->bits = 0;
+	pri->nbits = 0;
+	InitCodes(pri);
+#endif
+
+	/*--- set public member ---*/
+	self->Put = Put;
+	self->Finish = Finish;
+
+	/* init Deflate object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Deflate object
+ *
+ * @param the pointer of object
+ */
+void delete_Deflate(Deflate** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+#ifdef HAVE_ZLIB
+	deflateEnd(&(*self)->pri->zs);
+#else
+	free((*self)->pri->buf);
+	free((*self)->pri->head);
+	free((*self)->pri->prev);
+#endif
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void FlushOut(Deflate_private* pri)
+{
+	if(0 == pri->olen) return;
+	if(false == pri->out(pri->param, pri->obuf, pri->olen))
+	{
+		pri->failed = true;
+	}
+	pri->olen = 0;
+}
+
+#ifdef HAVE_ZLIB
+
+static void Run(Deflate_private* pri, const int flush)
+{
+	int r;
+
+	do
+	{
+		pri->zs.next_out = pri->obuf;
+		pri->zs.avail_out = OutSize;
+		r = deflate(&pri->zs, flush);
+		if(Z_STREAM_ERROR == r)
+		{
+			pri->failed = true;
+			return;
+		}
+		pri->olen = OutSize - pri->zs.avail_out;
+		FlushOut(pri);
+	} while(0 == pri->zs.avail_out);
+}
+
+static bool Put(Deflate* self, const uint8* data, const size_t len)
+{
+	Deflate_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->failed) return false;
+
+	pri->zs.next_in = (Bytef*)data;
+	pri->zs.avail_in = (uInt)len;
+	Run(pri, Z_NO_FLUSH);
+	return !pri->failed;
+}
+
+static bool Finish(Deflate* self)
+{
+	Deflate_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->failed) return false;
+
+	pri->zs.next_in = NULL;
+	pri->zs.avail_in = 0;
+	Run(pri, Z_FINISH);
+	return !pri->failed;
+}
+
+#else
+
+static void PutBits(Deflate_private* pri, const uint32 v, const int n)
+{
+	pri->bits |= v << pri->nbits;
+	pri->nbits += n;
+	while(8 <= pri->nbits)
+	{
+		if(OutSize == pri->olen) FlushOut(pri);
+		pri->obuf[pri->olen++] = (uint8)pri->bits;
+		pri->bits >>= 8;
+		pri->nbits -= 8;
+	}
+}
+
+static void PutLiteral(Deflate_private* pri, const int sym)
+{
+	PutBits(pri, pri->litCode[sym], pri->litLen[sym]);
+}
+
+static void PutMatch(Deflate_private* pri, const int len, const int dist)
+{
+	int s;
+
+	/* length */
+	s = pri->lengthSym[len];
+	PutLiteral(pri, 257 + s);
+	if(0 != lengthExtra[s])
+	{
+		PutBits(pri, (uint32)(len - lengthBase[s]), lengthExtra[s]);
+	}
+
+	/* distance */
+	for(s=29; distBase[s] > dist; s--);
+	PutBits(pri, pri->distCode[s], 5);
+	if(0 != distExtra[s])
+	{
+		PutBits(pri, (uint32)(dist - distBase[s]), distExtra[s]);
+	}
+}
+
+static uint32 Hash(const uint8* p)
+{
+	return ((((uint32)p[0] << 10) ^ ((uint32)p[1] << 5) ^ p[2]) * 2654435761u) >> (32 - HashBits);
+}
+
+static void Insert(Deflate_private* pri, const size_t pos)
+{
+	uint32 h;
+
+	if(pos + MinMatch > pri->len) return;
+	h = Hash(&pri->buf[pos]);
+	pri->prev[pos] = pri->head[h];
+	pri->head[h] = (int32)pos;
+}
+
+static int LongestMatch(Deflate_private* pri, const size_t pos, int* dist)
+{
+	const uint8* buf = pri->buf;
+	size_t limit;
+	int32 cand;
+	int chain = MaxChain;
+	int best = 0;
+	int n;
+
+	limit = pri->len - pos;
+	if(MaxMatch < limit) limit = MaxMatch;
+	if(MinMatch > limit) return 0;
+
+	cand = pri->head[Hash(&buf[pos])];
+	while((NoPos != cand) && (WindowSize >= pos - (size_t)cand) && (0 < chain--))
+	{
+		if(buf[cand+best] == buf[pos+(size_t)best])
+		{
+			for(n=0; (size_t)n < limit && buf[(size_t)cand+(size_t)n] == buf[pos+(size_t)n]; n++);
+			if(n > best)
+			{
+				best = n;
+				(*dist) = (int)(pos - (size_t)cand);
+				if((size_t)best == limit) break;
+			}
+		}
+		cand = pri->prev[cand];
+	}
+	return best;
+}
+
+/**
+ * Compress the pending input as one fixed huffman block
+ */
+static void CompressBlock(Deflate_private* pri, const bool final)
+{
+	size_t pos;
+	size_t i;
+	int len;
+	int dist = 0;
+
+	/* block header : BFINAL, BTYPE=01 */
+	PutBits(pri, (final ? 1u : 0u) | 2u, 3);
+
+	/* index the history */
+	for(i=0; i<HashSize; i++) pri->head[i] = NoPos;
+	for(pos=0; pos<pri->hist; pos++) Insert(pri, pos);
+
+	for(pos=pri->hist; pos<pri->len; )
+	{
+		len = LongestMatch(pri, pos, &dist);
+		if(MinMatch > len)
+		{
+			PutLiteral(pri, pri->buf[pos]);
+			Insert(pri, pos);
+			pos++;
+			continue;
+		}
+
+		PutMatch(pri, len, dist);
+		for(i=0; i<(size_t)len; i++) Insert(pri, pos+i);
+		pos += (size_t)len;
+	}
+
+	/* end of block */
+	PutLiteral(pri, 256);
+
+	/* slide window */
+	if(WindowSize < pri->len)
+	{
+		memmove(pri->buf, &pri->buf[pri->len - WindowSize], WindowSize);
+		pri->len = WindowSize;
+	}
+	pri->hist = pri->len;
+}
+
+static bool Put(Deflate* self, const uint8* data, const size_t len)
+{
+	Deflate_private* pri;
+	size_t n;
+	size_t i;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->failed) return false;
+
+	for(i=0; i<len; i+=n)
+	{
+		n = pri->hist + BlockSize - pri->len;
+		if(len - i < n) n = len - i;
+		memcpy(&pri->buf[pri->len], &data[i], n);
+		pri->len += n;
+		if(pri->hist + BlockSize == pri->len)
+		{
+			CompressBlock(pri, false);
+		}
+	}
+	return !pri->failed;
+}
+
+static bool Finish(Deflate* self)
+{
+	Deflate_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->failed) return false;
+
+	CompressBlock(pri, true);
+	/* byte align */
+	if(0 != pri->nbits) PutBits(pri, 0, 8 - pri->nbits);
+	FlushOut(pri);
+	return !pri->failed;
+}
+
+#endif
+
+
+/*--------------- CRC-32 ---------------*/
+
+uint32 Deflate_Crc32(uint32 crc, const uint8* data, const size_t len)
+{
+	static const uint32 half[16] = {
+		0x00000000, 0x1db71064, 0x3b6e20c8, 0x26d930ac,
+		0x76dc4190, 0x6b6b51f4, 0x4db26158, 0x5005713c,
+		0xedb88320, 0xf00f9344, 0xd6d6a3e8, 0xcb61b38c,
+		0x9b64c2b0, 0x86d3d2d4, 0xa00ae278, 0xbdbdf21c
+	};
+	size_t i;
+
+	crc = ~crc;
+	for(i=0; i<len; i++)
+	{
+		crc ^= data[i];
+		crc = (crc >> 4) ^ half[crc & 0x0f];
+		crc = (crc >> 4) ^ half[crc & 0x0f];
+	}
+	return ~crc;
+}
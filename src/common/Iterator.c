@@ -5,8 +5,11 @@
 #include <stdlib.h>
 #include <memory.h>
 #include <assert.h>
+#include "common/Arena.h"
 #include "common/Iterator.h"
 #include "Iterator.protected.h"
+#include "common/List.h"
+#include "List.protected.h"
 
 static Iterator* prev(Iterator*);
 static Iterator* next(Iterator*);
@@ -17,27 +20,19 @@ static void itremove(Iterator*, bool);
 /*--------------- Constructor / Destructor ---------------*/
 
 /**
- * @brief Create Iterator object
- *
- * @return the pointer of object
+ * @brief Initialize Iterator node
  */
-Iterator* new_Iterator(void* d)
+void Iterator_Init(IteratorNode* node, void* d, struct _List* owner, Arena* arena)
 {
-	Iterator* self;
-	Iterator_protected* pro;
-
-	/* make objects */
-	self = malloc(sizeof(Iterator));
-	pro = malloc(sizeof(Iterator_protected));
-
-	/* check whether object creatin succeeded */
-	assert(pro);
-	assert(self);
+	Iterator* self = &node->it;
+	Iterator_protected* pro = &node->pro;
 
 	/*--- set protected member ---*/
 	pro->data = d;
 	pro->prev = NULL;
 	pro->next = NULL;
+	pro->owner = owner;
+	pro->arena = arena;
 
 	/*--- set public member ---*/
 	self->data = data;
@@ -48,7 +43,42 @@ Iterator* new_Iterator(void* d)
 
 	/* init Iterator object */
 	self->pro = pro;
-	return self;
+}
+
+/**
+ * @brief Create Iterator object
+ *
+ * @return the pointer of object
+ */
+Iterator* new_Iterator(void* d)
+{
+	return new_IteratorEx(d, NULL);
+}
+
+/**
+ * @brief Create Iterator object from the arena
+ *
+ * @return the pointer of object
+ */
+Iterator* new_IteratorEx(void* d, Arena* arena)
+{
+	IteratorNode* node;
+
+	/* make objects */
+	if(NULL != arena)
+	{
+		node = arena->Alloc(arena, sizeof(IteratorNode));
+	}
+	else
+	{
+		node = malloc(sizeof(IteratorNode));
+	}
+
+	/* check whether object creatin succeeded */
+	assert(node);
+
+	Iterator_Init(node, d, NULL, arena);
+	return &node->it;
 }
 
 /**
@@ -61,8 +91,13 @@ void delete_Iterator(Iterator** self)
 	/* This is the template that default destractor. */
 	assert(self);
 	if(NULL == (*self)) return;
-	free((*self)->pro);
-	free(*self);
+
+	/* list nodes are released by the owner, and */
+	/* arena memory is released with the arena   */
+	if(NULL == (*self)->pro->owner && NULL == (*self)->pro->arena)
+	{
+		free(*self);
+	}
 	(*self) = NULL;
 }
 
@@ -89,7 +124,15 @@ static bool insert(Iterator* self, void* data)
 	Iterator *itPrev;
 	Iterator *itNew;
 
-	itNew = new_Iterator(data);
+	assert(self);
+
+	/* list node */
+	if(NULL != self->pro->owner)
+	{
+		return List_InsertBefore(self->pro->owner, self, data);
+	}
+
+	itNew = new_IteratorEx(data, self->pro->arena);
 	assert(itNew);
 	itPrev = self->prev(self);
 
@@ -107,6 +150,9 @@ static bool insert(Iterator* self, void* data)
 
 static void itremove(Iterator* self, bool isKeepData)
 {
-	/* TODO: Implement */
-	return;
+	assert(self);
+
+	/* only list node can be removed */
+	if(NULL == self->pro->owner) return;
+	List_Remove(self->pro->owner, self, isKeepData);
 }
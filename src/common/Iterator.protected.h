@@ -5,10 +5,14 @@
 
 /**
  * Iterator main instance
+ *   The methods and the links are allocated together.
  */
-struct _Iterator_protected{
-	Iterator *prev;
-	Iterator *next;
-	void * data;
-};
+typedef struct _IteratorNode {
+	Iterator		it;
+	Iterator_protected	pro;
+} IteratorNode;
 
+/**
+ * initialize node
+ */
+void Iterator_Init(IteratorNode*, void*, struct _List*, Arena*);
@@ -3,14 +3,16 @@
  */
 #include "common/types.h"
 #include <stdlib.h>
+#include <stddef.h>
 #include <memory.h>
 #include <assert.h>
+#include "common/Arena.h"
 #include "common/Iterator.h"
 #include "Iterator.protected.h"
 #include "common/List.h"
 
 /* this header isn't read from anything other */
-/* than inherited object.                     */ 
+/* than inherited object.                     */
 #include "List.protected.h"
 
 /* prototypes */
@@ -35,6 +37,16 @@ static List* Clone(List*);
  * @return the pointer of object
  */
 List* new_List(ListDataCloner_t cloner, ListDataDeleter_t deleter)
+{
+	return new_ListEx(cloner, deleter, NULL);
+}
+
+/**
+ * @brief Create List object whose nodes are allocated from the arena
+ *
+ * @return the pointer of object
+ */
+List* new_ListEx(ListDataCloner_t cloner, ListDataDeleter_t deleter, Arena* arena)
 {
 	List* self;
 	List_protected* pro;
@@ -53,6 +65,14 @@ List* new_List(ListDataCloner_t cloner, ListDataDeleter_t deleter)
 	pro->length = 0;
 	pro->top = NULL;
 	pro->tail = NULL;
+	pro->arena = arena;
+	pro->chunks = NULL;
+	pro->chunkUsed = 0;
+	pro->freeNodes = NULL;
+	pro->table = NULL;
+	pro->tableHead = 0;
+	pro->tableSize = 0;
+	pro->tableValid = false;
 
 	/*--- set public member ---*/
 	self->length = Length;
@@ -83,17 +103,29 @@ void delete_List_members(List* self)
 {
 	List_protected* lp;
 	Iterator* it;
-	Iterator* nx;
+	ListChunk* ch;
+	ListChunk* nx;
+
 	/* delete protected members */
 	lp = self->pro;
-	it = lp->top;
-	while(NULL != it)
+	if(NULL != lp->deleter)
 	{
-		nx = it->next(it);
-		lp->deleter(it->pro->data);
-		delete_Iterator(&it);
-		it = nx;
+		for(it = lp->top; NULL != it; it = Iterator_Next(it))
+		{
+			lp->deleter(Iterator_Data(it));
+		}
+	}
+
+	/* release node storage */
+	if(NULL == lp->arena)
+	{
+		for(ch = lp->chunks; NULL != ch; ch = nx)
+		{
+			nx = ch->next;
+			free(ch);
+		}
 	}
+	free(lp->table);
 }
 
 /**
@@ -113,6 +145,113 @@ void delete_List(List** self)
 }
 
 
+/*--------------- node storage ---------------*/
+
+static Iterator* NewNode(List* self, void* data)
+{
+	List_protected* sep = self->pro;
+	IteratorNode* node;
+	ListChunk* ch;
+	size_t n;
+	size_t bytes;
+
+	/* reuse released node */
+	if(NULL != sep->freeNodes)
+	{
+		node = (IteratorNode*)sep->freeNodes;
+		sep->freeNodes = Iterator_Next(sep->freeNodes);
+		Iterator_Init(node, data, self, sep->arena);
+		return &node->it;
+	}
+
+	/* new chunk */
+	if((NULL == sep->chunks) || (sep->chunks->size == sep->chunkUsed))
+	{
+		n = ListChunkFirst;
+		if(NULL != sep->chunks)
+		{
+			n = sep->chunks->size * 2;
+			if(ListChunkNodes < n) n = ListChunkNodes;
+		}
+		bytes = offsetof(ListChunk, nodes) + sizeof(IteratorNode) * n;
+		if(NULL != sep->arena)
+		{
+			ch = sep->arena->Alloc(sep->arena, bytes);
+		}
+		else
+		{
+			ch = malloc(bytes);
+		}
+		assert(ch);
+		ch->next = sep->chunks;
+		ch->size = n;
+		sep->chunks = ch;
+		sep->chunkUsed = 0;
+	}
+
+	node = &sep->chunks->nodes[sep->chunkUsed++];
+	Iterator_Init(node, data, self, sep->arena);
+	return &node->it;
+}
+
+static void ReleaseNode(List* self, Iterator* it)
+{
+	it->pro->next = self->pro->freeNodes;
+	it->pro->data = NULL;
+	self->pro->freeNodes = it;
+}
+
+
+/*--------------- index table ---------------*/
+
+static void TableInvalidate(List_protected* sep)
+{
+	sep->tableValid = false;
+}
+
+static void TableReserve(List_protected* sep, const size_t size)
+{
+	Iterator** tmp;
+	size_t sz;
+
+	if(sep->tableSize >= size) return;
+	sz = (0 == sep->tableSize) ? 64 : sep->tableSize;
+	while(sz < size) sz *= 2;
+	tmp = realloc(sep->table, sizeof(Iterator*) * sz);
+	assert(tmp);
+	sep->table = tmp;
+	sep->tableSize = sz;
+}
+
+static void TableBuild(List_protected* sep)
+{
+	Iterator* it;
+	size_t i;
+
+	TableReserve(sep, sep->length);
+	for(i = 0, it = sep->top; NULL != it; it = Iterator_Next(it), i++)
+	{
+		sep->table[i] = it;
+	}
+	sep->tableHead = 0;
+	sep->tableValid = true;
+}
+
+static void TableAppend(List_protected* sep, Iterator* it)
+{
+	if(false == sep->tableValid) return;
+
+	/* reuse the space of dequeued entries */
+	if((sep->tableHead + sep->length > sep->tableSize) && (sep->tableHead >= sep->length))
+	{
+		memmove(sep->table, &sep->table[sep->tableHead], sizeof(Iterator*) * (sep->length-1));
+		sep->tableHead = 0;
+	}
+	TableReserve(sep, sep->tableHead + sep->length);
+	sep->table[sep->tableHead + sep->length - 1] = it;
+}
+
+
 /*--------------- internal methods ---------------*/
 
 static size_t Length(List* self)
@@ -124,15 +263,13 @@ static size_t Length(List* self)
 static bool PushFront(List* self, void* data)
 {
 	Iterator* it;
-	Iterator_protected* itp;
 	List_protected* sep;
 
 	assert(self);
-	it = new_Iterator(data);
-	itp = it->pro;
+	it = NewNode(self, data);
 	sep = self->pro;
 
-	itp->next = sep->top;
+	it->pro->next = sep->top;
 	if(NULL != sep->top)
 	{
 		sep->top->pro->prev = it;
@@ -143,21 +280,31 @@ static bool PushFront(List* self, void* data)
 		sep->tail = sep->top;
 	}
 	sep->length++;
+
+	if(sep->tableValid)
+	{
+		if(0 == sep->tableHead)
+		{
+			TableInvalidate(sep);
+		}
+		else
+		{
+			sep->table[--sep->tableHead] = it;
+		}
+	}
 	return true;
 }
 
 static bool PushBack(List* self, void* data)
 {
 	Iterator* it;
-	Iterator_protected* itp;
 	List_protected* sep;
 
 	assert(self);
-	it = new_Iterator(data);
-	itp = it->pro;
+	it = NewNode(self, data);
 	sep = self->pro;
 
-	itp->prev = sep->tail;
+	it->pro->prev = sep->tail;
 	if(NULL != sep->tail)
 	{
 		sep->tail->pro->next = it;
@@ -168,13 +315,13 @@ static bool PushBack(List* self, void* data)
 		sep->top = sep->tail;
 	}
 	sep->length++;
+	TableAppend(sep, it);
 	return true;
 }
 
 static void* PopFront(List* self)
 {
 	Iterator* it;
-	Iterator_protected* itp;
 	List_protected* sep;
 	void* data;
 
@@ -186,17 +333,16 @@ static void* PopFront(List* self)
 	}
 
 	/* get data */
-	itp = sep->top->pro;
-	data = itp->data;
+	data = Iterator_Data(sep->top);
 
-	/* delete iterator */
-	it = sep->top->pro->next;
-	delete_Iterator(&sep->top);
+	/* release node */
+	it = Iterator_Next(sep->top);
+	ReleaseNode(self, sep->top);
 
 	/* list update */
 	if(NULL != it)
 	{
-		it->prev = NULL;
+		it->pro->prev = NULL;
 	}
 	sep->top = it;
 	sep->length--;
@@ -204,6 +350,7 @@ static void* PopFront(List* self)
 	{
 		sep->tail = sep->top;
 	}
+	if(sep->tableValid) sep->tableHead++;
 
 	return data;
 }
@@ -211,7 +358,6 @@ static void* PopFront(List* self)
 static void* PopBack(List* self)
 {
 	Iterator* it;
-	Iterator_protected* itp;
 	List_protected* sep;
 	void* data;
 
@@ -223,17 +369,16 @@ static void* PopBack(List* self)
 	}
 
 	/* get data */
-	itp = sep->tail->pro;
-	data = itp->data;
+	data = Iterator_Data(sep->tail);
 
-	/* delete iterator */
-	it = sep->tail->pro->prev;
-	delete_Iterator(&sep->tail);
+	/* release node */
+	it = Iterator_Prev(sep->tail);
+	ReleaseNode(self, sep->tail);
 
 	/* list update */
 	if(NULL != it)
 	{
-		it->next = NULL;
+		it->pro->next = NULL;
 	}
 	sep->tail = it;
 	sep->length--;
@@ -244,42 +389,20 @@ static void* PopBack(List* self)
 
 	return data;
 }
+
 static void* Index(List* self, const size_t inx)
 {
-	Iterator_protected* itp;
 	List_protected* sep;
-	size_t i;
 
 	assert(self);
-
-	/* valid value check */
-	if(0 > inx) return NULL;
-	if(self->pro->length <= inx) return NULL;
-
-	/* list empty check */
 	sep = self->pro;
-	if(NULL == sep->top) return NULL;
 
-	sep = self->pro;
-
-	/* seek from top */
-	if(sep->length/2 > inx)
-	{
-		itp = sep->top->pro;
-		for(i = 0; i != inx; i++)
-		{
-			itp = itp->next->pro; 
-		}
-		return itp->data;
-	}
+	/* valid value check */
+	if(sep->length <= inx) return NULL;
 
-	/* seek from tail */
-	itp = sep->tail->pro;
-	for(i = sep->length-1; i != inx; i--)
-	{
-		itp = itp->prev->pro;
-	}
-	return itp->data;
+	/* O(1) after the table is built */
+	if(false == sep->tableValid) TableBuild(sep);
+	return Iterator_Data(sep->table[sep->tableHead + inx]);
 }
 
 static Iterator* Begin(List* self)
@@ -296,7 +419,6 @@ static Iterator* End(List* self)
 static Iterator* SearchEx(List* self, const void* data, ListSearcher_t match, Iterator* beg, const bool isPrevSearch)
 {
 	Iterator* it;
-	Iterator_protected* itp;
 	assert(self);
 
 	it = self->pro->top;
@@ -311,26 +433,22 @@ static Iterator* SearchEx(List* self, const void* data, ListSearcher_t match, It
 
 	if(false == isPrevSearch)
 	{
-		while(NULL != it)
+		for(; NULL != it; it = Iterator_Next(it))
 		{
-			itp = it->pro;
-			if(true == match(data, itp->data))
+			if(true == match(data, Iterator_Data(it)))
 			{
 				return it;
 			}
-			it = itp->next;
 		}
 		return NULL;
 	}
 
-	while(NULL != it)
+	for(; NULL != it; it = Iterator_Prev(it))
 	{
-		itp = it->pro;
-		if(true == match(data, itp->data))
+		if(true == match(data, Iterator_Data(it)))
 		{
 			return it;
 		}
-		it = itp->prev;
 	}
 	return NULL;
 }
@@ -351,18 +469,76 @@ static List* Clone(List* src)
 	assert(src);
 
 	srp = src->pro;
-	sit = srp->top;
-	dest = new_List(srp->cloner, srp->deleter);
+	dest = new_ListEx(srp->cloner, srp->deleter, srp->arena);
 	assert(dest);
 
-	while(sit != NULL)
+	for(sit = srp->top; NULL != sit; sit = Iterator_Next(sit))
 	{
-		data = srp->cloner(sit->data(sit));
+		data = srp->cloner(Iterator_Data(sit));
 		assert(data);
 		dest->push(dest, data);
-		sit = sit->next(sit);
 	}
 
 	return dest;
 }
 
+
+/*--------------- node operations for Iterator ---------------*/
+
+/**
+ * insert data before the node
+ */
+bool List_InsertBefore(List* self, Iterator* pos, void* data)
+{
+	Iterator* it;
+	Iterator* itPrev;
+	List_protected* sep;
+
+	assert(self);
+	assert(pos);
+	sep = self->pro;
+
+	itPrev = Iterator_Prev(pos);
+	if(NULL == itPrev)
+	{
+		return PushFront(self, data);
+	}
+
+	it = NewNode(self, data);
+	it->pro->prev = itPrev;
+	it->pro->next = pos;
+	itPrev->pro->next = it;
+	pos->pro->prev = it;
+	sep->length++;
+	TableInvalidate(sep);
+	return true;
+}
+
+/**
+ * remove the node
+ */
+void List_Remove(List* self, Iterator* it, const bool isKeepData)
+{
+	List_protected* sep;
+	Iterator* itPrev;
+	Iterator* itNext;
+
+	assert(self);
+	assert(it);
+	sep = self->pro;
+
+	itPrev = Iterator_Prev(it);
+	itNext = Iterator_Next(it);
+	if(NULL != itPrev) itPrev->pro->next = itNext;
+	else sep->top = itNext;
+	if(NULL != itNext) itNext->pro->prev = itPrev;
+	else sep->tail = itPrev;
+
+	if((false == isKeepData) && (NULL != sep->deleter))
+	{
+		sep->deleter(Iterator_Data(it));
+	}
+	ReleaseNode(self, it);
+	sep->length--;
+	TableInvalidate(sep);
+}
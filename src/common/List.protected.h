@@ -3,9 +3,22 @@
  * List.protected.h
  */
 
+/**
+ * node storage chunk
+ *   The chunk size is doubled from ListChunkFirst up to ListChunkNodes,
+ *   so that a short list doesn't waste the memory.
+ */
+#define ListChunkFirst 4
+#define ListChunkNodes 64
+typedef struct _ListChunk ListChunk;
+struct _ListChunk {
+	ListChunk* next;
+	size_t size;
+	IteratorNode nodes[1];
+};
+
 /**
  * List main instance
- *   TODO : Fix it
  */
 struct _List_protected {
 	Iterator* top;
@@ -13,6 +26,16 @@ struct _List_protected {
 	size_t length;
 	ListDataCloner_t cloner;
 	ListDataDeleter_t deleter;
+	/* node storage */
+	Arena* arena;
+	ListChunk* chunks;
+	size_t chunkUsed;
+	Iterator* freeNodes;
+	/* index table(built by index method) */
+	Iterator** table;
+	size_t tableHead;
+	size_t tableSize;
+	bool tableValid;
 };
 
 /**
@@ -22,3 +45,8 @@ struct _List_protected {
  */
 void delete_List_members(List*);
 
+/**
+ * node operations for Iterator
+ */
+bool List_InsertBefore(List*, Iterator*, void*);
+void List_Remove(List*, Iterator*, const bool);
@@ -0,0 +1,258 @@
+/**
+ * FileWatch.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define WATCH_POSIX
+#  if defined(__linux__)
+#    define WATCH_INOTIFY
+#  endif
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <signal.h>
+#ifdef WATCH_POSIX
+#  include <errno.h>
+#  include <time.h>
+#  include <unistd.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+#ifdef WATCH_INOTIFY
+#  include <poll.h>
+#  include <sys/inotify.h>
+#endif
+#include "common/Str.h"
+#include "file/FileWatch.h"
+
+/* the stop flag is checked in this interval(msec) */
+#define PollMs		100
+
+/**
+ * FileWatch private members
+ */
+struct _FileWatch_private {
+	char*		dir;
+	char*		name;
+	volatile sig_atomic_t	stopped;
+#ifdef WATCH_INOTIFY
+	int		fd;
+#elif defined(WATCH_POSIX)
+	char*		path;
+	time_t		mtime;
+	off_t		size;
+#endif
+};
+
+/* prototypes */
+static bool Wait(FileWatch*, const int);
+static void Stop(FileWatch*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create FileWatch object
+ *
+ * @param path watched file
+ *
+ * @return the pointer of object
+ */
+FileWatch* new_FileWatch(const char* path)
+{
+	FileWatch* self;
+	FileWatch_private* pri;
+	const char* slash;
+
+	assert(path);
+
+	/* make objects */
+	self = malloc(sizeof(FileWatch));
+	pri = malloc(sizeof(FileWatch_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	slash = strrchr(path, '/');
+	if(NULL == slash)
+	{
+		pri->dir = Str_copy(".");
+		pri->name = Str_copy(path);
+	}
+	else
+	{
+		pri->dir = Str_copy(path);
+		pri->dir[slash - path + 1] = '\0';
+		pri->name = Str_copy(slash + 1);
+	}
+	pri->stopped = 0;
+#ifdef WATCH_INOTIFY
+	/* IN_CLOSE_WRITE isn't used, RomFile opens the rom with "rb+" */
+	pri->fd = inotify_init();
+	if((0 <= pri->fd)
+	&& (0 > inotify_add_watch(pri->fd, pri->dir, IN_MODIFY | IN_MOVED_TO)))
+	{
+		close(pri->fd);
+		pri->fd = -1;
+	}
+#elif defined(WATCH_POSIX)
+	{
+		struct stat st;
+
+		pri->path = Str_copy(path);
+		pri->mtime = 0;
+		pri->size = 0;
+		if(0 == stat(path, &st))
+		{
+			pri->mtime = st.st_mtime;
+			pri->size = st.st_size;
+		}
+	}
+#endif
+
+	/*--- set public member ---*/
+	self->Wait = Wait;
+	self->Stop = Stop;
+
+	/* init FileWatch object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete FileWatch object
+ *
+ * @param the pointer of object
+ */
+void delete_FileWatch(FileWatch** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+#ifdef WATCH_INOTIFY
+	if(0 <= (*self)->pri->fd) close((*self)->pri->fd);
+#elif defined(WATCH_POSIX)
+	free((*self)->pri->path);
+#endif
+	free((*self)->pri->dir);
+	free((*self)->pri->name);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+#ifdef WATCH_INOTIFY
+/**
+ * Read the events
+ *   return:
+ *     If the watched file is written, return true.
+ */
+static bool ReadEvents(FileWatch_private* pri)
+{
+	union {
+		struct inotify_event ev;
+		char buf[4096];
+	} events;
+	const struct inotify_event* ev;
+	ssize_t len;
+	ssize_t i;
+	bool result = false;
+
+	len = read(pri->fd, events.buf, sizeof(events.buf));
+	for(i=0; i<len; i+=(ssize_t)(sizeof(struct inotify_event) + ev->len))
+	{
+		ev = (const struct inotify_event*)&events.buf[i];
+		if(IN_Q_OVERFLOW & ev->mask) result = true;
+		if((0 != ev->len) && (0 == strcmp(ev->name, pri->name))) result = true;
+	}
+	return result;
+}
+
+static bool Wait(FileWatch* self, const int quietMs)
+{
+	FileWatch_private* pri;
+	struct pollfd pfd;
+	bool pending = false;
+	int n;
+
+	assert(self);
+	pri = self->pri;
+	if(0 > pri->fd) return false;
+
+	pfd.fd = pri->fd;
+	pfd.events = POLLIN;
+	while(0 == pri->stopped)
+	{
+		n = poll(&pfd, 1, pending ? quietMs : PollMs);
+		if(0 > n)
+		{
+			if(EINTR == errno) continue;
+			return false;
+		}
+		if(0 == n)
+		{
+			/* no write in the quiet time */
+			if(pending) return true;
+			continue;
+		}
+		if(ReadEvents(pri)) pending = true;
+	}
+	return false;
+}
+#elif defined(WATCH_POSIX)
+static void Sleep(const int ms)
+{
+	struct timespec ts;
+
+	ts.tv_sec = ms / 1000;
+	ts.tv_nsec = (long)(ms % 1000) * 1000000L;
+	nanosleep(&ts, NULL);
+}
+
+static bool Wait(FileWatch* self, const int quietMs)
+{
+	FileWatch_private* pri;
+	struct stat st;
+	bool pending = false;
+	int quiet = 0;
+
+	assert(self);
+	pri = self->pri;
+
+	while(0 == pri->stopped)
+	{
+		Sleep(PollMs);
+		if((0 == stat(pri->path, &st))
+		&& ((st.st_mtime != pri->mtime) || (st.st_size != pri->size)))
+		{
+			pri->mtime = st.st_mtime;
+			pri->size = st.st_size;
+			pending = true;
+			quiet = 0;
+			continue;
+		}
+		quiet += PollMs;
+		if(pending && (quietMs <= quiet)) return true;
+	}
+	return false;
+}
+#else
+static bool Wait(FileWatch* self, const int quietMs)
+{
+	(void)self;
+	(void)quietMs;
+	return false;
+}
+#endif
+
+static void Stop(FileWatch* self)
+{
+	assert(self);
+	self->pri->stopped = 1;
+}
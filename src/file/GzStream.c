@@ -0,0 +1,282 @@
+/**
+ * GzStream.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define GZ_THREAD
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#ifdef GZ_THREAD
+#  include <pthread.h>
+#endif
+#include "common/ReadWrite.h"
+#include "common/Deflate.h"
+#include "file/GzStream.h"
+
+#define StreamBufferSize	(256*1024)
+
+/**
+ * GzStream private members
+ */
+struct _GzStream_private {
+	FILE*		fp;
+	Deflate*	def;
+	uint32		crc;
+	uint32		isize;
+	bool		closed;
+	bool		failed;
+	/* caller side buffer */
+	uint8*		fill;
+	size_t		fillLen;
+	/* compressor side buffer */
+	uint8*		work;
+	size_t		workLen;
+#ifdef GZ_THREAD
+	pthread_t	thread;
+	pthread_mutex_t	mutex;
+	pthread_cond_t	cond;
+	bool		busy;
+	bool		quit;
+#endif
+};
+
+/* prototypes */
+static bool Write(GzStream*, const void*, const size_t);
+static bool Close(GzStream*);
+static bool WriteFile(void*, const uint8*, const size_t);
+#ifdef GZ_THREAD
+static void* Worker(void*);
+#endif
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create GzStream object
+ *
+ * @return the pointer of object
+ */
+GzStream* new_GzStream(FILE* fp)
+{
+	static const uint8 header[10] = {
+		0x1f, 0x8b,		/* magic */
+		0x08,			/* deflate */
+		0x00,			/* flags */
+		0x00, 0x00, 0x00, 0x00,	/* mtime */
+		0x00,			/* extra flags */
+		0xff			/* OS (unknown) */
+	};
+	GzStream* self;
+	GzStream_private* pri;
+
+	assert(fp);
+
+	/* make objects */
+	self = malloc(sizeof(GzStream));
+	pri = malloc(sizeof(GzStream_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->fp = fp;
+	pri->def = new_Deflate(WriteFile, pri);
+	pri->crc = 0;
+	pri->isize = 0;
+	pri->closed = false;
+	pri->failed = false;
+	pri->fill = malloc(StreamBufferSize);
+	pri->work = malloc(StreamBufferSize);
+	assert(pri->fill);
+	assert(pri->work);
+	pri->fillLen = 0;
+	pri->workLen = 0;
+
+	if(sizeof(header) != fwrite(header, sizeof(uint8), sizeof(header), fp))
+	{
+		pri->failed = true;
+	}
+
+#ifdef GZ_THREAD
+	pri->busy = false;
+	pri->quit = false;
+	pthread_mutex_init(&pri->mutex, NULL);
+	pthread_cond_init(&pri->cond, NULL);
+	if(0 != pthread_create(&pri->thread, NULL, Worker, pri))
+	{
+		/* It can't run without the thread */
+		pri->failed = true;
+		pri->closed = true;
+	}
+#endif
+
+	/*--- set public member ---*/
+	self->Write = Write;
+	self->Close = Close;
+
+	/* init GzStream object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete GzStream object
+ *
+ * @param the pointer of object
+ */
+void delete_GzStream(GzStream** self)
+{
+	GzStream_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	Close(*self);
+#ifdef GZ_THREAD
+	pthread_mutex_destroy(&pri->mutex);
+	pthread_cond_destroy(&pri->cond);
+#endif
+	delete_Deflate(&pri->def);
+	free(pri->fill);
+	free(pri->work);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static bool WriteFile(void* param, const uint8* data, const size_t len)
+{
+	GzStream_private* pri = (GzStream_private*)param;
+	return (len == fwrite(data, sizeof(uint8), len, pri->fp));
+}
+
+/* compress the work buffer */
+static void Compress(GzStream_private* pri)
+{
+	pri->crc = Deflate_Crc32(pri->crc, pri->work, pri->workLen);
+	pri->isize += (uint32)pri->workLen;
+	if(false == pri->def->Put(pri->def, pri->work, pri->workLen))
+	{
+		pri->failed = true;
+	}
+	pri->workLen = 0;
+}
+
+#ifdef GZ_THREAD
+static void* Worker(void* param)
+{
+	GzStream_private* pri = (GzStream_private*)param;
+
+	while(true)
+	{
+		pthread_mutex_lock(&pri->mutex);
+		while((false == pri->busy) && (false == pri->quit))
+		{
+			pthread_cond_wait(&pri->cond, &pri->mutex);
+		}
+		if(false == pri->busy)
+		{
+			pthread_mutex_unlock(&pri->mutex);
+			break;
+		}
+		pthread_mutex_unlock(&pri->mutex);
+
+		Compress(pri);
+
+		pthread_mutex_lock(&pri->mutex);
+		pri->busy = false;
+		pthread_cond_signal(&pri->cond);
+		pthread_mutex_unlock(&pri->mutex);
+	}
+	return NULL;
+}
+#endif
+
+/* pass the filled buffer to the compressor */
+static void Submit(GzStream_private* pri)
+{
+	uint8* tmp;
+
+	if(0 == pri->fillLen) return;
+#ifdef GZ_THREAD
+	pthread_mutex_lock(&pri->mutex);
+	while(pri->busy)
+	{
+		pthread_cond_wait(&pri->cond, &pri->mutex);
+	}
+#endif
+	tmp = pri->work;
+	pri->work = pri->fill;
+	pri->workLen = pri->fillLen;
+	pri->fill = tmp;
+	pri->fillLen = 0;
+#ifdef GZ_THREAD
+	pri->busy = true;
+	pthread_cond_signal(&pri->cond);
+	pthread_mutex_unlock(&pri->mutex);
+#else
+	Compress(pri);
+#endif
+}
+
+static bool Write(GzStream* self, const void* data, const size_t len)
+{
+	GzStream_private* pri;
+	const uint8* p = (const uint8*)data;
+	size_t n;
+	size_t i;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->closed) return false;
+
+	for(i=0; i<len; i+=n)
+	{
+		n = StreamBufferSize - pri->fillLen;
+		if(len - i < n) n = len - i;
+		memcpy(&pri->fill[pri->fillLen], &p[i], n);
+		pri->fillLen += n;
+		if(StreamBufferSize == pri->fillLen) Submit(pri);
+	}
+	return !pri->failed;
+}
+
+static bool Close(GzStream* self)
+{
+	GzStream_private* pri;
+	uint8 trailer[8];
+
+	assert(self);
+	pri = self->pri;
+	if(pri->closed) return !pri->failed;
+	pri->closed = true;
+
+	Submit(pri);
+#ifdef GZ_THREAD
+	pthread_mutex_lock(&pri->mutex);
+	pri->quit = true;
+	pthread_cond_signal(&pri->cond);
+	pthread_mutex_unlock(&pri->mutex);
+	pthread_join(pri->thread, NULL);
+#endif
+
+	if(false == pri->def->Finish(pri->def))
+	{
+		pri->failed = true;
+	}
+	write32(&trailer[0], pri->crc);
+	write32(&trailer[4], pri->isize);
+	if(sizeof(trailer) != fwrite(trailer, sizeof(uint8), sizeof(trailer), pri->fp))
+	{
+		pri->failed = true;
+	}
+	return !pri->failed;
+}
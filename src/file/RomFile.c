@@ -332,7 +332,7 @@ static uint32 LoRom_Pc2Snes(RomFile* self, const uint32 pca)
 }
 
 /*===== SA-1(LoRom) =====*/
-static uint32 SA1_Snes2Pc(RomFile* self, const uint32 sna)
+uint32 RomFile_SA1Snes2Pc(const long size, const SA1AdrInfo* inf, const uint32 sna)
 {
 	uint32 pca;
 	int slot;
@@ -386,46 +386,46 @@ static uint32 SA1_Snes2Pc(RomFile* self, const uint32 sna)
 
 	if(useHiRomMap)
 	{
-		pca = (uint32)((((self->pro->sa1adrinf.slots[slot])+((uint32)bnk&0x0f)) << 16) + ((uint32)sna & 0xffff));
+		pca = (uint32)((((inf->slots[slot])+((uint32)bnk&0x0f)) << 16) + ((uint32)sna & 0xffff));
 	}
 	else
 	{
 		if(0 == (sna & 0x8000)) return ROMADDRESS_NULL;
-		pca = (uint32)(((uint32)self->pro->sa1adrinf.slots[slot] << 16) + (((uint32)bnk&0x1f) << 15) + ((uint32)sna & 0x7fff));
+		pca = (uint32)(((uint32)inf->slots[slot] << 16) + (((uint32)bnk&0x1f) << 15) + ((uint32)sna & 0x7fff));
 	}
 
-	if(self->pro->size <= pca) return ROMADDRESS_NULL;
+	if(size <= pca) return ROMADDRESS_NULL;
 	return pca;
 }
-static uint32 SA1_Pc2Snes(RomFile* self, const uint32 pca)
+uint32 RomFile_SA1Pc2Snes(const long size, const SA1AdrInfo* inf, const uint32 pca)
 {
 	int i;
 	uint8 bnk = (uint8)(pca>>16);
 	uint32 add = 0;
 
-	if(self->pro->size <= pca) return ROMADDRESS_NULL;
+	if(size <= pca) return ROMADDRESS_NULL;
 	if(0x800000 <= pca) return ROMADDRESS_NULL;
 
 	/* HiRom map */
-	if(self->pro->sa1adrinf.useHiRomMap)
+	if(inf->useHiRomMap)
 	{
 		for(i=0; i<4; i++)
 		{
-			if(self->pro->sa1adrinf.slots[i] <= bnk
-					&& self->pro->sa1adrinf.slots[i] + 16 > bnk)
+			if(inf->slots[i] <= bnk
+					&& inf->slots[i] + 16 > bnk)
 			{
 				break;
 			}
 		}
 		if(4 <= i) return ROMADDRESS_NULL;
-		return (((((self->pro->sa1adrinf.slots[i] & 0x7f) + ((uint32)bnk & 0x0f)) << 16) + (((uint32)pca&0xffff))) | 0xc00000);
+		return (((((inf->slots[i] & 0x7f) + ((uint32)bnk & 0x0f)) << 16) + (((uint32)pca&0xffff))) | 0xc00000);
 	}
 
 	/* LoRom map */
 	for(i=0; i<4; i++)
 	{
-		if(self->pro->sa1adrinf.slots[i] <= bnk
-		&& self->pro->sa1adrinf.slots[i] + 16 > bnk)
+		if(inf->slots[i] <= bnk
+		&& inf->slots[i] + 16 > bnk)
 		{
 			break;
 		}
@@ -450,6 +450,19 @@ static uint32 SA1_Pc2Snes(RomFile* self, const uint32 pca)
 	return (((add + ((uint32)bnk & 0x0f)) << 16) + (((uint32)pca&0x17fff)|0x8000));
 }
 
+static uint32 SA1_Snes2Pc(RomFile* self, const uint32 sna)
+{
+	return RomFile_SA1Snes2Pc(self->pro->size, &self->pro->sa1adrinf, sna);
+}
+static uint32 SA1_Pc2Snes(RomFile* self, const uint32 pca)
+{
+	return RomFile_SA1Pc2Snes(self->pro->size, &self->pro->sa1adrinf, pca);
+}
+bool RomFile_IsSA1(RomFile* self)
+{
+	return (SA1_Snes2Pc == self->Snes2PcAdr);
+}
+
 /*===== HiRom =====*/
 static uint32 HiRom_Snes2Pc(RomFile* self, const uint32 sna)
 {
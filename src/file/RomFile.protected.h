@@ -31,3 +31,11 @@ struct _RomFile_protected {
  */
 void delete_RomFile_members(RomFile*);
 
+
+/**
+ * SA-1 address conversion with the given slot configuration
+ *   They don't touch the object, so RomView uses them for its own slots.
+ */
+uint32 RomFile_SA1Snes2Pc(const long, const SA1AdrInfo*, const uint32);
+uint32 RomFile_SA1Pc2Snes(const long, const SA1AdrInfo*, const uint32);
+bool RomFile_IsSA1(RomFile*);
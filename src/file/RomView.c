@@ -0,0 +1,246 @@
+/**
+ * RomView.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include "common/Str.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+
+/* the tables are built from the protected members of RomFile */
+#include "RomFile.protected.h"
+
+/* the conversion is linear in each 32KB block */
+#define BlockBits	15
+#define BlockMask	0x7fff
+#define SnesBlocks	(0x1000000 >> BlockBits)
+#define PcBlocks	(0x800000 >> BlockBits)
+
+/**
+ * RomView private members
+ *   Nothing is changed after the construction.
+ */
+struct _RomView_private {
+	char*		path;
+	const uint8*	rom;
+	uint32		size;
+	RomType		type;
+	MapMode		map;
+	SA1AdrInfo	sa1adrinf;
+	uint32		snes2pc[SnesBlocks];	/* pc address of each snes block */
+	uint32		pc2snes[PcBlocks];	/* snes address of each pc block */
+};
+
+/* prototypes */
+static const char* path_get(const RomView*);
+static uint32 size_get(const RomView*);
+static RomType type_get(const RomView*);
+static MapMode mapmode_get(const RomView*);
+static const uint8* GetSnesPtr(const RomView*, const uint32);
+static const uint8* GetPcPtr(const RomView*, const uint32);
+static uint32 Pc2SnesAdr(const RomView*, const uint32);
+static uint32 Snes2PcAdr(const RomView*, const uint32);
+static void BuildTables(RomView_private*, RomFile*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create RomView object
+ *
+ * @param rom opened RomFile
+ *
+ * @return the pointer of object
+ */
+RomView* new_RomView(RomFile* rom)
+{
+	assert(rom);
+	return new_RomViewSA1(rom, rom->pro->sa1adrinf.useHiRomMap);
+}
+
+/**
+ * @brief Create RomView object with the SA-1 map
+ *
+ * @param rom opened RomFile
+ * @param useHiRomMap convert pc address to the HiRom map
+ *
+ * @return the pointer of object
+ */
+RomView* new_RomViewSA1(RomFile* rom, const bool useHiRomMap)
+{
+	RomView* self;
+	RomView_private* pri;
+
+	assert(rom);
+
+	/* make objects */
+	self = malloc(sizeof(RomView));
+	pri = malloc(sizeof(RomView_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->path = Str_copy(rom->super.path_get(&rom->super));
+	pri->rom = rom->pro->rom;
+	pri->size = (NULL == rom->pro->rom) ? 0 : (uint32)rom->pro->size;
+	pri->type = rom->pro->type;
+	pri->map = rom->pro->map;
+	pri->sa1adrinf = rom->pro->sa1adrinf;
+	pri->sa1adrinf.useHiRomMap = useHiRomMap;
+	BuildTables(pri, rom);
+
+	/*--- set public member ---*/
+	self->path_get = path_get;
+	self->size_get = size_get;
+	self->type_get = type_get;
+	self->mapmode_get = mapmode_get;
+	self->GetSnesPtr = GetSnesPtr;
+	self->GetPcPtr = GetPcPtr;
+	self->Pc2SnesAdr = Pc2SnesAdr;
+	self->Snes2PcAdr = Snes2PcAdr;
+
+	/* init RomView object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete RomView object
+ *
+ * @param the pointer of object
+ */
+void delete_RomView(RomView** self)
+{
+	RomView_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (RomView_private*)(*self)->pri;
+
+	free(pri->path);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+/**
+ * @brief Build the conversion tables
+ *
+ * The head address of each block is converted by RomFile, and the rest
+ * of the block is derived from it.
+ */
+static void BuildTables(RomView_private* pri, RomFile* rom)
+{
+	const bool isSA1 = RomFile_IsSA1(rom);
+	uint32 i;
+
+	for(i=0; i<SnesBlocks; i++)
+	{
+		if(0 == pri->size)
+		{
+			pri->snes2pc[i] = ROMADDRESS_NULL;
+		}
+		else if(isSA1)
+		{
+			pri->snes2pc[i] = RomFile_SA1Snes2Pc((long)pri->size, &pri->sa1adrinf, i << BlockBits);
+		}
+		else
+		{
+			pri->snes2pc[i] = rom->Snes2PcAdr(rom, i << BlockBits);
+		}
+	}
+
+	for(i=0; i<PcBlocks; i++)
+	{
+		if(0 == pri->size)
+		{
+			pri->pc2snes[i] = ROMADDRESS_NULL;
+		}
+		else if(isSA1)
+		{
+			pri->pc2snes[i] = RomFile_SA1Pc2Snes((long)pri->size, &pri->sa1adrinf, i << BlockBits);
+		}
+		else
+		{
+			pri->pc2snes[i] = rom->Pc2SnesAdr(rom, i << BlockBits);
+		}
+	}
+}
+
+static const char* path_get(const RomView* self)
+{
+	assert(self);
+	return self->pri->path;
+}
+
+static uint32 size_get(const RomView* self)
+{
+	assert(self);
+	return self->pri->size;
+}
+
+static RomType type_get(const RomView* self)
+{
+	assert(self);
+	return self->pri->type;
+}
+
+static MapMode mapmode_get(const RomView* self)
+{
+	assert(self);
+	return self->pri->map;
+}
+
+static uint32 Snes2PcAdr(const RomView* self, const uint32 sna)
+{
+	uint32 pca;
+
+	assert(self);
+	if((SnesBlocks << BlockBits) <= sna) return ROMADDRESS_NULL;
+
+	pca = self->pri->snes2pc[sna >> BlockBits];
+	if(ROMADDRESS_NULL == pca) return ROMADDRESS_NULL;
+	pca += (sna & BlockMask);
+	if(self->pri->size <= pca) return ROMADDRESS_NULL;
+	return pca;
+}
+
+static uint32 Pc2SnesAdr(const RomView* self, const uint32 pca)
+{
+	uint32 sna;
+
+	assert(self);
+	if(self->pri->size <= pca) return ROMADDRESS_NULL;
+	if((PcBlocks << BlockBits) <= pca) return ROMADDRESS_NULL;
+
+	sna = self->pri->pc2snes[pca >> BlockBits];
+	if(ROMADDRESS_NULL == sna) return ROMADDRESS_NULL;
+	return sna + (pca & BlockMask);
+}
+
+static const uint8* GetSnesPtr(const RomView* self, const uint32 sna)
+{
+	uint32 pca;
+
+	assert(self);
+	pca = Snes2PcAdr(self, sna);
+	if(ROMADDRESS_NULL == pca) return NULL;
+
+	return &self->pri->rom[pca];
+}
+
+static const uint8* GetPcPtr(const RomView* self, const uint32 pca)
+{
+	assert(self);
+	if(ROMADDRESS_NULL == Pc2SnesAdr(self, pca)) return NULL;
+
+	return &self->pri->rom[pca];
+}
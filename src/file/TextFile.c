@@ -1,6 +1,9 @@
 /**
  * TextFile.c
  */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#endif
 #include "common/types.h"
 #include <stdlib.h>
 #include <memory.h>
@@ -11,12 +14,18 @@
 #include "file/File.h"
 #include "File.protected.h" /* inherit */
 #include "file/TextFile.h"
+#include "file/GzStream.h"
 
 /* this header isn't read from anything other */
 /* than inherited object.                     */ 
 #include "TextFile.protected.h"
 
 #define BuffLen 256
+#define PrintLen 1024
+
+#if defined(_MSC_VER)
+#  define vsnprintf _vsnprintf
+#endif
 
 /* prototypes */
 /* overrides */
@@ -26,6 +35,9 @@ static E_FileOpen Open2(TextFile*, const char*);
 static uint row_get(TextFile*);
 static const char* GetLine(TextFile*);
 static void Printf(TextFile*, const char*, ...);
+static bool Write(TextFile*, const void*, const size_t);
+static bool Close(TextFile*);
+static void compress_set(TextFile*, const bool);
 
 
 /*--------------- Constructor / Destructor ---------------*/
@@ -57,6 +69,8 @@ TextFile* new_TextFile(const char* path)
 	/*--- set protected member ---*/
 	pro->line = 0;
 	pro->lineBuffer = NULL;
+	pro->compress = false;
+	pro->gz = NULL;
 
 	/*--- set public member ---*/
 	self->Open = Open;
@@ -64,6 +78,9 @@ TextFile* new_TextFile(const char* path)
 	self->row_get = row_get;
 	self->GetLine = GetLine;
 	self->Printf = Printf;
+	self->Write = Write;
+	self->Close = Close;
+	self->compress_set = compress_set;
 
 	/* init TextFile object */
 	self->pro = pro;
@@ -77,6 +94,9 @@ TextFile* new_TextFile(const char* path)
  */
 void delete_TextFile_members(TextFile* self)
 {
+	/* complete the compressed stream */
+	delete_GzStream(&self->pro->gz);
+
 	/* delete super members */
 	delete_File_members(&self->super);
 
@@ -170,14 +190,84 @@ static void Printf(TextFile* self, const char* fmt, ...)
 {
 	FILE* fp;
 	va_list vl;
+	char buf[PrintLen];
+	char* p;
+	int len;
 
 	assert(self);
+	if(NULL != self->pro->gz)
+	{
+		va_start(vl, fmt);
+		len = vsnprintf(buf, PrintLen, fmt, vl);
+		va_end(vl);
+		if(0 > len) return;
+		if(PrintLen > len)
+		{
+			self->pro->gz->Write(self->pro->gz, buf, (size_t)len);
+			return;
+		}
+
+		/* long text */
+		p = malloc((size_t)len+1);
+		assert(p);
+		va_start(vl, fmt);
+		vsnprintf(p, (size_t)len+1, fmt, vl);
+		va_end(vl);
+		self->pro->gz->Write(self->pro->gz, p, (size_t)len);
+		free(p);
+		return;
+	}
+
 	fp = self->super.pro->fp;
 	va_start(vl, fmt);
 	vfprintf(fp, fmt, vl);
 	va_end(vl);
 }
 
+static bool Write(TextFile* self, const void* data, const size_t len)
+{
+	FILE* fp;
+
+	assert(self);
+	if(NULL != self->pro->gz)
+	{
+		return self->pro->gz->Write(self->pro->gz, data, len);
+	}
+	fp = self->super.pro->fp;
+	return (len == fwrite(data, sizeof(uint8), len, fp));
+}
+
+static bool Close(TextFile* self)
+{
+	bool result = true;
+
+	assert(self);
+	if(NULL != self->pro->gz)
+	{
+		result = self->pro->gz->Close(self->pro->gz);
+		delete_GzStream(&self->pro->gz);
+	}
+	self->super.Close(&self->super);
+	return result;
+}
+
+static void compress_set(TextFile* self, const bool compress)
+{
+	assert(self);
+	self->pro->compress = compress;
+}
+
+static bool IsCompressed(TextFile* self, const char* mode)
+{
+	const char* ext;
+
+	if(('w' != mode[0]) && ('a' != mode[0])) return false;
+	if(self->pro->compress) return true;
+
+	ext = self->super.ext_get(&self->super);
+	return ((NULL != ext) && (0 == strcmp(".gz", ext)));
+}
+
 static E_FileOpen Open2(TextFile* self, const char* mode)
 {
 	File_protected* filep;
@@ -198,6 +288,23 @@ static E_FileOpen Open2(TextFile* self, const char* mode)
 	}
 
 	textp->line = 0;
+	if((NULL != filep->mode) && IsCompressed(self, filep->mode))
+	{
+		E_FileOpen result;
+
+		/* gzip stream is always binary */
+		if(NULL == strchr(filep->mode, 'b'))
+		{
+			char* tmp = Str_concat(filep->mode, "b");
+			assert(tmp);
+			free(filep->mode);
+			filep->mode = tmp;
+		}
+		result = self->super.Open(&self->super);
+		if(FileOpen_NoError != result) return result;
+		textp->gz = new_GzStream(filep->fp);
+		return FileOpen_NoError;
+	}
 	return self->super.Open(&self->super);
 }
 
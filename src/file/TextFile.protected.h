@@ -10,6 +10,9 @@ struct _TextFile_protected {
 	/* member */
 	char* lineBuffer;
 	uint line;
+	/* compressed output */
+	bool compress;
+	GzStream* gz;
 };
 
 /**
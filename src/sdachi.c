@@ -2,14 +2,42 @@
  * sdachi.c
  */
 #include "common/types.h"
+#include <signal.h>
+#include <time.h>
+#include "common/puts.h"
 #include "common/Option.h"
+#include "common/Iterator.h"
+#include "common/List.h"
+#include "common/Str.h"
 #include "file/FilePath.h"
 #include "file/File.h"
 #include "file/TextFile.h"
 #include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/FileWatch.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
 #include "sdachi/DisAsm.h"
+#include "sdachi/Server.h"
+#include "sdachi/ResultCache.h"
+#include "sdachi/RomDiff.h"
+#include "sdachi/Batch.h"
+#include "sdachi/BankStore.h"
+#include "sdachi/Signature.h"
+#include "sdachi/SigSearch.h"
 #include "sdachi/version.h"
 
+/* the running server / watcher(stopped by the signal) */
+static Server* server = NULL;
+static FileWatch* watch = NULL;
+
+/* the shared bank-local traces(--bank-store) */
+static BankStore* banks = NULL;
+
+/* debounce time of the rom change(msec) */
+#define WatchQuietMs	50
+
 static void ShowUsage(const char* pg, const OptionStruct* opt)
 {
 	printf("Usage: %s [options] <rom>\n", pg);
@@ -24,19 +52,79 @@ static void ShowVersion()
 	printf("  compiled : %s\n", __DATE__);
 }
 
-static bool DisassembleRom(const char* rompath, DisAsmInf* inf, bool (*dis)(RomFile*, TextFile*, DisAsmInf*))
+static TextFile* OpenOutput(const char* path, const char* mode, const bool compress, bool* ok)
+{
+	TextFile* f;
+
+	if(NULL == path) return NULL;
+
+	f = new_TextFile(path);
+	f->compress_set(f, compress);
+	if(FileOpen_NoError != f->Open2(f, mode))
+	{
+		puterror("Can't open \"%s\".", path);
+		delete_TextFile(&f);
+		(*ok) = false;
+	}
+	return f;
+}
+
+static bool CloseOutput(TextFile** f)
+{
+	bool result = true;
+
+	if(NULL == (*f)) return true;
+
+	if(false == (*f)->Close(*f))
+	{
+		puterror("Write failed : %s", (*f)->super.path_get(&(*f)->super));
+		result = false;
+	}
+	printf("Output: %s\n", (*f)->super.path_get(&(*f)->super));
+	delete_TextFile(f);
+	return result;
+}
+
+/* --entry argument */
+static bool PushEntry(void* param, const char* arg)
+{
+	List* entries = (List*)param;
+
+	return entries->push(entries, (void*)arg);
+}
+
+static bool DisassembleRom(const char* rompath, const DisAsmInf* inf, List* entries, const bool incremental)
 {
 	RomFile* from;
 	TextFile* fasm;
+	TextFile* fjson;
+	TextFile* fcsv;
+	TextFile* fbin;
 	FilePath* fpath;
+	DisAsmContext* ctx;
+	DisAsmInf dbinf;
+	Iterator* it;
+	uint32 snesadr;
+	uint16 psw;
+	bool ok = true;
 	bool result;
 
+	/* the entry points */
+	List_Foreach(entries, it)
+	{
+		if(false == DisAsm_ParseEntry((const char*)Iterator_Data(it), inf, &snesadr, &psw))
+		{
+			puterror("Invalid entry point : %s", (const char*)Iterator_Data(it));
+			return false;
+		}
+	}
+
 	from = new_RomFile(rompath);
 
 	if(NULL == inf->outputPath)
 	{
 		fpath = new_FilePath(rompath);
-		fpath->ext_set(fpath, ".asm");
+		fpath->ext_set(fpath, inf->compressOutput ? ".asm.gz" : ".asm");
 		fasm = new_TextFile(fpath->path_get(fpath));
 		delete_FilePath(&fpath);
 	}
@@ -44,6 +132,7 @@ static bool DisassembleRom(const char* rompath, DisAsmInf* inf, bool (*dis)(RomF
 	{
 		fasm = new_TextFile(inf->outputPath);
 	}
+	fasm->compress_set(fasm, inf->compressOutput);
 
 	if(FileOpen_NoError != from->Open(from)
 	|| FileOpen_NoError != fasm->Open2(fasm, "w"))
@@ -53,34 +142,379 @@ static bool DisassembleRom(const char* rompath, DisAsmInf* inf, bool (*dis)(RomF
 		return false;
 	}
 
-	result = dis(from, fasm, inf);
+	/* additional outputs */
+	fjson = OpenOutput(inf->jsonPath, "w", inf->compressOutput, &ok);
+	fcsv = OpenOutput(inf->csvPath, "w", inf->compressOutput, &ok);
+	fbin = OpenOutput(inf->binPath, "wb", inf->compressOutput, &ok);
+	if(false == ok)
+	{
+		delete_RomFile(&from);
+		delete_TextFile(&fasm);
+		delete_TextFile(&fjson);
+		delete_TextFile(&fcsv);
+		delete_TextFile(&fbin);
+		return false;
+	}
+
+	/* the analysis state is saved next to the output */
+	memcpy(&dbinf, inf, sizeof(DisAsmInf));
+	fpath = NULL;
+	if(incremental)
+	{
+		fpath = new_FilePath(fasm->super.path_get(&fasm->super));
+		fpath->ext_set(fpath, ".sdb");
+		dbinf.dbPath = fpath->path_get(fpath);
+	}
+
+	/* all outputs are fed from one analysis */
+	ctx = new_DisAsmContext(&dbinf);
+	List_Foreach(entries, it)
+	{
+		DisAsm_ParseEntry((const char*)Iterator_Data(it), inf, &snesadr, &psw);
+		ctx->AddEntry(ctx, snesadr, psw);
+	}
+	ctx->AddSink(ctx, new_AsmSink(fasm, inf->enableUpper));
+	if(NULL != fjson) ctx->AddSink(ctx, new_JsonSink(fjson));
+	if(NULL != fcsv) ctx->AddSink(ctx, new_CsvSink(fcsv));
+	if(NULL != fbin) ctx->AddSink(ctx, new_BinSink(fbin));
+	if(NULL != banks) ctx->UseBankStore(ctx, banks);
+
+	result = ctx->Run(ctx, from);
+	ctx->PrintDiags(ctx);
 
+	delete_DisAsmContext(&ctx);
+	delete_FilePath(&fpath);
 	delete_RomFile(&from);
-	fasm->super.Close(&fasm->super);
 	/*if(!result)
 	{
 		remove(fasm->super.path_get(&fasm->super));
 	}
 	else*/
 	{
-		printf("Output: %s\n", fasm->super.path_get(&fasm->super));
+		result &= CloseOutput(&fasm);
+		result &= CloseOutput(&fjson);
+		result &= CloseOutput(&fcsv);
+		result &= CloseOutput(&fbin);
+	}
+
+	return result;
+}
+
+/**
+ * Fetch the outputs from the cache, or disassemble the rom and store them
+ */
+static bool DisassembleCached(const char* rompath, const DisAsmInf* inf, List* entries, const bool incremental, const char* dir, const int sizeMB)
+{
+	ResultCache* cache;
+	FilePath* fpath;
+	Iterator* it;
+	char* asmpath;
+	const char* paths[6];
+	const char* outputs[6];
+	char opts[256];
+	int count = 0;
+	int i;
+	bool result;
+
+	/* the output files */
+	if(NULL == inf->outputPath)
+	{
+		fpath = new_FilePath(rompath);
+		fpath->ext_set(fpath, inf->compressOutput ? ".asm.gz" : ".asm");
+		asmpath = Str_copy(fpath->path_get(fpath));
+		delete_FilePath(&fpath);
+	}
+	else
+	{
+		asmpath = Str_copy(inf->outputPath);
+	}
+	paths[0] = asmpath;
+	paths[1] = inf->jsonPath;
+	paths[2] = inf->csvPath;
+	paths[3] = inf->binPath;
+	paths[4] = inf->exportBinPath;
+	paths[5] = inf->cfgPath;
+
+	/* key : the rom(and the trace / code data logs, the fingerprints), the options and the version */
+	cache = new_ResultCache(dir, (ulong)sizeMB * 1024 * 1024);
+	if((false == cache->AddKeyFile(cache, rompath))
+	|| ((NULL != inf->tracePath) && (false == cache->AddKeyFile(cache, inf->tracePath)))
+	|| ((NULL != inf->cdlPath) && (false == cache->AddKeyFile(cache, inf->cdlPath)))
+	|| ((NULL != inf->fingerprintPath) && (false == cache->AddKeyFile(cache, inf->fingerprintPath))))
+	{
+		delete_ResultCache(&cache);
+		free(asmpath);
+		return DisassembleRom(rompath, inf, entries, incremental);
+	}
+	sprintf(opts, "%s %.2f|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d|%d", AppName, AppVersion,
+			inf->accum16bits, inf->index16bits, inf->progCounter,
+			inf->dataSplits, inf->dataCount, inf->depthMax,
+			inf->enableUpper, inf->fullListing, inf->compressOutput,
+			(NULL != banks), inf->dataflow, inf->execSteps);
+	cache->AddKeyString(cache, opts);
+	cache->AddKeyString(cache, inf->dataLabel);
+	cache->AddKeyString(cache, rompath);
+	for(i=0; i<6; i++)
+	{
+		cache->AddKeyString(cache, (NULL == paths[i]) ? "" : paths[i]);
+		if(NULL != paths[i]) outputs[count++] = paths[i];
+	}
+	List_Foreach(entries, it)
+	{
+		cache->AddKeyString(cache, (const char*)Iterator_Data(it));
+	}
+
+	if(cache->Fetch(cache, outputs, count))
+	{
+		printf("Cache hit : %s\n", cache->key_get(cache));
+		for(i=0; i<count; i++)
+		{
+			printf("Output: %s\n", outputs[i]);
+		}
+		result = true;
+	}
+	else
+	{
+		result = DisassembleRom(rompath, inf, entries, incremental);
+		if(result)
+		{
+			if(false == cache->Store(cache, outputs, count))
+			{
+				putwarn("Can't store the outputs to the cache \"%s\".", dir);
+			}
+			cache->Evict(cache);
+		}
 	}
-	delete_TextFile(&fasm);
 
+	delete_ResultCache(&cache);
+	free(asmpath);
+	return result;
+}
+
+/**
+ * Compare the roms, and write the change report(default: <new rom>.diff)
+ */
+static bool DiffRoms(const char* oldpath, const char* newpath, const DisAsmInf* inf, List* entries)
+{
+	RomFile* oldRom;
+	RomFile* newRom;
+	RomView* oldView;
+	RomView* newView;
+	TextFile* out;
+	FilePath* fpath;
+	RomDiff* diff;
+	Iterator* it;
+	uint32 snesadr;
+	uint16 psw;
+	bool result;
+
+	/* the entry points */
+	List_Foreach(entries, it)
+	{
+		if(false == DisAsm_ParseEntry((const char*)Iterator_Data(it), inf, &snesadr, &psw))
+		{
+			puterror("Invalid entry point : %s", (const char*)Iterator_Data(it));
+			return false;
+		}
+	}
+
+	if(NULL == inf->outputPath)
+	{
+		fpath = new_FilePath(newpath);
+		fpath->ext_set(fpath, inf->compressOutput ? ".diff.gz" : ".diff");
+		out = new_TextFile(fpath->path_get(fpath));
+		delete_FilePath(&fpath);
+	}
+	else
+	{
+		out = new_TextFile(inf->outputPath);
+	}
+	out->compress_set(out, inf->compressOutput);
+
+	oldRom = new_RomFile(oldpath);
+	newRom = new_RomFile(newpath);
+	if(FileOpen_NoError != oldRom->Open(oldRom)
+	|| FileOpen_NoError != newRom->Open(newRom)
+	|| FileOpen_NoError != out->Open2(out, "w"))
+	{
+		delete_RomFile(&oldRom);
+		delete_RomFile(&newRom);
+		delete_TextFile(&out);
+		return false;
+	}
+	oldView = new_RomView(oldRom);
+	newView = new_RomView(newRom);
+
+	diff = new_RomDiff(inf);
+	List_Foreach(entries, it)
+	{
+		DisAsm_ParseEntry((const char*)Iterator_Data(it), inf, &snesadr, &psw);
+		diff->AddEntry(diff, snesadr, psw);
+	}
+	result = diff->Run(diff, oldView, newView, out);
+	diff->PrintDiags(diff);
+	if(result)
+	{
+		printf("%lu changed, %lu affected, %lu added, %lu removed routines, %lu data ranges\n",
+				(ulong)diff->count_get(diff, RomDiff_Changed), (ulong)diff->count_get(diff, RomDiff_Affected),
+				(ulong)diff->count_get(diff, RomDiff_Added), (ulong)diff->count_get(diff, RomDiff_Removed),
+				(ulong)diff->count_get(diff, RomDiff_Data));
+	}
+
+	delete_RomDiff(&diff);
+	delete_RomView(&oldView);
+	delete_RomView(&newView);
+	delete_RomFile(&oldRom);
+	delete_RomFile(&newRom);
+	result &= CloseOutput(&out);
+	return result;
+}
+
+static bool Disassemble(const char* rompath, const DisAsmInf* inf, List* entries, const bool incremental, const char* cacheDir, const int cacheSize)
+{
+	/* the fingerprint database is written while building it */
+	if((NULL != cacheDir) && (NULL == inf->namesPath))
+	{
+		return DisassembleCached(rompath, inf, entries, incremental, cacheDir, cacheSize);
+	}
+	return DisassembleRom(rompath, inf, entries, incremental);
+}
+
+static void StopWatch(int sig)
+{
+	(void)sig;
+	if(NULL != watch) watch->Stop(watch);
+}
+
+/**
+ * Disassemble the rom again on each change
+ *   The analysis state is saved next to the output, so only the pass2
+ *   runs if the changed bytes are out of the analyzed code.
+ */
+static bool WatchRom(const char* rompath, const DisAsmInf* inf, List* entries, const char* cacheDir, const int cacheSize)
+{
+	clock_t start;
+	bool result;
+
+	watch = new_FileWatch(rompath);
+	signal(SIGINT, StopWatch);
+	signal(SIGTERM, StopWatch);
+
+	result = Disassemble(rompath, inf, entries, true, cacheDir, cacheSize);
+	printf("%s\n", result ? "Succeeded." : "Failed...");
+	printf("Watching %s\n", rompath);
+	fflush(stdout);
+	while(watch->Wait(watch, WatchQuietMs))
+	{
+		start = clock();
+		result = Disassemble(rompath, inf, entries, true, cacheDir, cacheSize);
+		printf("%s (%lu ms)\n", result ? "Succeeded." : "Failed...",
+				(ulong)((clock() - start) * 1000 / CLOCKS_PER_SEC));
+		fflush(stdout);
+	}
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	delete_FileWatch(&watch);
+	return true;
+}
+
+static void StopServer(int sig)
+{
+	(void)sig;
+	if(NULL != server) server->Stop(server);
+}
+
+static bool ServeRoms(const char* path, const DisAsmInf* inf, const int threads)
+{
+	bool result;
+
+	server = new_Server(inf, threads);
+	signal(SIGINT, StopServer);
+	signal(SIGTERM, StopServer);
+
+	printf("Listening on %s\n", path);
+	result = server->Serve(server, path);
+
+	signal(SIGINT, SIG_DFL);
+	signal(SIGTERM, SIG_DFL);
+	delete_Server(&server);
+	return result;
+}
+
+/**
+ * Run the jobs in the manifest, and write the summary
+ */
+static bool RunBatch(const char* path, const DisAsmInf* inf, const int threads)
+{
+	Batch* batch;
+	bool result;
+
+	batch = new_Batch(inf, threads);
+	if(NULL != banks) batch->UseBankStore(batch, banks);
+	result = batch->Load(batch, path);
+	if(result)
+	{
+		result = batch->Run(batch);
+		batch->PrintSummary(batch);
+	}
+	delete_Batch(&batch);
+	return result;
+}
+
+/**
+ * Scan the roms(and the directories) by the signatures, and write the matches
+ */
+static bool SearchSignatures(const char* path, const int count, char** roms, const int threads)
+{
+	Signature* sigs;
+	SigSearch* search;
+	bool result;
+	int i;
+
+	sigs = new_Signature();
+	if(false == sigs->Load(sigs, path))
+	{
+		printf("%s\n", sigs->error_get(sigs));
+		delete_Signature(&sigs);
+		return false;
+	}
+
+	search = new_SigSearch(sigs, threads);
+	result = true;
+	for(i=0; i<count; i++)
+	{
+		if(false == search->AddPath(search, roms[i]))
+		{
+			printf("Can't read \"%s\"\n", roms[i]);
+			result = false;
+		}
+	}
+	result &= search->Run(search);
+	search->PrintResults(search);
+	delete_SigSearch(&search);
+	delete_Signature(&sigs);
 	return result;
 }
 
 int main(int argc, char** argv)
 {
 	/* options */
-	DisAsmInf disinf = {
-		false, false,
-		-1,
-		16, 0, "", 3,
-		NULL, false
-	};
+	DisAsmInf disinf;
 	bool showVersion = false;
 	bool showHelp = false;
+	char* servePath = NULL;
+	int serveThreads = 4;
+	bool incremental = false;
+	bool watchRom = false;
+	char* diffPath = NULL;
+	char* batchPath = NULL;
+	char* sigPath = NULL;
+	char* bankDir = NULL;
+	char* cacheDir = NULL;
+	int cacheSize = 1024;
+	List* entries;
+	SetOptStruct entryOpt;
 
 	bool  result;
 
@@ -95,14 +529,45 @@ int main(int argc, char** argv)
 		{ "label", 'l', "Specify data mode label", OptionType_String, &disinf.dataLabel },
 		{ "upper", 'u', "Enable upper case", OptionType_Bool, &disinf.enableUpper },
 		{ "output", 'o', "Specify output file(default: <rom>.asm)", OptionType_String, &disinf.outputPath },
+		{ "json", 'j', "Specify JSON Lines output file", OptionType_String, &disinf.jsonPath },
+		{ "csv", 'C', "Specify CSV output file", OptionType_String, &disinf.csvPath },
+		{ "bin", 'b', "Specify binary record output file", OptionType_String, &disinf.binPath },
+		{ "export-bin", 'e', "Specify columnar binary export file", OptionType_String, &disinf.exportBinPath },
+		{ "cfg", 'G', "Specify control-flow graph output file(.dot / JSON Lines)", OptionType_String, &disinf.cfgPath },
+		{ "full", 'F', "Full-ROM listing(fill gaps between code with data)", OptionType_Bool, &disinf.fullListing },
+		{ "gzip", 'z', "Compress the outputs(gzip / also enabled by \".gz\" extension)", OptionType_Bool, &disinf.compressOutput },
+		{ "dataflow", 'f', "Trace the M/X flags by the dataflow(php / plp, subroutine exit states)", OptionType_Bool, &disinf.dataflow },
+		{ "exec", 'n', "Run the rom from the reset / NMI vector, and add the executed code(steps)", OptionType_Int, &disinf.execSteps },
+		{ "trace", 't', "Import the emulator trace log(seed the analysis, and count the hits of the routines)", OptionType_String, &disinf.tracePath },
+		{ "cdl", 'L', "Import the code / data log(seed the logged code, and don't decode the logged data)", OptionType_String, &disinf.cdlPath },
+		{ "fingerprints", 'y', "Name the known routines by the fingerprint database", OptionType_String, &disinf.fingerprintPath },
+		{ "names", 'N', "Add the named routines in the file to the fingerprint database(with -y)", OptionType_String, &disinf.namesPath },
+		{ "stats", 'S', "Show analysis memory statistics", OptionType_Bool, &disinf.showStats },
+		{ "entry", 'E', "Add entry point(SNES Address[:a][x] / can be repeated)", OptionType_FunctionString, &entryOpt },
+		{ "incremental", 'I', "Save the analysis state(<output>.sdb), and reuse it", OptionType_Bool, &incremental },
+		{ "cache", 'K', "Specify result cache directory", OptionType_String, &cacheDir },
+		{ "cache-size", 'M', "Result cache size limit in MB(default: 1024)", OptionType_Int, &cacheSize },
+		{ "bank-store", 'H', "Trace each bank separately, and share the traces in the directory", OptionType_String, &bankDir },
+		{ "diff", 'd', "Compare with the old rom, and write the changes(--diff <old> <new>)", OptionType_String, &diffPath },
+		{ "watch", 'W', "Watch the rom, and disassemble it again on each change", OptionType_Bool, &watchRom },
+		{ "serve", 'D', "Serve the JSON requests on the unix socket", OptionType_String, &servePath },
+		{ "batch", 'B', "Run the jobs in the manifest(JSON)", OptionType_String, &batchPath },
+		{ "signatures", 'g', "Search the signatures in the file over the roms(--signatures <file> <rom / dir>...)", OptionType_String, &sigPath },
+		{ "threads", 'T', "Server / batch / signature search worker threads(default: 4)", OptionType_Int, &serveThreads },
 		{ "version", 'v', "show version", OptionType_Bool, &showVersion },
 		{ "help", '?', "show help message", OptionType_Bool, &showHelp },
 		/* term */
 		{ NULL, '\0', NULL, OptionType_Term, NULL },
 	};
 
+	DisAsm_InitInf(&disinf);
+	entries = new_List(NULL, NULL);
+	entryOpt.func = PushEntry;
+	entryOpt.dest = entries;
+
 	if(!Option_Parse(&argc, &argv, options))
 	{
+		delete_List(&entries);
 		return -1;
 	}
 
@@ -117,17 +582,79 @@ int main(int argc, char** argv)
 	}
 	if((true == showVersion) || (true == showHelp))
 	{
+		delete_List(&entries);
 		return 0;
 	}
 
+	/* the names are added to the fingerprint database */
+	if((NULL != disinf.namesPath) && (NULL == disinf.fingerprintPath))
+	{
+		delete_List(&entries);
+		puterror("The names need the fingerprint database(-y)");
+		return -1;
+	}
+
+	/* server mode */
+	if(NULL != servePath)
+	{
+		delete_List(&entries);
+		return ServeRoms(servePath, &disinf, serveThreads) ? 0 : -1;
+	}
+
+	if(NULL != bankDir)
+	{
+		banks = new_BankStore(bankDir);
+	}
+
+	/* batch mode */
+	if(NULL != batchPath)
+	{
+		delete_List(&entries);
+		result = RunBatch(batchPath, &disinf, serveThreads);
+		delete_BankStore(&banks);
+		return result ? 0 : -1;
+	}
+
+	/* signature search mode */
+	if((NULL != sigPath) && (2 <= argc))
+	{
+		delete_List(&entries);
+		delete_BankStore(&banks);
+		result = SearchSignatures(sigPath, argc - 1, &argv[1], serveThreads);
+		return result ? 0 : -1;
+	}
+
 	if(argc != 2)
 	{
+		delete_List(&entries);
+		delete_BankStore(&banks);
 		printf("Usage: %s [options] <rom>\n", argv[0]);
 		printf("Please try '-?' or '--help' option, and you can get more information.\n");
 		return 0;
 	}
 
-	result = DisassembleRom(argv[1], &disinf, DisAsm);
+	/* diff mode */
+	if(NULL != diffPath)
+	{
+		result = DiffRoms(diffPath, argv[1], &disinf, entries);
+		delete_List(&entries);
+		delete_BankStore(&banks);
+		printf("%s\n", result ? "Succeeded." : "Failed...");
+		return result ? 0 : -1;
+	}
+
+	/* watch mode */
+	if(watchRom)
+	{
+		result = WatchRom(argv[1], &disinf, entries, cacheDir, cacheSize);
+		delete_List(&entries);
+		delete_BankStore(&banks);
+		return result ? 0 : -1;
+	}
+
+	result = Disassemble(argv[1], &disinf, entries, incremental, cacheDir, cacheSize);
+	delete_List(&entries);
+	delete_BankStore(&banks);
 
 	if(false == result)
 	{
@@ -0,0 +1,273 @@
+/**
+ * Analysis.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/List.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+
+/* this header isn't read from anything other */
+/* than DisAsm modules.                       */
+#include "ConstProp.protected.h"
+#include "DisAsm.protected.h"
+
+/**
+ * cross reference(sorted by the destination)
+ */
+typedef struct _XrefRec {
+	uint32		target;	/* snes address */
+	uint32		pcadr;	/* referrer */
+} XrefRec;
+
+/**
+ * Analysis private members
+ */
+struct _Analysis_private {
+	const RomView*	from;
+	InsnStore*	store;
+	XrefRec*	xrefs;
+	uint32		xrefCount;
+};
+
+/* prototypes */
+static uint32 count_get(Analysis*);
+static const RomView* view_get(Analysis*);
+static bool Decode(Analysis*, const uint32, Instruction*);
+static uint32 QueryRange(Analysis*, const uint32, const uint32, AnalysisVisitor_t, void*);
+static uint32 QueryXref(Analysis*, const uint32, AnalysisVisitor_t, void*);
+static void BuildXref(Analysis_private*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Analysis object
+ *
+ * @param from analyzed rom
+ * @param store sorted pass1 store(owned by the object)
+ *
+ * @return the pointer of object
+ */
+Analysis* new_Analysis(const RomView* from, InsnStore* store)
+{
+	Analysis* self;
+	Analysis_private* pri;
+
+	assert(from);
+	assert(store);
+
+	/* make objects */
+	self = malloc(sizeof(Analysis));
+	pri = malloc(sizeof(Analysis_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->store = store;
+	BuildXref(pri);
+
+	/*--- set public member ---*/
+	self->count_get = count_get;
+	self->view_get = view_get;
+	self->Decode = Decode;
+	self->QueryRange = QueryRange;
+	self->QueryXref = QueryXref;
+
+	/* init Analysis object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Analysis object
+ *
+ * @param the pointer of object
+ */
+void delete_Analysis(Analysis** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	delete_InsnStore(&(*self)->pri->store);
+	free((*self)->pri->xrefs);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+InsnStore* Analysis_Store(Analysis* self)
+{
+	assert(self);
+	return self->pri->store;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+/**
+ * The destination is written as a label only if it's an instruction.
+ */
+static bool IsNumericTarget(Analysis_private* pri, const Instruction* ins)
+{
+	uint32 target;
+	uint32 pca;
+	uint32 inx;
+
+	if(false == Opcode_Target(ins, &target)) return false;
+
+	pca = pri->from->Snes2PcAdr(pri->from, target);
+	if(ROMADDRESS_NULL == pca) return true;
+	inx = pri->store->Search(pri->store, pca);
+	if(InsnStore_NotFound == inx) return true;
+	return (InsnRec_Snes(pri->store->Record(pri->store, inx)) != target);
+}
+
+static void DecodeRecord(Analysis_private* pri, const InsnRec* rec, Instruction* ins)
+{
+	InsnRec_Decode(rec, pri->from, ins);
+	ins->numeric = IsNumericTarget(pri, ins);
+}
+
+static int CompareXrefRec(const void* a, const void* b)
+{
+	const XrefRec* xa = (const XrefRec*)a;
+	const XrefRec* xb = (const XrefRec*)b;
+
+	if(xa->target != xb->target) return (xa->target < xb->target) ? -1 : 1;
+	if(xa->pcadr != xb->pcadr) return (xa->pcadr < xb->pcadr) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Index the static destinations
+ */
+static void BuildXref(Analysis_private* pri)
+{
+	InsnStore* store = pri->store;
+	Instruction ins;
+	uint32 target;
+	uint32 i;
+
+	pri->xrefs = NULL;
+	pri->xrefCount = 0;
+	if(0 == store->count_get(store)) return;
+
+	pri->xrefs = malloc(sizeof(XrefRec) * store->count_get(store));
+	assert(pri->xrefs);
+	for(i = 0; i < store->count_get(store); i++)
+	{
+		InsnRec_Decode(store->Record(store, i), pri->from, &ins);
+		if(false == Opcode_Target(&ins, &target)) continue;
+		pri->xrefs[pri->xrefCount].target = target;
+		pri->xrefs[pri->xrefCount].pcadr = ins.pcadr;
+		pri->xrefCount++;
+	}
+	qsort(pri->xrefs, pri->xrefCount, sizeof(XrefRec), CompareXrefRec);
+}
+
+static uint32 count_get(Analysis* self)
+{
+	assert(self);
+	return self->pri->store->count_get(self->pri->store);
+}
+
+static const RomView* view_get(Analysis* self)
+{
+	assert(self);
+	return self->pri->from;
+}
+
+static bool Decode(Analysis* self, const uint32 pcadr, Instruction* ins)
+{
+	Analysis_private* pri;
+	uint32 inx;
+
+	assert(self);
+	assert(ins);
+	pri = self->pri;
+
+	inx = pri->store->Search(pri->store, pcadr);
+	if(InsnStore_NotFound == inx) return false;
+
+	DecodeRecord(pri, pri->store->Record(pri->store, inx), ins);
+	return true;
+}
+
+static uint32 QueryRange(Analysis* self, const uint32 start, const uint32 end, AnalysisVisitor_t visitor, void* param)
+{
+	Analysis_private* pri;
+	InsnStore* store;
+	const InsnRec* rec;
+	Instruction ins;
+	uint32 pca;
+	uint32 count = 0;
+	uint32 i;
+
+	assert(self);
+	assert(visitor);
+	pri = self->pri;
+	store = pri->store;
+
+	/* an instruction is InsnRec_MaxLength bytes at most, */
+	/* so the overlapping one starts after this.           */
+	i = store->LowerBound(store, (InsnRec_MaxLength <= start) ? start - (InsnRec_MaxLength-1) : 0);
+	for(; i < store->count_get(store); i++)
+	{
+		rec = store->Record(store, i);
+		pca = InsnRec_Pc(rec);
+		if(end <= pca) break;
+		if(pca + InsnRec_Length(rec, pri->from) <= start) continue;
+
+		DecodeRecord(pri, rec, &ins);
+		count++;
+		if(false == visitor(param, &ins)) break;
+	}
+	return count;
+}
+
+static uint32 QueryXref(Analysis* self, const uint32 target, AnalysisVisitor_t visitor, void* param)
+{
+	Analysis_private* pri;
+	Instruction ins;
+	uint32 lo = 0;
+	uint32 hi;
+	uint32 mid;
+	uint32 count = 0;
+
+	assert(self);
+	assert(visitor);
+	pri = self->pri;
+
+	/* search the first one */
+	hi = pri->xrefCount;
+	while(lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if(pri->xrefs[mid].target < target)
+		{
+			lo = mid+1;
+			continue;
+		}
+		hi = mid;
+	}
+
+	for(; (lo < pri->xrefCount) && (target == pri->xrefs[lo].target); lo++)
+	{
+		Decode(self, pri->xrefs[lo].pcadr, &ins);
+		count++;
+		if(false == visitor(param, &ins)) break;
+	}
+	return count;
+}
@@ -0,0 +1,513 @@
+/**
+ * AnalysisDb.c
+ *   persisted pass1 state
+ *
+ *   All values are little-endian.
+ *
+ *   header :
+ *      0 : magic "SDACHIDB"
+ *      8 : version(16), pass1 succeeded(8), reserved(8)
+ *     12 : rom hash(32), rom size(32), entry(32), call from(32),
+ *          psw(16), map(16), depth max(32), exec steps(32),
+ *          trace hash(32), cdl hash(32), names hash(32), dataflow(8)
+ *
+ *   blocks   : count(32), hash(32) * count   (FNV-1a of each 4KB block)
+ *   entries  : count(32), { snes(32), psw(16) } * count
+ *   pointers : count(32), block(32) * count  (the pointers read by pass1)
+ *   diags    : count(32), { level(8), length(16), message } * count
+ *   records  : count(32), InsnRec(8 bytes) * count   (sorted)
+ *   groups   : count(32), { callFrom(32), depth(32) } * count
+ *
+ *   Pass1 reads nothing but the bytes of the analyzed instructions and
+ *   the pointers of the indirect jumps, so the state of the changed rom is
+ *   still reused if all the changed blocks are out of them.
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "common/Iterator.h"
+#include "common/List.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "ConstProp.protected.h"
+#include "DisAsm.protected.h"
+
+#define AnalysisDb_Magic	"SDACHIDB"
+#define AnalysisDb_Version	9
+#define StageSize		4096
+#define BlockShift		AnalysisDb_BlockShift
+#define DiagLen			256
+
+#define FNV_Offset		0x811c9dc5u
+#define FNV_Prime		0x01000193u
+
+
+/*--------------- writer ---------------*/
+
+typedef struct _DbWriter {
+	TextFile*	out;
+	uint8		stage[StageSize];
+	size_t		inx;
+	bool		failed;
+} DbWriter;
+
+static void Flush(DbWriter* w)
+{
+	if(0 == w->inx) return;
+	if(false == w->out->Write(w->out, w->stage, w->inx))
+	{
+		w->failed = true;
+	}
+	w->inx = 0;
+}
+
+static void PutBytes(DbWriter* w, const uint8* data, const size_t len)
+{
+	size_t i;
+
+	for(i=0; i<len; i++)
+	{
+		if(StageSize == w->inx) Flush(w);
+		w->stage[w->inx++] = data[i];
+	}
+}
+
+static void Put8(DbWriter* w, const uint8 v)
+{
+	PutBytes(w, &v, 1);
+}
+
+static void Put16(DbWriter* w, const uint16 v)
+{
+	uint8 b[2];
+	write16(b, v);
+	PutBytes(w, b, 2);
+}
+
+static void Put32(DbWriter* w, const uint32 v)
+{
+	uint8 b[4];
+	write32(b, v);
+	PutBytes(w, b, 4);
+}
+
+static uint32 Hash(const uint8* ptr, const uint32 size)
+{
+	uint32 hash = FNV_Offset;
+	uint32 i;
+
+	for(i=0; i<size; i++)
+	{
+		hash = (hash ^ ptr[i]) * FNV_Prime;
+	}
+	return hash;
+}
+
+uint32 AnalysisDb_Hash(const RomView* from)
+{
+	const uint8* ptr;
+
+	ptr = from->GetPcPtr(from, 0);
+	if(NULL == ptr) return FNV_Offset;
+	return Hash(ptr, from->size_get(from));
+}
+
+static uint32 BlockCount(const RomView* from)
+{
+	return (from->size_get(from) + (1 << BlockShift) - 1) >> BlockShift;
+}
+
+static uint32 BlockHash(const RomView* from, const uint32 block)
+{
+	const uint8* ptr;
+	uint32 pcadr = block << BlockShift;
+	uint32 size = 1 << BlockShift;
+
+	ptr = from->GetPcPtr(from, pcadr);
+	if(NULL == ptr) return FNV_Offset;
+	if(from->size_get(from) - pcadr < size) size = from->size_get(from) - pcadr;
+	return Hash(ptr, size);
+}
+
+bool AnalysisDb_Save(DisAsmContext* ctx, const char* path, const AnalysisDbKey* key, const RomView* from, List* entries, const uint8* pointers, const bool pass1ok, InsnStore* store)
+{
+	DbWriter* w;
+	TextFile* out;
+	const DisAsmDiag* d;
+	const DisAsmEntry* e;
+	const InsnRec* rec;
+	const GroupRec* grp;
+	Iterator* it;
+	size_t len;
+	uint32 count;
+	uint32 i;
+	bool result;
+
+	out = new_TextFile(path);
+	if(FileOpen_NoError != out->Open2(out, "wb"))
+	{
+		delete_TextFile(&out);
+		return false;
+	}
+	w = malloc(sizeof(DbWriter));
+	assert(w);
+	w->out = out;
+	w->inx = 0;
+	w->failed = false;
+
+	/* header */
+	PutBytes(w, (const uint8*)AnalysisDb_Magic, 8);
+	Put16(w, AnalysisDb_Version);
+	Put8(w, pass1ok ? 1 : 0);
+	Put8(w, 0);
+	Put32(w, key->romHash);
+	Put32(w, key->romSize);
+	Put32(w, key->entry);
+	Put32(w, key->callFrom);
+	Put16(w, key->psw);
+	Put16(w, key->romMap);
+	Put32(w, (uint32)key->depthMax);
+	Put32(w, (uint32)key->execSteps);
+	Put32(w, key->traceHash);
+	Put32(w, key->cdlHash);
+	Put32(w, key->namesHash);
+	Put8(w, key->dataflow ? 1 : 0);
+
+	/* blocks */
+	Put32(w, BlockCount(from));
+	for(i=0; i<BlockCount(from); i++)
+	{
+		Put32(w, BlockHash(from, i));
+	}
+
+	/* entries */
+	i = 0;
+	List_Foreach(entries, it) i++;
+	Put32(w, i);
+	List_Foreach(entries, it)
+	{
+		e = (const DisAsmEntry*)Iterator_Data(it);
+		Put32(w, e->snesadr);
+		Put16(w, e->psw);
+	}
+
+	/* the blocks of the pointers */
+	count = 0;
+	for(i=0; i<BlockCount(from); i++)
+	{
+		if(pointers[i]) count++;
+	}
+	Put32(w, count);
+	for(i=0; i<BlockCount(from); i++)
+	{
+		if(pointers[i]) Put32(w, i);
+	}
+
+	/* diagnostics of pass1 */
+	Put32(w, ctx->diagCount_get(ctx));
+	for(i=0; i<ctx->diagCount_get(ctx); i++)
+	{
+		d = ctx->Diag(ctx, i);
+		len = strlen(d->message);
+		if(DiagLen <= len) len = DiagLen-1;
+		Put8(w, (uint8)d->level);
+		Put16(w, (uint16)len);
+		PutBytes(w, (const uint8*)d->message, len);
+	}
+
+	/* store */
+	Put32(w, store->count_get(store));
+	for(i=0; i<store->count_get(store); i++)
+	{
+		rec = store->Record(store, i);
+		PutBytes(w, rec->pcadr, 3);
+		PutBytes(w, rec->snesadr, 3);
+		Put8(w, rec->psw);
+		Put8(w, rec->flags);
+	}
+	Put32(w, store->groupCount_get(store));
+	for(i=0; i<store->groupCount_get(store); i++)
+	{
+		grp = store->Group(store, i);
+		Put32(w, grp->callFrom);
+		Put32(w, (uint32)grp->depth);
+	}
+	Flush(w);
+
+	result = !w->failed;
+	free(w);
+	result &= out->Close(out);
+	delete_TextFile(&out);
+	return result;
+}
+
+
+/*--------------- reader ---------------*/
+
+typedef struct _DbReader {
+	const uint8*	ptr;
+	size_t		rest;
+	bool		failed;
+} DbReader;
+
+static const uint8* GetBytes(DbReader* r, const size_t len)
+{
+	const uint8* p;
+
+	if(r->failed || (r->rest < len))
+	{
+		r->failed = true;
+		return NULL;
+	}
+	p = r->ptr;
+	r->ptr += len;
+	r->rest -= len;
+	return p;
+}
+
+static uint32 Get8(DbReader* r)
+{
+	const uint8* p = GetBytes(r, 1);
+	return (NULL == p) ? 0 : p[0];
+}
+
+static uint32 Get16(DbReader* r)
+{
+	const uint8* p = GetBytes(r, 2);
+	return (NULL == p) ? 0 : read16(p);
+}
+
+static uint32 Get32(DbReader* r)
+{
+	const uint8* p = GetBytes(r, 4);
+	return (NULL == p) ? 0 : read32(p);
+}
+
+static uint8* ReadAll(const char* path, size_t* size)
+{
+	FILE* fp;
+	long len;
+	uint8* buf;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return NULL;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if(0 >= len)
+	{
+		fclose(fp);
+		return NULL;
+	}
+	buf = malloc((size_t)len);
+	assert(buf);
+	if((size_t)len != fread(buf, 1, (size_t)len, fp))
+	{
+		fclose(fp);
+		free(buf);
+		return NULL;
+	}
+	fclose(fp);
+	(*size) = (size_t)len;
+	return buf;
+}
+
+/**
+ * Check the header, the blocks and the entries
+ *   The changed blocks are flagged in the table if the rom is changed.
+ *   return: the number of the saved entries, or -1
+ */
+static int ReadHead(DbReader* r, const AnalysisDbKey* key, const RomView* from, List* entries, uint8** changed, bool* pass1ok)
+{
+	const DisAsmEntry* e;
+	Iterator* it;
+	const uint8* magic;
+	uint32 count;
+	uint32 i;
+
+	magic = GetBytes(r, 8);
+	if((NULL == magic) || (0 != memcmp(magic, AnalysisDb_Magic, 8))) return -1;
+	if(AnalysisDb_Version != Get16(r)) return -1;
+	(*pass1ok) = (0 != Get8(r));
+	Get8(r);
+	if(key->romHash != Get32(r))
+	{
+		(*changed) = malloc(BlockCount(from));
+		assert(*changed);
+	}
+	if(key->romSize != Get32(r)) return -1;
+	if(key->entry != Get32(r)) return -1;
+	if(key->callFrom != Get32(r)) return -1;
+	if(key->psw != Get16(r)) return -1;
+	if(key->romMap != Get16(r)) return -1;
+	if((uint32)key->depthMax != Get32(r)) return -1;
+	if((uint32)key->execSteps != Get32(r)) return -1;
+	if(key->traceHash != Get32(r)) return -1;
+	if(key->cdlHash != Get32(r)) return -1;
+	if(key->namesHash != Get32(r)) return -1;
+	if((uint32)(key->dataflow ? 1 : 0) != Get8(r)) return -1;
+
+	/* the blocks are compared only if the rom is changed */
+	if(BlockCount(from) != Get32(r)) return -1;
+	for(i=0; i<BlockCount(from); i++)
+	{
+		if(NULL == (*changed))
+		{
+			Get32(r);
+			continue;
+		}
+		(*changed)[i] = (BlockHash(from, i) != Get32(r)) ? 1 : 0;
+	}
+
+	/* the saved entries must be the head of the current entries */
+	count = Get32(r);
+	it = entries->begin(entries);
+	for(i=0; i<count; i++)
+	{
+		if(NULL == it) return -1;
+		e = (const DisAsmEntry*)Iterator_Data(it);
+		if(e->snesadr != Get32(r)) return -1;
+		if(e->psw != Get16(r)) return -1;
+		it = Iterator_Next(it);
+	}
+	if(r->failed || (0x7fffffff < count)) return -1;
+	return (int)count;
+}
+
+/**
+ * Check whether the instruction is in the changed blocks
+ */
+static bool IsChanged(const RomView* from, const uint8* changed, const uint8* rec)
+{
+	uint32 pca;
+	uint32 len;
+
+	if(NULL == changed) return false;
+	pca = read24(&rec[0]);
+	/* the opcode is checked before the length is read from it */
+	if(changed[pca >> BlockShift]) return true;
+	len = InsnRec_Length((const InsnRec*)rec, from);
+	if(from->size_get(from) < pca + len) return true;
+	return (0 != changed[(pca + len - 1) >> BlockShift]);
+}
+
+int AnalysisDb_Load(DisAsmContext* ctx, const char* path, const AnalysisDbKey* key, const RomView* from, List* entries, uint8* pointers, InsnStore* store, bool* pass1ok)
+{
+	DbReader r;
+	DbReader ptrs;
+	DbReader diags;
+	DbReader recs;
+	const uint8* rec;
+	const uint8* grp;
+	const uint8* msg;
+	char text[DiagLen];
+	uint8* buf;
+	uint8* changed = NULL;
+	size_t size;
+	uint32 ptrCount;
+	uint32 diagCount;
+	uint32 count;
+	uint32 groups;
+	uint32 heads;
+	uint32 prev = 0;
+	uint32 pca;
+	uint32 level;
+	uint32 len;
+	uint32 i;
+	uint32 g;
+	int done;
+
+	assert(0 == store->count_get(store));
+
+	buf = ReadAll(path, &size);
+	if(NULL == buf) return -1;
+	r.ptr = buf;
+	r.rest = size;
+	r.failed = false;
+
+	done = ReadHead(&r, key, from, entries, &changed, pass1ok);
+	if(0 > done)
+	{
+		free(changed);
+		free(buf);
+		return -1;
+	}
+
+	/* validate all before the store is changed */
+	ptrCount = Get32(&r);
+	ptrs = r;
+	for(i=0; (i<ptrCount) && (false == r.failed); i++)
+	{
+		g = Get32(&r);
+		if(BlockCount(from) <= g) r.failed = true;
+		else if((NULL != changed) && changed[g]) r.failed = true;
+	}
+
+	diagCount = Get32(&r);
+	diags = r;
+	for(i=0; (i<diagCount) && (false == r.failed); i++)
+	{
+		level = Get8(&r);
+		len = Get16(&r);
+		if((DisAsmDiag_Error < level) || (DiagLen <= len)) r.failed = true;
+		GetBytes(&r, len);
+	}
+
+	count = Get32(&r);
+	recs = r;
+	heads = 0;
+	for(i=0; (i<count) && (false == r.failed); i++)
+	{
+		rec = GetBytes(&r, sizeof(InsnRec));
+		if(NULL == rec) break;
+		pca = read24(&rec[0]);
+		if((key->romSize <= pca) || ((0 != i) && (pca <= prev))) r.failed = true;
+		else if(IsChanged(from, changed, rec)) r.failed = true;
+		if(InsnRec_GroupHead & rec[7]) heads++;
+		prev = pca;
+	}
+	groups = Get32(&r);
+	grp = GetBytes(&r, (size_t)groups * 8);
+	free(changed);
+	if(r.failed || (heads != groups) || (0 != r.rest))
+	{
+		free(buf);
+		return -1;
+	}
+
+	/* restore */
+	for(i=0; i<ptrCount; i++)
+	{
+		pointers[Get32(&ptrs)] = 1;
+	}
+	for(i=0; i<diagCount; i++)
+	{
+		level = Get8(&diags);
+		len = Get16(&diags);
+		msg = GetBytes(&diags, len);
+		memcpy(text, msg, len);
+		text[len] = '\0';
+		ctx->Report(ctx, (DisAsmDiagLevel)level, "%s", text);
+	}
+	for(i=0, g=0; i<count; i++)
+	{
+		rec = GetBytes(&recs, sizeof(InsnRec));
+		store->Add(store, read24(&rec[3]), read24(&rec[0]), rec[6]);
+		if(InsnRec_GroupHead & rec[7])
+		{
+			store->AddGroup(store, read32(&grp[8*g]), (int)read32(&grp[8*g+4]));
+			g++;
+		}
+	}
+
+	free(buf);
+	return done;
+}
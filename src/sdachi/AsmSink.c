@@ -0,0 +1,175 @@
+/**
+ * AsmSink.c
+ *   assembler listing output
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/Str.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "Sink.protected.h"
+
+#define DataBufferSize 1024
+
+/* prototypes */
+static void Begin(Sink*, const RomView*, const char*);
+static void Label(Sink*, const uint32, const char*);
+static void Org(Sink*, const uint32);
+static void Group(Sink*, const GroupInfo*);
+static void Insn(Sink*, const Instruction*);
+static void Data(Sink*, const uint32, const uint32, const uint8*, const size_t);
+
+
+/*--------------- Constructor ---------------*/
+
+/**
+ * @brief Create AsmSink object
+ *
+ * @return the pointer of object
+ */
+Sink* new_AsmSink(TextFile* out, const bool enableUpper)
+{
+	Sink* self;
+
+	assert(out);
+	self = new_Sink(out);
+	self->pro->enableUpper = enableUpper;
+
+	/*--- override ---*/
+	self->Begin = Begin;
+	self->Label = Label;
+	self->Org = Org;
+	self->Group = Group;
+	self->Insn = Insn;
+	self->Data = Data;
+
+	return self;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void Begin(Sink* self, const RomView* from, const char* map)
+{
+	TextFile* fasm;
+
+	assert(self);
+	fasm = self->pro->out;
+	fasm->Printf(fasm, ";-------------------------------------------------\n");
+	fasm->Printf(fasm, ";  File : %s\n", fasm->super.path_get(&fasm->super));
+	fasm->Printf(fasm, ";  From : %s\n", from->path_get(from));
+	fasm->Printf(fasm, ";  Map  : %s\n", map);
+	fasm->Printf(fasm, ";-------------------------------------------------\n");
+}
+
+static void Label(Sink* self, const uint32 snesadr, const char* name)
+{
+	TextFile* fasm;
+
+	assert(self);
+	fasm = self->pro->out;
+	fasm->Printf(fasm, "%s:\n", name);
+}
+
+static void Org(Sink* self, const uint32 snesadr)
+{
+	TextFile* fasm;
+
+	assert(self);
+	fasm = self->pro->out;
+	fasm->Printf(fasm, "\n\torg\t$%06x\n", snesadr);
+}
+
+static void Group(Sink* self, const GroupInfo* grp)
+{
+	TextFile* fasm;
+
+	assert(self);
+	fasm = self->pro->out;
+	fasm->Printf(fasm, "\n");
+	fasm->Printf(fasm, ";-----------------------------\n");
+	fasm->Printf(fasm, ";   call depth   : %d\n", grp->depth);
+	fasm->Printf(fasm, ";   call from    : $%06x\n", grp->callFrom);
+	fasm->Printf(fasm, ";   A register   : %s\n", (grp->psw & 0x20) ? "8 bit" : "16 bit");
+	fasm->Printf(fasm, ";   X/Y register : %s\n", (grp->psw & 0x10) ? "8 bit" : "16 bit");
+	if(GroupInfo_NotTraced != grp->hits)
+	{
+		fasm->Printf(fasm, ";   hit count    : %lu (max %lu)\n", (ulong)grp->hits, (ulong)grp->hitsMax);
+	}
+	fasm->Printf(fasm, ";-----------------------------\n");
+}
+
+static void Insn(Sink* self, const Instruction* ins)
+{
+	TextFile* fasm;
+	char operand[16];
+	char buf[64];
+	int len;
+	int i;
+
+	assert(self);
+	fasm = self->pro->out;
+
+	/* "L008000:\tlda.b #$01         ; a9 01" */
+	Opcode_Operand(ins, operand);
+	len = sprintf_s(buf, sizeof(buf), "L%06x:\t%s%-2s %-12s ; %02x",
+			ins->snesadr, Opcode_Mnemonic(ins->op), Opcode_SizeSuffix(ins), operand, ins->op);
+	for(i=0; i<ins->arglen; i++)
+	{
+		len += sprintf_s(&buf[len], sizeof(buf)-(size_t)len, " %02x", ins->arg[i]);
+	}
+	buf[len++] = '\n';
+	buf[len] = '\0';
+
+	if(self->pro->enableUpper)
+	{
+		Str_toupper(buf);
+	}
+	fasm->Printf(fasm, "%s", buf);
+}
+
+/* "\t.db\t$01, $02, $03\n" */
+static void Data(Sink* self, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	static const char hex[] = "0123456789abcdef";
+	TextFile* fasm;
+	char buf[DataBufferSize+8];
+	size_t inx;
+	size_t i;
+
+	assert(self);
+	fasm = self->pro->out;
+	if(0 == len) return;
+
+	/* format the line without printf, and write in chunks */
+	buf[0] = '\t';
+	buf[1] = '.';
+	buf[2] = 'd';
+	buf[3] = 'b';
+	buf[4] = '\t';
+	inx = 5;
+	for(i=0; i<len; i++)
+	{
+		buf[inx++] = '$';
+		buf[inx++] = hex[data[i] >> 4];
+		buf[inx++] = hex[data[i] & 0x0f];
+		if(i == len-1)
+		{
+			buf[inx++] = '\n';
+			break;
+		}
+		buf[inx++] = ',';
+		buf[inx++] = ' ';
+		if(DataBufferSize <= inx)
+		{
+			if(false == fasm->Write(fasm, buf, inx)) self->pro->failed = true;
+			inx = 0;
+		}
+	}
+	if(false == fasm->Write(fasm, buf, inx)) self->pro->failed = true;
+}
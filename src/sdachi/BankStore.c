@@ -0,0 +1,458 @@
+/**
+ * BankStore.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define BANKSTORE_POSIX
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#ifdef BANKSTORE_POSIX
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+#include "common/Str.h"
+#include "common/ReadWrite.h"
+#include "sdachi/BankStore.h"
+
+#define FNV_Prime	(((uint64)0x00000100 << 32) | 0x000001b3)
+
+#define FileMagic	"SDBK"
+#define FileVersion	2
+#define HeaderSize	20
+#define RecSize		5
+#define GroupSize	8
+#define ExitSize	14
+
+#define InitialSlots	256
+
+#ifdef BANKSTORE_POSIX
+#  define Mutex_Lock(m)		pthread_mutex_lock(m)
+#  define Mutex_Unlock(m)	pthread_mutex_unlock(m)
+#else
+#  define Mutex_Lock(m)
+#  define Mutex_Unlock(m)
+#endif
+
+/**
+ * hash table slot
+ */
+typedef struct _BankSlot {
+	uint64		key;
+	BankTrace*	trace;		/* NULL : empty */
+} BankSlot;
+
+/**
+ * BankStore private members
+ */
+struct _BankStore_private {
+	char*		dir;
+	BankSlot*	slots;
+	uint32		slotCount;	/* power of 2 */
+	uint32		count;
+	ulong		hits;
+	ulong		misses;
+	uint32		serial;		/* temporary name */
+#ifdef BANKSTORE_POSIX
+	pthread_mutex_t	lock;
+#endif
+};
+
+/* prototypes */
+static const BankTrace* Find(BankStore*, const uint64);
+static const BankTrace* Add(BankStore*, const uint64, BankTrace*);
+static ulong hits_get(BankStore*);
+static ulong misses_get(BankStore*);
+
+
+/*--------------- trace ---------------*/
+
+BankTrace* new_BankTrace(const uint32 recs, const uint32 groups, const uint32 exits)
+{
+	BankTrace* self;
+
+	self = malloc(sizeof(BankTrace));
+	assert(self);
+	self->recs = malloc(sizeof(BankTraceRec) * (recs + 1));
+	self->groups = malloc(sizeof(BankTraceGroup) * (groups + 1));
+	self->exits = malloc(sizeof(BankTraceExit) * (exits + 1));
+	assert(self->recs);
+	assert(self->groups);
+	assert(self->exits);
+	self->recCount = recs;
+	self->groupCount = groups;
+	self->exitCount = exits;
+	return self;
+}
+
+void delete_BankTrace(BankTrace** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	free((*self)->recs);
+	free((*self)->groups);
+	free((*self)->exits);
+	free(*self);
+	(*self) = NULL;
+}
+
+uint64 BankStore_Hash(uint64 hash, const void* data, const size_t len)
+{
+	const uint8* p = (const uint8*)data;
+	size_t i;
+
+	for(i=0; i<len; i++)
+	{
+		hash = (hash ^ p[i]) * FNV_Prime;
+	}
+	return hash;
+}
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create BankStore object
+ *
+ * @param dir store directory(or NULL)
+ *
+ * @return the pointer of object
+ */
+BankStore* new_BankStore(const char* dir)
+{
+	BankStore* self;
+	BankStore_private* pri;
+
+	/* make objects */
+	self = malloc(sizeof(BankStore));
+	pri = malloc(sizeof(BankStore_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->dir = Str_copy(dir);
+	pri->slotCount = InitialSlots;
+	pri->slots = calloc(pri->slotCount, sizeof(BankSlot));
+	assert(pri->slots);
+	pri->count = 0;
+	pri->hits = 0;
+	pri->misses = 0;
+	pri->serial = 0;
+#ifdef BANKSTORE_POSIX
+	pthread_mutex_init(&pri->lock, NULL);
+	if(NULL != dir) mkdir(dir, 0777);
+#endif
+
+	/*--- set public member ---*/
+	self->Find = Find;
+	self->Add = Add;
+	self->hits_get = hits_get;
+	self->misses_get = misses_get;
+
+	/* init BankStore object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete BankStore object
+ *
+ * @param the pointer of object
+ */
+void delete_BankStore(BankStore** self)
+{
+	BankStore_private* pri;
+	uint32 i;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	for(i=0; i<pri->slotCount; i++)
+	{
+		delete_BankTrace(&pri->slots[i].trace);
+	}
+#ifdef BANKSTORE_POSIX
+	pthread_mutex_destroy(&pri->lock);
+#endif
+	free(pri->slots);
+	free(pri->dir);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- hash table ---------------*/
+
+static BankSlot* Lookup(BankSlot* slots, const uint32 slotCount, const uint64 key)
+{
+	uint32 i;
+
+	i = (uint32)(key ^ (key >> 32)) & (slotCount - 1);
+	while((NULL != slots[i].trace) && (slots[i].key != key))
+	{
+		i = (i + 1) & (slotCount - 1);
+	}
+	return &slots[i];
+}
+
+static void Grow(BankStore_private* pri)
+{
+	BankSlot* slots;
+	BankSlot* s;
+	uint32 i;
+
+	slots = calloc((size_t)pri->slotCount * 2, sizeof(BankSlot));
+	assert(slots);
+	for(i=0; i<pri->slotCount; i++)
+	{
+		if(NULL == pri->slots[i].trace) continue;
+		s = Lookup(slots, pri->slotCount * 2, pri->slots[i].key);
+		(*s) = pri->slots[i];
+	}
+	free(pri->slots);
+	pri->slots = slots;
+	pri->slotCount *= 2;
+}
+
+/**
+ * Insert the trace into the table
+ *   If the key is already added, the given trace is deleted.
+ */
+static const BankTrace* Insert(BankStore_private* pri, const uint64 key, BankTrace* trace)
+{
+	BankSlot* s;
+	const BankTrace* result;
+
+	Mutex_Lock(&pri->lock);
+	s = Lookup(pri->slots, pri->slotCount, key);
+	if(NULL == s->trace)
+	{
+		s->key = key;
+		s->trace = trace;
+		pri->count++;
+		if(pri->slotCount < pri->count * 2) Grow(pri);
+		result = trace;
+	}
+	else
+	{
+		delete_BankTrace(&trace);
+		result = s->trace;
+	}
+	Mutex_Unlock(&pri->lock);
+	return result;
+}
+
+
+/*--------------- files ---------------*/
+
+#ifdef BANKSTORE_POSIX
+static char* KeyPath(const char* dir, const uint64 key)
+{
+	char* path;
+
+	path = malloc(strlen(dir) + 18);
+	assert(path);
+	sprintf(path, "%s/%08lx%08lx", dir, (ulong)(key >> 32), (ulong)(key & 0xffffffff));
+	return path;
+}
+
+static BankTrace* ReadTrace(const char* path)
+{
+	FILE* fp;
+	BankTrace* trace = NULL;
+	uint8 head[HeaderSize];
+	uint8* buf;
+	uint8* p;
+	uint32 recs;
+	uint32 groups;
+	uint32 exits;
+	size_t len;
+	uint32 i;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return NULL;
+
+	if((HeaderSize != fread(head, 1, HeaderSize, fp))
+	|| (0 != memcmp(head, FileMagic, 4))
+	|| (FileVersion != read32(&head[4])))
+	{
+		fclose(fp);
+		return NULL;
+	}
+	recs = read32(&head[8]);
+	groups = read32(&head[12]);
+	exits = read32(&head[16]);
+	if((0x10000 < recs) || (recs < groups) || (0x100000 < exits))
+	{
+		fclose(fp);
+		return NULL;
+	}
+
+	len = (size_t)recs * RecSize + (size_t)groups * GroupSize + (size_t)exits * ExitSize;
+	buf = malloc(len + 1);
+	assert(buf);
+	if(len == fread(buf, 1, len, fp))
+	{
+		trace = new_BankTrace(recs, groups, exits);
+		p = buf;
+		for(i=0; i<recs; i++, p+=RecSize)
+		{
+			trace->recs[i].snesadr = read24(&p[0]);
+			trace->recs[i].psw = p[3];
+			trace->recs[i].flags = p[4];
+		}
+		for(i=0; i<groups; i++, p+=GroupSize)
+		{
+			trace->groups[i].callFrom = read32(&p[0]);
+			trace->groups[i].depth = (int)read32(&p[4]);
+		}
+		for(i=0; i<exits; i++, p+=ExitSize)
+		{
+			trace->exits[i].snesadr = read32(&p[0]);
+			trace->exits[i].callFrom = read32(&p[4]);
+			trace->exits[i].psw = read16(&p[8]);
+			trace->exits[i].depth = (int)read32(&p[10]);
+		}
+	}
+	free(buf);
+	fclose(fp);
+	return trace;
+}
+
+static bool WriteTrace(const char* path, const BankTrace* trace)
+{
+	FILE* fp;
+	uint8 buf[HeaderSize];
+	bool result;
+	uint32 i;
+
+	fp = fopen(path, "wb");
+	if(NULL == fp) return false;
+
+	memcpy(buf, FileMagic, 4);
+	write32(&buf[4], FileVersion);
+	write32(&buf[8], trace->recCount);
+	write32(&buf[12], trace->groupCount);
+	write32(&buf[16], trace->exitCount);
+	result = (HeaderSize == fwrite(buf, 1, HeaderSize, fp));
+	for(i=0; result && (i<trace->recCount); i++)
+	{
+		write24(&buf[0], trace->recs[i].snesadr);
+		buf[3] = trace->recs[i].psw;
+		buf[4] = trace->recs[i].flags;
+		result = (RecSize == fwrite(buf, 1, RecSize, fp));
+	}
+	for(i=0; result && (i<trace->groupCount); i++)
+	{
+		write32(&buf[0], trace->groups[i].callFrom);
+		write32(&buf[4], (uint32)trace->groups[i].depth);
+		result = (GroupSize == fwrite(buf, 1, GroupSize, fp));
+	}
+	for(i=0; result && (i<trace->exitCount); i++)
+	{
+		write32(&buf[0], trace->exits[i].snesadr);
+		write32(&buf[4], trace->exits[i].callFrom);
+		write16(&buf[8], trace->exits[i].psw);
+		write32(&buf[10], (uint32)trace->exits[i].depth);
+		result = (ExitSize == fwrite(buf, 1, ExitSize, fp));
+	}
+	result &= (0 == fclose(fp));
+	return result;
+}
+#endif
+
+
+/*--------------- methods ---------------*/
+
+static const BankTrace* Find(BankStore* self, const uint64 key)
+{
+	BankStore_private* pri;
+	const BankTrace* result;
+#ifdef BANKSTORE_POSIX
+	BankTrace* trace;
+	char* path;
+#endif
+
+	assert(self);
+	pri = self->pri;
+
+	Mutex_Lock(&pri->lock);
+	result = Lookup(pri->slots, pri->slotCount, key)->trace;
+	Mutex_Unlock(&pri->lock);
+
+#ifdef BANKSTORE_POSIX
+	/* the file of the other run */
+	if((NULL == result) && (NULL != pri->dir))
+	{
+		path = KeyPath(pri->dir, key);
+		trace = ReadTrace(path);
+		if(NULL != trace) result = Insert(pri, key, trace);
+		free(path);
+	}
+#endif
+
+	Mutex_Lock(&pri->lock);
+	if(NULL != result) pri->hits++;
+	else pri->misses++;
+	Mutex_Unlock(&pri->lock);
+	return result;
+}
+
+static const BankTrace* Add(BankStore* self, const uint64 key, BankTrace* trace)
+{
+	BankStore_private* pri;
+	const BankTrace* result;
+#ifdef BANKSTORE_POSIX
+	char* path;
+	char* tmp;
+	uint32 serial;
+#endif
+
+	assert(self);
+	assert(trace);
+	pri = self->pri;
+
+	result = Insert(pri, key, trace);
+
+#ifdef BANKSTORE_POSIX
+	/* the file is written to the temporary name, and renamed into place */
+	if(NULL != pri->dir)
+	{
+		Mutex_Lock(&pri->lock);
+		serial = pri->serial++;
+		Mutex_Unlock(&pri->lock);
+
+		path = KeyPath(pri->dir, key);
+		tmp = malloc(strlen(pri->dir) + 96);
+		assert(tmp);
+		sprintf(tmp, "%s/tmp-%ld-%p-%lu", pri->dir, (long)getpid(), (void*)self, (ulong)serial);
+		if((false == WriteTrace(tmp, result)) || (0 != rename(tmp, path)))
+		{
+			remove(tmp);
+		}
+		free(tmp);
+		free(path);
+	}
+#endif
+	return result;
+}
+
+static ulong hits_get(BankStore* self)
+{
+	assert(self);
+	return self->pri->hits;
+}
+
+static ulong misses_get(BankStore* self)
+{
+	assert(self);
+	return self->pri->misses;
+}
@@ -0,0 +1,881 @@
+/**
+ * Batch.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define BATCH_THREAD
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stdarg.h>
+#include <time.h>
+#ifdef BATCH_THREAD
+#  include <pthread.h>
+#endif
+#include "common/puts.h"
+#include "common/Str.h"
+#include "file/FilePath.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/Batch.h"
+#include "sdachi/BankStore.h"
+#include "Json.protected.h"
+
+#if defined(_MSC_VER)
+#  define vsnprintf _vsnprintf
+#endif
+
+#define ErrorLen	256
+#define ReadChunk	4096
+
+#ifdef BATCH_THREAD
+#  define Mutex_Lock(m)		pthread_mutex_lock(m)
+#  define Mutex_Unlock(m)	pthread_mutex_unlock(m)
+#else
+#  define Mutex_Lock(m)
+#  define Mutex_Unlock(m)
+#endif
+
+/**
+ * rom shared by the jobs
+ */
+typedef struct _BatchRom {
+	char*		path;
+	RomFile*	rom;
+	RomView*	view;
+	bool		loaded;		/* tried to load */
+	uint32		remaining;	/* the jobs which aren't done */
+#ifdef BATCH_THREAD
+	pthread_mutex_t	lock;
+#endif
+} BatchRom;
+
+/* string members of the job(strs) */
+enum {
+	JobStr_Rom,
+	JobStr_Output,
+	JobStr_Json,
+	JobStr_Csv,
+	JobStr_Bin,
+	JobStr_Export,
+	JobStr_Cfg,
+	JobStr_Trace,
+	JobStr_Cdl,
+	JobStr_Fingerprints,
+	JobStr_Label,
+	JobStr_Count
+};
+
+/**
+ * job in the manifest
+ */
+typedef struct _BatchJob {
+	DisAsmInf	inf;
+	uint32		romIndex;
+	uint32*		adrs;		/* entry points */
+	uint16*		psws;
+	uint32		entryCount;
+	char*		strs[JobStr_Count];	/* the strings owned by the job */
+	char*		message;
+	BatchResult	result;
+} BatchJob;
+
+/**
+ * Batch private members
+ */
+struct _Batch_private {
+	DisAsmInf	inf;
+	int		threads;
+	BankStore*	banks;		/* not owned */
+	BatchJob*	jobs;
+	uint32		jobCount;
+	uint32		jobSize;
+	BatchRom*	roms;
+	uint32		romCount;
+	uint32		romSize;
+	uint32*		order;		/* the jobs grouped by the rom */
+	uint32		next;
+	ulong		msec;		/* total time of the last run */
+#ifdef BATCH_THREAD
+	pthread_mutex_t	lock;		/* next */
+#endif
+};
+
+static const char* const JobStrKeys[JobStr_Count] = {
+	"rom", "output", "json", "csv", "bin", "export", "cfg", "trace", "cdl", "fingerprints", "label"
+};
+
+/* prototypes */
+static bool Load(Batch*, const char*);
+static void UseBankStore(Batch*, BankStore*);
+static bool Run(Batch*);
+static uint32 count_get(Batch*);
+static const BatchResult* Result(Batch*, const uint32);
+static void PrintSummary(Batch*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Batch object
+ *
+ * @param inf default options of the jobs
+ * @param threads worker threads
+ *
+ * @return the pointer of object
+ */
+Batch* new_Batch(const DisAsmInf* inf, const int threads)
+{
+	Batch* self;
+	Batch_private* pri;
+
+	assert(inf);
+
+	/* make objects */
+	self = malloc(sizeof(Batch));
+	pri = malloc(sizeof(Batch_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	memcpy(&pri->inf, inf, sizeof(DisAsmInf));
+	pri->inf.dbPath = NULL;
+	pri->inf.namesPath = NULL;	/* the fingerprint database is only read by the jobs */
+	pri->threads = (0 < threads) ? threads : 1;
+	pri->banks = NULL;
+	pri->jobs = NULL;
+	pri->jobCount = 0;
+	pri->jobSize = 0;
+	pri->roms = NULL;
+	pri->romCount = 0;
+	pri->romSize = 0;
+	pri->order = NULL;
+	pri->next = 0;
+	pri->msec = 0;
+#ifdef BATCH_THREAD
+	pthread_mutex_init(&pri->lock, NULL);
+#endif
+
+	/*--- set public member ---*/
+	self->Load = Load;
+	self->UseBankStore = UseBankStore;
+	self->Run = Run;
+	self->count_get = count_get;
+	self->Result = Result;
+	self->PrintSummary = PrintSummary;
+
+	/* init Batch object */
+	self->pri = pri;
+	return self;
+}
+
+static void ReleaseRom(BatchRom* rom)
+{
+	delete_RomView(&rom->view);
+	delete_RomFile(&rom->rom);
+}
+
+/**
+ * @brief Delete Batch object
+ *
+ * @param the pointer of object
+ */
+void delete_Batch(Batch** self)
+{
+	Batch_private* pri;
+	uint32 i;
+	int j;
+
+	assert(self);
+	if(NULL == (*self)) return;
+
+	pri = (*self)->pri;
+	for(i=0; i<pri->jobCount; i++)
+	{
+		for(j=0; j<JobStr_Count; j++)
+		{
+			free(pri->jobs[i].strs[j]);
+		}
+		free(pri->jobs[i].adrs);
+		free(pri->jobs[i].psws);
+		free(pri->jobs[i].message);
+	}
+	for(i=0; i<pri->romCount; i++)
+	{
+		ReleaseRom(&pri->roms[i]);
+		free(pri->roms[i].path);
+#ifdef BATCH_THREAD
+		pthread_mutex_destroy(&pri->roms[i].lock);
+#endif
+	}
+#ifdef BATCH_THREAD
+	pthread_mutex_destroy(&pri->lock);
+#endif
+	free(pri->jobs);
+	free(pri->roms);
+	free(pri->order);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- manifest ---------------*/
+
+static char* ReadText(const char* path)
+{
+	FILE* fp;
+	char* buf;
+	char* tmp;
+	size_t len = 0;
+	size_t size = ReadChunk;
+	size_t n;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return NULL;
+
+	buf = malloc(size);
+	assert(buf);
+	while(0 != (n = fread(&buf[len], 1, size - len - 1, fp)))
+	{
+		len += n;
+		if(len + 1 == size)
+		{
+			size *= 2;
+			tmp = realloc(buf, size);
+			assert(tmp);
+			buf = tmp;
+		}
+	}
+	buf[len] = '\0';
+	if(0 != ferror(fp))
+	{
+		free(buf);
+		buf = NULL;
+	}
+	fclose(fp);
+	return buf;
+}
+
+static uint32 FindRom(Batch_private* pri, const char* path)
+{
+	BatchRom* tmp;
+	uint32 i;
+
+	for(i=0; i<pri->romCount; i++)
+	{
+		if(0 == strcmp(pri->roms[i].path, path)) return i;
+	}
+
+	if(pri->romCount == pri->romSize)
+	{
+		pri->romSize = (0 == pri->romSize) ? 16 : pri->romSize * 2;
+		tmp = realloc(pri->roms, sizeof(BatchRom) * pri->romSize);
+		assert(tmp);
+		pri->roms = tmp;
+	}
+	pri->roms[i].path = Str_copy(path);
+	pri->roms[i].rom = NULL;
+	pri->roms[i].view = NULL;
+	pri->roms[i].loaded = false;
+	pri->roms[i].remaining = 0;
+#ifdef BATCH_THREAD
+	pthread_mutex_init(&pri->roms[i].lock, NULL);
+#endif
+	pri->romCount++;
+	return i;
+}
+
+/**
+ * Parse "$808000:a,$809000" to the entry points
+ */
+static bool ParseEntries(BatchJob* job, const char* text, char* err)
+{
+	char* list;
+	char* p;
+	char* comma;
+	uint32 n = 1;
+
+	for(p=(char*)text; '\0' != *p; p++)
+	{
+		if(',' == *p) n++;
+	}
+	job->adrs = malloc(sizeof(uint32) * n);
+	job->psws = malloc(sizeof(uint16) * n);
+	assert(job->adrs);
+	assert(job->psws);
+
+	list = Str_copy(text);
+	for(p=list; NULL != p; p=(NULL == comma) ? NULL : comma+1)
+	{
+		comma = strchr(p, ',');
+		if(NULL != comma) (*comma) = '\0';
+		if(false == DisAsm_ParseEntry(p, &job->inf, &job->adrs[job->entryCount], &job->psws[job->entryCount]))
+		{
+			sprintf(err, "Invalid entry point : %.64s", p);
+			free(list);
+			return false;
+		}
+		job->entryCount++;
+	}
+	free(list);
+	return true;
+}
+
+/**
+ * Make the job from the manifest object
+ */
+static bool ParseJob(Batch_private* pri, JsonObject* obj, BatchJob* job, char* err)
+{
+	JsonMember* m;
+	FilePath* fpath;
+	uint32 adr;
+	int i;
+	int j;
+
+	memcpy(&job->inf, &pri->inf, sizeof(DisAsmInf));
+	job->adrs = NULL;
+	job->psws = NULL;
+	job->entryCount = 0;
+	job->message = NULL;
+	for(j=0; j<JobStr_Count; j++)
+	{
+		job->strs[j] = NULL;
+	}
+
+	for(i=0; i<obj->count; i++)
+	{
+		m = &obj->members[i];
+		for(j=0; j<JobStr_Count; j++)
+		{
+			if(0 == strcmp(m->key, JobStrKeys[j])) break;
+		}
+		if(j < JobStr_Count)
+		{
+			if(JsonType_String != m->type)
+			{
+				sprintf(err, "\"%.32s\" must be a string", m->key);
+				return false;
+			}
+			job->strs[j] = Str_copy(m->str);
+		}
+		else if(0 == strcmp(m->key, "a") || 0 == strcmp(m->key, "x")
+		|| 0 == strcmp(m->key, "upper") || 0 == strcmp(m->key, "full")
+		|| 0 == strcmp(m->key, "gzip") || 0 == strcmp(m->key, "dataflow"))
+		{
+			if(JsonType_Bool != m->type)
+			{
+				sprintf(err, "\"%.32s\" must be true / false", m->key);
+				return false;
+			}
+			switch(m->key[0])
+			{
+				case 'a': job->inf.accum16bits = m->b; break;
+				case 'x': job->inf.index16bits = m->b; break;
+				case 'u': job->inf.enableUpper = m->b; break;
+				case 'f': job->inf.fullListing = m->b; break;
+				case 'd': job->inf.dataflow = m->b; break;
+				default: job->inf.compressOutput = m->b; break;
+			}
+		}
+		else if(0 == strcmp(m->key, "depth") || 0 == strcmp(m->key, "count")
+		|| 0 == strcmp(m->key, "split") || 0 == strcmp(m->key, "exec"))
+		{
+			if(JsonType_Number != m->type)
+			{
+				sprintf(err, "\"%.32s\" must be a number", m->key);
+				return false;
+			}
+			switch(m->key[0])
+			{
+				case 'd': job->inf.depthMax = (int)m->num; break;
+				case 'c': job->inf.dataCount = (int)m->num; break;
+				case 'e': job->inf.execSteps = (int)m->num; break;
+				default: job->inf.dataSplits = (int)m->num; break;
+			}
+		}
+		else if(0 == strcmp(m->key, "pc"))
+		{
+			if(false == Json_GetAddress(obj, "pc", &adr))
+			{
+				sprintf(err, "Invalid pc");
+				return false;
+			}
+			job->inf.progCounter = (int)adr;
+		}
+		else if(0 != strcmp(m->key, "entry"))
+		{
+			sprintf(err, "Unknown member \"%.32s\"", m->key);
+			return false;
+		}
+	}
+
+	if(NULL == job->strs[JobStr_Rom])
+	{
+		sprintf(err, "\"rom\" isn't given");
+		return false;
+	}
+
+	/* the entry points are parsed with the job's a / x */
+	m = Json_Get(obj, "entry");
+	if(NULL != m)
+	{
+		if(JsonType_String != m->type)
+		{
+			sprintf(err, "\"entry\" must be a string");
+			return false;
+		}
+		if(false == ParseEntries(job, m->str, err)) return false;
+	}
+
+	/* the options are pointed to the job's strings */
+	if(NULL == job->strs[JobStr_Output])
+	{
+		fpath = new_FilePath(job->strs[JobStr_Rom]);
+		fpath->ext_set(fpath, job->inf.compressOutput ? ".asm.gz" : ".asm");
+		job->strs[JobStr_Output] = Str_copy(fpath->path_get(fpath));
+		delete_FilePath(&fpath);
+	}
+	job->inf.outputPath = job->strs[JobStr_Output];
+	job->inf.jsonPath = job->strs[JobStr_Json];
+	job->inf.csvPath = job->strs[JobStr_Csv];
+	job->inf.binPath = job->strs[JobStr_Bin];
+	job->inf.exportBinPath = job->strs[JobStr_Export];
+	job->inf.cfgPath = job->strs[JobStr_Cfg];
+	if(NULL != job->strs[JobStr_Trace]) job->inf.tracePath = job->strs[JobStr_Trace];
+	if(NULL != job->strs[JobStr_Cdl]) job->inf.cdlPath = job->strs[JobStr_Cdl];
+	if(NULL != job->strs[JobStr_Fingerprints]) job->inf.fingerprintPath = job->strs[JobStr_Fingerprints];
+	if(NULL != job->strs[JobStr_Label]) job->inf.dataLabel = job->strs[JobStr_Label];
+
+	job->romIndex = FindRom(pri, job->strs[JobStr_Rom]);
+	job->result.rom = pri->roms[job->romIndex].path;
+	job->result.output = job->inf.outputPath;
+	job->result.ok = false;
+	job->result.msec = 0;
+	job->result.message = NULL;
+	return true;
+}
+
+static BatchJob* NewJob(Batch_private* pri)
+{
+	BatchJob* tmp;
+
+	if(pri->jobCount == pri->jobSize)
+	{
+		pri->jobSize = (0 == pri->jobSize) ? 16 : pri->jobSize * 2;
+		tmp = realloc(pri->jobs, sizeof(BatchJob) * pri->jobSize);
+		assert(tmp);
+		pri->jobs = tmp;
+	}
+	return &pri->jobs[pri->jobCount];
+}
+
+static void FreeJob(BatchJob* job)
+{
+	int j;
+
+	for(j=0; j<JobStr_Count; j++)
+	{
+		free(job->strs[j]);
+	}
+	free(job->adrs);
+	free(job->psws);
+}
+
+static bool Load(Batch* self, const char* path)
+{
+	Batch_private* pri;
+	JsonObject obj;
+	BatchJob* job;
+	char err[ErrorLen];
+	char* text;
+	const char* cur;
+	bool result = true;
+
+	assert(self);
+	pri = self->pri;
+
+	text = ReadText(path);
+	if(NULL == text)
+	{
+		puterror("Can't open \"%s\".", path);
+		return false;
+	}
+
+	for(cur=text; (' ' == *cur) || ('\t' == *cur) || ('\r' == *cur) || ('\n' == *cur); cur++);
+	if('[' != *cur)
+	{
+		puterror("%s : The manifest must be an array of the jobs.", path);
+		free(text);
+		return false;
+	}
+	for(cur++; (' ' == *cur) || ('\t' == *cur) || ('\r' == *cur) || ('\n' == *cur); cur++);
+
+	while(']' != *cur)
+	{
+		if(false == Json_ParseNext(&obj, &cur))
+		{
+			puterror("%s : Invalid job %lu.", path, (ulong)pri->jobCount + 1);
+			free(obj.buf);
+			result = false;
+			break;
+		}
+
+		job = NewJob(pri);
+		if(false == ParseJob(pri, &obj, job, err))
+		{
+			puterror("%s : Invalid job %lu : %s", path, (ulong)pri->jobCount + 1, err);
+			FreeJob(job);
+			free(obj.buf);
+			result = false;
+			break;
+		}
+		pri->jobCount++;
+		free(obj.buf);
+	}
+
+	free(text);
+	return result;
+}
+
+
+/*--------------- run ---------------*/
+
+/* monotonic time(msec) */
+static ulong Now(void)
+{
+#ifdef BATCH_THREAD
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ulong)ts.tv_sec * 1000 + (ulong)(ts.tv_nsec / 1000000);
+#else
+	return (ulong)((double)clock() * 1000 / CLOCKS_PER_SEC);
+#endif
+}
+
+static void SetMessage(BatchJob* job, const char* fmt, ...)
+{
+	va_list args;
+	char buf[ErrorLen];
+
+	if(NULL != job->message) return;
+
+	va_start(args, fmt);
+	vsnprintf(buf, ErrorLen, fmt, args);
+	va_end(args);
+	job->message = Str_copy(buf);
+	job->result.message = job->message;
+}
+
+static TextFile* OpenOutput(BatchJob* job, const char* path, const char* mode, bool* ok)
+{
+	TextFile* f;
+
+	if(NULL == path) return NULL;
+
+	f = new_TextFile(path);
+	f->compress_set(f, job->inf.compressOutput);
+	if(FileOpen_NoError != f->Open2(f, mode))
+	{
+		SetMessage(job, "Can't open \"%s\"", path);
+		delete_TextFile(&f);
+		(*ok) = false;
+	}
+	return f;
+}
+
+static bool CloseOutput(BatchJob* job, TextFile** f)
+{
+	bool result = true;
+
+	if(NULL == (*f)) return true;
+
+	if(false == (*f)->Close(*f))
+	{
+		SetMessage(job, "Write failed : %s", (*f)->super.path_get(&(*f)->super));
+		result = false;
+	}
+	delete_TextFile(f);
+	return result;
+}
+
+/**
+ * Disassemble the shared rom to the job's outputs
+ *   The diagnostics aren't printed, the first error is kept in the result.
+ */
+static bool RunJob(BatchJob* job, const RomView* view, BankStore* banks)
+{
+	TextFile* fasm;
+	TextFile* fjson;
+	TextFile* fcsv;
+	TextFile* fbin;
+	DisAsmContext* ctx;
+	const DisAsmDiag* d;
+	const DisAsmDiag* first = NULL;
+	bool ok = true;
+	bool result;
+	uint32 i;
+
+	fasm = OpenOutput(job, job->inf.outputPath, "w", &ok);
+	fjson = OpenOutput(job, job->inf.jsonPath, "w", &ok);
+	fcsv = OpenOutput(job, job->inf.csvPath, "w", &ok);
+	fbin = OpenOutput(job, job->inf.binPath, "wb", &ok);
+	if(false == ok)
+	{
+		delete_TextFile(&fasm);
+		delete_TextFile(&fjson);
+		delete_TextFile(&fcsv);
+		delete_TextFile(&fbin);
+		return false;
+	}
+
+	ctx = new_DisAsmContext(&job->inf);
+	for(i=0; i<job->entryCount; i++)
+	{
+		ctx->AddEntry(ctx, job->adrs[i], job->psws[i]);
+	}
+	ctx->AddSink(ctx, new_AsmSink(fasm, job->inf.enableUpper));
+	if(NULL != fjson) ctx->AddSink(ctx, new_JsonSink(fjson));
+	if(NULL != fcsv) ctx->AddSink(ctx, new_CsvSink(fcsv));
+	if(NULL != fbin) ctx->AddSink(ctx, new_BinSink(fbin));
+	if(NULL != banks) ctx->UseBankStore(ctx, banks);
+
+	result = ctx->RunView(ctx, view);
+
+	/* the error first, the warning next */
+	for(i=0; i<ctx->diagCount_get(ctx); i++)
+	{
+		d = ctx->Diag(ctx, i);
+		if(DisAsmDiag_Info == d->level) continue;
+		if((NULL == first) || ((DisAsmDiag_Error == d->level) && (DisAsmDiag_Error != first->level)))
+		{
+			first = d;
+		}
+	}
+	if(NULL != first) SetMessage(job, "%s", first->message);
+	delete_DisAsmContext(&ctx);
+
+	result &= CloseOutput(job, &fasm);
+	result &= CloseOutput(job, &fjson);
+	result &= CloseOutput(job, &fcsv);
+	result &= CloseOutput(job, &fbin);
+	if(false == result) SetMessage(job, "Failed");
+	return result;
+}
+
+/**
+ * Get the shared view(the rom is loaded by the first job)
+ */
+static const RomView* AcquireRom(BatchRom* rom)
+{
+	const RomView* view;
+
+	Mutex_Lock(&rom->lock);
+	if(false == rom->loaded)
+	{
+		rom->loaded = true;
+		rom->rom = new_RomFile(rom->path);
+		if(FileOpen_NoError == rom->rom->Open(rom->rom))
+		{
+			rom->view = new_RomView(rom->rom);
+		}
+		else
+		{
+			delete_RomFile(&rom->rom);
+		}
+	}
+	view = rom->view;
+	Mutex_Unlock(&rom->lock);
+	return view;
+}
+
+/**
+ * Release the rom after its last job
+ */
+static void ReturnRom(BatchRom* rom)
+{
+	Mutex_Lock(&rom->lock);
+	rom->remaining--;
+	if(0 == rom->remaining)
+	{
+		ReleaseRom(rom);
+	}
+	Mutex_Unlock(&rom->lock);
+}
+
+static void* Worker(void* arg)
+{
+	Batch_private* pri = (Batch_private*)arg;
+	BatchJob* job;
+	BatchRom* rom;
+	const RomView* view;
+	ulong start;
+
+	for(;;)
+	{
+		Mutex_Lock(&pri->lock);
+		job = (pri->next < pri->jobCount) ? &pri->jobs[pri->order[pri->next++]] : NULL;
+		Mutex_Unlock(&pri->lock);
+		if(NULL == job) break;
+
+		start = Now();
+		rom = &pri->roms[job->romIndex];
+		view = AcquireRom(rom);
+		if(NULL == view)
+		{
+			SetMessage(job, "Can't open \"%s\"", rom->path);
+			job->result.ok = false;
+		}
+		else
+		{
+			job->result.ok = RunJob(job, view, pri->banks);
+		}
+		ReturnRom(rom);
+		job->result.msec = Now() - start;
+	}
+	return NULL;
+}
+
+static void UseBankStore(Batch* self, BankStore* banks)
+{
+	assert(self);
+	self->pri->banks = banks;
+}
+
+/**
+ * Group the jobs by the rom(counting sort, the manifest order is kept)
+ */
+static void SortOrder(Batch_private* pri)
+{
+	uint32* counts;
+	uint32 i;
+
+	counts = calloc(pri->romCount + 1, sizeof(uint32));
+	assert(counts);
+	for(i=0; i<pri->jobCount; i++)
+	{
+		counts[pri->jobs[i].romIndex + 1]++;
+	}
+	for(i=0; i<pri->romCount; i++)
+	{
+		counts[i+1] += counts[i];
+	}
+	for(i=0; i<pri->jobCount; i++)
+	{
+		pri->order[counts[pri->jobs[i].romIndex]++] = i;
+	}
+	free(counts);
+}
+
+static bool Run(Batch* self)
+{
+	Batch_private* pri;
+	ulong start;
+	uint32 i;
+	bool result = true;
+#ifdef BATCH_THREAD
+	pthread_t* workers;
+	int started = 0;
+	int n;
+#endif
+
+	assert(self);
+	pri = self->pri;
+	start = Now();
+
+	free(pri->order);
+	pri->order = malloc(sizeof(uint32) * (pri->jobCount + 1));
+	assert(pri->order);
+	SortOrder(pri);
+	pri->next = 0;
+
+	/* the roms are loaded again in the next run */
+	for(i=0; i<pri->romCount; i++)
+	{
+		ReleaseRom(&pri->roms[i]);
+		pri->roms[i].loaded = false;
+		pri->roms[i].remaining = 0;
+	}
+	for(i=0; i<pri->jobCount; i++)
+	{
+		pri->roms[pri->jobs[i].romIndex].remaining++;
+		free(pri->jobs[i].message);
+		pri->jobs[i].message = NULL;
+		pri->jobs[i].result.message = NULL;
+	}
+
+#ifdef BATCH_THREAD
+	n = ((uint32)pri->threads < pri->jobCount) ? pri->threads : (int)pri->jobCount;
+	workers = malloc(sizeof(pthread_t) * (size_t)(n + 1));
+	assert(workers);
+	for(started=0; started<n; started++)
+	{
+		if(0 != pthread_create(&workers[started], NULL, Worker, pri)) break;
+	}
+	/* no worker thread, the jobs are run on this thread */
+	if(0 == started) Worker(pri);
+	for(i=0; i<(uint32)started; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+#else
+	Worker(pri);
+#endif
+
+	for(i=0; i<pri->jobCount; i++)
+	{
+		result &= pri->jobs[i].result.ok;
+	}
+	pri->msec = Now() - start;
+	return result;
+}
+
+
+/*--------------- results ---------------*/
+
+static uint32 count_get(Batch* self)
+{
+	assert(self);
+	return self->pri->jobCount;
+}
+
+static const BatchResult* Result(Batch* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->jobCount <= inx) return NULL;
+	return &self->pri->jobs[inx].result;
+}
+
+static void PrintSummary(Batch* self)
+{
+	Batch_private* pri;
+	const BatchResult* r;
+	uint32 failed = 0;
+	uint32 i;
+
+	assert(self);
+	pri = self->pri;
+
+	for(i=0; i<pri->jobCount; i++)
+	{
+		r = &pri->jobs[i].result;
+		if(false == r->ok) failed++;
+		printf("%-4s %6lu ms  %s -> %s", r->ok ? "ok" : "NG", r->msec, r->rom, r->output);
+		if(NULL != r->message) printf(" : %s", r->message);
+		printf("\n");
+	}
+	printf("%lu jobs, %lu succeeded, %lu failed (%lu roms, %lu ms)\n",
+			(ulong)pri->jobCount, (ulong)(pri->jobCount - failed), (ulong)failed,
+			(ulong)pri->romCount, pri->msec);
+}
@@ -0,0 +1,163 @@
+/**
+ * BinSink.c
+ *   fixed-width binary record output
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "Sink.protected.h"
+
+/* prototypes */
+static void Label(Sink*, const uint32, const char*);
+static void Group(Sink*, const GroupInfo*);
+static void Insn(Sink*, const Instruction*);
+static void Data(Sink*, const uint32, const uint32, const uint8*, const size_t);
+static bool End(Sink*);
+
+
+/*--------------- Constructor ---------------*/
+
+/**
+ * @brief Create BinSink object
+ *
+ * @return the pointer of object
+ */
+Sink* new_BinSink(TextFile* out)
+{
+	Sink* self;
+
+	assert(out);
+	self = new_Sink(out);
+
+	/*--- override ---*/
+	self->Label = Label;
+	self->Group = Group;
+	self->Insn = Insn;
+	self->Data = Data;
+	self->End = End;
+
+	return self;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void PutRecord(Sink* self, const uint8* rec)
+{
+	TextFile* out;
+
+	out = self->pro->out;
+	if(false == self->pro->headed)
+	{
+		uint8 head[BinSink_RecordSize] = {0};
+
+		memcpy(head, BinSink_Magic, 8);
+		write16(&head[8], BinSink_Version);
+		write16(&head[10], BinSink_RecordSize);
+		if(false == out->Write(out, head, BinSink_RecordSize))
+		{
+			self->pro->failed = true;
+		}
+		self->pro->headed = true;
+	}
+	if(NULL == rec) return;
+
+	if(false == out->Write(out, rec, BinSink_RecordSize))
+	{
+		self->pro->failed = true;
+	}
+}
+
+static void Label(Sink* self, const uint32 snesadr, const char* name)
+{
+	uint8 rec[BinSink_RecordSize];
+	size_t len;
+	size_t i;
+	size_t n;
+
+	assert(self);
+	len = strlen(name);
+
+	/* 4 bytes per record, as the data */
+	for(i=0; i<len; i+=n)
+	{
+		n = len - i;
+		if(4 < n) n = 4;
+
+		memset(rec, 0, sizeof(rec));
+		rec[0] = BinRecord_Label;
+		rec[1] = (uint8)n;
+		write32(&rec[4], snesadr);
+		write32(&rec[8], (uint32)i);
+		memcpy(&rec[12], &name[i], n);
+		PutRecord(self, rec);
+	}
+}
+
+static void Group(Sink* self, const GroupInfo* grp)
+{
+	uint8 rec[BinSink_RecordSize] = {0};
+
+	assert(self);
+	rec[0] = BinRecord_Group;
+	rec[2] = (uint8)grp->psw;
+	rec[3] = (uint8)grp->depth;
+	write32(&rec[4], grp->snesadr);
+	write32(&rec[8], grp->callFrom);
+	PutRecord(self, rec);
+}
+
+static void Insn(Sink* self, const Instruction* ins)
+{
+	uint8 rec[BinSink_RecordSize] = {0};
+
+	assert(self);
+	rec[0] = BinRecord_Insn;
+	rec[1] = (uint8)(ins->arglen+1);
+	rec[2] = (uint8)ins->psw;
+	write32(&rec[4], ins->snesadr);
+	write32(&rec[8], ins->pcadr);
+	rec[12] = ins->op;
+	memcpy(&rec[13], ins->arg, sizeof(ins->arg));
+	PutRecord(self, rec);
+}
+
+static void Data(Sink* self, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	uint8 rec[BinSink_RecordSize];
+	size_t i;
+	size_t n;
+
+	assert(self);
+
+	/* 4 bytes per record */
+	for(i=0; i<len; i+=n)
+	{
+		n = len - i;
+		if(4 < n) n = 4;
+
+		memset(rec, 0, sizeof(rec));
+		rec[0] = BinRecord_Data;
+		rec[1] = (uint8)n;
+		write32(&rec[4], (uint32)(snesadr + i));
+		write32(&rec[8], (uint32)(pcadr + i));
+		memcpy(&rec[12], &data[i], n);
+		PutRecord(self, rec);
+	}
+}
+
+static bool End(Sink* self)
+{
+	assert(self);
+
+	/* empty output still has the header */
+	PutRecord(self, NULL);
+	return !self->pro->failed;
+}
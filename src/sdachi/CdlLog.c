@@ -0,0 +1,291 @@
+/**
+ * CdlLog.c
+ *   code / data log import
+ */
+#include "common/types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/CdlLog.h"
+
+#define HeaderMagic	"CDLv2"
+#define HeaderSize	9	/* the magic and the crc32 */
+#define InitialRegions	256
+
+/* the code region is broken by these(the head of the instruction) */
+#define CodeBreak	(CdlLog_Code | CdlLog_JumpTarget | CdlLog_SubEntry)
+
+/* the byte in each byte of the word */
+#define Repeat8(b)	((uint64)(b) * ((((uint64)0x01010101) << 32) | 0x01010101))
+
+/**
+ * CdlLog private members
+ */
+struct _CdlLog_private {
+	const RomView*	from;
+	uint8*		flags;
+	uint32		size;
+	CdlRegion*	regions;
+	uint32		count;
+	uint32		capacity;
+	uint32		hash;
+	uint32		codeBytes;
+	uint32		dataBytes;
+};
+
+/* prototypes */
+static bool Load(CdlLog*, const char*);
+static uint8 Flags(CdlLog*, const uint32);
+static uint32 regionCount_get(CdlLog*);
+static const CdlRegion* Region(CdlLog*, const uint32);
+static uint32 Hash(CdlLog*);
+static uint32 codeBytes_get(CdlLog*);
+static uint32 dataBytes_get(CdlLog*);
+static size_t bytes_get(CdlLog*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create CdlLog object
+ *
+ * @param from rom
+ *
+ * @return the pointer of object
+ */
+CdlLog* new_CdlLog(const RomView* from)
+{
+	CdlLog* self;
+	CdlLog_private* pri;
+
+	assert(from);
+
+	/* make objects */
+	self = malloc(sizeof(CdlLog));
+	pri = malloc(sizeof(CdlLog_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->flags = NULL;
+	pri->size = 0;
+	pri->regions = NULL;
+	pri->count = 0;
+	pri->capacity = 0;
+	pri->hash = 0;
+	pri->codeBytes = 0;
+	pri->dataBytes = 0;
+
+	/*--- set public member ---*/
+	self->Load = Load;
+	self->Flags = Flags;
+	self->regionCount_get = regionCount_get;
+	self->Region = Region;
+	self->Hash = Hash;
+	self->codeBytes_get = codeBytes_get;
+	self->dataBytes_get = dataBytes_get;
+	self->bytes_get = bytes_get;
+
+	/* init CdlLog object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete CdlLog object
+ *
+ * @param the pointer of object
+ */
+void delete_CdlLog(CdlLog** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	free((*self)->pri->flags);
+	free((*self)->pri->regions);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- regions ---------------*/
+
+/**
+ * End of the run of the bytes which are ((flags & mask) == value)
+ *   The bytes are compared by 8 in a word, and the rest byte by byte.
+ */
+static uint32 RunEnd(const uint8* flags, uint32 pos, const uint32 size, const uint8 mask, const uint8 value)
+{
+	const uint64 m = Repeat8(mask);
+	const uint64 v = Repeat8(value);
+	uint64 w;
+
+	while(pos + 8 <= size)
+	{
+		memcpy(&w, &flags[pos], 8);
+		if(v != (w & m)) break;
+		pos += 8;
+	}
+	while((pos < size) && (value == (flags[pos] & mask))) pos++;
+	return pos;
+}
+
+static void AddRegion(CdlLog_private* pri, const uint32 pcadr, const uint32 size, const uint8 flags)
+{
+	CdlRegion* r;
+
+	if(pri->capacity <= pri->count)
+	{
+		pri->capacity = (0 == pri->capacity) ? InitialRegions : pri->capacity * 2;
+		pri->regions = realloc(pri->regions, sizeof(CdlRegion) * pri->capacity);
+		assert(pri->regions);
+	}
+	r = &pri->regions[pri->count++];
+	r->pcadr = pcadr;
+	r->size = size;
+	r->flags = flags;
+}
+
+/**
+ * Make the runs of the code / the data into the regions
+ */
+static void MakeRegions(CdlLog_private* pri)
+{
+	const uint8* flags = pri->flags;
+	uint32 pos = 0;
+	uint32 end;
+	uint8 f;
+
+	while(pos < pri->size)
+	{
+		f = flags[pos];
+		if(0 != (f & CdlLog_Code))
+		{
+			end = RunEnd(flags, pos + 1, pri->size, CodeBreak, CdlLog_Code);
+			AddRegion(pri, pos, end - pos, (uint8)(f & (CdlLog_Code | CdlLog_M8 | CdlLog_X8)));
+			pri->codeBytes += end - pos;
+		}
+		else if(0 != (f & CdlLog_Data))
+		{
+			end = RunEnd(flags, pos + 1, pri->size, CdlLog_Code | CdlLog_Data, CdlLog_Data);
+			AddRegion(pri, pos, end - pos, CdlLog_Data);
+			pri->dataBytes += end - pos;
+		}
+		else
+		{
+			/* not logged */
+			end = RunEnd(flags, pos + 1, pri->size, CdlLog_Code | CdlLog_Data, 0);
+		}
+		pos = end;
+	}
+}
+
+
+/*--------------- methods ---------------*/
+
+static bool Load(CdlLog* self, const char* path)
+{
+	CdlLog_private* pri;
+	FILE* fp;
+	uint8 head[HeaderSize];
+	long len;
+	uint32 size;
+	uint32 i;
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return false;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	size = pri->from->size_get(pri->from);
+
+	/* the flags, or the header and the flags */
+	if(((long)size != len)
+	&& (((long)size + HeaderSize != len)
+	 || (HeaderSize != fread(head, 1, HeaderSize, fp))
+	 || (0 != memcmp(head, HeaderMagic, strlen(HeaderMagic)))))
+	{
+		fclose(fp);
+		return false;
+	}
+
+	free(pri->flags);
+	pri->flags = malloc(size);
+	assert(pri->flags);
+	pri->size = 0;
+	pri->count = 0;
+	pri->codeBytes = 0;
+	pri->dataBytes = 0;
+	if(size != fread(pri->flags, 1, size, fp))
+	{
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+	pri->size = size;
+
+	pri->hash = 0x811c9dc5;
+	for(i=0; i<size; i++)
+	{
+		pri->hash = (pri->hash ^ pri->flags[i]) * 0x01000193;
+	}
+	MakeRegions(pri);
+	return true;
+}
+
+static uint8 Flags(CdlLog* self, const uint32 pcadr)
+{
+	assert(self);
+	if(self->pri->size <= pcadr) return 0;
+	return self->pri->flags[pcadr];
+}
+
+static uint32 regionCount_get(CdlLog* self)
+{
+	assert(self);
+	return self->pri->count;
+}
+
+static const CdlRegion* Region(CdlLog* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return NULL;
+	return &self->pri->regions[inx];
+}
+
+static uint32 Hash(CdlLog* self)
+{
+	assert(self);
+	return self->pri->hash;
+}
+
+static uint32 codeBytes_get(CdlLog* self)
+{
+	assert(self);
+	return self->pri->codeBytes;
+}
+
+static uint32 dataBytes_get(CdlLog* self)
+{
+	assert(self);
+	return self->pri->dataBytes;
+}
+
+static size_t bytes_get(CdlLog* self)
+{
+	assert(self);
+	return sizeof(CdlLog) + sizeof(CdlLog_private)
+		+ self->pri->size
+		+ sizeof(CdlRegion) * self->pri->capacity;
+}
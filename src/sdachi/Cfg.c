@@ -0,0 +1,718 @@
+/**
+ * Cfg.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Cfg.h"
+
+/* bitmap (1 bit per record) */
+#define Bit_Test(map, i)	(0 != ((map)[(i)>>3] & (1u << ((i)&7))))
+#define Bit_Set(map, i)		((map)[(i)>>3] = (uint8)((map)[(i)>>3] | (1u << ((i)&7))))
+
+/* the instruction text of the dot label */
+#define InsnTextLen	32
+
+/**
+ * control flow of the instruction
+ */
+typedef enum {
+	Flow_Next,
+	Flow_Branch,		/* conditional */
+	Flow_Jump,
+	Flow_Call,
+	Flow_Return,
+	Flow_Indirect
+} Flow;
+
+/**
+ * Cfg private members
+ */
+struct _Cfg_private {
+	const RomView*	from;
+	InsnStore*	store;
+	CfgBlock*	blocks;
+	uint32		blockCount;
+	uint32*		succStart;	/* blockCount + 1 */
+	uint32*		succ;
+	uint32*		predStart;
+	uint32*		pred;
+	uint32		edgeCount;
+	uint32*		routineStart;	/* routineCount + 1 */
+	uint32*		routineBlocks;
+	uint32		routineCount;
+};
+
+/* prototypes */
+static uint32 blockCount_get(Cfg*);
+static const CfgBlock* Block(Cfg*, const uint32);
+static uint32 BlockOf(Cfg*, const uint32);
+static uint32 Successors(Cfg*, const uint32, const uint32**);
+static uint32 Predecessors(Cfg*, const uint32, const uint32**);
+static uint32 routineCount_get(Cfg*);
+static uint32 RoutineBlocks(Cfg*, const uint32, const uint32**);
+static bool WriteJson(Cfg*, TextFile*);
+static bool WriteDot(Cfg*, TextFile*);
+static size_t bytes_get(Cfg*);
+static void Build(Cfg_private*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Cfg object
+ *
+ * @param from analyzed rom
+ * @param store sorted pass1 store
+ *
+ * @return the pointer of object
+ */
+Cfg* new_Cfg(const RomView* from, InsnStore* store)
+{
+	Cfg* self;
+	Cfg_private* pri;
+
+	assert(from);
+	assert(store);
+
+	/* make objects */
+	self = malloc(sizeof(Cfg));
+	pri = malloc(sizeof(Cfg_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->store = store;
+	Build(pri);
+
+	/*--- set public member ---*/
+	self->blockCount_get = blockCount_get;
+	self->Block = Block;
+	self->BlockOf = BlockOf;
+	self->Successors = Successors;
+	self->Predecessors = Predecessors;
+	self->routineCount_get = routineCount_get;
+	self->RoutineBlocks = RoutineBlocks;
+	self->WriteJson = WriteJson;
+	self->WriteDot = WriteDot;
+	self->bytes_get = bytes_get;
+
+	/* init Cfg object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Cfg object
+ *
+ * @param the pointer of object
+ */
+void delete_Cfg(Cfg** self)
+{
+	Cfg_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	free(pri->blocks);
+	free(pri->succStart);
+	free(pri->succ);
+	free(pri->predStart);
+	free(pri->pred);
+	free(pri->routineStart);
+	free(pri->routineBlocks);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- build ---------------*/
+
+static Flow FlowOf(const uint8 op)
+{
+	switch(op)
+	{
+		case 0x40:	/* rti */
+		case 0x60:	/* rts */
+		case 0x6b:	/* rtl */
+			return Flow_Return;
+
+		case 0x6c:	/* jmp (abs) */
+		case 0x7c:	/* jmp (abs,x) */
+		case 0xdc:	/* jml [abs] */
+			return Flow_Indirect;
+
+		case 0x10:	/* bpl */
+		case 0x30:	/* bmi */
+		case 0x50:	/* bvc */
+		case 0x70:	/* bvs */
+		case 0x90:	/* bcc */
+		case 0xb0:	/* bcs */
+		case 0xd0:	/* bne */
+		case 0xf0:	/* beq */
+			return Flow_Branch;
+
+		case 0x80:	/* bra */
+		case 0x82:	/* brl */
+		case 0x4c:	/* jmp */
+		case 0x5c:	/* jml */
+			return Flow_Jump;
+
+		case 0x20:	/* jsr */
+		case 0x22:	/* jsl */
+			return Flow_Call;
+
+		default:
+			break;
+	}
+	return Flow_Next;
+}
+
+/**
+ * Record index of the static destination
+ *   return:
+ *     record index, or InsnStore_NotFound
+ */
+static uint32 TargetIndex(Cfg_private* pri, const Instruction* ins, const Flow flow)
+{
+	uint32 target;
+	uint32 pca;
+
+	if(Flow_Next == flow) return InsnStore_NotFound;
+	if(false == Opcode_Target(ins, &target)) return InsnStore_NotFound;
+	pca = pri->from->Snes2PcAdr(pri->from, target);
+	if(ROMADDRESS_NULL == pca) return InsnStore_NotFound;
+	return pri->store->Search(pri->store, pca);
+}
+
+/**
+ * Block of the record
+ */
+static uint32 BlockOfRecord(Cfg_private* pri, const uint32 inx)
+{
+	uint32 lo = 0;
+	uint32 hi = pri->blockCount;
+	uint32 mid;
+
+	/* the last block which starts at or before the record */
+	while(1 < hi - lo)
+	{
+		mid = lo + (hi-lo)/2;
+		if(pri->blocks[mid].first <= inx)
+		{
+			lo = mid;
+			continue;
+		}
+		hi = mid;
+	}
+	return lo;
+}
+
+/**
+ * Split the records into the blocks
+ */
+static void MakeBlocks(Cfg_private* pri, uint8* jumped, uint8* called)
+{
+	InsnStore* store = pri->store;
+	const InsnRec* rec;
+	Instruction ins;
+	CfgBlock* b = NULL;
+	uint8* leader;
+	Flow flow = Flow_Return;
+	uint32 count;
+	uint32 next = 0;
+	uint32 nextSnes = 0;
+	uint32 t;
+	uint32 i;
+
+	count = store->count_get(store);
+	leader = calloc((size_t)(count/8 + 1), sizeof(uint8));
+	assert(leader);
+
+	for(i=0; i<count; i++)
+	{
+		rec = store->Record(store, i);
+		InsnRec_Decode(rec, pri->from, &ins);
+
+		/* after the transfer, the group head, or the gap */
+		if((Flow_Next != flow && Flow_Call != flow)
+		|| (0 != (rec->flags & InsnRec_GroupHead))
+		|| (ins.pcadr != next) || (ins.snesadr != nextSnes))
+		{
+			Bit_Set(leader, i);
+		}
+
+		flow = FlowOf(ins.op);
+		t = TargetIndex(pri, &ins, flow);
+		if(InsnStore_NotFound != t)
+		{
+			Bit_Set(leader, t);
+			if(Flow_Call == flow) Bit_Set(called, t);
+			else Bit_Set(jumped, t);
+		}
+		next = ins.pcadr + 1 + (uint32)ins.arglen;
+		nextSnes = ins.snesadr + 1 + (uint32)ins.arglen;
+	}
+
+	pri->blockCount = 0;
+	for(i=0; i<count; i++)
+	{
+		if(Bit_Test(leader, i)) pri->blockCount++;
+	}
+	pri->blocks = malloc(sizeof(CfgBlock) * (pri->blockCount + 1));
+	assert(pri->blocks);
+
+	pri->blockCount = 0;
+	for(i=0; i<count; i++)
+	{
+		rec = store->Record(store, i);
+		if(Bit_Test(leader, i))
+		{
+			b = &pri->blocks[pri->blockCount++];
+			b->first = i;
+			b->count = 0;
+			b->snesadr = InsnRec_Snes(rec);
+			b->routine = Cfg_NotFound;
+			b->flags = 0;
+		}
+		b->count++;
+		b->endSnes = InsnRec_Snes(rec) + InsnRec_Length(rec, pri->from);
+	}
+	free(leader);
+}
+
+/**
+ * Make the successors / predecessors
+ */
+static void MakeEdges(Cfg_private* pri)
+{
+	InsnStore* store = pri->store;
+	CfgBlock* b;
+	const InsnRec* last;
+	const InsnRec* head;
+	Instruction ins;
+	uint32* from;
+	uint32* to;
+	uint32 edges = 0;
+	uint32 fall;
+	uint32 t;
+	uint32 i;
+	Flow flow;
+
+	from = malloc(sizeof(uint32) * ((size_t)pri->blockCount * 2 + 1));
+	to = malloc(sizeof(uint32) * ((size_t)pri->blockCount * 2 + 1));
+	pri->succStart = calloc((size_t)pri->blockCount + 1, sizeof(uint32));
+	pri->predStart = calloc((size_t)pri->blockCount + 1, sizeof(uint32));
+	assert(from);
+	assert(to);
+	assert(pri->succStart);
+	assert(pri->predStart);
+
+	for(i=0; i<pri->blockCount; i++)
+	{
+		b = &pri->blocks[i];
+		last = store->Record(store, b->first + b->count - 1);
+		InsnRec_Decode(last, pri->from, &ins);
+		flow = FlowOf(ins.op);
+		if(Flow_Return == flow) b->flags |= CfgBlock_Return;
+		if(Flow_Indirect == flow) b->flags |= CfgBlock_Indirect;
+
+		/* fall through to the next block */
+		fall = Cfg_NotFound;
+		if(((Flow_Next == flow) || (Flow_Branch == flow) || (Flow_Call == flow))
+		&& (i+1 < pri->blockCount))
+		{
+			head = store->Record(store, pri->blocks[i+1].first);
+			if((InsnRec_Pc(head) == ins.pcadr + 1 + (uint32)ins.arglen)
+			&& (InsnRec_Snes(head) == b->endSnes))
+			{
+				fall = i+1;
+				from[edges] = i;
+				to[edges++] = fall;
+			}
+		}
+
+		if((Flow_Branch == flow) || (Flow_Jump == flow))
+		{
+			t = TargetIndex(pri, &ins, flow);
+			if(InsnStore_NotFound != t)
+			{
+				t = BlockOfRecord(pri, t);
+				if(t != fall)
+				{
+					from[edges] = i;
+					to[edges++] = t;
+				}
+			}
+		}
+	}
+	pri->edgeCount = edges;
+
+	/* CSR (the edges are made in the order of the source block) */
+	pri->succ = malloc(sizeof(uint32) * (edges + 1));
+	pri->pred = malloc(sizeof(uint32) * (edges + 1));
+	assert(pri->succ);
+	assert(pri->pred);
+	for(i=0; i<edges; i++)
+	{
+		pri->succStart[from[i]+1]++;
+		pri->predStart[to[i]+1]++;
+	}
+	for(i=0; i<pri->blockCount; i++)
+	{
+		pri->succStart[i+1] += pri->succStart[i];
+		pri->predStart[i+1] += pri->predStart[i];
+	}
+	for(i=0; i<edges; i++)
+	{
+		pri->succ[i] = to[i];
+		pri->pred[pri->predStart[to[i]]++] = from[i];
+	}
+	for(i=pri->blockCount; 0 < i; i--)
+	{
+		pri->predStart[i] = pri->predStart[i-1];
+	}
+	pri->predStart[0] = 0;
+
+	free(to);
+	free(from);
+}
+
+/**
+ * Assign the blocks to the routines
+ */
+static void MakeRoutines(Cfg_private* pri, const uint8* jumped, const uint8* called)
+{
+	InsnStore* store = pri->store;
+	CfgBlock* b;
+	uint32* queue;
+	uint32* fill;
+	uint32 qhead;
+	uint32 qtail;
+	uint32 x;
+	uint32 s;
+	uint32 i;
+
+	/* the heads */
+	pri->routineCount = 0;
+	for(i=0; i<pri->blockCount; i++)
+	{
+		b = &pri->blocks[i];
+		if((0 == i) || Bit_Test(called, b->first)
+		|| ((0 != (store->Record(store, b->first)->flags & InsnRec_GroupHead)) && !Bit_Test(jumped, b->first)))
+		{
+			b->flags |= CfgBlock_RoutineHead;
+			b->routine = pri->routineCount++;
+		}
+	}
+
+	/* the blocks reached from the head */
+	queue = malloc(sizeof(uint32) * (pri->blockCount + 1));
+	assert(queue);
+	for(i=0; i<pri->blockCount; i++)
+	{
+		if(0 == (pri->blocks[i].flags & CfgBlock_RoutineHead)) continue;
+		qhead = 0;
+		qtail = 0;
+		queue[qtail++] = i;
+		while(qhead < qtail)
+		{
+			x = queue[qhead++];
+			for(s=pri->succStart[x]; s<pri->succStart[x+1]; s++)
+			{
+				if(Cfg_NotFound != pri->blocks[pri->succ[s]].routine) continue;
+				pri->blocks[pri->succ[s]].routine = pri->blocks[i].routine;
+				queue[qtail++] = pri->succ[s];
+			}
+		}
+	}
+	free(queue);
+
+	/* not reached(only by the indirect jumps) : the previous one */
+	for(i=1; i<pri->blockCount; i++)
+	{
+		if(Cfg_NotFound == pri->blocks[i].routine)
+		{
+			pri->blocks[i].routine = pri->blocks[i-1].routine;
+		}
+	}
+
+	/* the blocks of each routine(CSR, the head first) */
+	pri->routineStart = calloc((size_t)pri->routineCount + 1, sizeof(uint32));
+	pri->routineBlocks = malloc(sizeof(uint32) * (pri->blockCount + 1));
+	fill = malloc(sizeof(uint32) * (pri->routineCount + 1));
+	assert(pri->routineStart);
+	assert(pri->routineBlocks);
+	assert(fill);
+	for(i=0; i<pri->blockCount; i++)
+	{
+		pri->routineStart[pri->blocks[i].routine + 1]++;
+	}
+	for(i=0; i<pri->routineCount; i++)
+	{
+		pri->routineStart[i+1] += pri->routineStart[i];
+		fill[i] = pri->routineStart[i] + 1;
+	}
+	for(i=0; i<pri->blockCount; i++)
+	{
+		b = &pri->blocks[i];
+		if(0 != (b->flags & CfgBlock_RoutineHead))
+		{
+			pri->routineBlocks[pri->routineStart[b->routine]] = i;
+			continue;
+		}
+		pri->routineBlocks[fill[b->routine]++] = i;
+	}
+	free(fill);
+}
+
+static void Build(Cfg_private* pri)
+{
+	uint8* jumped;
+	uint8* called;
+	uint32 count;
+
+	count = pri->store->count_get(pri->store);
+	jumped = calloc((size_t)(count/8 + 1), sizeof(uint8));
+	called = calloc((size_t)(count/8 + 1), sizeof(uint8));
+	assert(jumped);
+	assert(called);
+
+	MakeBlocks(pri, jumped, called);
+	MakeEdges(pri);
+	MakeRoutines(pri, jumped, called);
+
+	free(called);
+	free(jumped);
+}
+
+
+/*--------------- accessors ---------------*/
+
+static uint32 blockCount_get(Cfg* self)
+{
+	assert(self);
+	return self->pri->blockCount;
+}
+
+static const CfgBlock* Block(Cfg* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->blockCount <= inx) return NULL;
+	return &self->pri->blocks[inx];
+}
+
+static uint32 BlockOf(Cfg* self, const uint32 pcadr)
+{
+	uint32 inx;
+
+	assert(self);
+	inx = self->pri->store->Search(self->pri->store, pcadr);
+	if(InsnStore_NotFound == inx) return Cfg_NotFound;
+	return BlockOfRecord(self->pri, inx);
+}
+
+static uint32 Successors(Cfg* self, const uint32 inx, const uint32** list)
+{
+	Cfg_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	(*list) = pri->succ;
+	if(pri->blockCount <= inx) return 0;
+	(*list) = &pri->succ[pri->succStart[inx]];
+	return pri->succStart[inx+1] - pri->succStart[inx];
+}
+
+static uint32 Predecessors(Cfg* self, const uint32 inx, const uint32** list)
+{
+	Cfg_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	(*list) = pri->pred;
+	if(pri->blockCount <= inx) return 0;
+	(*list) = &pri->pred[pri->predStart[inx]];
+	return pri->predStart[inx+1] - pri->predStart[inx];
+}
+
+static uint32 routineCount_get(Cfg* self)
+{
+	assert(self);
+	return self->pri->routineCount;
+}
+
+static uint32 RoutineBlocks(Cfg* self, const uint32 inx, const uint32** list)
+{
+	Cfg_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	(*list) = pri->routineBlocks;
+	if(pri->routineCount <= inx) return 0;
+	(*list) = &pri->routineBlocks[pri->routineStart[inx]];
+	return pri->routineStart[inx+1] - pri->routineStart[inx];
+}
+
+static size_t bytes_get(Cfg* self)
+{
+	Cfg_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	return sizeof(CfgBlock) * (pri->blockCount + 1)
+		+ sizeof(uint32) * ((size_t)pri->blockCount + 1) * 3
+		+ sizeof(uint32) * ((size_t)pri->edgeCount + 1) * 2
+		+ sizeof(uint32) * ((size_t)pri->routineCount + 1);
+}
+
+
+/*--------------- export ---------------*/
+
+static void PutIndexList(TextFile* out, const char* name, const uint32* list, const uint32 n)
+{
+	uint32 i;
+
+	out->Printf(out, ",\"%s\":[", name);
+	for(i=0; i<n; i++)
+	{
+		out->Printf(out, "%s%lu", (0 == i) ? "" : ",", (ulong)list[i]);
+	}
+	out->Printf(out, "]");
+}
+
+/**
+ * Write the destinations of the calls in the block
+ */
+static void PutCalls(Cfg_private* pri, TextFile* out, const CfgBlock* b)
+{
+	Instruction ins;
+	uint32 target;
+	uint32 n = 0;
+	uint32 i;
+
+	out->Printf(out, ",\"calls\":[");
+	for(i=b->first; i<b->first+b->count; i++)
+	{
+		InsnRec_Decode(pri->store->Record(pri->store, i), pri->from, &ins);
+		if(Flow_Call != FlowOf(ins.op)) continue;
+		if(false == Opcode_Target(&ins, &target)) continue;
+		out->Printf(out, "%s\"$%06x\"", (0 == n++) ? "" : ",", target);
+	}
+	out->Printf(out, "]");
+}
+
+static bool WriteJson(Cfg* self, TextFile* out)
+{
+	Cfg_private* pri;
+	const CfgBlock* b;
+	const uint32* blocks;
+	const uint32* list;
+	uint32 count;
+	uint32 n;
+	uint32 r;
+	uint32 i;
+
+	assert(self);
+	assert(out);
+	pri = self->pri;
+
+	for(r=0; r<pri->routineCount; r++)
+	{
+		count = RoutineBlocks(self, r, &blocks);
+		out->Printf(out, "{\"routine\":\"$%06x\",\"blocks\":[", pri->blocks[blocks[0]].snesadr);
+		for(i=0; i<count; i++)
+		{
+			b = &pri->blocks[blocks[i]];
+			out->Printf(out, "%s{\"id\":%lu,\"start\":\"$%06x\",\"end\":\"$%06x\",\"insns\":%lu",
+					(0 == i) ? "" : ",", (ulong)blocks[i], b->snesadr, b->endSnes, (ulong)b->count);
+			n = Successors(self, blocks[i], &list);
+			PutIndexList(out, "succ", list, n);
+			n = Predecessors(self, blocks[i], &list);
+			PutIndexList(out, "pred", list, n);
+			PutCalls(pri, out, b);
+			out->Printf(out, "}");
+		}
+		out->Printf(out, "]}\n");
+	}
+	return true;
+}
+
+static bool WriteDot(Cfg* self, TextFile* out)
+{
+	Cfg_private* pri;
+	const CfgBlock* b;
+	const uint32* blocks;
+	const uint32* list;
+	Instruction ins;
+	char text[InsnTextLen];
+	uint32 target;
+	uint32 callee;
+	uint32 count;
+	uint32 n;
+	uint32 r;
+	uint32 i;
+	uint32 j;
+
+	assert(self);
+	assert(out);
+	pri = self->pri;
+
+	out->Printf(out, "digraph cfg {\n");
+	out->Printf(out, "\tnode [shape=box, fontname=\"monospace\"];\n");
+	for(r=0; r<pri->routineCount; r++)
+	{
+		count = RoutineBlocks(self, r, &blocks);
+		out->Printf(out, "\tsubgraph \"cluster_L%06x\" {\n", pri->blocks[blocks[0]].snesadr);
+		out->Printf(out, "\t\tlabel=\"L%06x\";\n", pri->blocks[blocks[0]].snesadr);
+		for(i=0; i<count; i++)
+		{
+			b = &pri->blocks[blocks[i]];
+			out->Printf(out, "\t\tb%lu [label=\"L%06x:\\l", (ulong)blocks[i], b->snesadr);
+			for(j=b->first; j<b->first+b->count; j++)
+			{
+				InsnRec_Decode(pri->store->Record(pri->store, j), pri->from, &ins);
+				Opcode_Format(&ins, false, text, sizeof(text));
+				out->Printf(out, "  %s\\l", text);
+			}
+			out->Printf(out, "\"];\n");
+		}
+		out->Printf(out, "\t}\n");
+	}
+
+	/* the edges, and the calls(dashed) */
+	for(i=0; i<pri->blockCount; i++)
+	{
+		n = Successors(self, i, &list);
+		for(j=0; j<n; j++)
+		{
+			out->Printf(out, "\tb%lu -> b%lu;\n", (ulong)i, (ulong)list[j]);
+		}
+
+		b = &pri->blocks[i];
+		for(j=b->first; j<b->first+b->count; j++)
+		{
+			InsnRec_Decode(pri->store->Record(pri->store, j), pri->from, &ins);
+			if(Flow_Call != FlowOf(ins.op)) continue;
+			if(false == Opcode_Target(&ins, &target)) continue;
+			callee = pri->from->Snes2PcAdr(pri->from, target);
+			if(ROMADDRESS_NULL == callee) continue;
+			callee = BlockOf(self, callee);
+			if(Cfg_NotFound == callee) continue;
+			out->Printf(out, "\tb%lu -> b%lu [style=dashed];\n", (ulong)i, (ulong)callee);
+		}
+	}
+	out->Printf(out, "}\n");
+	return true;
+}
@@ -0,0 +1,453 @@
+/**
+ * ConstProp.c
+ *   constant propagation for the indirect jumps
+ */
+#include "common/types.h"
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "ConstProp.protected.h"
+
+#define LowRamEnd	0x2000
+
+/**
+ * operand address of the store
+ */
+typedef enum {
+	Ram_Low,	/* the low RAM */
+	Ram_Other,	/* doesn't overlap the low RAM */
+	Ram_Unknown
+} RamKind;
+
+/*--------------- memory ---------------*/
+
+static void Remove(ConstProp* self, const int inx)
+{
+	int i;
+
+	for(i=inx; i+1<self->memCount; i++)
+	{
+		self->memAdr[i] = self->memAdr[i+1];
+		self->mem[i] = self->mem[i+1];
+	}
+	self->memCount--;
+}
+
+static int Find(const ConstProp* self, const uint32 adr)
+{
+	int i;
+
+	for(i=0; i<self->memCount; i++)
+	{
+		if(adr == self->memAdr[i]) return i;
+	}
+	return -1;
+}
+
+static void Forget(ConstProp* self, const uint32 adr)
+{
+	int i;
+
+	i = Find(self, adr);
+	if(0 <= i) Remove(self, i);
+}
+
+static void Keep(ConstProp* self, const uint32 adr, const uint8 v)
+{
+	Forget(self, adr);
+	if(ConstProp_MemMax == self->memCount) Remove(self, 0);
+	self->memAdr[self->memCount] = (uint16)adr;
+	self->mem[self->memCount] = v;
+	self->memCount++;
+}
+
+/**
+ * Address of the dp / abs / long operand in the low RAM
+ */
+static RamKind Ram(const ConstProp* self, const uint8* code, uint32* adr)
+{
+	uint32 bank;
+
+	switch(code[0])
+	{
+		/* direct page */
+		case 0x04: case 0x06: case 0x14: case 0x26: case 0x46: case 0x64:
+		case 0x66: case 0x84: case 0x85: case 0x86: case 0xc6: case 0xe6:
+			if(0 == (self->known & ConstProp_D)) return Ram_Unknown;
+			(*adr) = (uint32)(self->d + code[1]) & 0xffff;
+			break;
+
+		/* absolute(DB is taken as the bank of the low RAM) */
+		case 0x0c: case 0x0e: case 0x1c: case 0x2e: case 0x4e: case 0x6e:
+		case 0x8c: case 0x8d: case 0x8e: case 0x9c: case 0xce: case 0xee:
+			(*adr) = read16(&code[1]);
+			break;
+
+		/* long */
+		case 0x8f:
+			bank = code[3];
+			if((0x7e != bank) && (0 != (bank & 0x40))) return Ram_Other;
+			(*adr) = read16(&code[1]);
+			break;
+
+		default:
+			return Ram_Unknown;
+	}
+	return (LowRamEnd <= (*adr)) ? Ram_Other : Ram_Low;
+}
+
+/**
+ * Store the byte(s) to the operand address
+ *   args: StoreTo(self, code, v, known, wide)
+ */
+static void StoreTo(ConstProp* self, const uint8* code, const uint16 v, const bool known, const bool wide)
+{
+	uint32 adr = 0;
+
+	switch(Ram(self, code, &adr))
+	{
+		case Ram_Low:
+			break;
+		case Ram_Unknown:
+			self->memCount = 0;
+			return;
+		default:
+			return;
+	}
+
+	if(known) Keep(self, adr, (uint8)v);
+	else Forget(self, adr);
+
+	if(!wide || (LowRamEnd <= adr + 1)) return;
+	if(known) Keep(self, adr + 1, (uint8)(v >> 8));
+	else Forget(self, adr + 1);
+}
+
+/**
+ * Read the byte of the pointer(the low RAM or the rom)
+ *   pcadr - the rom address of the byte, or ROMADDRESS_NULL for the low RAM
+ */
+static bool Read(const ConstProp* self, const RomView* from, const uint32 snesadr, uint8* v, uint32* pcadr)
+{
+	const uint8* ptr;
+	int i;
+
+	/* system area of the bank 00-3f / 80-bf */
+	if((0 == (snesadr & 0x400000)) && (0x8000 > (snesadr & 0xffff)))
+	{
+		if(LowRamEnd <= (snesadr & 0xffff)) return false;
+		i = Find(self, snesadr & 0xffff);
+		if(0 > i) return false;
+		(*v) = self->mem[i];
+		(*pcadr) = ROMADDRESS_NULL;
+		return true;
+	}
+
+	ptr = from->GetSnesPtr(from, snesadr);
+	if(NULL == ptr) return false;
+	(*v) = ptr[0];
+	(*pcadr) = from->Snes2PcAdr(from, snesadr);
+	return true;
+}
+
+
+/*--------------- registers ---------------*/
+
+static void Forget16(ConstProp* self, const bool m8)
+{
+	self->known &= (uint8)~(m8 ? ConstProp_A : (ConstProp_A | ConstProp_B));
+}
+
+/**
+ * Set A in the width of M
+ */
+static void SetA(ConstProp* self, const uint16 v, const bool known, const bool m8)
+{
+	Forget16(self, m8);
+	if(!known) return;
+	if(m8)
+	{
+		self->a = (uint16)((self->a & 0xff00) | (v & 0xff));
+		self->known |= ConstProp_A;
+	}
+	else
+	{
+		self->a = v;
+		self->known |= ConstProp_A | ConstProp_B;
+	}
+}
+
+/**
+ * Set X / Y in the width of X
+ */
+static void SetIndex(ConstProp* self, uint16* reg, const uint8 bit, const uint16 v, const bool known, const bool x8)
+{
+	self->known &= (uint8)~bit;
+	if(!known) return;
+	(*reg) = x8 ? (uint16)(v & 0xff) : v;
+	self->known |= bit;
+}
+
+static bool KnownA(const ConstProp* self, const bool m8)
+{
+	const uint8 bits = m8 ? ConstProp_A : (ConstProp_A | ConstProp_B);
+
+	return bits == (self->known & bits);
+}
+
+
+/*--------------- functions ---------------*/
+
+void ConstProp_Init(ConstProp* self)
+{
+	assert(self);
+	memset(self, 0, sizeof(ConstProp));
+	self->known = ConstProp_D;
+}
+
+void ConstProp_Clear(ConstProp* self)
+{
+	assert(self);
+	self->known &= ConstProp_D;
+	self->memCount = 0;
+}
+
+void ConstProp_Step(ConstProp* self, const uint8* code, const uint16 psw)
+{
+	const bool m8 = (0 != (psw & 0x20));
+	const bool x8 = (0 != (psw & 0x10));
+	const uint8 op = code[0];
+	uint8 lo;
+
+	assert(self);
+
+	switch(op)
+	{
+		/* immediate */
+		case 0xa9:	/* lda # */
+			SetA(self, m8 ? code[1] : read16(&code[1]), true, m8);
+			return;
+		case 0xa2:	/* ldx # */
+			SetIndex(self, &self->x, ConstProp_X, x8 ? code[1] : read16(&code[1]), true, x8);
+			return;
+		case 0xa0:	/* ldy # */
+			SetIndex(self, &self->y, ConstProp_Y, x8 ? code[1] : read16(&code[1]), true, x8);
+			return;
+
+		/* transfer */
+		case 0xaa:	/* tax */
+			SetIndex(self, &self->x, ConstProp_X, self->a, KnownA(self, x8), x8);
+			return;
+		case 0xa8:	/* tay */
+			SetIndex(self, &self->y, ConstProp_Y, self->a, KnownA(self, x8), x8);
+			return;
+		case 0x8a:	/* txa */
+			SetA(self, self->x, 0 != (self->known & ConstProp_X), m8);
+			return;
+		case 0x98:	/* tya */
+			SetA(self, self->y, 0 != (self->known & ConstProp_Y), m8);
+			return;
+		case 0x9b:	/* txy */
+			SetIndex(self, &self->y, ConstProp_Y, self->x, 0 != (self->known & ConstProp_X), x8);
+			return;
+		case 0xbb:	/* tyx */
+			SetIndex(self, &self->x, ConstProp_X, self->y, 0 != (self->known & ConstProp_Y), x8);
+			return;
+		case 0x5b:	/* tcd */
+			self->d = self->a;
+			self->known &= (uint8)~ConstProp_D;
+			if(KnownA(self, false)) self->known |= ConstProp_D;
+			return;
+		case 0x7b:	/* tdc */
+			SetA(self, self->d, 0 != (self->known & ConstProp_D), false);
+			return;
+		case 0xeb:	/* xba */
+			self->a = (uint16)((self->a << 8) | (self->a >> 8));
+			lo = (uint8)(self->known & ConstProp_A);
+			self->known = (uint8)((self->known & ~(ConstProp_A | ConstProp_B))
+					| ((self->known & ConstProp_B) ? ConstProp_A : 0) | (lo ? ConstProp_B : 0));
+			return;
+
+		/* increment / decrement */
+		case 0x1a:	/* ina */
+		case 0x3a:	/* dea */
+			SetA(self, (uint16)(self->a + ((0x1a == op) ? 1 : 0xffff)), KnownA(self, m8), m8);
+			return;
+		case 0xe8:	/* inx */
+		case 0xca:	/* dex */
+			SetIndex(self, &self->x, ConstProp_X, (uint16)(self->x + ((0xe8 == op) ? 1 : 0xffff)),
+					0 != (self->known & ConstProp_X), x8);
+			return;
+		case 0xc8:	/* iny */
+		case 0x88:	/* dey */
+			SetIndex(self, &self->y, ConstProp_Y, (uint16)(self->y + ((0xc8 == op) ? 1 : 0xffff)),
+					0 != (self->known & ConstProp_Y), x8);
+			return;
+
+		/* the width of the index */
+		case 0xe2:	/* sep */
+			if(0 != (code[1] & 0x10))
+			{
+				self->x &= 0xff;
+				self->y &= 0xff;
+			}
+			return;
+		case 0xfb:	/* xce */
+			self->known &= (uint8)~(ConstProp_X | ConstProp_Y);
+			return;
+
+		/* store */
+		case 0x85: case 0x8d: case 0x8f:	/* sta */
+			StoreTo(self, code, self->a, KnownA(self, m8), !m8);
+			return;
+		case 0x86: case 0x8e:			/* stx */
+			StoreTo(self, code, self->x, 0 != (self->known & ConstProp_X), !x8);
+			return;
+		case 0x84: case 0x8c:			/* sty */
+			StoreTo(self, code, self->y, 0 != (self->known & ConstProp_Y), !x8);
+			return;
+		case 0x64: case 0x9c:			/* stz */
+			StoreTo(self, code, 0, true, !m8);
+			return;
+
+		/* read-modify-write */
+		case 0x04: case 0x06: case 0x14: case 0x26: case 0x46: case 0x66: case 0xc6: case 0xe6:
+		case 0x0c: case 0x0e: case 0x1c: case 0x2e: case 0x4e: case 0x6e: case 0xce: case 0xee:
+			StoreTo(self, code, 0, false, !m8);
+			return;
+
+		/* store to the unknown address */
+		case 0x81: case 0x83: case 0x87: case 0x91: case 0x92: case 0x93: case 0x95: case 0x97:
+		case 0x99: case 0x9d: case 0x9f: case 0x94: case 0x96: case 0x74: case 0x9e:
+		case 0x16: case 0x36: case 0x56: case 0x76: case 0xd6: case 0xf6:
+		case 0x1e: case 0x3e: case 0x5e: case 0x7e: case 0xde: case 0xfe:
+			self->memCount = 0;
+			return;
+
+		/* block move */
+		case 0x44:	/* mvp */
+		case 0x54:	/* mvn */
+			self->known &= ConstProp_D;
+			self->memCount = 0;
+			return;
+
+		/* the routine which isn't traced */
+		case 0x00:	/* brk */
+		case 0x02:	/* cop */
+		case 0xfc:	/* jsr (abs,x) */
+			ConstProp_Clear(self);
+			return;
+
+		/* the other loads */
+		case 0x0a: case 0x2a: case 0x4a: case 0x6a:	/* asl / rol / lsr / ror A */
+		case 0x68:					/* pla */
+			Forget16(self, m8);
+			return;
+		case 0x3b:	/* tsc */
+			Forget16(self, false);
+			return;
+		case 0xa6: case 0xae: case 0xb6: case 0xbe: case 0xfa: case 0xba:	/* ldx / plx / tsx */
+			self->known &= (uint8)~ConstProp_X;
+			return;
+		case 0xa4: case 0xac: case 0xb4: case 0xbc: case 0x7a:		/* ldy / ply */
+			self->known &= (uint8)~ConstProp_Y;
+			return;
+		case 0x2b:	/* pld */
+			self->known &= (uint8)~ConstProp_D;
+			return;
+
+		default:
+			break;
+	}
+
+	/* ora / and / eor / adc / lda / sbc(the other addressing modes) */
+	switch(op & 0x1f)
+	{
+		case 0x01: case 0x03: case 0x05: case 0x07: case 0x09: case 0x0d: case 0x0f:
+		case 0x11: case 0x12: case 0x13: case 0x15: case 0x17: case 0x19: case 0x1d: case 0x1f:
+			if((0x80 == (op & 0xe0)) || (0xc0 == (op & 0xe0))) break;	/* sta / bit # / cmp */
+			Forget16(self, m8);
+			break;
+
+		default:
+			break;
+	}
+}
+
+bool ConstProp_Target(const ConstProp* self, const RomView* from, const uint8* code, const uint32 snesadr, uint32* target, uint32* pcadrs)
+{
+	uint32 ptr;
+	uint32 t = 0;
+	uint32 pca[3] = { ROMADDRESS_NULL, ROMADDRESS_NULL, ROMADDRESS_NULL };
+	uint8 v;
+	int len;
+	int i;
+
+	assert(self);
+	assert(from);
+
+	switch(code[0])
+	{
+		case 0x6c:	/* jmp (abs) */
+			ptr = read16(&code[1]);
+			len = 2;
+			break;
+		case 0x7c:	/* jmp (abs,x) */
+			if(0 == (self->known & ConstProp_X)) return false;
+			ptr = (snesadr & 0xff0000) | ((uint32)(read16(&code[1]) + self->x) & 0xffff);
+			len = 2;
+			break;
+		case 0xdc:	/* jml [abs] */
+			ptr = read16(&code[1]);
+			len = 3;
+			break;
+		default:
+			return false;
+	}
+
+	for(i=0; i<len; i++)
+	{
+		if(false == Read(self, from, (ptr & 0xff0000) | ((ptr + (uint32)i) & 0xffff), &v, &pca[i])) return false;
+		t |= (uint32)v << (8*i);
+	}
+	if(2 == len) t |= snesadr & 0xff0000;
+
+	if(NULL == from->GetSnesPtr(from, t)) return false;
+	(*target) = t;
+	memcpy(pcadrs, pca, sizeof(pca));
+	return true;
+}
+
+bool ConstProp_Meet(ConstProp* self, const ConstProp* src)
+{
+	uint8 known;
+	bool changed = false;
+	int i;
+	int j;
+
+	assert(self);
+	assert(src);
+
+	known = (uint8)(self->known & src->known);
+	if((self->a & 0xff) != (src->a & 0xff)) known &= (uint8)~ConstProp_A;
+	if((self->a >> 8) != (src->a >> 8)) known &= (uint8)~ConstProp_B;
+	if(self->x != src->x) known &= (uint8)~ConstProp_X;
+	if(self->y != src->y) known &= (uint8)~ConstProp_Y;
+	if(self->d != src->d) known &= (uint8)~ConstProp_D;
+	if(known != self->known)
+	{
+		self->known = known;
+		changed = true;
+	}
+
+	for(i=self->memCount-1; 0<=i; i--)
+	{
+		j = Find(src, self->memAdr[i]);
+		if((0 <= j) && (src->mem[j] == self->mem[i])) continue;
+		Remove(self, i);
+		changed = true;
+	}
+	return changed;
+}
@@ -0,0 +1,72 @@
+#pragma once
+/**
+ * ConstProp.protected.h
+ *   constant propagation for the indirect jumps(DisAsm / MxFlow)
+ *
+ *   The immediate values in A / X / Y / D and the bytes of the low RAM
+ *   (bank 00 $0000-$1fff) which are stored from them are tracked along
+ *   the trace, so that the pointer of jmp ($0000) / jmp ($8000,x) /
+ *   jml [$0000] can be read.
+ *     - lda / ldx / ldy #imm, the transfers, xba, inc / dec of the registers
+ *     - sta / stx / sty / stz to dp, abs and long
+ *   The store to the unknown address(indexed / indirect / unknown D)
+ *   forgets all bytes. The stores through DB are taken as the low RAM, and
+ *   the pushes aren't taken as the stores.
+ *   At most ConstProp_MemMax bytes are kept(the oldest one is dropped).
+ */
+
+#define ConstProp_MemMax	8
+
+/* known values */
+#define ConstProp_A		0x01	/* A(low) */
+#define ConstProp_B		0x02	/* A(high) */
+#define ConstProp_X		0x04
+#define ConstProp_Y		0x08
+#define ConstProp_D		0x10
+
+typedef struct _ConstProp {
+	uint16		a;
+	uint16		x;
+	uint16		y;
+	uint16		d;
+	uint8		known;
+	uint8		memCount;
+	uint16		memAdr[ConstProp_MemMax];	/* the oldest first */
+	uint8		mem[ConstProp_MemMax];
+} ConstProp;
+
+/**
+ * Initialize at the entry point(D = $0000)
+ */
+void ConstProp_Init(ConstProp*);
+
+/**
+ * Forget the values changed by the called routine(D is kept)
+ */
+void ConstProp_Clear(ConstProp*);
+
+/**
+ * Trace the instruction
+ *   args: ConstProp_Step(ConstProp* self, const uint8* code, const uint16 psw)
+ *     code - the opcode and its operand
+ *     psw  - the width(M / X) of the instruction
+ */
+void ConstProp_Step(ConstProp*, const uint8*, const uint16);
+
+/**
+ * Resolve the destination of jmp (abs) / jmp (abs,x) / jml [abs]
+ *   args: ConstProp_Target(const ConstProp* self, const RomView* from, const uint8* code, const uint32 snesadr, uint32* target, uint32* pcadrs)
+ *     snesadr - the address of the instruction(the program bank)
+ *     pcadrs  - output(3 entries) : the rom addresses of the pointer bytes,
+ *               ROMADDRESS_NULL for the low RAM and the unused ones
+ *   return:
+ *     If the pointer isn't known or doesn't point to the rom, return false.
+ */
+bool ConstProp_Target(const ConstProp*, const RomView*, const uint8*, const uint32, uint32*, uint32*);
+
+/**
+ * Keep the values which are the same in both
+ *   return:
+ *     If dst is changed, return true.
+ */
+bool ConstProp_Meet(ConstProp*, const ConstProp*);
@@ -0,0 +1,1122 @@
+/**
+ * Cpu.c
+ *   65816 interpreter
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Cpu.h"
+
+#define PageBits	12
+#define PageCount	(1 << (24 - PageBits))
+#define PageMask	((1 << PageBits) - 1)
+#define NotRom		0xffffffff
+#define WramSize	0x20000
+#define FrameSteps	20000		/* instructions per frame(about) */
+#define InitialLogs	4096
+
+/* the first psw of the rom byte */
+#define Unseen		0xff
+#define Seen_Conflict	0x01
+
+/* status register */
+#define P_C		0x01
+#define P_Z		0x02
+#define P_I		0x04
+#define P_D		0x08
+#define P_X		0x10
+#define P_M		0x20
+#define P_V		0x40
+#define P_N		0x80
+
+/* vectors(native / emulation) */
+#define Vector_Cop	0x00ffe4
+#define Vector_Nmi	0x00ffea
+#define Vector_CopE	0x00fff4
+#define Vector_NmiE	0x00fffa
+#define Vector_Reset	0x00fffc
+
+/* shift / rotate */
+typedef enum {
+	Shift_Asl,
+	Shift_Rol,
+	Shift_Lsr,
+	Shift_Ror
+} ShiftKind;
+
+/**
+ * Cpu private members
+ */
+struct _Cpu_private {
+	const RomView*	from;
+	const uint8*	rpage[PageCount];	/* NULL : the registers / open bus */
+	uint8*		wpage[PageCount];	/* NULL : the registers / rom */
+	uint32		romPage[PageCount];	/* rom address of the page, or NotRom */
+	uint8*		wram;
+	uint8*		seen;			/* the first psw(1 byte per rom byte) */
+	uint8		modes[256];
+	uint8		lens[256];
+
+	/* registers */
+	uint16		a;
+	uint16		x;
+	uint16		y;
+	uint16		s;
+	uint16		d;
+	uint16		pc;
+	uint8		db;
+	uint8		pb;
+	uint8		p;
+	bool		e;
+
+	/* stubbed registers */
+	bool		nmiEnable;
+	uint8		apu[4];
+	uint8		toggle;
+	uint8		mulA;
+	uint16		dividend;
+	uint16		quotient;
+	uint16		product;	/* or the remainder */
+
+	/* trace */
+	uint32		prev;		/* the last instruction */
+	uint8		flow;		/* CpuLog_Head / CpuLog_Call of the next instruction */
+	int		depth;
+	uint32		frameLeft;
+	bool		stopped;
+	uint32		stopAdr;
+	bool		nmiRun;
+
+	CpuLog*		logs;
+	uint32		logCount;
+	uint32		logSize;
+	uint32		steps;
+	uint32		conflicts;
+};
+
+/* prototypes */
+static void Reset(Cpu*);
+static uint32 Run(Cpu*, const uint32);
+static bool Stopped(Cpu*, uint32*);
+static void Registers(Cpu*, CpuRegs*);
+static uint32 logCount_get(Cpu*);
+static const CpuLog* Log(Cpu*, const uint32);
+static uint32 Emit(Cpu*, InsnStore*);
+static uint32 steps_get(Cpu*);
+static uint32 conflicts_get(Cpu*);
+static size_t bytes_get(Cpu*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * Map the rom and WRAM to the pages
+ */
+static void MapPages(Cpu_private* pri)
+{
+	const RomView* from = pri->from;
+	const uint8* rom;
+	const uint8* ptr;
+	uint32 base;
+	uint32 page;
+
+	rom = from->GetPcPtr(from, 0);
+	for(page=0; page<PageCount; page++)
+	{
+		base = page << PageBits;
+		pri->rpage[page] = NULL;
+		pri->wpage[page] = NULL;
+		pri->romPage[page] = NotRom;
+
+		if((0x7e0000 <= base) && (0x800000 > base))
+		{
+			pri->rpage[page] = pri->wpage[page] = &pri->wram[base - 0x7e0000];
+			continue;
+		}
+		if((0 == (base & 0x400000)) && (0x2000 > (base & 0xffff)))
+		{
+			pri->rpage[page] = pri->wpage[page] = &pri->wram[base & 0x1fff];
+			continue;
+		}
+		if((0 == (base & 0x400000)) && (0x8000 > (base & 0xffff))) continue;
+
+		/* the page which is mapped to the contiguous rom */
+		ptr = from->GetSnesPtr(from, base);
+		if((NULL == ptr) || (NULL == rom) || (&ptr[PageMask] != from->GetSnesPtr(from, base + PageMask))) continue;
+		pri->rpage[page] = ptr;
+		pri->romPage[page] = (uint32)(ptr - rom);
+	}
+}
+
+/**
+ * @brief Create Cpu object
+ *
+ * @param from rom
+ *
+ * @return the pointer of object
+ */
+Cpu* new_Cpu(const RomView* from)
+{
+	Cpu* self;
+	Cpu_private* pri;
+	int op;
+
+	assert(from);
+
+	/* make objects */
+	self = malloc(sizeof(Cpu));
+	pri = malloc(sizeof(Cpu_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->wram = calloc(WramSize, 1);
+	pri->seen = malloc((size_t)from->size_get(from) + 1);
+	pri->logs = NULL;
+	pri->logCount = 0;
+	pri->logSize = 0;
+	pri->steps = 0;
+	pri->conflicts = 0;
+	assert(pri->wram);
+	assert(pri->seen);
+	memset(pri->seen, Unseen, (size_t)from->size_get(from) + 1);
+	for(op=0; op<256; op++)
+	{
+		pri->modes[op] = (uint8)Opcode_AdrMode((uint8)op);
+		pri->lens[op] = (uint8)Opcode_ArgLength((uint8)op, 0x30);
+	}
+	MapPages(pri);
+
+	/*--- set public member ---*/
+	self->Reset = Reset;
+	self->Run = Run;
+	self->Stopped = Stopped;
+	self->Registers = Registers;
+	self->logCount_get = logCount_get;
+	self->Log = Log;
+	self->Emit = Emit;
+	self->steps_get = steps_get;
+	self->conflicts_get = conflicts_get;
+	self->bytes_get = bytes_get;
+
+	/* init Cpu object */
+	self->pri = pri;
+	Reset(self);
+	return self;
+}
+
+/**
+ * @brief Delete Cpu object
+ *
+ * @param the pointer of object
+ */
+void delete_Cpu(Cpu** self)
+{
+	Cpu_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	free(pri->wram);
+	free(pri->seen);
+	free(pri->logs);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- memory ---------------*/
+
+static uint8 ReadIo(Cpu_private* c, const uint32 adr)
+{
+	const uint32 lo = adr & 0xffff;
+	const uint8* ptr;
+
+	if((0 == (adr & 0x400000)) && (0x2000 <= lo) && (0x8000 > lo))
+	{
+		if((0x2140 <= lo) && (0x2180 > lo)) return c->apu[lo & 3];
+		switch(lo)
+		{
+			case 0x4214: return (uint8)c->quotient;
+			case 0x4215: return (uint8)(c->quotient >> 8);
+			case 0x4216: return (uint8)c->product;
+			case 0x4217: return (uint8)(c->product >> 8);
+			default: break;
+		}
+		/* expansion / SRAM */
+		if(0x6000 <= lo) return 0;
+		c->toggle ^= 0xff;
+		return c->toggle;
+	}
+
+	/* the page which isn't mapped at once */
+	ptr = c->from->GetSnesPtr(c->from, adr);
+	return (NULL == ptr) ? 0 : ptr[0];
+}
+
+static void WriteIo(Cpu_private* c, const uint32 adr, const uint8 v)
+{
+	const uint32 lo = adr & 0xffff;
+
+	if((0 != (adr & 0x400000)) || (0x2000 > lo) || (0x6000 <= lo)) return;
+	if((0x2140 <= lo) && (0x2180 > lo))
+	{
+		c->apu[lo & 3] = v;
+		return;
+	}
+	switch(lo)
+	{
+		case 0x4200:	/* NMITIMEN */
+			c->nmiEnable = (0 != (v & 0x80));
+			break;
+		case 0x4202:	/* WRMPYA */
+			c->mulA = v;
+			break;
+		case 0x4203:	/* WRMPYB */
+			c->product = (uint16)(c->mulA * v);
+			break;
+		case 0x4204:	/* WRDIVL */
+			c->dividend = (uint16)((c->dividend & 0xff00) | v);
+			break;
+		case 0x4205:	/* WRDIVH */
+			c->dividend = (uint16)((c->dividend & 0x00ff) | (v << 8));
+			break;
+		case 0x4206:	/* WRDIVB */
+			c->quotient = (uint16)((0 == v) ? 0xffff : c->dividend / v);
+			c->product = (uint16)((0 == v) ? c->dividend : c->dividend % v);
+			break;
+		default:
+			break;
+	}
+}
+
+static uint8 Read8(Cpu_private* c, const uint32 adr)
+{
+	const uint8* p = c->rpage[(adr & 0xffffff) >> PageBits];
+
+	if(NULL != p) return p[adr & PageMask];
+	return ReadIo(c, adr & 0xffffff);
+}
+
+static uint32 Read16(Cpu_private* c, const uint32 adr)
+{
+	return (uint32)Read8(c, adr) | ((uint32)Read8(c, adr + 1) << 8);
+}
+
+/**
+ * Read the pointer in the bank 0(direct page / stack / vector)
+ */
+static uint32 ReadB0_16(Cpu_private* c, const uint32 adr)
+{
+	return (uint32)Read8(c, adr & 0xffff) | ((uint32)Read8(c, (adr + 1) & 0xffff) << 8);
+}
+
+static uint32 ReadB0_24(Cpu_private* c, const uint32 adr)
+{
+	return ReadB0_16(c, adr) | ((uint32)Read8(c, (adr + 2) & 0xffff) << 16);
+}
+
+static void Write8(Cpu_private* c, const uint32 adr, const uint8 v)
+{
+	uint8* p = c->wpage[(adr & 0xffffff) >> PageBits];
+
+	if(NULL != p)
+	{
+		p[adr & PageMask] = v;
+		return;
+	}
+	WriteIo(c, adr & 0xffffff, v);
+}
+
+static uint32 Load(Cpu_private* c, const uint32 adr, const bool wide)
+{
+	return wide ? Read16(c, adr) : Read8(c, adr);
+}
+
+static void Store(Cpu_private* c, const uint32 adr, const uint32 v, const bool wide)
+{
+	Write8(c, adr, (uint8)v);
+	if(wide) Write8(c, adr + 1, (uint8)(v >> 8));
+}
+
+
+/*--------------- stack ---------------*/
+
+static void Push8(Cpu_private* c, const uint8 v)
+{
+	Write8(c, c->s, v);
+	c->s = c->e ? (uint16)(0x100 | ((c->s - 1) & 0xff)) : (uint16)(c->s - 1);
+}
+
+static void Push16(Cpu_private* c, const uint32 v)
+{
+	Push8(c, (uint8)(v >> 8));
+	Push8(c, (uint8)v);
+}
+
+static uint8 Pull8(Cpu_private* c)
+{
+	c->s = c->e ? (uint16)(0x100 | ((c->s + 1) & 0xff)) : (uint16)(c->s + 1);
+	return Read8(c, c->s);
+}
+
+static uint32 Pull16(Cpu_private* c)
+{
+	uint32 lo;
+
+	lo = Pull8(c);
+	return lo | ((uint32)Pull8(c) << 8);
+}
+
+
+/*--------------- flags / alu ---------------*/
+
+static void SetP(Cpu_private* c, const uint8 p)
+{
+	c->p = p;
+	if(c->e) c->p |= P_M | P_X;
+	if(0 != (c->p & P_X))
+	{
+		c->x &= 0xff;
+		c->y &= 0xff;
+	}
+}
+
+static void NZ(Cpu_private* c, const uint32 v, const bool wide)
+{
+	const uint32 sign = wide ? (v >> 8) : v;
+	const uint32 zero = v & (wide ? 0xffff : 0xff);
+
+	c->p = (uint8)((c->p & (0xff ^ (P_N | P_Z))) | (sign & P_N) | ((0 == zero) ? P_Z : 0));
+}
+
+static void SetFlag(Cpu_private* c, const uint8 flag, const bool on)
+{
+	c->p = (uint8)(on ? (c->p | flag) : (c->p & ~flag));
+}
+
+/**
+ * A in the width of M
+ */
+static uint32 GetA(const Cpu_private* c, const bool wide)
+{
+	return wide ? c->a : (uint32)(c->a & 0xff);
+}
+
+static void SetA(Cpu_private* c, const uint32 v, const bool wide)
+{
+	c->a = wide ? (uint16)v : (uint16)((c->a & 0xff00) | (v & 0xff));
+	NZ(c, v, wide);
+}
+
+static uint16 Index(const uint32 v, const bool wide)
+{
+	return (uint16)(wide ? (v & 0xffff) : (v & 0xff));
+}
+
+/**
+ * adc / sbc(binary and decimal)
+ */
+static uint32 AddCarry(Cpu_private* c, const uint32 a, uint32 v, const bool sub, const bool wide)
+{
+	const int32 mask = wide ? 0xffff : 0xff;
+	const uint32 sign = wide ? 0x8000 : 0x80;
+	const int nibbles = wide ? 4 : 2;
+	int32 carry = c->p & P_C;
+	int32 r = 0;
+	int shift;
+	int i;
+
+	if(sub) v = ~v & (uint32)mask;
+	if(0 == (c->p & P_D))
+	{
+		r = (int32)a + (int32)v + carry;
+	}
+	else
+	{
+		for(i=0; i<nibbles; i++)
+		{
+			shift = 4*i;
+			r = (int32)(a & (0xfu << shift)) + (int32)(v & (0xfu << shift)) + (carry << shift) + (r & ((1 << shift) - 1));
+			if(nibbles - 1 == i) break;
+			if(sub && (r < (0x10 << shift))) r -= 6 << shift;
+			if(!sub && (r >= (0xa << shift))) r += 6 << shift;
+			carry = (r >= (0x10 << shift)) ? 1 : 0;
+		}
+	}
+
+	SetFlag(c, P_V, 0 != (~(a ^ v) & (a ^ (uint32)r) & sign));
+	if(0 != (c->p & P_D))
+	{
+		shift = 4*(nibbles - 1);
+		if(sub && (r < (0x10 << shift))) r -= 6 << shift;
+		if(!sub && (r >= (0xa << shift))) r += 6 << shift;
+	}
+	SetFlag(c, P_C, r > mask);
+	return (uint32)r & (uint32)mask;
+}
+
+static void Compare(Cpu_private* c, const uint32 reg, const uint32 v, const bool wide)
+{
+	SetFlag(c, P_C, reg >= v);
+	NZ(c, reg - v, wide);
+}
+
+static uint32 Shift(Cpu_private* c, uint32 v, const ShiftKind kind, const bool wide)
+{
+	const uint32 sign = wide ? 0x8000 : 0x80;
+	const uint32 carry = c->p & P_C;
+
+	switch(kind)
+	{
+		case Shift_Asl:
+			SetFlag(c, P_C, 0 != (v & sign));
+			v = v << 1;
+			break;
+		case Shift_Rol:
+			SetFlag(c, P_C, 0 != (v & sign));
+			v = (v << 1) | carry;
+			break;
+		case Shift_Lsr:
+			SetFlag(c, P_C, 0 != (v & 1));
+			v = v >> 1;
+			break;
+		default:
+			SetFlag(c, P_C, 0 != (v & 1));
+			v = (v >> 1) | ((0 != carry) ? sign : 0);
+			break;
+	}
+	v &= wide ? 0xffff : 0xff;
+	NZ(c, v, wide);
+	return v;
+}
+
+
+/*--------------- control ---------------*/
+
+static void Jump(Cpu_private* c, const uint32 pc)
+{
+	c->pc = (uint16)pc;
+	c->flow = CpuLog_Head;
+}
+
+static void Call(Cpu_private* c, const uint32 pc)
+{
+	c->pc = (uint16)pc;
+	c->flow = CpuLog_Head | CpuLog_Call;
+	c->depth++;
+}
+
+static void Return(Cpu_private* c, const uint32 pc)
+{
+	c->pc = (uint16)pc;
+	c->flow = CpuLog_Head;
+	if(0 < c->depth) c->depth--;
+}
+
+static void Interrupt(Cpu_private* c, const uint32 vector, const uint32 vectorE)
+{
+	if(!c->e) Push8(c, c->pb);
+	Push16(c, c->pc);
+	Push8(c, c->p);
+	c->p = (uint8)((c->p | P_I) & ~P_D);
+	c->pb = 0;
+	Call(c, ReadB0_16(c, c->e ? vectorE : vector));
+}
+
+static void Stop(Cpu_private* c, const uint32 pc24)
+{
+	c->stopped = true;
+	c->stopAdr = pc24;
+}
+
+/**
+ * Log the first execution of the rom address
+ */
+static void See(Cpu_private* c, const uint32 pcadr, const uint32 pc24)
+{
+	const uint8 psw = (uint8)(c->p & (P_M | P_X));
+	CpuLog* l;
+
+	if(Unseen != c->seen[pcadr])
+	{
+		if(0 != (c->seen[pcadr] & Seen_Conflict)) return;
+		c->seen[pcadr] |= Seen_Conflict;
+		c->conflicts++;
+		return;
+	}
+	c->seen[pcadr] = psw;
+
+	if(c->logCount == c->logSize)
+	{
+		c->logSize = (0 == c->logSize) ? InitialLogs : c->logSize * 2;
+		c->logs = realloc(c->logs, sizeof(CpuLog) * c->logSize);
+		assert(c->logs);
+	}
+	l = &c->logs[c->logCount++];
+	l->snesadr = pc24;
+	l->callFrom = c->prev;
+	l->depth = c->depth;
+	l->psw = psw;
+	l->flags = c->flow;
+}
+
+/**
+ * Execute the instructions
+ *   return:
+ *     the number of the executed instructions
+ */
+static uint32 Execute(Cpu_private* c, const uint32 steps)
+{
+	const uint8* page;
+	uint32 pc24;
+	uint32 opr;
+	uint32 ea = 0;
+	uint32 db;
+	uint32 v;
+	uint32 off;
+	uint32 n;
+	uint16 next;
+	uint8 op;
+	uint8 mode;
+	bool m16;
+	bool x16;
+	int len;
+	int i;
+
+	for(n=0; n<steps; n++)
+	{
+		/* the frame */
+		if(0 == --c->frameLeft)
+		{
+			c->frameLeft = FrameSteps;
+			if(c->nmiEnable)
+			{
+				Interrupt(c, Vector_Nmi, Vector_NmiE);
+				c->nmiRun = true;
+			}
+		}
+
+		pc24 = ((uint32)c->pb << 16) | c->pc;
+		page = c->rpage[pc24 >> PageBits];
+		if(NULL == page)
+		{
+			Stop(c, pc24);
+			break;
+		}
+
+		/* brk is taken as the run into the data(it isn't logged) */
+		op = page[pc24 & PageMask];
+		if(0x00 == op)
+		{
+			Stop(c, pc24);
+			break;
+		}
+
+		/* log the first execution */
+		off = c->romPage[pc24 >> PageBits];
+		if(NotRom != off)
+		{
+			off += pc24 & PageMask;
+			if(c->seen[off] != (c->p & (P_M | P_X))) See(c, off, pc24);
+		}
+		c->flow = 0;
+		c->prev = pc24;
+
+		/* decode */
+		mode = c->modes[op];
+		m16 = (0 == (c->p & P_M));
+		x16 = (0 == (c->p & P_X));
+		len = c->lens[op];
+		if(Adr_immM == mode) len = m16 ? 2 : 1;
+		else if(Adr_immX == mode) len = x16 ? 2 : 1;
+		next = (uint16)(c->pc + 1 + len);
+
+		opr = 0;
+		if((pc24 & PageMask) < PageMask - 3)
+		{
+			opr = (uint32)page[(pc24 & PageMask) + 1]
+				| ((uint32)page[(pc24 & PageMask) + 2] << 8)
+				| ((uint32)page[(pc24 & PageMask) + 3] << 16);
+			opr &= (1u << (8*len)) - 1;
+		}
+		else
+		{
+			for(i=0; i<len; i++)
+			{
+				opr |= (uint32)Read8(c, (pc24 & 0xff0000) | ((c->pc + 1u + (uint32)i) & 0xffff)) << (8*i);
+			}
+		}
+
+		/* effective address */
+		db = (uint32)c->db << 16;
+		switch(mode)
+		{
+			case Adr_imm:
+			case Adr_immM:
+			case Adr_immX:
+				ea = (pc24 & 0xff0000) | ((c->pc + 1u) & 0xffff);
+				break;
+			case Adr_sr:	ea = (c->s + opr) & 0xffff; break;
+			case Adr_dp:	ea = (c->d + opr) & 0xffff; break;
+			case Adr_dpx:	ea = (c->d + opr + c->x) & 0xffff; break;
+			case Adr_dpy:	ea = (c->d + opr + c->y) & 0xffff; break;
+			case Adr_idp:	ea = db | ReadB0_16(c, c->d + opr); break;
+			case Adr_idx:	ea = db | ReadB0_16(c, c->d + opr + c->x); break;
+			case Adr_idy:	ea = ((db | ReadB0_16(c, c->d + opr)) + c->y) & 0xffffff; break;
+			case Adr_idl:	ea = ReadB0_24(c, c->d + opr); break;
+			case Adr_idly:	ea = (ReadB0_24(c, c->d + opr) + c->y) & 0xffffff; break;
+			case Adr_isy:	ea = ((db | ReadB0_16(c, c->s + opr)) + c->y) & 0xffffff; break;
+			case Adr_abs:	ea = db | opr; break;
+			case Adr_abx:	ea = ((db | opr) + c->x) & 0xffffff; break;
+			case Adr_aby:	ea = ((db | opr) + c->y) & 0xffffff; break;
+			case Adr_abl:	ea = opr; break;
+			case Adr_alx:	ea = (opr + c->x) & 0xffffff; break;
+			default:	break;
+		}
+		c->pc = next;
+
+		switch(op)
+		{
+			/* index load / store */
+			case 0xa2: case 0xa6: case 0xae: case 0xb6: case 0xbe:	/* ldx */
+				c->x = (uint16)Load(c, ea, x16);
+				NZ(c, c->x, x16);
+				break;
+			case 0xa0: case 0xa4: case 0xac: case 0xb4: case 0xbc:	/* ldy */
+				c->y = (uint16)Load(c, ea, x16);
+				NZ(c, c->y, x16);
+				break;
+			case 0x86: case 0x8e: case 0x96:	/* stx */
+				Store(c, ea, c->x, x16);
+				break;
+			case 0x84: case 0x8c: case 0x94:	/* sty */
+				Store(c, ea, c->y, x16);
+				break;
+			case 0x64: case 0x74: case 0x9c: case 0x9e:	/* stz */
+				Store(c, ea, 0, m16);
+				break;
+
+			/* read-modify-write */
+			case 0x06: case 0x0e: case 0x16: case 0x1e:	/* asl */
+			case 0x26: case 0x2e: case 0x36: case 0x3e:	/* rol */
+			case 0x46: case 0x4e: case 0x56: case 0x5e:	/* lsr */
+			case 0x66: case 0x6e: case 0x76: case 0x7e:	/* ror */
+				Store(c, ea, Shift(c, Load(c, ea, m16), (ShiftKind)((op >> 5) & 3), m16), m16);
+				break;
+			case 0x0a: case 0x2a: case 0x4a: case 0x6a:
+				SetA(c, Shift(c, GetA(c, m16), (ShiftKind)((op >> 5) & 3), m16), m16);
+				break;
+			case 0xe6: case 0xee: case 0xf6: case 0xfe:	/* inc */
+			case 0xc6: case 0xce: case 0xd6: case 0xde:	/* dec */
+				v = (Load(c, ea, m16) + ((0xe0 == (op & 0xe0)) ? 1u : 0xffffu)) & (m16 ? 0xffff : 0xff);
+				NZ(c, v, m16);
+				Store(c, ea, v, m16);
+				break;
+			case 0x1a:	/* inc A */
+				SetA(c, GetA(c, m16) + 1, m16);
+				break;
+			case 0x3a:	/* dec A */
+				SetA(c, GetA(c, m16) + 0xffff, m16);
+				break;
+			case 0x04: case 0x0c:	/* tsb */
+			case 0x14: case 0x1c:	/* trb */
+				v = Load(c, ea, m16);
+				SetFlag(c, P_Z, 0 == (v & GetA(c, m16)));
+				Store(c, ea, (0 == (op & 0x10)) ? (v | c->a) : (v & ~(uint32)c->a), m16);
+				break;
+
+			/* compare / test */
+			case 0x89:	/* bit # */
+				SetFlag(c, P_Z, 0 == (Load(c, ea, m16) & GetA(c, m16)));
+				break;
+			case 0x24: case 0x2c: case 0x34: case 0x3c:	/* bit */
+				v = Load(c, ea, m16);
+				SetFlag(c, P_Z, 0 == (v & GetA(c, m16)));
+				SetFlag(c, P_N, 0 != (v & (m16 ? 0x8000 : 0x80)));
+				SetFlag(c, P_V, 0 != (v & (m16 ? 0x4000 : 0x40)));
+				break;
+			case 0xe0: case 0xe4: case 0xec:	/* cpx */
+				Compare(c, c->x, Load(c, ea, x16), x16);
+				break;
+			case 0xc0: case 0xc4: case 0xcc:	/* cpy */
+				Compare(c, c->y, Load(c, ea, x16), x16);
+				break;
+
+			/* index */
+			case 0xe8:	/* inx */
+				c->x = Index(c->x + 1u, x16);
+				NZ(c, c->x, x16);
+				break;
+			case 0xca:	/* dex */
+				c->x = Index(c->x + 0xffffu, x16);
+				NZ(c, c->x, x16);
+				break;
+			case 0xc8:	/* iny */
+				c->y = Index(c->y + 1u, x16);
+				NZ(c, c->y, x16);
+				break;
+			case 0x88:	/* dey */
+				c->y = Index(c->y + 0xffffu, x16);
+				NZ(c, c->y, x16);
+				break;
+
+			/* branch */
+			case 0x10: if(0 == (c->p & P_N)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0x30: if(0 != (c->p & P_N)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0x50: if(0 == (c->p & P_V)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0x70: if(0 != (c->p & P_V)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0x90: if(0 == (c->p & P_C)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0xb0: if(0 != (c->p & P_C)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0xd0: if(0 == (c->p & P_Z)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0xf0: if(0 != (c->p & P_Z)) Jump(c, next + (uint32)(int8)opr); break;
+			case 0x80: Jump(c, next + (uint32)(int8)opr); break;
+			case 0x82: Jump(c, next + (uint32)(int16)opr); break;
+
+			/* jump */
+			case 0x4c:	/* jmp */
+				Jump(c, opr);
+				break;
+			case 0x5c:	/* jml */
+				c->pb = (uint8)(opr >> 16);
+				Jump(c, opr);
+				break;
+			case 0x6c:	/* jmp () */
+				Jump(c, ReadB0_16(c, opr));
+				break;
+			case 0x7c:	/* jmp (,x) */
+				Jump(c, Read16(c, (pc24 & 0xff0000) | ((opr + c->x) & 0xffff)));
+				break;
+			case 0xdc:	/* jml [] */
+				v = ReadB0_24(c, opr);
+				c->pb = (uint8)(v >> 16);
+				Jump(c, v);
+				break;
+
+			/* subroutine */
+			case 0x20:	/* jsr */
+				Push16(c, next - 1u);
+				Call(c, opr);
+				break;
+			case 0xfc:	/* jsr (,x) */
+				v = Read16(c, (pc24 & 0xff0000) | ((opr + c->x) & 0xffff));
+				Push16(c, next - 1u);
+				Call(c, v);
+				break;
+			case 0x22:	/* jsl */
+				Push8(c, c->pb);
+				Push16(c, next - 1u);
+				c->pb = (uint8)(opr >> 16);
+				Call(c, opr);
+				break;
+			case 0x60:	/* rts */
+				Return(c, Pull16(c) + 1);
+				break;
+			case 0x6b:	/* rtl */
+				v = Pull16(c) + 1;
+				c->pb = Pull8(c);
+				Return(c, v);
+				break;
+			case 0x40:	/* rti */
+				SetP(c, Pull8(c));
+				v = Pull16(c);
+				if(!c->e) c->pb = Pull8(c);
+				Return(c, v);
+				break;
+			case 0x00:	/* brk(stopped before) */
+				break;
+			case 0x02:	/* cop */
+				Interrupt(c, Vector_Cop, Vector_CopE);
+				break;
+
+			/* stack */
+			case 0x08: Push8(c, c->p); break;				/* php */
+			case 0x28: SetP(c, Pull8(c)); break;				/* plp */
+			case 0x48:							/* pha */
+				if(m16) Push16(c, c->a);
+				else Push8(c, (uint8)c->a);
+				break;
+			case 0x68: SetA(c, m16 ? Pull16(c) : Pull8(c), m16); break;	/* pla */
+			case 0xda:							/* phx */
+				if(x16) Push16(c, c->x);
+				else Push8(c, (uint8)c->x);
+				break;
+			case 0x5a:							/* phy */
+				if(x16) Push16(c, c->y);
+				else Push8(c, (uint8)c->y);
+				break;
+			case 0xfa:							/* plx */
+				c->x = (uint16)(x16 ? Pull16(c) : Pull8(c));
+				NZ(c, c->x, x16);
+				break;
+			case 0x7a:							/* ply */
+				c->y = (uint16)(x16 ? Pull16(c) : Pull8(c));
+				NZ(c, c->y, x16);
+				break;
+			case 0x0b: Push16(c, c->d); break;				/* phd */
+			case 0x2b: c->d = (uint16)Pull16(c); NZ(c, c->d, true); break;	/* pld */
+			case 0x4b: Push8(c, c->pb); break;				/* phk */
+			case 0x8b: Push8(c, c->db); break;				/* phb */
+			case 0xab: c->db = Pull8(c); NZ(c, c->db, false); break;	/* plb */
+			case 0xf4: Push16(c, opr); break;				/* pea */
+			case 0xd4: Push16(c, ReadB0_16(c, c->d + opr)); break;		/* pei */
+			case 0x62: Push16(c, next + opr); break;			/* per */
+
+			/* transfer */
+			case 0xaa: c->x = Index(c->a, x16); NZ(c, c->x, x16); break;	/* tax */
+			case 0xa8: c->y = Index(c->a, x16); NZ(c, c->y, x16); break;	/* tay */
+			case 0x8a: SetA(c, c->x, m16); break;				/* txa */
+			case 0x98: SetA(c, c->y, m16); break;				/* tya */
+			case 0x9b: c->y = Index(c->x, x16); NZ(c, c->y, x16); break;	/* txy */
+			case 0xbb: c->x = Index(c->y, x16); NZ(c, c->x, x16); break;	/* tyx */
+			case 0xba: c->x = Index(c->s, x16); NZ(c, c->x, x16); break;	/* tsx */
+			case 0x9a:							/* txs */
+				c->s = c->e ? (uint16)(0x100 | (c->x & 0xff)) : c->x;
+				break;
+			case 0x1b:							/* tcs */
+				c->s = c->e ? (uint16)(0x100 | (c->a & 0xff)) : c->a;
+				break;
+			case 0x3b: SetA(c, c->s, true); break;				/* tsc */
+			case 0x5b: c->d = c->a; NZ(c, c->d, true); break;		/* tcd */
+			case 0x7b: SetA(c, c->d, true); break;				/* tdc */
+			case 0xeb:							/* xba */
+				c->a = (uint16)((c->a << 8) | (c->a >> 8));
+				NZ(c, c->a & 0xff, false);
+				break;
+			case 0xfb:							/* xce */
+				v = c->p & P_C;
+				SetFlag(c, P_C, c->e);
+				c->e = (0 != v);
+				if(c->e) c->s = (uint16)(0x100 | (c->s & 0xff));
+				SetP(c, c->p);
+				break;
+
+			/* status */
+			case 0x18: SetFlag(c, P_C, false); break;	/* clc */
+			case 0x38: SetFlag(c, P_C, true); break;	/* sec */
+			case 0x58: SetFlag(c, P_I, false); break;	/* cli */
+			case 0x78: SetFlag(c, P_I, true); break;	/* sei */
+			case 0xb8: SetFlag(c, P_V, false); break;	/* clv */
+			case 0xd8: SetFlag(c, P_D, false); break;	/* cld */
+			case 0xf8: SetFlag(c, P_D, true); break;	/* sed */
+			case 0xc2: SetP(c, (uint8)(c->p & ~opr)); break;	/* rep */
+			case 0xe2: SetP(c, (uint8)(c->p | opr)); break;	/* sep */
+
+			/* block move(a byte per step) */
+			case 0x44:	/* mvp */
+			case 0x54:	/* mvn */
+				c->db = (uint8)opr;
+				Write8(c, ((opr & 0xff) << 16) | c->y, Read8(c, ((opr & 0xff00) << 8) | c->x));
+				c->x = Index(c->x + ((0x54 == op) ? 1u : 0xffffu), x16);
+				c->y = Index(c->y + ((0x54 == op) ? 1u : 0xffffu), x16);
+				c->a--;
+				if(0xffff != c->a) c->pc = (uint16)pc24;
+				break;
+
+			/* the others */
+			case 0xcb:	/* wai */
+				if(c->nmiEnable) c->frameLeft = 1;
+				else Stop(c, pc24);
+				break;
+			case 0xdb:	/* stp */
+				Stop(c, pc24);
+				break;
+			case 0x42:	/* wdm */
+			case 0xea:	/* nop */
+				break;
+
+			/* ora / and / eor / adc / sta / lda / cmp / sbc */
+			default:
+				switch(op >> 5)
+				{
+					case 0: SetA(c, GetA(c, m16) | Load(c, ea, m16), m16); break;
+					case 1: SetA(c, GetA(c, m16) & Load(c, ea, m16), m16); break;
+					case 2: SetA(c, GetA(c, m16) ^ Load(c, ea, m16), m16); break;
+					case 3: SetA(c, AddCarry(c, GetA(c, m16), Load(c, ea, m16), false, m16), m16); break;
+					case 4: Store(c, ea, c->a, m16); break;
+					case 5: SetA(c, Load(c, ea, m16), m16); break;
+					case 6: Compare(c, GetA(c, m16), Load(c, ea, m16), m16); break;
+					default: SetA(c, AddCarry(c, GetA(c, m16), Load(c, ea, m16), true, m16), m16); break;
+				}
+				break;
+		}
+		if(c->stopped)
+		{
+			n++;
+			break;
+		}
+	}
+	return n;
+}
+
+
+/*--------------- methods ---------------*/
+
+static void Reset(Cpu* self)
+{
+	Cpu_private* c;
+
+	assert(self);
+	c = self->pri;
+
+	c->a = c->x = c->y = 0;
+	c->s = 0x01ff;
+	c->d = 0;
+	c->db = c->pb = 0;
+	c->p = P_M | P_X | P_I;
+	c->e = true;
+	c->pc = (uint16)ReadB0_16(c, Vector_Reset);
+
+	c->nmiEnable = false;
+	c->apu[0] = 0xaa;	/* IPL ready */
+	c->apu[1] = 0xbb;
+	c->apu[2] = c->apu[3] = 0;
+	c->toggle = 0;
+	c->mulA = 0;
+	c->dividend = c->quotient = c->product = 0;
+
+	c->prev = Vector_Reset;
+	c->flow = CpuLog_Head | CpuLog_Call;
+	c->depth = 0;
+	c->frameLeft = FrameSteps;
+	c->stopped = false;
+	c->stopAdr = 0;
+	c->nmiRun = false;
+}
+
+/**
+ * Restart from the NMI vector(native mode)
+ */
+static void RestartNmi(Cpu_private* c)
+{
+	c->e = false;
+	c->s = 0x01ff;
+	c->d = 0;
+	c->db = c->pb = 0;
+	SetP(c, P_M | P_X | P_I);
+	c->pc = (uint16)ReadB0_16(c, Vector_Nmi);
+	c->prev = Vector_Nmi;
+	c->flow = CpuLog_Head | CpuLog_Call;
+	c->depth = 0;
+	c->stopped = false;
+	c->nmiRun = true;
+}
+
+static uint32 Run(Cpu* self, const uint32 steps)
+{
+	Cpu_private* c;
+	uint32 n = 0;
+
+	assert(self);
+	c = self->pri;
+
+	while(n < steps)
+	{
+		if(!c->stopped) n += Execute(c, steps - n);
+		if(!c->stopped || c->nmiRun) break;
+		RestartNmi(c);
+	}
+	c->steps += n;
+	return n;
+}
+
+static bool Stopped(Cpu* self, uint32* snesadr)
+{
+	assert(self);
+	if(false == self->pri->stopped) return false;
+	if(NULL != snesadr) (*snesadr) = self->pri->stopAdr;
+	return true;
+}
+
+static void Registers(Cpu* self, CpuRegs* regs)
+{
+	Cpu_private* c;
+
+	assert(self);
+	assert(regs);
+	c = self->pri;
+
+	regs->a = c->a;
+	regs->x = c->x;
+	regs->y = c->y;
+	regs->s = c->s;
+	regs->d = c->d;
+	regs->pc = ((uint32)c->pb << 16) | c->pc;
+	regs->db = c->db;
+	regs->p = c->p;
+	regs->e = c->e;
+}
+
+static uint32 logCount_get(Cpu* self)
+{
+	assert(self);
+	return self->pri->logCount;
+}
+
+static const CpuLog* Log(Cpu* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->logCount <= inx) return NULL;
+	return &self->pri->logs[inx];
+}
+
+static uint32 Emit(Cpu* self, InsnStore* store)
+{
+	const RomView* from;
+	const CpuLog* l;
+	uint32 count = 0;
+	uint32 i;
+	bool added;
+	bool prevAdded = false;
+
+	assert(self);
+	assert(store);
+	from = self->pri->from;
+
+	for(i=0; i<self->pri->logCount; i++)
+	{
+		l = &self->pri->logs[i];
+		added = store->Add(store, l->snesadr, from->Snes2PcAdr(from, l->snesadr), l->psw);
+		if(added)
+		{
+			/* the head, or the first one after the stored instructions */
+			if((0 != (l->flags & CpuLog_Head)) || !prevAdded) store->AddGroup(store, l->callFrom, l->depth);
+			count++;
+		}
+		prevAdded = added;
+	}
+	return count;
+}
+
+static uint32 steps_get(Cpu* self)
+{
+	assert(self);
+	return self->pri->steps;
+}
+
+static uint32 conflicts_get(Cpu* self)
+{
+	assert(self);
+	return self->pri->conflicts;
+}
+
+static size_t bytes_get(Cpu* self)
+{
+	Cpu_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	return sizeof(Cpu) + sizeof(Cpu_private) + WramSize
+		+ (size_t)pri->from->size_get(pri->from) + 1
+		+ sizeof(CpuLog) * pri->logSize;
+}
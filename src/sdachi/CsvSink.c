@@ -0,0 +1,170 @@
+/**
+ * CsvSink.c
+ *   CSV output
+ *     type,snes,pc,bytes,text,m,x,target,depth,from
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "Sink.protected.h"
+
+/* prototypes */
+static void Label(Sink*, const uint32, const char*);
+static void Org(Sink*, const uint32);
+static void Group(Sink*, const GroupInfo*);
+static void Insn(Sink*, const Instruction*);
+static void Data(Sink*, const uint32, const uint32, const uint8*, const size_t);
+static bool End(Sink*);
+
+
+/*--------------- Constructor ---------------*/
+
+/**
+ * @brief Create CsvSink object
+ *
+ * @return the pointer of object
+ */
+Sink* new_CsvSink(TextFile* out)
+{
+	Sink* self;
+
+	assert(out);
+	self = new_Sink(out);
+
+	/*--- override ---*/
+	self->Label = Label;
+	self->Org = Org;
+	self->Group = Group;
+	self->Insn = Insn;
+	self->Data = Data;
+	self->End = End;
+
+	return self;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static TextFile* Row(Sink* self)
+{
+	TextFile* out;
+
+	out = self->pro->out;
+	if(false == self->pro->headed)
+	{
+		out->Printf(out, "type,snes,pc,bytes,text,m,x,target,depth,from\n");
+		self->pro->headed = true;
+	}
+	return out;
+}
+
+static void PutBytes(TextFile* out, const uint8* data, const size_t len)
+{
+	size_t i;
+
+	for(i=0; i<len; i++)
+	{
+		out->Printf(out, "%02x", data[i]);
+	}
+}
+
+/* quote field text ('"' is doubled) */
+static void PutText(TextFile* out, const char* s)
+{
+	out->Printf(out, "\"");
+	for(; '\0' != *s; s++)
+	{
+		if('"' == *s)
+		{
+			out->Printf(out, "\"\"");
+			continue;
+		}
+		out->Printf(out, "%c", *s);
+	}
+	out->Printf(out, "\"");
+}
+
+static void Label(Sink* self, const uint32 snesadr, const char* name)
+{
+	TextFile* out;
+
+	assert(self);
+	out = Row(self);
+	out->Printf(out, "label,%06x,,,", snesadr);
+	PutText(out, name);
+	out->Printf(out, ",,,,,\n");
+}
+
+static void Org(Sink* self, const uint32 snesadr)
+{
+	TextFile* out;
+
+	assert(self);
+	out = Row(self);
+	out->Printf(out, "org,%06x,,,,,,,,\n", snesadr);
+}
+
+static void Group(Sink* self, const GroupInfo* grp)
+{
+	TextFile* out;
+
+	assert(self);
+	out = Row(self);
+	out->Printf(out, "group,%06x,,,,%d,%d,,%d,%06x\n",
+			grp->snesadr,
+			(grp->psw & 0x20) ? 8 : 16, (grp->psw & 0x10) ? 8 : 16,
+			grp->depth, grp->callFrom);
+}
+
+static void Insn(Sink* self, const Instruction* ins)
+{
+	TextFile* out;
+	char operand[16];
+	uint8 bytes[4];
+	uint32 target;
+
+	assert(self);
+	out = Row(self);
+
+	Opcode_Operand(ins, operand);
+	bytes[0] = ins->op;
+	memcpy(&bytes[1], ins->arg, sizeof(ins->arg));
+
+	out->Printf(out, "insn,%06x,%06x,", ins->snesadr, ins->pcadr);
+	PutBytes(out, bytes, (size_t)(ins->arglen+1));
+	out->Printf(out, ",\"%s%s%s%s\",%d,%d,",
+			Opcode_Mnemonic(ins->op), Opcode_SizeSuffix(ins),
+			('\0' != operand[0]) ? " " : "", operand,
+			(ins->psw & 0x20) ? 8 : 16, (ins->psw & 0x10) ? 8 : 16);
+	if(Opcode_Target(ins, &target))
+	{
+		out->Printf(out, "%06x", target);
+	}
+	out->Printf(out, ",,\n");
+}
+
+static void Data(Sink* self, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	TextFile* out;
+
+	assert(self);
+	out = Row(self);
+	out->Printf(out, "data,%06x,%06x,", snesadr, pcadr);
+	PutBytes(out, data, len);
+	out->Printf(out, ",,,,,,\n");
+}
+
+static bool End(Sink* self)
+{
+	assert(self);
+
+	/* empty output still has the column row */
+	Row(self);
+	return !self->pro->failed;
+}
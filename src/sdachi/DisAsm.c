@@ -1,11 +1,15 @@
 /**
  * DisAsm.c
  */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#endif
 #include "common/types.h"
 #include <assert.h>
 #include <stdarg.h>
 #include "common/puts.h"
 #include "common/Str.h"
+#include "common/Arena.h"
 #include "common/List.h"
 #include "common/Option.h"
 #include "common/ReadWrite.h"
@@ -13,26 +17,85 @@
 #include "file/File.h"
 #include "file/TextFile.h"
 #include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Analysis.h"
 #include "sdachi/DisAsm.h"
+#include "sdachi/BankStore.h"
+#include "sdachi/Cfg.h"
+#include "sdachi/MxFlow.h"
+#include "sdachi/Cpu.h"
+#include "sdachi/TraceLog.h"
+#include "sdachi/CdlLog.h"
+#include "sdachi/Fingerprint.h"
 
-typedef struct _SnesRegisters {
-	uint8		db;
-	uint16		d;
-	uint32		pc;
-	uint16		a;
-	uint16		x;
-	uint16		y;
+/* this header isn't read from anything other */
+/* than DisAsm modules.                       */
+#include "ConstProp.protected.h"
+#include "DisAsm.protected.h"
+
+#define DiagLen 256
+#define NameLen 256
+
+#define FNV_Offset	0x811c9dc5u
+#define FNV_Prime	0x01000193u
+
+#if defined(_MSC_VER)
+#  define vsnprintf _vsnprintf
+#endif
+
+/**
+ * named routine(the names file)
+ */
+typedef struct _DisAsmName {
+	uint32		pcadr;
+	uint32		snesadr;
 	uint16		psw;
-	uint16		sp;
+	uint32		row;		/* the line of the file */
+	char*		name;
+} DisAsmName;
 
-	/* stack info */
-	uint32		callFrom;
-	int		depth;
-} SnesRegisters;
-static void SnesRegistersCleaner(void* ptr)
-{
-	free(ptr);
-}
+/**
+ * DisAsmContext private members
+ */
+struct _DisAsmContext_private {
+	DisAsmInf	inf;
+	List*		sinks;
+	List*		diags;
+	List*		entries;	/* additional entry points */
+	BankStore*	banks;		/* shared traces(not owned) */
+	/* work data (while Run) */
+	Arena*		arena;
+	InsnStore*	store;
+	InsnStore*	scratch;	/* bank-local trace */
+	TraceLog*	trace;		/* the imported trace log */
+	CdlLog*		cdl;		/* the imported code / data log */
+	uint32		cdlStops;	/* the traces stopped at the logged data */
+	DisAsmName*	names;		/* the named routines(sorted by the pc address) */
+	uint32		nameCount;
+	uint32		namesHash;
+	Fingerprint*	fp;		/* the fingerprint database */
+	int		traceBank;	/* the bank which is traced, or -1 */
+	bool		traceShared;	/* the trace reads nothing but the bank data */
+	uint8*		pointers;	/* the blocks of the pointers read from the rom(-I) */
+	List*		exits;		/* the transfers out of the bank */
+	uint64		bankHash[256];
+	uint8		bankHashed[256/8];
+};
+
+/* prototypes */
+static void AddSink(DisAsmContext*, Sink*);
+static void AddEntry(DisAsmContext*, const uint32, const uint16);
+static void UseBankStore(DisAsmContext*, BankStore*);
+static bool Run(DisAsmContext*, RomFile*);
+static bool RunView(DisAsmContext*, const RomView*);
+static Analysis* Analyze(DisAsmContext*, const RomView*);
+static void Report(DisAsmContext*, const DisAsmDiagLevel, const char*, ...);
+static uint32 diagCount_get(DisAsmContext*);
+static const DisAsmDiag* Diag(DisAsmContext*, const uint32);
+static void PrintDiags(DisAsmContext*);
 
 typedef union _UniAdr {
 	uint32		abl;
@@ -42,387 +105,175 @@ typedef union _UniAdr {
 }UniAdr;
 
 /* for pass1 */
-typedef struct _OpStruct {
-	uint8		op;
-	int		arglen;
-	uint8		arg[4];
-	uint32		snesadr;
-	uint32		pcadr;
-	SnesRegisters	*regs;
-} OpStruct;
-static void OpStructCleaner(void* ptr)
-{
-	free(((OpStruct*)ptr)->regs);
-	free(ptr);
-}
 typedef enum {
 	Pass1_NoError,
 	Pass1_InvalidPointer,
 } Pass1Result;
 
-typedef enum {
-	AddOpcode_NoError,
-	AddOpcode_Exists,
-} AddOpcodeResult;
-
-
-typedef enum _AdrMode {
-	Adr_imm,
-	Adr_immM,
-	Adr_immX,
-	Adr_sr,
-	Adr_dp,
-	Adr_dpx,
-	Adr_dpy,
-	Adr_idp,
-	Adr_idx,
-	Adr_idy,
-	Adr_idl,
-	Adr_idly,
-	Adr_isy,
-	Adr_abs,
-	Adr_abx,
-	Adr_aby,
-	Adr_abl,
-	Adr_alx,
-	Adr_ind,
-	Adr_iax,
-	Adr_ial,
-	Adr_rel,
-	Adr_rell,
-	Adr_bm,
-	Adr_none
-} AdrMode;
-
-static const int argLength[] = {
-	1,  /* Adr_imm */
-	-1, /* Adr_immM */
-	-1, /* Adr_immX */
-	1,  /* Adr_sr */
-	1,  /* Adr_dp */
-	1,  /* Adr_dpx */
-	1,  /* Adr_dpy */
-	1,  /* Adr_idp */
-	1,  /* Adr_idx */
-	1,  /* Adr_idy */
-	1,  /* Adr_idl */
-	1,  /* Adr_idly */
-	1,  /* Adr_isy */
-	2,  /* Adr_abs */
-	2,  /* Adr_abx */
-	2,  /* Adr_aby */
-	3,  /* Adr_abl */
-	3,  /* Adr_alx */
-	2,  /* Adr_ind */
-	2,  /* Adr_iax */
-	3,  /* Adr_ial */
-	1,  /* Adr_rel */
-	2,  /* Adr_rell */
-	2,  /* Adr_bm */
-	0,  /* Adr_none */
-};
 
+/*--------------- Constructor / Destructor ---------------*/
 
-typedef struct _Opcode {
-	char	*op;
-	AdrMode	mode;
-} Opcode;
-static Opcode opcodes [] = {
-	/* 0x00 */
-	{ "brk",	Adr_none },	/* 0x00 */
-	{ "ora",	Adr_idx  },	/* 0x01 */
-	{ "cop",	Adr_imm  },	/* 0x02 */
-	{ "ora",	Adr_sr   },	/* 0x03 */
-	{ "tsb",	Adr_dp   },	/* 0x04 */
-	{ "ora",	Adr_dp   },	/* 0x05 */
-	{ "asl",	Adr_dp   },	/* 0x06 */
-	{ "ora",	Adr_idl  },	/* 0x07 */
-	{ "php",	Adr_none },	/* 0x08 */
-	{ "ora",	Adr_immM },	/* 0x09 */
-	{ "asl",	Adr_none },	/* 0x0A */
-	{ "phd",	Adr_none },	/* 0x0B */
-	{ "tsb",	Adr_abs  },	/* 0x0C */
-	{ "ora",	Adr_abs  },	/* 0x0D */
-	{ "asl",	Adr_abs  },	/* 0x0E */
-	{ "ora",	Adr_abl  },	/* 0x0F */
-	/* 0x10 */
-	{ "bpl",	Adr_rel  },	/* 0x10 */
-	{ "ora",	Adr_idy  },	/* 0x11 */
-	{ "ora",	Adr_idp  },	/* 0x12 */
-	{ "ora",	Adr_isy  },	/* 0x13 */
-	{ "trb",	Adr_dp   },	/* 0x14 */
-	{ "ora",	Adr_dpx  },	/* 0x15 */
-	{ "asl",	Adr_dpx  },	/* 0x16 */
-	{ "ora",	Adr_idly },	/* 0x17 */
-	{ "clc",	Adr_none },	/* 0x18 */
-	{ "ora",	Adr_aby  },	/* 0x19 */
-	{ "inc",	Adr_none },	/* 0x1A */
-	{ "tcs",	Adr_none },	/* 0x1B */
-	{ "trb",	Adr_abs  },	/* 0x1C */
-	{ "ora",	Adr_abx  },	/* 0x1D */
-	{ "asl",	Adr_abx  },	/* 0x1E */
-	{ "ora",	Adr_alx  },	/* 0x1F */
-	/* 0x20 */
-	{ "jsr",	Adr_abs  },	/* 0x20 */
-	{ "and",	Adr_idx  },	/* 0x21 */
-	{ "jsl",	Adr_abl  },	/* 0x22 */
-	{ "and",	Adr_sr   },	/* 0x23 */
-	{ "bit",	Adr_dp   },	/* 0x24 */
-	{ "and",	Adr_dp   },	/* 0x25 */
-	{ "rol",	Adr_dp   },	/* 0x26 */
-	{ "and",	Adr_idl  },	/* 0x27 */
-	{ "plp",	Adr_none },	/* 0x28 */
-	{ "and",	Adr_immM },	/* 0x29 */
-	{ "rol",	Adr_none },	/* 0x2A */
-	{ "pld",	Adr_none },	/* 0x2B */
-	{ "bit",	Adr_abs  },	/* 0x2C */
-	{ "and",	Adr_abs  },	/* 0x2D */
-	{ "rol",	Adr_abs  },	/* 0x2E */
-	{ "and",	Adr_abl  },	/* 0x2F */
-	/* 0x30 */
-	{ "bmi",	Adr_rel  },	/* 0x30 */
-	{ "and",	Adr_idy  },	/* 0x31 */
-	{ "and",	Adr_idp  },	/* 0x32 */
-	{ "and",	Adr_isy  },	/* 0x33 */
-	{ "bit",	Adr_dpx  },	/* 0x34 */
-	{ "and",	Adr_dpx  },	/* 0x35 */
-	{ "rol",	Adr_dpx  },	/* 0x36 */
-	{ "and",	Adr_idly },	/* 0x37 */
-	{ "sec",	Adr_none },	/* 0x38 */
-	{ "and",	Adr_aby  },	/* 0x39 */
-	{ "dec",	Adr_none },	/* 0x3A */
-	{ "tsc",	Adr_none },	/* 0x3B */
-	{ "bit",	Adr_abx  },	/* 0x3C */
-	{ "and",	Adr_abx  },	/* 0x3D */
-	{ "rol",	Adr_abx  },	/* 0x3E */
-	{ "and",	Adr_alx  },	/* 0x3F */
-	/* 0x40 */
-	{ "rti",	Adr_none },	/* 0x40 */
-	{ "eor",	Adr_idx  },	/* 0x41 */
-	{ "wdm",	Adr_none },	/* 0x42 */
-	{ "eor",	Adr_sr   },	/* 0x43 */
-	{ "mvp",	Adr_bm   },	/* 0x44 */
-	{ "eor",	Adr_dp   },	/* 0x45 */
-	{ "lsr",	Adr_dp   },	/* 0x46 */
-	{ "eor",	Adr_idl  },	/* 0x47 */
-	{ "pha",	Adr_none },	/* 0x48 */
-	{ "eor",	Adr_immM },	/* 0x49 */
-	{ "lsr",	Adr_none },	/* 0x4A */
-	{ "phk",	Adr_none },	/* 0x4B */
-	{ "jmp",	Adr_abs  },	/* 0x4C */
-	{ "eor",	Adr_abs  },	/* 0x4D */
-	{ "lsr",	Adr_abs  },	/* 0x4E */
-	{ "eor",	Adr_abl  },	/* 0x4F */
-	/* 0x50 */
-	{ "bvc",	Adr_rel  },	/* 0x50 */
-	{ "eor",	Adr_idy  },	/* 0x51 */
-	{ "eor",	Adr_idp  },	/* 0x52 */
-	{ "eor",	Adr_isy  },	/* 0x53 */
-	{ "mvn",	Adr_bm   },	/* 0x54 */
-	{ "eor",	Adr_dpx  },	/* 0x55 */
-	{ "lsr",	Adr_dpx  },	/* 0x56 */
-	{ "eor",	Adr_idly },	/* 0x57 */
-	{ "cli",	Adr_none },	/* 0x58 */
-	{ "eor",	Adr_aby  },	/* 0x59 */
-	{ "phy",	Adr_none },	/* 0x5A */
-	{ "tcd",	Adr_none },	/* 0x5B */
-	{ "jml",	Adr_abl  },	/* 0x5C */
-	{ "eor",	Adr_abx  },	/* 0x5D */
-	{ "lsr",	Adr_abx  },	/* 0x5E */
-	{ "eor",	Adr_alx  },	/* 0x5F */
-	/* 0x60 */
-	{ "rts",	Adr_none },	/* 0x60 */
-	{ "adc",	Adr_idx  },	/* 0x61 */
-	{ "per",	Adr_rell },	/* 0x62 */
-	{ "adc",	Adr_sr   },	/* 0x63 */
-	{ "stz",	Adr_dp   },	/* 0x64 */
-	{ "adc",	Adr_dp   },	/* 0x65 */
-	{ "ror",	Adr_dp   },	/* 0x66 */
-	{ "adc",	Adr_idl  },	/* 0x67 */
-	{ "pla",	Adr_none },	/* 0x68 */
-	{ "adc",	Adr_immM },	/* 0x69 */
-	{ "ror",	Adr_none },	/* 0x6A */
-	{ "rtl",	Adr_none },	/* 0x6B */
-	{ "jmp",	Adr_ind  },	/* 0x6C */
-	{ "adc",	Adr_abs  },	/* 0x6D */
-	{ "ror",	Adr_abs  },	/* 0x6E */
-	{ "adc",	Adr_abl  },	/* 0x6F */
-	/* 0x70 */
-	{ "bvs",	Adr_rel  },	/* 0x70 */
-	{ "adc",	Adr_idy  },	/* 0x71 */
-	{ "adc",	Adr_idp  },	/* 0x72 */
-	{ "adc",	Adr_isy  },	/* 0x73 */
-	{ "stz",	Adr_dpx  },	/* 0x74 */
-	{ "adc",	Adr_dpx  },	/* 0x75 */
-	{ "ror",	Adr_dpx  },	/* 0x76 */
-	{ "adc",	Adr_idly },	/* 0x77 */
-	{ "sei",	Adr_none },	/* 0x78 */
-	{ "adc",	Adr_immM },	/* 0x79 */
-	{ "ply",	Adr_none },	/* 0x7A */
-	{ "tdc",	Adr_none },	/* 0x7B */
-	{ "jmp",	Adr_ial  },	/* 0x7C */
-	{ "adc",	Adr_abx  },	/* 0x7D */
-	{ "ror",	Adr_abx  },	/* 0x7E */
-	{ "adc",	Adr_alx  },	/* 0x7F */
-	/* 0x80 */
-	{ "bra",	Adr_rel  },	/* 0x80 */
-	{ "sta",	Adr_idx  },	/* 0x81 */
-	{ "brl",	Adr_rell },	/* 0x82 */
-	{ "sta",	Adr_sr   },	/* 0x83 */
-	{ "sty",	Adr_dp   },	/* 0x84 */
-	{ "sta",	Adr_dp   },	/* 0x85 */
-	{ "stx",	Adr_dp   },	/* 0x86 */
-	{ "sta",	Adr_idl  },	/* 0x87 */
-	{ "dey",	Adr_none },	/* 0x88 */
-	{ "bit",	Adr_immM },	/* 0x89 */
-	{ "txa",	Adr_none },	/* 0x8A */
-	{ "phb",	Adr_none },	/* 0x8B */
-	{ "sty",	Adr_abs  },	/* 0x8C */
-	{ "sta",	Adr_abs  },	/* 0x8D */
-	{ "stx",	Adr_abs  },	/* 0x8E */
-	{ "sta",	Adr_abl  },	/* 0x8F */
-	/* 0x90 */
-	{ "bcc",	Adr_rel  },	/* 0x90 */
-	{ "sta",	Adr_idy  },	/* 0x91 */
-	{ "sta",	Adr_idp  },	/* 0x92 */
-	{ "sta",	Adr_isy  },	/* 0x93 */
-	{ "sty",	Adr_dpx  },	/* 0x94 */
-	{ "sta",	Adr_dpx  },	/* 0x95 */
-	{ "stx",	Adr_dpy  },	/* 0x96 */
-	{ "sta",	Adr_idly },	/* 0x97 */
-	{ "tya",	Adr_none },	/* 0x98 */
-	{ "sta",	Adr_aby  },	/* 0x99 */
-	{ "txs",	Adr_none },	/* 0x9A */
-	{ "txy",	Adr_none },	/* 0x9B */
-	{ "stz",	Adr_abs  },	/* 0x9C */
-	{ "sta",	Adr_abx  },	/* 0x9D */
-	{ "stz",	Adr_abx  },	/* 0x9E */
-	{ "sta",	Adr_alx  },	/* 0x9F */
-	/* 0xA0 */
-	{ "ldy",	Adr_immX  },	/* 0xA0 */
-	{ "lda",	Adr_idx  },	/* 0xA1 */
-	{ "ldx",	Adr_immX  },	/* 0xA2 */
-	{ "lda",	Adr_sr   },	/* 0xA3 */
-	{ "ldy",	Adr_dp   },	/* 0xA4 */
-	{ "lda",	Adr_dp   },	/* 0xA5 */
-	{ "ldx",	Adr_dp   },	/* 0xA6 */
-	{ "lda",	Adr_idl  },	/* 0xA7 */
-	{ "tay",	Adr_none },	/* 0xA8 */
-	{ "lda",	Adr_immM  },	/* 0xA9 */
-	{ "tax",	Adr_none },	/* 0xAA */
-	{ "plb",	Adr_none },	/* 0xAB */
-	{ "ldy",	Adr_abs  },	/* 0xAC */
-	{ "lda",	Adr_abs  },	/* 0xAD */
-	{ "ldx",	Adr_abs  },	/* 0xAE */
-	{ "lda",	Adr_abl  },	/* 0xAF */
-	/* 0xB0 */
-	{ "bcs",	Adr_rel  },	/* 0xB0 */
-	{ "lda",	Adr_idy  },	/* 0xB1 */
-	{ "lda",	Adr_idp  },	/* 0xB2 */
-	{ "lda",	Adr_isy  },	/* 0xB3 */
-	{ "ldy",	Adr_dpx  },	/* 0xB4 */
-	{ "lda",	Adr_dpx  },	/* 0xB5 */
-	{ "ldx",	Adr_dpy  },	/* 0xB6 */
-	{ "lda",	Adr_idly },	/* 0xB7 */
-	{ "clv",	Adr_none },	/* 0xB8 */
-	{ "lda",	Adr_aby  },	/* 0xB9 */
-	{ "tsx",	Adr_none },	/* 0xBA */
-	{ "tyx",	Adr_none },	/* 0xBB */
-	{ "ldy",	Adr_abx  },	/* 0xBC */
-	{ "lda",	Adr_abx  },	/* 0xBD */
-	{ "ldx",	Adr_aby  },	/* 0xBE */
-	{ "lda",	Adr_alx  },	/* 0xBF */
-	/* 0xC0 */
-	{ "cpy",	Adr_immX  },	/* 0xC0 */
-	{ "cmp",	Adr_idx  },	/* 0xC1 */
-	{ "rep",	Adr_imm  },	/* 0xC2 */
-	{ "cmp",	Adr_sr   },	/* 0xC3 */
-	{ "cpy",	Adr_dp   },	/* 0xC4 */
-	{ "cmp",	Adr_dp   },	/* 0xC5 */
-	{ "dec",	Adr_dp   },	/* 0xC6 */
-	{ "cmp",	Adr_idl  },	/* 0xC7 */
-	{ "iny",	Adr_none },	/* 0xC8 */
-	{ "cmp",	Adr_immM },	/* 0xC9 */
-	{ "dex",	Adr_none },	/* 0xCA */
-	{ "wai",	Adr_none },	/* 0xCB */
-	{ "cpy",	Adr_abs  },	/* 0xCC */
-	{ "cmp",	Adr_abs  },	/* 0xCD */
-	{ "dec",	Adr_abs  },	/* 0xCE */
-	{ "cmp",	Adr_abl  },	/* 0xCF */
-	/* 0xD0 */
-	{ "bne",	Adr_rel  },	/* 0xD0 */
-	{ "cmp",	Adr_idy  },	/* 0xD1 */
-	{ "cmp",	Adr_idp  },	/* 0xD2 */
-	{ "cmp",	Adr_isy  },	/* 0xD3 */
-	{ "pei",	Adr_idp  },	/* 0xD4 */
-	{ "cmp",	Adr_dpx  },	/* 0xD5 */
-	{ "dec",	Adr_dpx  },	/* 0xD6 */
-	{ "cmp",	Adr_idly },	/* 0xD7 */
-	{ "cld",	Adr_none },	/* 0xD8 */
-	{ "cmp",	Adr_aby  },	/* 0xD9 */
-	{ "phx",	Adr_none },	/* 0xDA */
-	{ "stp",	Adr_none },	/* 0xDB */
-	{ "jmp",	Adr_iax  },	/* 0xDC */
-	{ "cmp",	Adr_abx  },	/* 0xDD */
-	{ "dec",	Adr_abx  },	/* 0xDE */
-	{ "cmp",	Adr_alx  },	/* 0xDF */
-	/* 0xE0 */
-	{ "cpx",	Adr_immX  },	/* 0xE0 */
-	{ "sbc",	Adr_idx  },	/* 0xE1 */
-	{ "sep",	Adr_imm  },	/* 0xE2 */
-	{ "sbc",	Adr_sr   },	/* 0xE3 */
-	{ "cpx",	Adr_dp   },	/* 0xE4 */
-	{ "sbc",	Adr_dp   },	/* 0xE5 */
-	{ "inc",	Adr_dp   },	/* 0xE6 */
-	{ "sbc",	Adr_idl  },	/* 0xE7 */
-	{ "inx",	Adr_none },	/* 0xE8 */
-	{ "sbc",	Adr_immM },	/* 0xE9 */
-	{ "nop",	Adr_none },	/* 0xEA */
-	{ "xba",	Adr_none },	/* 0xEB */
-	{ "cpx",	Adr_abs  },	/* 0xEC */
-	{ "sbc",	Adr_abs  },	/* 0xED */
-	{ "inc",	Adr_abs  },	/* 0xEE */
-	{ "sbc",	Adr_abl  },	/* 0xEF */
-	/* 0xF0 */
-	{ "beq",	Adr_rel  },	/* 0xF0 */
-	{ "sbc",	Adr_idy  },	/* 0xF1 */
-	{ "sbc",	Adr_idp  },	/* 0xF2 */
-	{ "sbc",	Adr_isy  },	/* 0xF3 */
-	{ "pea",	Adr_abs  },	/* 0xF4 */
-	{ "sbc",	Adr_dpx  },	/* 0xF5 */
-	{ "inc",	Adr_dpx  },	/* 0xF6 */
-	{ "sbc",	Adr_idly },	/* 0xF7 */
-	{ "sed",	Adr_none },	/* 0xF8 */
-	{ "sbc",	Adr_aby  },	/* 0xF9 */
-	{ "plx",	Adr_none },	/* 0xFA */
-	{ "xce",	Adr_none },	/* 0xFB */
-	{ "jsr",	Adr_iax  },	/* 0xFC */
-	{ "sbc",	Adr_abx  },	/* 0xFD */
-	{ "inc",	Adr_abx  },	/* 0xFE */
-	{ "sbc",	Adr_alx  },	/* 0xFF */
-};
+static void SinkCleaner(void* ptr)
+{
+	Sink* s = (Sink*)ptr;
+	delete_Sink(&s);
+}
 
-typedef struct {
-	int    inx;
-	char   buffer[256];
-}SprintfBuffer;
-static void CleanSprintfBuffer(SprintfBuffer *b)
+static void DiagCleaner(void* ptr)
 {
-	b->inx = 0;
-	b->buffer[0] = '\0';	/* quick clean */
+	DisAsmDiag* d = (DisAsmDiag*)ptr;
+	free(d->message);
+	free(d);
 }
-static void bufSprintf(SprintfBuffer *b, const char* fmt, ...)
+
+/**
+ * @brief Create DisAsmContext object
+ *
+ * @return the pointer of object
+ */
+DisAsmContext* new_DisAsmContext(const DisAsmInf* inf)
 {
-	va_list vl;
-	int len;
+	DisAsmContext* self;
+	DisAsmContext_private* pri;
+
+	assert(inf);
+
+	/* make objects */
+	self = malloc(sizeof(DisAsmContext));
+	pri = malloc(sizeof(DisAsmContext_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	memcpy(&pri->inf, inf, sizeof(DisAsmInf));
+	pri->inf.dataLabel = Str_copy((NULL == inf->dataLabel) ? "" : inf->dataLabel);
+	pri->inf.exportBinPath = Str_copy(inf->exportBinPath);
+	pri->inf.cfgPath = Str_copy(inf->cfgPath);
+	pri->inf.tracePath = Str_copy(inf->tracePath);
+	pri->inf.cdlPath = Str_copy(inf->cdlPath);
+	pri->inf.fingerprintPath = Str_copy(inf->fingerprintPath);
+	pri->inf.namesPath = Str_copy(inf->namesPath);
+	/* the outputs are given as the sinks */
+	pri->inf.outputPath = NULL;
+	pri->inf.jsonPath = NULL;
+	pri->inf.csvPath = NULL;
+	pri->inf.binPath = NULL;
+	pri->sinks = new_List(NULL, SinkCleaner);
+	pri->diags = new_List(NULL, DiagCleaner);
+	pri->entries = new_List(NULL, free);
+	assert(pri->sinks);
+	assert(pri->diags);
+	assert(pri->entries);
+	pri->banks = NULL;
+	pri->arena = NULL;
+	pri->store = NULL;
+	pri->scratch = NULL;
+	pri->trace = NULL;
+	pri->cdl = NULL;
+	pri->cdlStops = 0;
+	pri->names = NULL;
+	pri->nameCount = 0;
+	pri->namesHash = 0;
+	pri->fp = NULL;
+	pri->traceBank = -1;
+	pri->traceShared = true;
+	pri->pointers = NULL;
+	pri->exits = NULL;
+
+	/*--- set public member ---*/
+	self->AddSink = AddSink;
+	self->AddEntry = AddEntry;
+	self->UseBankStore = UseBankStore;
+	self->Run = Run;
+	self->RunView = RunView;
+	self->Analyze = Analyze;
+	self->Report = Report;
+	self->diagCount_get = diagCount_get;
+	self->Diag = Diag;
+	self->PrintDiags = PrintDiags;
+
+	/* init DisAsmContext object */
+	self->pri = pri;
+	return self;
+}
 
-	va_start(vl, fmt);
-	len = vsprintf_s(&b->buffer[b->inx], (size_t)(256-b->inx), fmt, vl);
-	b->inx += len;
-	va_end(vl);
+/**
+ * @brief Delete DisAsmContext object
+ *
+ * @param the pointer of object
+ */
+void delete_DisAsmContext(DisAsmContext** self)
+{
+	DisAsmContext_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	free(pri->inf.dataLabel);
+	free((char*)pri->inf.exportBinPath);
+	free((char*)pri->inf.cfgPath);
+	free((char*)pri->inf.tracePath);
+	free((char*)pri->inf.cdlPath);
+	free((char*)pri->inf.fingerprintPath);
+	free((char*)pri->inf.namesPath);
+	delete_List(&pri->sinks);
+	delete_List(&pri->diags);
+	delete_List(&pri->entries);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+void DisAsm_InitInf(DisAsmInf* inf)
+{
+	assert(inf);
+	memset(inf, 0, sizeof(DisAsmInf));
+	inf->progCounter = -1;
+	inf->dataSplits = 16;
+	inf->dataLabel = "";
+	inf->depthMax = 3;
+}
+
+bool DisAsm_ParseEntry(const char* arg, const DisAsmInf* inf, uint32* snesadr, uint16* psw)
+{
+	const char* p = arg;
+	char* end;
+	int base = 10;
+
+	if('$' == p[0])
+	{
+		p++;
+		base = 16;
+	}
+	else if(0 == strncmp("0x", p, 2))
+	{
+		p += 2;
+		base = 16;
+	}
+	(*snesadr) = (uint32)strtoul(p, &end, base);
+	if(end == p) return false;
+
+	(*psw) = 0x30;
+	if(':' == *end)
+	{
+		for(end++; '\0' != *end; end++)
+		{
+			if('a' == *end) (*psw) = (uint16)((*psw) & (0x20 ^ 0xff));
+			else if('x' == *end) (*psw) = (uint16)((*psw) & (0x10 ^ 0xff));
+			else return false;
+		}
+		return true;
+	}
+	if(inf->accum16bits) (*psw) = (uint16)((*psw) & (0x20 ^ 0xff));
+	if(inf->index16bits) (*psw) = (uint16)((*psw) & (0x10 ^ 0xff));
+	return ('\0' == *end);
 }
 
-static const char * GetMapModeString(RomFile *from)
+const char* DisAsm_MapModeString(const RomView* from)
 {
 	switch(from->mapmode_get(from))
 	{
@@ -460,12 +311,99 @@ static const char * GetMapModeString(RomFile *from)
 	return "Unknown";
 }
 
-static void AddAnalysysTarget(SnesRegisters* base, UniAdr adr, AdrMode mode, List* snesRegsList)
+/*--------------- Sink dispatchers ---------------*/
+
+static void PutBegin(List* sinks, const RomView* from)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Begin(s, from, DisAsm_MapModeString(from));
+	}
+}
+
+static void PutLabel(List* sinks, const uint32 snesadr, const char* name)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Label(s, snesadr, name);
+	}
+}
+
+static void PutOrg(List* sinks, const uint32 snesadr)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Org(s, snesadr);
+	}
+}
+
+static void PutGroup(List* sinks, const GroupInfo* grp)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Group(s, grp);
+	}
+}
+
+static void PutInsn(List* sinks, const Instruction* ins)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Insn(s, ins);
+	}
+}
+
+static void PutData(List* sinks, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	Iterator* it;
+	Sink* s;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		s->Data(s, snesadr, pcadr, data, len);
+	}
+}
+
+static bool PutEnd(List* sinks)
+{
+	Iterator* it;
+	Sink* s;
+	bool result = true;
+
+	for(it = sinks->begin(sinks); NULL != it; it = it->next(it))
+	{
+		s = (Sink*)it->data(it);
+		result &= s->End(s);
+	}
+	return result;
+}
+
+static void AddAnalysysTarget(Arena* arena, SnesRegisters* base, UniAdr adr, AdrMode mode, List* snesRegsList)
 {
 	SnesRegisters* regs;
 
-	regs = malloc(sizeof(SnesRegisters));
-	assert(regs);
+	regs = arena->Alloc(arena, sizeof(SnesRegisters));
 	memcpy(regs, base, sizeof(SnesRegisters));
 	regs->callFrom = base->callFrom;
 
@@ -491,142 +429,120 @@ static void AddAnalysysTarget(SnesRegisters* base, UniAdr adr, AdrMode mode, Lis
 	snesRegsList->enqueue(snesRegsList, regs);
 }
 
-static bool SearchOpStruct(const void* a, const void* b)
+/**
+ * Keep the transfer out of the traced bank
+ */
+static void AddBankExit(DisAsmContext* self, const SnesRegisters* regs, const int depth)
 {
-	const OpStruct *opsA = (OpStruct*)a;
-	const OpStruct *opsB = (OpStruct*)b;
-
-	return (opsA->pcadr == opsB->pcadr);
+	BankTraceExit* e;
+
+	e = self->pri->arena->Alloc(self->pri->arena, sizeof(BankTraceExit));
+	e->snesadr = regs->pc;
+	e->callFrom = regs->callFrom;
+	e->psw = regs->psw;
+	e->depth = depth;
+	self->pri->exits->enqueue(self->pri->exits, e);
 }
 
-static AddOpcodeResult AddOpcode(OpStruct *ops, List* opStructList)
+/**
+ * Check whether the pointer of the indirect jump is read from the rom
+ */
+static bool PointerInRom(const uint32* pcadrs)
 {
-	Iterator* it;
-	OpStruct* o;
-	uint32 begdif = 0;
-	uint32 enddif = 0;
-
-	if(opStructList->length(opStructList) != 0)
-	{
-		it = opStructList->begin(opStructList);
-		o = (OpStruct*)it->data(it);
-		begdif = (uint32)abs((int)(ops->pcadr - o->pcadr));
-		if(o->pcadr > ops->pcadr)
-		{
-			opStructList->pushFront(opStructList,ops);
-			return AddOpcode_NoError;
-		}
-
-		it = opStructList->end(opStructList);
-		o = (OpStruct*)it->data(it);
-		enddif = (uint32)abs((int)(ops->pcadr - o->pcadr));
-		if(o->pcadr < ops->pcadr)
-		{
-			opStructList->enqueue(opStructList,ops);
-			return AddOpcode_NoError;
-		}
-	}
-
-	/* dup check */
-	if(begdif < enddif)
-	{
-		/* search from top */
-		if(NULL != opStructList->searchex(opStructList, ops, SearchOpStruct, NULL, false))
-		return AddOpcode_Exists;
-	}
-	else
-	{
-		/* search from tail */
-		if(NULL != opStructList->searchex(opStructList, ops, SearchOpStruct, NULL, true))
-		return AddOpcode_Exists;
-	}
+	return (ROMADDRESS_NULL != pcadrs[0]) || (ROMADDRESS_NULL != pcadrs[1]) || (ROMADDRESS_NULL != pcadrs[2]);
+}
 
-	/* insert */
-	for(it = opStructList->begin(opStructList); it != NULL; it = it->next(it))
-	{
-		o = it->data(it);
-		if(ops->pcadr < o->pcadr) break;
-	}
-	if(NULL != it)
-	{
-		it->insert(it, ops);
-	}
-	else
-	{
-		opStructList->enqueue(opStructList,ops);
-	}
-	return AddOpcode_NoError;
+/**
+ * Flag the blocks of the pointer bytes read from the rom(the saved state depends on them)
+ */
+static void AddPointer(DisAsmContext_private* pri, const uint32 pcadr)
+{
+	if((NULL == pri->pointers) || (ROMADDRESS_NULL == pcadr)) return;
+	pri->pointers[pcadr >> AnalysisDb_BlockShift] = 1;
 }
 
-static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStructList, const int depth, const int depthMax)
+static Pass1Result DisAsm_Pass1(DisAsmContext* self, const RomView* from, SnesRegisters* regs, const int depth)
 {
-	uint8* ptr;
+	Arena* arena = self->pri->arena;
+	InsnStore* store = self->pri->store;
+	CdlLog* cdl = self->pri->cdl;
+	const int depthMax = self->pri->inf.depthMax;
+	const uint8* ptr;
+	const uint8* arg;
+	uint8 op;
+	uint8 logged;
+	uint32 pcadr;
 	List* snesRegsList;
 	uint16 pcLo = 0;
 	uint16 prevPcLo = 0;
-	Opcode *op;
-	OpStruct *opst;
 	int arglen;
 	SnesRegisters* subRegs;
 	UniAdr adr = {0};
-	SnesRegisters *grpSts;
+	uint32 entryFrom;
+	uint32 pointer[3];
+	bool head = true;
 
 	/* check recursive limit */
 	if((depthMax <= depth) && (0 != depthMax)) return Pass1_NoError;
 
+	/* out of the traced bank */
+	if((0 <= self->pri->traceBank) && ((uint32)self->pri->traceBank != (regs->pc >> 16)))
+	{
+		AddBankExit(self, regs, depth);
+		return Pass1_NoError;
+	}
+
 	/* get data pointer */
 	ptr = from->GetSnesPtr(from, regs->pc);
 	if(NULL == ptr)
 	{
-		puterror("Invalid pointer : $%06x (call from $%06x)", regs->pc, regs->callFrom);
+		self->Report(self, DisAsmDiag_Error, "Invalid pointer : $%06x (call from $%06x)", regs->pc, regs->callFrom);
 		return Pass1_InvalidPointer;
 	}
+	entryFrom = regs->callFrom;
 
-	grpSts = malloc(sizeof(SnesRegisters));
-	assert(grpSts);
-	memcpy(grpSts, regs, sizeof(SnesRegisters));
-	grpSts->depth = depth;
-
-	snesRegsList = new_List(NULL, SnesRegistersCleaner);
+	snesRegsList = new_ListEx(NULL, NULL, arena);
 	assert(snesRegsList);
 
 	pcLo = (uint16)(regs->pc & 0xffff);
 	while(prevPcLo <= pcLo)
 	{
-		opst = calloc(1, sizeof(OpStruct));
-		assert(opst);
-
-		opst->regs = grpSts;
-		grpSts = NULL;
-		opst->op = ptr[0];
-		opst->snesadr = regs->pc;
-		opst->pcadr = from->Snes2PcAdr(from, regs->pc);
-
-		regs->callFrom = regs->pc;
-		op = &opcodes[(ptr++)[0]];
-		arglen = 2;	/* default: imm(16bits mode) length */
-		switch(op->mode)
+		pcadr = from->Snes2PcAdr(from, regs->pc);
+		if(NULL != cdl)
 		{
-			case Adr_immM:
-				if(regs->psw & 0x20) arglen = 1;
-				break;
-
-			case Adr_immX:
-				if(regs->psw & 0x10) arglen = 1;
-				break;
-
-			default:
-				arglen = argLength[op->mode];
-				break;
+			/* the logged data isn't decoded, and the logged code is decoded with its flags */
+			logged = cdl->Flags(cdl, pcadr);
+			if(CdlLog_IsData(logged))
+			{
+				self->pri->cdlStops++;
+				goto ReturnRoutine;
+			}
+			if(0 != (logged & CdlLog_Code))
+			{
+				regs->psw = (uint16)((regs->psw & 0xffcf) | (logged & (CdlLog_M8 | CdlLog_X8)));
+			}
 		}
-		opst->arglen = arglen;
-		memcpy(opst->arg, ptr, (size_t)arglen);
+
+		/* the instruction across the end of the rom */
+		if(from->size_get(from) < pcadr + 1 + (uint32)Opcode_ArgLength(ptr[0], regs->psw)) goto ReturnRoutine;
 
 		/* add disassemble list */
-		if(AddOpcode_Exists == AddOpcode(opst, opStructList))
+		if(false == store->Add(store, regs->pc, pcadr, (uint8)regs->psw))
 		{
+			delete_List(&snesRegsList);
 			return Pass1_NoError;
 		}
+		if(head)
+		{
+			store->AddGroup(store, entryFrom, depth);
+			head = false;
+		}
+
+		regs->callFrom = regs->pc;
+		ConstProp_Step(&regs->consts, ptr, regs->psw);
+		op = ptr[0];
+		arglen = Opcode_ArgLength((ptr++)[0], regs->psw);
+		arg = ptr;
 
 		/* increase program counters */
 		prevPcLo = pcLo;
@@ -637,7 +553,7 @@ static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStru
 
 		/* analysys the opcode */
 		adr.abl = 0;
-		switch(opst->op)
+		switch(op)
 		{
 			/* return */
 			case 0x40:	/* rti */
@@ -649,6 +565,16 @@ static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStru
 			case 0x6c:
 			case 0x7c:
 			case 0xdc:
+				/* the pointer which is made from the immediate values */
+				if(ConstProp_Target(&regs->consts, from, &arg[-1], regs->callFrom, &adr.abl, pointer))
+				{
+					/* the pointer in the rom(maybe out of the bank) isn't in the key of the trace */
+					if(PointerInRom(pointer)) self->pri->traceShared = false;
+					AddPointer(self->pri, pointer[0]);
+					AddPointer(self->pri, pointer[1]);
+					AddPointer(self->pri, pointer[2]);
+					AddAnalysysTarget(arena, regs, adr, Adr_abl, snesRegsList);
+				}
 				goto ReturnRoutine;
 
 			/* relative branch */
@@ -660,30 +586,30 @@ static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStru
 			case 0xb0:	/* bcs */
 			case 0xd0:	/* bne */
 			case 0xf0:	/* beq */
-				adr.rel = (int8)opst->arg[0];
-				AddAnalysysTarget(regs, adr, Adr_rel, snesRegsList);
+				adr.rel = (int8)arg[0];
+				AddAnalysysTarget(arena, regs, adr, Adr_rel, snesRegsList);
 				break;
 
 			case 0x80:	/* bra */
-				adr.rel = (int8)opst->arg[0];
-				AddAnalysysTarget(regs, adr, Adr_rel, snesRegsList);
+				adr.rel = (int8)arg[0];
+				AddAnalysysTarget(arena, regs, adr, Adr_rel, snesRegsList);
 				goto ReturnRoutine;
 
 			/* relative long branch */
 			case 0x82:	/* brl */
-				adr.rell = (int16)read16(&opst->arg[0]);
-				AddAnalysysTarget(regs, adr, Adr_rell, snesRegsList);
+				adr.rell = (int16)read16(&arg[0]);
+				AddAnalysysTarget(arena, regs, adr, Adr_rell, snesRegsList);
 				goto ReturnRoutine;
 
 			/* jump */
 			case 0x4c:	/* jmp */
-				adr.abs = read16(&opst->arg[0]);
-				AddAnalysysTarget(regs, adr, Adr_abs, snesRegsList);
+				adr.abs = read16(&arg[0]);
+				AddAnalysysTarget(arena, regs, adr, Adr_abs, snesRegsList);
 				goto ReturnRoutine;
 
 			case 0x5c:	/* jml */
-				adr.abl = read24(&opst->arg[0]);
-				AddAnalysysTarget(regs, adr, Adr_abl, snesRegsList);
+				adr.abl = read24(&arg[0]);
+				AddAnalysysTarget(arena, regs, adr, Adr_abl, snesRegsList);
 				goto ReturnRoutine;
 
 			/* subroutine */
@@ -692,14 +618,15 @@ static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStru
 					uint32 pre = regs->pc;
 					uint32 precf = regs->callFrom;
 					Pass1Result r;
-					regs->pc = (regs->pc & 0xff0000) + read16(&opst->arg[0]);
-					if(Pass1_NoError != (r = DisAsm_Pass1(from, regs, opStructList, depth+1, depthMax)))
+					regs->pc = (regs->pc & 0xff0000) + read16(&arg[0]);
+					if(Pass1_NoError != (r = DisAsm_Pass1(self, from, regs, depth+1)))
 					{
 						delete_List(&snesRegsList);
 						return r;
 					}
 					regs->pc = pre;
 					regs->callFrom = precf;
+					ConstProp_Clear(&regs->consts);
 				}
 				break;
 
@@ -708,23 +635,24 @@ static Pass1Result DisAsm_Pass1(RomFile* from, SnesRegisters* regs, List* opStru
 					uint32 pre = regs->pc;
 					uint32 precf = regs->callFrom;
 					Pass1Result r;
-					regs->pc = read24(&opst->arg[0]);
-					if(Pass1_NoError != (r = DisAsm_Pass1(from, regs, opStructList, depth+1, depthMax)))
+					regs->pc = read24(&arg[0]);
+					if(Pass1_NoError != (r = DisAsm_Pass1(self, from, regs, depth+1)))
 					{
 						delete_List(&snesRegsList);
 						return r;
 					}
 					regs->pc = pre;
 					regs->callFrom = precf;
+					ConstProp_Clear(&regs->consts);
 				}
 				break;
 
 			case 0xc2:	/* rep */
-				regs->psw = (uint16)(regs->psw & (opst->arg[0] ^ 0xff));
+				regs->psw = (uint16)(regs->psw & (arg[0] ^ 0xff));
 				break;
 
 			case 0xe2:	/* sep */
-				regs->psw = (uint16)(regs->psw | opst->arg[0]);
+				regs->psw = (uint16)(regs->psw | arg[0]);
 				break;
 
 			default:
@@ -738,8 +666,7 @@ ReturnRoutine:
 	while(NULL != subRegs)
 	{
 		Pass1Result r;
-		r = DisAsm_Pass1(from, subRegs, opStructList, depth, depthMax);
-		SnesRegistersCleaner(subRegs);
+		r = DisAsm_Pass1(self, from, subRegs, depth);
 
 		if(r != Pass1_NoError)
 		{
@@ -755,252 +682,914 @@ ReturnRoutine:
 }
 
 
-bool DisAsm_Pass2(TextFile* fasm, List* opStructList, bool enableUpper)
-{
-	OpStruct* opst;
-	SprintfBuffer buf;
+/*--------------- bank-local trace ---------------*/
 
-	opst = opStructList->dequeue(opStructList);
-	while(NULL != opst)
+/**
+ * Hash of the rom data mapped to the snes bank(cached while pass1)
+ */
+static uint64 BankHash(DisAsmContext_private* pri, const RomView* from, const uint32 bank)
+{
+	uint64 hash = BankStore_HashInit;
+	const uint8* ptr;
+	uint32 size;
+	uint32 page;
+	uint32 pca;
+	uint32 len;
+	uint8 mapped;
+
+	if(0 != (pri->bankHashed[bank>>3] & (1u << (bank&7)))) return pri->bankHash[bank];
+
+	/* the mapping is linear in each 4KB page */
+	size = (uint32)from->size_get(from);
+	for(page = 0; page < 0x10000; page += 0x1000)
 	{
-		/* puts group info */
-		if(NULL != opst->regs)
-		{
-			fasm->Printf(fasm, "\n");
-			fasm->Printf(fasm, ";-----------------------------\n");
-			fasm->Printf(fasm, ";   call depth   : %d\n", opst->regs->depth);
-			fasm->Printf(fasm, ";   call from    : $%06x\n", opst->regs->callFrom);
-			fasm->Printf(fasm, ";   A register   : %s\n", (opst->regs->psw & 0x20) ? "8 bit" : "16 bit");
-			fasm->Printf(fasm, ";   X/Y register : %s\n", (opst->regs->psw & 0x10) ? "8 bit" : "16 bit");
-			fasm->Printf(fasm, ";-----------------------------\n");
-		}
-
-		CleanSprintfBuffer(&buf);
-		bufSprintf(&buf, "L%06x:\t%s", opst->snesadr, opcodes[opst->op].op);
-		switch(opcodes[opst->op].mode)
-		{
-			case Adr_imm:
-				/* "...#$02        " */
-				bufSprintf(&buf, "   #$%02x         ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+		pca = from->Snes2PcAdr(from, (bank << 16) | page);
+		mapped = (uint8)((ROMADDRESS_NULL != pca) && (pca < size));
+		hash = BankStore_Hash(hash, &mapped, 1);
+		if(0 == mapped) continue;
+
+		len = size - pca;
+		if(0x1000 < len) len = 0x1000;
+		ptr = from->GetPcPtr(from, pca);
+		assert(ptr);
+		hash = BankStore_Hash(hash, ptr, len);
+	}
 
-			case Adr_immM:
-			case Adr_immX:
-				if(2 == opst->arglen)
-				{
-					/* ".w.#$1234      " */
-					bufSprintf(&buf, ".w #$%04x       ; %02x %02x %02x\n",
-							read16(&opst->arg[0]),
-							opst->op, opst->arg[0], opst->arg[1]);
-					break;
-				}
-				/* "...#$02        " */
-				bufSprintf(&buf, ".b #$%02x         ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+	pri->bankHash[bank] = hash;
+	pri->bankHashed[bank>>3] = (uint8)(pri->bankHashed[bank>>3] | (1u << (bank&7)));
+	return hash;
+}
 
-			case Adr_sr:
-				/* ".b.$02, s      " */
-				bufSprintf(&buf, ".b $%02x, s       ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+/**
+ * Key of the trace : the bank data, the rom map and the entry state
+ *   The pointers read from the rom aren't in the key, so the traces which
+ *   read them aren't shared(TraceBank).
+ */
+static uint64 BankKey(DisAsmContext_private* pri, const RomView* from, const BankTraceExit* entry)
+{
+	uint8 buf[16];
+
+	write32(&buf[0], entry->snesadr);
+	write16(&buf[4], entry->psw);
+	write32(&buf[6], (uint32)entry->depth);
+	write32(&buf[10], (uint32)pri->inf.depthMax);
+	buf[14] = (uint8)from->type_get(from);
+	buf[15] = (uint8)from->mapmode_get(from);
+	return BankStore_Hash(BankHash(pri, from, entry->snesadr >> 16), buf, sizeof(buf));
+}
 
-			case Adr_dp:
-				/* ".b.$02         " */
-				bufSprintf(&buf, ".b $%02x          ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+/**
+ * Trace the bank from the entry into the scratch store
+ *   return:
+ *     the trace, or NULL if pass1 failed(the error is reported)
+ *     If the trace read the pointers from the rom, traceShared is cleared.
+ */
+static BankTrace* TraceBank(DisAsmContext* self, const RomView* from, const BankTraceExit* entry)
+{
+	DisAsmContext_private* pri = self->pri;
+	InsnStore* store = pri->store;
+	InsnStore* scratch;
+	SnesRegisters regs = {0};
+	BankTrace* trace;
+	const InsnRec* rec;
+	const GroupRec* grp;
+	Iterator* it;
+	Pass1Result r;
+	uint32 i;
 
-			case Adr_dpx:
-				/* ".b.$02, x      " */
-				bufSprintf(&buf, ".b $%02x, x       ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+	if(NULL == pri->scratch)
+	{
+		pri->scratch = new_InsnStore((uint32)from->size_get(from));
+		assert(pri->scratch);
+	}
+	scratch = pri->scratch;
+	scratch->Clear(scratch);
+
+	regs.pc = entry->snesadr;
+	regs.db = (uint8)(entry->snesadr >> 16);
+	regs.psw = entry->psw;
+	regs.callFrom = BankTrace_Entry;
+	ConstProp_Init(&regs.consts);
+
+	pri->store = scratch;
+	pri->traceBank = (int)(entry->snesadr >> 16);
+	pri->traceShared = true;
+	pri->exits = new_ListEx(NULL, NULL, pri->arena);
+	assert(pri->exits);
+	r = DisAsm_Pass1(self, from, &regs, entry->depth);
+	pri->store = store;
+	pri->traceBank = -1;
+	if(Pass1_NoError != r)
+	{
+		delete_List(&pri->exits);
+		return NULL;
+	}
 
-			case Adr_dpy:
-				/* ".b.$02, y      " */
-				bufSprintf(&buf, ".b $%02x, y       ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+	/* in the trace order */
+	trace = new_BankTrace(scratch->count_get(scratch), scratch->groupCount_get(scratch),
+			(uint32)pri->exits->length(pri->exits));
+	for(i=0; i<trace->recCount; i++)
+	{
+		rec = scratch->Record(scratch, i);
+		trace->recs[i].snesadr = InsnRec_Snes(rec);
+		trace->recs[i].psw = rec->psw;
+		trace->recs[i].flags = rec->flags;
+	}
+	for(i=0; i<trace->groupCount; i++)
+	{
+		grp = scratch->Group(scratch, i);
+		trace->groups[i].callFrom = grp->callFrom;
+		trace->groups[i].depth = grp->depth;
+	}
+	i = 0;
+	List_Foreach(pri->exits, it)
+	{
+		memcpy(&trace->exits[i++], Iterator_Data(it), sizeof(BankTraceExit));
+	}
+	delete_List(&pri->exits);
 
-			case Adr_idp:
-				/* ".b.($02)       " */
-				bufSprintf(&buf, ".b ($%02x)        ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+	return trace;
+}
 
-			case Adr_idx:
-				/* ".b.($02, x)    " */
-				bufSprintf(&buf, ".b ($%02x, x)     ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+/**
+ * Add the records of the trace to the store
+ *   The records which are already stored are skipped.
+ */
+static void ReplayTrace(InsnStore* store, const RomView* from, const BankTrace* trace, const uint32 callFrom)
+{
+	const BankTraceRec* r;
+	const BankTraceGroup* g;
+	uint32 group = 0;
+	uint32 i;
+	bool added;
 
-			case Adr_idy:
-				/* ".b.($02), y    " */
-				bufSprintf(&buf, ".b ($%02x), y     ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+	for(i=0; i<trace->recCount; i++)
+	{
+		r = &trace->recs[i];
+		added = store->Add(store, r->snesadr, from->Snes2PcAdr(from, r->snesadr), r->psw);
+		if((0 == (r->flags & InsnRec_GroupHead)) || (trace->groupCount <= group)) continue;
 
-			case Adr_idl:
-				/* ".b.[$02]       " */
-				bufSprintf(&buf, ".b [$%02x]        ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+		g = &trace->groups[group++];
+		if(added)
+		{
+			store->AddGroup(store, (BankTrace_Entry == g->callFrom) ? callFrom : g->callFrom, g->depth);
+		}
+	}
+}
 
-			case Adr_idly:
-				/* ".b.[$02], y    " */
-				bufSprintf(&buf, ".b [$%02x], y     ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+/**
+ * Pass1 by the bank-local traces
+ *   Each entry into the bank is traced(or found in the bank store), and
+ *   its exits are traced as the entries of the other banks.
+ *   The registers aren't carried back from the other banks.
+ */
+static Pass1Result DisAsm_Pass1Banked(DisAsmContext* self, const RomView* from, SnesRegisters* regs, const int depth)
+{
+	DisAsmContext_private* pri = self->pri;
+	Arena* arena = pri->arena;
+	InsnStore* store = pri->store;
+	const int depthMax = pri->inf.depthMax;
+	const BankTrace* trace;
+	BankTrace* local;
+	BankTraceExit* e;
+	BankTraceExit* next;
+	List* queue;
+	uint64 key;
+	uint32 i;
+
+	queue = new_ListEx(NULL, NULL, arena);
+	assert(queue);
+	e = arena->Alloc(arena, sizeof(BankTraceExit));
+	e->snesadr = regs->pc;
+	e->callFrom = regs->callFrom;
+	e->psw = regs->psw;
+	e->depth = depth;
+	queue->enqueue(queue, e);
+
+	for(e = queue->dequeue(queue); NULL != e; e = queue->dequeue(queue))
+	{
+		/* check recursive limit */
+		if((depthMax <= e->depth) && (0 != depthMax)) continue;
 
-			case Adr_isy:
-				/* ".b.($02, s), y " */
-				bufSprintf(&buf, ".b ($%02x, s), y  ; %02x %02x\n",
-						opst->arg[0],
-						opst->op, opst->arg[0]);
-				break;
+		if(NULL == from->GetSnesPtr(from, e->snesadr))
+		{
+			self->Report(self, DisAsmDiag_Error, "Invalid pointer : $%06x (call from $%06x)", e->snesadr, e->callFrom);
+			delete_List(&queue);
+			return Pass1_InvalidPointer;
+		}
+		if(store->Has(store, from->Snes2PcAdr(from, e->snesadr))) continue;
 
-			case Adr_abs:
-				/* ".w.$1234       " */
-				switch(opst->op)
-				{
-					case 0x20:	/* jsr */
-					case 0x4c:	/* jmp */
-						bufSprintf(&buf, "   L%06x      ; %02x %02x %02x\n",
-								((uint32)((((int32)opst->snesadr+3) & 0xff0000) + read16(&opst->arg[0]))),
-								opst->op, opst->arg[0], opst->arg[1]);
-						break;
-
-					default:
-						bufSprintf(&buf, ".w $%04x        ; %02x %02x %02x\n",
-								read16(&opst->arg[0]),
-								opst->op, opst->arg[0], opst->arg[1]);
-						break;
-				}
-				break;
+		key = BankKey(pri, from, e);
+		trace = pri->banks->Find(pri->banks, key);
+		local = NULL;
+		if(NULL == trace)
+		{
+			local = TraceBank(self, from, e);
+			if(NULL == local)
+			{
+				delete_List(&queue);
+				return Pass1_InvalidPointer;
+			}
+			trace = local;
+			if(pri->traceShared)
+			{
+				trace = pri->banks->Add(pri->banks, key, local);
+				local = NULL;
+			}
+		}
 
-			case Adr_abx:
-				/* ".w.$1234, x    " */
-				bufSprintf(&buf, ".w $%04x, x     ; %02x %02x %02x\n",
-						read16(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
+		ReplayTrace(store, from, trace, e->callFrom);
+		for(i=0; i<trace->exitCount; i++)
+		{
+			next = arena->Alloc(arena, sizeof(BankTraceExit));
+			memcpy(next, &trace->exits[i], sizeof(BankTraceExit));
+			queue->enqueue(queue, next);
+		}
+		delete_BankTrace(&local);
+	}
 
-			case Adr_aby:
-				/* ".w.$1234, y    " */
-				bufSprintf(&buf, ".w $%04x, y     ; %02x %02x %02x\n",
-						read16(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
+	delete_List(&queue);
+	return Pass1_NoError;
+}
 
-			case Adr_abl:
-				/* ".l.$123456     " */
-				switch(opst->op)
-				{
-					case 0x22:	/* jsl */
-					case 0x5c:	/* jml */
-						bufSprintf(&buf, "   L%06x      ; %02x %02x %02x %02x\n",
-								read24(&opst->arg[0]),
-								opst->op, opst->arg[0], opst->arg[1], opst->arg[2]);
-						break;
-
-					default:
-						bufSprintf(&buf, ".l $%06x      ; %02x %02x %02x %02x\n",
-								read24(&opst->arg[0]),
-								opst->op, opst->arg[0], opst->arg[1], opst->arg[2]);
-						break;
-				}
-				break;
+/**
+ * Pass1 from the entry(by the bank-local traces if the bank store is used)
+ */
+static Pass1Result Pass1Entry(DisAsmContext* self, const RomView* from, SnesRegisters* regs)
+{
+	/* the bank traces are shared without the code / data log */
+	if((NULL != self->pri->banks) && (NULL == self->pri->cdl))
+	{
+		return DisAsm_Pass1Banked(self, from, regs, 0);
+	}
+	return DisAsm_Pass1(self, from, regs, 0);
+}
 
-			case Adr_alx:
-				/* ".l.$123456, x  " */
-				bufSprintf(&buf, ".l $%06x, x   ; %02x %02x %02x %02x\n",
-						read24(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1], opst->arg[2]);
-				break;
 
-			case Adr_ind:
-				/* ".w.($1234)     " */
-				bufSprintf(&buf, ".w ($%04x)      ; %02x %02x %02x\n",
-						read16(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
+/**
+ * Run the rom, and add the executed code
+ *   The code from the executed jump / call destinations which aren't
+ *   stored yet is traced by Pass1, then the rest of the executed
+ *   instructions is added as it is.
+ */
+static void RunExec(DisAsmContext* self, const RomView* from)
+{
+	InsnStore* store = self->pri->store;
+	SnesRegisters regs;
+	const CpuLog* l;
+	Cpu* cpu;
+	uint32 added;
+	uint32 i;
 
-			case Adr_iax:
-				/* ".w.($1234, x)  " */
-				bufSprintf(&buf, ".w ($%04x, x)   ; %02x %02x %02x\n",
-						read16(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
+	cpu = new_Cpu(from);
+	cpu->Run(cpu, (uint32)self->pri->inf.execSteps);
 
-			case Adr_ial:
-				/* ".l.[$123456]   " */
-				bufSprintf(&buf, ".l [$%06x]    ; %02x %02x %02x %02x\n",
-						read24(&opst->arg[0]),
-						opst->op, opst->arg[0], opst->arg[1], opst->arg[2]);
-				break;
+	for(i=0; i<cpu->logCount_get(cpu); i++)
+	{
+		l = cpu->Log(cpu, i);
+		if(0 == (l->flags & CpuLog_Head)) continue;
+		if(store->Has(store, from->Snes2PcAdr(from, l->snesadr))) continue;
+
+		memset(&regs, 0, sizeof(SnesRegisters));
+		regs.psw = l->psw;
+		regs.callFrom = l->callFrom;
+		regs.pc = l->snesadr;
+		regs.db = (uint8)(l->snesadr >> 16);
+		ConstProp_Init(&regs.consts);
+		Pass1Entry(self, from, &regs);
+	}
+	added = cpu->Emit(cpu, store);
 
-			case Adr_rel:
-				/* "...$02         " */
-				bufSprintf(&buf, "   L%06x      ; %02x %02x\n",
-						((uint32)((int32)opst->snesadr+2 + (int8)opst->arg[0])),
-						opst->op, opst->arg[0]);
-				break;
+	if(self->pri->inf.showStats)
+	{
+		self->Report(self, DisAsmDiag_Info, "Exec : %lu steps, %lu instructions (%lu added, %lu conflicts / %lu bytes)",
+				(ulong)cpu->steps_get(cpu),
+				(ulong)cpu->logCount_get(cpu),
+				(ulong)added,
+				(ulong)cpu->conflicts_get(cpu),
+				(ulong)cpu->bytes_get(cpu));
+	}
+	delete_Cpu(&cpu);
+}
 
-			case Adr_rell:
-				/* "...$1234       " */
-				bufSprintf(&buf, "   L%06x      ; %02x %02x %02x\n",
-						((uint32)((int32)opst->snesadr+3 + (int16)read16(&opst->arg[0]))),
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
 
-			case Adr_bm:
-				/* "...$02, $03    " */
-				bufSprintf(&buf, "   $%02x, $%02x     ; %02x %02x %02x\n",
-						opst->arg[0], opst->arg[1],
-						opst->op, opst->arg[0], opst->arg[1]);
-				break;
+/**
+ * Load the trace log
+ */
+static bool LoadTrace(DisAsmContext* self, const RomView* from)
+{
+	TraceLog* trace;
 
-			case Adr_none:
-				bufSprintf(&buf, "%15s ; %02x\n", "", opst->op);
-				break;
+	trace = new_TraceLog(from);
+	if(false == trace->Load(trace, self->pri->inf.tracePath, 0))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't read the trace log : %s", self->pri->inf.tracePath);
+		delete_TraceLog(&trace);
+		return false;
+	}
+	self->pri->trace = trace;
+	return true;
+}
+
+/**
+ * Trace the logged code which isn't stored yet(with the logged flags)
+ */
+static void SeedTrace(DisAsmContext* self, const RomView* from)
+{
+	TraceLog* trace = self->pri->trace;
+	InsnStore* store = self->pri->store;
+	SnesRegisters regs;
+	const TraceHit* h;
+	uint32 seeded = 0;
+	uint32 i;
+
+	for(i=0; i<trace->count_get(trace); i++)
+	{
+		h = trace->Hit(trace, i);
+		if(store->Has(store, h->pcadr)) continue;
+
+		memset(&regs, 0, sizeof(SnesRegisters));
+		regs.psw = h->psw;
+		regs.callFrom = h->snesadr;
+		regs.pc = h->snesadr;
+		regs.db = (uint8)(h->snesadr >> 16);
+		ConstProp_Init(&regs.consts);
+		Pass1Entry(self, from, &regs);
+		seeded++;
+	}
+
+	if(self->pri->inf.showStats)
+	{
+		self->Report(self, DisAsmDiag_Info, "Trace : %lu lines (%lu skipped), %lu addresses, %lu entries seeded (%lu bytes)",
+				trace->lines_get(trace),
+				trace->skipped_get(trace),
+				(ulong)trace->count_get(trace),
+				(ulong)seeded,
+				(ulong)trace->bytes_get(trace));
+	}
+}
+
+/**
+ * Load the code / data log
+ */
+static bool LoadCdl(DisAsmContext* self, const RomView* from)
+{
+	CdlLog* cdl;
+
+	cdl = new_CdlLog(from);
+	if(false == cdl->Load(cdl, self->pri->inf.cdlPath))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't read the code / data log(or the size isn't the rom's one) : %s", self->pri->inf.cdlPath);
+		delete_CdlLog(&cdl);
+		return false;
+	}
+	self->pri->cdl = cdl;
+	self->pri->cdlStops = 0;
+	return true;
+}
+
+/**
+ * Trace the logged code regions which aren't stored yet(with the logged flags)
+ */
+static void SeedCdl(DisAsmContext* self, const RomView* from)
+{
+	CdlLog* cdl = self->pri->cdl;
+	InsnStore* store = self->pri->store;
+	SnesRegisters regs;
+	const CdlRegion* r;
+	uint32 seeded = 0;
+	uint32 i;
+
+	for(i=0; i<cdl->regionCount_get(cdl); i++)
+	{
+		r = cdl->Region(cdl, i);
+		if(0 == (r->flags & CdlLog_Code)) continue;
+		if(store->Has(store, r->pcadr)) continue;
+
+		memset(&regs, 0, sizeof(SnesRegisters));
+		regs.psw = (uint16)(r->flags & (CdlLog_M8 | CdlLog_X8));
+		regs.pc = from->Pc2SnesAdr(from, r->pcadr);
+		regs.callFrom = regs.pc;
+		regs.db = (uint8)(regs.pc >> 16);
+		ConstProp_Init(&regs.consts);
+		Pass1Entry(self, from, &regs);
+		seeded++;
+	}
+
+	if(self->pri->inf.showStats)
+	{
+		self->Report(self, DisAsmDiag_Info, "Cdl : %lu code bytes, %lu data bytes, %lu regions, %lu entries seeded, %lu traces stopped at the data (%lu bytes)",
+				(ulong)cdl->codeBytes_get(cdl),
+				(ulong)cdl->dataBytes_get(cdl),
+				(ulong)cdl->regionCount_get(cdl),
+				(ulong)seeded,
+				(ulong)self->pri->cdlStops,
+				(ulong)cdl->bytes_get(cdl));
+	}
+}
+
+/**
+ * Release the named routines
+ */
+static void FreeNames(DisAsmContext_private* pri)
+{
+	uint32 i;
+
+	for(i=0; i<pri->nameCount; i++)
+	{
+		free(pri->names[i].name);
+	}
+	free(pri->names);
+	pri->names = NULL;
+	pri->nameCount = 0;
+	pri->namesHash = 0;
+}
+
+static int NameCompare(const void* a, const void* b)
+{
+	const DisAsmName* x = (const DisAsmName*)a;
+	const DisAsmName* y = (const DisAsmName*)b;
+
+	if(x->pcadr != y->pcadr) return (x->pcadr < y->pcadr) ? -1 : 1;
+	return 0;
+}
+
+/* by the address, and the first line first */
+static int NameOrder(const void* a, const void* b)
+{
+	const DisAsmName* x = (const DisAsmName*)a;
+	const DisAsmName* y = (const DisAsmName*)b;
+
+	if(x->pcadr != y->pcadr) return (x->pcadr < y->pcadr) ? -1 : 1;
+	if(x->row != y->row) return (x->row < y->row) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Parse the line of the names file("<entry> <label>", '#' starts the comment)
+ *   return:
+ *     If the line is broken, return false. (The empty line isn't a name.)
+ */
+static bool ParseName(DisAsmContext* self, char* line, DisAsmName* n)
+{
+	char* adr;
+	char* end;
+
+	n->name = NULL;
+	end = strchr(line, '#');
+	if(NULL != end) (*end) = '\0';
+	for(adr = line; (' ' == *adr) || ('\t' == *adr); adr++);
+	if('\0' == *adr) return true;
+
+	for(end = adr; ('\0' != *end) && (' ' != *end) && ('\t' != *end); end++);
+	if('\0' == *end) return false;
+	(*end) = '\0';
+	if(false == DisAsm_ParseEntry(adr, &self->pri->inf, &n->snesadr, &n->psw)) return false;
+
+	/* the name is a label */
+	for(n->name = end + 1; (' ' == *n->name) || ('\t' == *n->name); n->name++);
+	for(end = n->name; ('\0' != *end) && (' ' != *end) && ('\t' != *end) && ('\r' != *end); end++);
+	for(adr = end; (' ' == *adr) || ('\t' == *adr) || ('\r' == *adr); adr++);
+	(*end) = '\0';
+	return ('\0' != n->name[0]) && ('\0' == *adr);
+}
+
+/**
+ * Load the names file
+ */
+static bool LoadNames(DisAsmContext* self, const RomView* from)
+{
+	DisAsmContext_private* pri = self->pri;
+	TextFile* in;
+	const char* line;
+	char buf[NameLen];
+	uint8 key[5];
+	DisAsmName n;
+	uint32 capacity = 0;
+	uint32 hash = FNV_Offset;
+	uint32 keep = 0;
+	uint32 i;
+	bool result = true;
+
+	in = new_TextFile(pri->inf.namesPath);
+	if(FileOpen_NoError != in->Open2(in, "r"))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't read the names : %s", pri->inf.namesPath);
+		delete_TextFile(&in);
+		return false;
+	}
+	while(NULL != (line = in->GetLine(in)))
+	{
+		result = (strlen(line) < NameLen);
+		if(result)
+		{
+			strcpy(buf, line);
+			result = ParseName(self, buf, &n);
+		}
+		if(false == result)
+		{
+			self->Report(self, DisAsmDiag_Error, "Invalid routine name : %s(%u)", pri->inf.namesPath, in->row_get(in));
+			break;
 		}
+		if(NULL == n.name) continue;
 
-		if(enableUpper)
+		n.pcadr = from->Snes2PcAdr(from, n.snesadr);
+		if(NULL == from->GetSnesPtr(from, n.snesadr))
+		{
+			self->Report(self, DisAsmDiag_Warn, "Invalid entry point : $%06x (%s)", n.snesadr, n.name);
+			continue;
+		}
+		if(capacity <= pri->nameCount)
 		{
-			Str_toupper(buf.buffer);
+			capacity = (0 == capacity) ? 64 : capacity * 2;
+			pri->names = realloc(pri->names, sizeof(DisAsmName) * capacity);
+			assert(pri->names);
 		}
-		fasm->Printf(fasm, "%s", buf.buffer);
+		n.name = Str_copy(n.name);
+		n.row = in->row_get(in);
+		pri->names[pri->nameCount++] = n;
+
+		/* the key of the analysis state */
+		write24(&key[0], n.snesadr);
+		write16(&key[3], n.psw);
+		for(i=0; i<sizeof(key); i++)
+		{
+			hash = (hash ^ key[i]) * FNV_Prime;
+		}
+	}
+	delete_TextFile(&in);
+	if(false == result)
+	{
+		FreeNames(pri);
+		return false;
+	}
 
-		OpStructCleaner(opst);
-		opst = opStructList->dequeue(opStructList);
+	/* the first name of the address is kept */
+	if(1 < pri->nameCount)
+	{
+		qsort(pri->names, pri->nameCount, sizeof(DisAsmName), NameOrder);
+		for(i=0; i<pri->nameCount; i++)
+		{
+			if((0 < keep) && (pri->names[keep-1].pcadr == pri->names[i].pcadr))
+			{
+				free(pri->names[i].name);
+				continue;
+			}
+			pri->names[keep++] = pri->names[i];
+		}
+		pri->nameCount = keep;
+	}
+	pri->namesHash = hash;
+	return true;
+}
+
+/**
+ * Trace the named routines which aren't stored yet
+ */
+static void SeedNames(DisAsmContext* self, const RomView* from)
+{
+	InsnStore* store = self->pri->store;
+	SnesRegisters regs;
+	const DisAsmName* n;
+	uint32 i;
+
+	for(i=0; i<self->pri->nameCount; i++)
+	{
+		n = &self->pri->names[i];
+		if(store->Has(store, n->pcadr)) continue;
+
+		memset(&regs, 0, sizeof(SnesRegisters));
+		regs.psw = n->psw;
+		regs.callFrom = n->snesadr;
+		regs.pc = n->snesadr;
+		regs.db = (uint8)(n->snesadr >> 16);
+		ConstProp_Init(&regs.consts);
+		Pass1Entry(self, from, &regs);
+	}
+}
+
+static const DisAsmName* FindName(DisAsmContext_private* pri, const uint32 pcadr)
+{
+	DisAsmName key;
+
+	if(0 == pri->nameCount) return NULL;
+	key.pcadr = pcadr;
+	return (const DisAsmName*)bsearch(&key, pri->names, pri->nameCount, sizeof(DisAsmName), NameCompare);
+}
+
+/**
+ * Name the routines by the fingerprints
+ *   With the names file, the named routines are added to the database,
+ *   and it's saved. Otherwise, the routines are searched in it.
+ *   return:
+ *     the names of the groups(the pointers are alive while the context
+ *     has the database), or NULL on the error
+ */
+static const char** NameRoutines(DisAsmContext* self, const RomView* from, InsnStore* store)
+{
+	DisAsmContext_private* pri = self->pri;
+	const char* path = pri->inf.fingerprintPath;
+	FingerprintHash* hashes;
+	Fingerprint* fp;
+	FILE* f;
+	bool exists;
+	const DisAsmName* n;
+	const char** names;
+	uint32 count;
+	uint32 found = 0;
+	uint32 g;
+
+	/* the database is made by the first names file */
+	f = fopen(path, "rb");
+	exists = (NULL != f);
+	if(exists) fclose(f);
+	fp = new_Fingerprint();
+	if((exists || (NULL == pri->inf.namesPath)) && (false == fp->Load(fp, path)))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't read the fingerprint database : %s", path);
+		delete_Fingerprint(&fp);
+		return NULL;
+	}
+
+	count = store->groupCount_get(store);
+	hashes = malloc(sizeof(FingerprintHash) * ((size_t)count + 1));
+	names = calloc((size_t)count + 1, sizeof(char*));
+	assert(hashes);
+	assert(names);
+	Fingerprint_Routines(from, store, hashes);
+
+	for(g=0; g<count; g++)
+	{
+		if(NULL == pri->inf.namesPath)
+		{
+			names[g] = fp->Find(fp, &hashes[g]);
+			if(NULL != names[g]) found++;
+			continue;
+		}
+		n = FindName(pri, store->Group(store, g)->pcadr);
+		if(NULL == n) continue;
+		names[g] = n->name;
+		if(fp->Add(fp, &hashes[g], n->name)) found++;
+	}
+	free(hashes);
+
+	if((NULL != pri->inf.namesPath) && (false == fp->Save(fp, path)))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't save the fingerprint database : %s", path);
+		delete_Fingerprint(&fp);
+		free(names);
+		return NULL;
+	}
+
+	if(pri->inf.showStats)
+	{
+		if(NULL != pri->inf.namesPath)
+		{
+			self->Report(self, DisAsmDiag_Info, "Fingerprint : %lu names, %lu routines added, %lu fingerprints (%lu conflicts / %lu bytes)",
+					(ulong)pri->nameCount, (ulong)found,
+					(ulong)fp->count_get(fp), (ulong)fp->conflicts_get(fp), (ulong)fp->bytes_get(fp));
+		}
+		else
+		{
+			self->Report(self, DisAsmDiag_Info, "Fingerprint : %lu routines, %lu named, %lu fingerprints (%lu bytes)",
+					(ulong)count, (ulong)found, (ulong)fp->count_get(fp), (ulong)fp->bytes_get(fp));
+		}
+	}
+	pri->fp = fp;
+	return names;
+}
+
+
+/**
+ * Executions of the routine head, and of the most executed instruction
+ * in the routine
+ */
+static void GroupHits(TraceLog* trace, InsnStore* store, const InsnRec* rec, GroupInfo* grp)
+{
+	uint32 hits;
+	uint32 inx;
+
+	grp->hits = GroupInfo_NotTraced;
+	grp->hitsMax = 0;
+	if(NULL == trace) return;
+
+	grp->hits = trace->Hits(trace, InsnRec_Pc(rec));
+	grp->hitsMax = grp->hits;
+	for(inx = store->Search(store, InsnRec_Pc(rec)) + 1; inx < store->count_get(store); inx++)
+	{
+		rec = store->Record(store, inx);
+		if(0 != (rec->flags & InsnRec_GroupHead)) break;
+		hits = trace->Hits(trace, InsnRec_Pc(rec));
+		if(grp->hitsMax < hits) grp->hitsMax = hits;
+	}
+}
+
+
+static void PutRecord(List* sinks, const RomView* from, InsnStore* store, TraceLog* trace, const char** names, const InsnRec* rec, uint32* group, const bool numeric)
+{
+	Instruction ins;
+	GroupInfo grp;
+	const GroupRec* g;
+
+	/* puts group info(and the name of the routine) */
+	if(0 != (rec->flags & InsnRec_GroupHead))
+	{
+		g = store->Group(store, *group);
+		assert(g && g->pcadr == InsnRec_Pc(rec));
+		grp.snesadr = InsnRec_Snes(rec);
+		grp.callFrom = g->callFrom;
+		grp.depth = g->depth;
+		grp.psw = rec->psw;
+		GroupHits(trace, store, rec, &grp);
+		PutGroup(sinks, &grp);
+		if((NULL != names) && (NULL != names[*group]))
+		{
+			PutLabel(sinks, grp.snesadr, names[*group]);
+		}
+		(*group)++;
+	}
+
+	InsnRec_Decode(rec, from, &ins);
+	ins.numeric = numeric;
+	PutInsn(sinks, &ins);
+}
+
+static bool DisAsm_Pass2(const RomView* from, List* sinks, InsnStore* store, TraceLog* trace, const char** names)
+{
+	uint32 group = 0;
+	uint32 i;
+
+	for(i = 0; i < store->count_get(store); i++)
+	{
+		PutRecord(sinks, from, store, trace, names, store->Record(store, i), &group, false);
 	}
 
 	return true;
 }
 
 
-bool DisAsm(RomFile* from, TextFile* fasm, DisAsmInf* inf)
+/*--------------- Full-ROM listing ---------------*/
+
+/* coverage bitmap (1 bit per rom byte) */
+#define Cover_Test(map, i)	(0 != ((map)[(i)>>3] & (1u << ((i)&7))))
+#define Cover_Set(map, i)	((map)[(i)>>3] = (uint8)((map)[(i)>>3] | (1u << ((i)&7))))
+
+/* data lines never straddle this boundary (the smallest rom bank) */
+#define BankSize 0x8000
+
+/**
+ * Mark the bytes that are covered by the listed instructions,
+ * and the head of them.
+ * The instruction that overlaps a preceding one is dropped, so that
+ * every rom byte is written just once.
+ */
+static void MakeCoverage(const RomView* from, InsnStore* store, uint8** cover, uint8** listed)
 {
-	uint8* ptr;
-	uint32 address;
+	const InsnRec* rec;
+	uint32 size;
+	uint32 pca;
+	uint32 end = 0;
+	uint32 i;
+	uint32 j;
+
+	size = (uint32)from->size_get(from);
+	(*cover) = calloc((size_t)(size/8 + 1), sizeof(uint8));
+	(*listed) = calloc((size_t)(size/8 + 1), sizeof(uint8));
+	assert(*cover);
+	assert(*listed);
+
+	for(i = 0; i < store->count_get(store); i++)
+	{
+		rec = store->Record(store, i);
+		pca = InsnRec_Pc(rec);
+		if(pca < end) continue;
+		if(size < pca + InsnRec_Length(rec, from)) continue;
+
+		Cover_Set(*listed, pca);
+		end = pca + InsnRec_Length(rec, from);
+		for(j = pca; j < end; j++)
+		{
+			Cover_Set(*cover, j);
+		}
+	}
+}
+
+/**
+ * The destination is written as a label only if it's listed.
+ */
+static bool IsNumericTarget(const RomView* from, InsnStore* store, const InsnRec* rec, const uint8* listed)
+{
+	Instruction ins;
+	uint32 target;
+	uint32 pca;
+	uint32 inx;
+
+	InsnRec_Decode(rec, from, &ins);
+	if(false == Opcode_Target(&ins, &target)) return false;
+
+	pca = from->Snes2PcAdr(from, target);
+	if(ROMADDRESS_NULL == pca) return true;
+	if(false == Cover_Test(listed, pca)) return true;
+	inx = store->Search(store, pca);
+	assert(InsnStore_NotFound != inx);
+	return (InsnRec_Snes(store->Record(store, inx)) != target);
+}
+
+/**
+ * Write the whole rom in address order.
+ * The code is written as Pass2, and the gaps are filled with data lines.
+ */
+static bool DisAsm_Pass2Full(const RomView* from, List* sinks, InsnStore* store, TraceLog* trace, const char** names, const int splits)
+{
+	const InsnRec* rec;
+	uint8* cover;
+	uint8* listed;
+	const uint8* ptr;
+	uint32 size;
+	uint32 pca;
+	uint32 end;
+	uint32 lim;
+	uint32 snesadr;
+	uint32 next = ROMADDRESS_NULL;
+	uint32 group = 0;
+	uint32 i = 0;
+
+	size = (uint32)from->size_get(from);
+	MakeCoverage(from, store, &cover, &listed);
+
+	for(pca = 0; pca < size; )
+	{
+		if(Cover_Test(cover, pca))
+		{
+			/* the dropped instructions keep the group order */
+			rec = store->Record(store, i++);
+			while(InsnRec_Pc(rec) != pca)
+			{
+				if(0 != (rec->flags & InsnRec_GroupHead)) group++;
+				rec = store->Record(store, i++);
+			}
+			assert(Cover_Test(listed, pca));
+
+			snesadr = InsnRec_Snes(rec);
+			if(snesadr != next)
+			{
+				PutOrg(sinks, snesadr);
+			}
+			PutRecord(sinks, from, store, trace, names, rec, &group, IsNumericTarget(from, store, rec, listed));
+			pca += InsnRec_Length(rec, from);
+			next = snesadr + InsnRec_Length(rec, from);
+			continue;
+		}
+
+		/* search end of the gap line */
+		lim = pca - (pca % (uint32)splits) + (uint32)splits;
+		if(lim > (pca | (BankSize-1)) + 1) lim = (pca | (BankSize-1)) + 1;
+		if(lim > size) lim = size;
+		for(end = pca; end < lim; )
+		{
+			if(0 == (end & 7) && 0 == cover[end>>3] && end+8 <= lim)
+			{
+				end += 8;
+				continue;
+			}
+			if(Cover_Test(cover, end)) break;
+			end++;
+		}
+
+		/* keep the mirror of the previous line if it's continuous */
+		snesadr = next;
+		if(ROMADDRESS_NULL == next || from->Snes2PcAdr(from, next) != pca)
+		{
+			snesadr = from->Pc2SnesAdr(from, pca);
+			PutOrg(sinks, snesadr);
+		}
+		ptr = from->GetPcPtr(from, pca);
+		assert(ptr);
+		PutData(sinks, snesadr, pca, ptr, (size_t)(end - pca));
+		next = snesadr + (end - pca);
+		pca = end;
+	}
+
+	free(cover);
+	free(listed);
+	return true;
+}
+
+
+/**
+ * Get the entry point(the reset vector, or the -p address)
+ *   return:
+ *     pointer of the entry, or NULL(the error is reported)
+ */
+static const uint8* EntryPoint(DisAsmContext* self, const RomView* from, uint32* address)
+{
+	DisAsmInf* inf = &self->pri->inf;
+	const uint8* ptr;
 
 	if(RomType_Unknown == from->type_get(from))
 	{
-		puterror("Unknown rom type.");
-		return false;
+		self->Report(self, DisAsmDiag_Error, "Unknown rom type.");
+		return NULL;
 	}
 
 	if(inf->progCounter == -1)
@@ -1008,84 +1597,490 @@ bool DisAsm(RomFile* from, TextFile* fasm, DisAsmInf* inf)
 		uint16 sa;
 		ptr = from->GetSnesPtr(from,0xfffc);
 		sa = read16(ptr);
-		address = sa;
+		(*address) = sa;
 		ptr = from->GetSnesPtr(from,sa);
 	}
 	else
 	{
-		address = (uint32)inf->progCounter;
+		(*address) = (uint32)inf->progCounter;
 		ptr = from->GetSnesPtr(from, (uint32)inf->progCounter);
 	}
 	if(NULL == ptr)
 	{
-		puterror("Invalid snes address.");
+		self->Report(self, DisAsmDiag_Error, "Invalid snes address.");
+	}
+	return ptr;
+}
+
+/**
+ * Write the control-flow graph of the sorted store
+ *   The path ending with ".dot"(or ".dot.gz") is graphviz, the others are JSON Lines.
+ */
+static bool WriteCfg(DisAsmContext* self, const char* path, const RomView* from, InsnStore* store)
+{
+	Cfg* cfg;
+	TextFile* out;
+	size_t len;
+	bool dot;
+	bool result;
+
+	len = strlen(path);
+	dot = ((4 <= len) && (0 == strcmp(".dot", &path[len-4])))
+		|| ((7 <= len) && (0 == strcmp(".dot.gz", &path[len-7])));
+
+	out = new_TextFile(path);
+	out->compress_set(out, self->pri->inf.compressOutput);
+	if(FileOpen_NoError != out->Open2(out, "w"))
+	{
+		self->Report(self, DisAsmDiag_Error, "Can't open \"%s\".", path);
+		delete_TextFile(&out);
+		return false;
+	}
+
+	cfg = new_Cfg(from, store);
+	result = dot ? cfg->WriteDot(cfg, out) : cfg->WriteJson(cfg, out);
+	result &= out->Close(out);
+	if(self->pri->inf.showStats)
+	{
+		self->Report(self, DisAsmDiag_Info, "Cfg : %lu blocks in %lu routines (%lu bytes)",
+				(ulong)cfg->blockCount_get(cfg),
+				(ulong)cfg->routineCount_get(cfg),
+				(ulong)cfg->bytes_get(cfg));
+	}
+	delete_Cfg(&cfg);
+	delete_TextFile(&out);
+	return result;
+}
+
+/**
+ * Pass1 from the entry point into the context's store, and sort it
+ *   If the state file is specified, the saved state is restored and only
+ *   the entries added after it are analyzed.
+ *   return:
+ *     If pass1 failed, return false. (The store keeps the analyzed part.)
+ */
+static bool RunPass1(DisAsmContext* self, const RomView* from, const uint32 address)
+{
+	DisAsmInf* inf = &self->pri->inf;
+	InsnStore* store = self->pri->store;
+	bool result = true;
+	bool traced;
+	bool logged;
+	bool named;
+	DisAsmEntry* entry;
+	Iterator* it;
+	AnalysisDbKey key;
+	MxFlow* flow = NULL;
+	uint32 invalid;
+	uint32 invalidFrom;
+	uint32 n;
+	int restored = -1;
+	int i = 0;
+	SnesRegisters regs = {0};
+	regs.psw = 0x30;
+
+	if(-1 == inf->progCounter)
+	{
+		regs.callFrom = 0xfffc;
+	}
+	else
+	{
+		regs.callFrom = (uint32)inf->progCounter;
+	}
+
+	if(inf->accum16bits) regs.psw = (uint16)(regs.psw & (0x20 ^ 0xff));
+	if(inf->index16bits) regs.psw = (uint16)(regs.psw & (0x10 ^ 0xff));
+
+	/* the trace log is kept for Pass2 */
+	traced = (NULL == inf->tracePath) || LoadTrace(self, from);
+	logged = (NULL == inf->cdlPath) || LoadCdl(self, from);
+	named = (NULL == inf->namesPath) || LoadNames(self, from);
+
+	regs.pc = address;
+	regs.db = (uint8)(address >> 16);
+	ConstProp_Init(&regs.consts);
+	memset(self->pri->bankHashed, 0, sizeof(self->pri->bankHashed));
+
+	if(NULL != inf->dbPath)
+	{
+		key.romHash = AnalysisDb_Hash(from);
+		key.romSize = from->size_get(from);
+		key.entry = address;
+		key.callFrom = regs.callFrom;
+		key.psw = regs.psw;
+		key.romMap = (uint16)((from->type_get(from) << 8) | (from->mapmode_get(from) & 0xff));
+		key.depthMax = inf->depthMax;
+		key.execSteps = inf->execSteps;
+		key.dataflow = inf->dataflow;
+		key.traceHash = (NULL != self->pri->trace) ? self->pri->trace->Hash(self->pri->trace) : 0;
+		key.cdlHash = (NULL != self->pri->cdl) ? self->pri->cdl->Hash(self->pri->cdl) : 0;
+		key.namesHash = self->pri->namesHash;
+		self->pri->pointers = calloc((from->size_get(from) >> AnalysisDb_BlockShift) + 1, 1);
+		assert(self->pri->pointers);
+		restored = AnalysisDb_Load(self, inf->dbPath, &key, from, self->pri->entries, self->pri->pointers, store, &result);
+	}
+
+	/* the flags are traced by the dataflow, and all entries are run together */
+	if(inf->dataflow)
+	{
+		flow = new_MxFlow(from, inf->depthMax);
+	}
+
+	if(0 > restored)
+	{
+		if(NULL != flow)
+		{
+			/* the reset vector starts in the emulation mode */
+			flow->AddEntry(flow, regs.pc, regs.psw, regs.callFrom,
+					(-1 == inf->progCounter) && !inf->accum16bits && !inf->index16bits);
+		}
+		else if(Pass1_NoError != Pass1Entry(self, from, &regs))
+		{
+			result = false;
+		}
+	}
+
+	/* additional entry points */
+	List_Foreach(self->pri->entries, it)
+	{
+		/* already analyzed in the saved state */
+		if(i++ < restored) continue;
+
+		entry = Iterator_Data(it);
+		if(NULL == from->GetSnesPtr(from, entry->snesadr))
+		{
+			self->Report(self, DisAsmDiag_Warn, "Invalid entry point : $%06x", entry->snesadr);
+			continue;
+		}
+		memset(&regs, 0, sizeof(SnesRegisters));
+		regs.psw = entry->psw;
+		regs.callFrom = entry->snesadr;
+		regs.pc = entry->snesadr;
+		regs.db = (uint8)(entry->snesadr >> 16);
+		ConstProp_Init(&regs.consts);
+		if(NULL != flow)
+		{
+			flow->AddEntry(flow, regs.pc, regs.psw, regs.callFrom, false);
+		}
+		else if(Pass1_NoError != Pass1Entry(self, from, &regs))
+		{
+			result = false;
+		}
+	}
+
+	if(NULL != flow)
+	{
+		if(false == flow->Run(flow))
+		{
+			flow->Invalid(flow, &invalid, &invalidFrom);
+			self->Report(self, DisAsmDiag_Error, "Invalid pointer : $%06x (call from $%06x)", invalid, invalidFrom);
+			result = false;
+		}
+		flow->Emit(flow, store);
+		for(n=0; n<flow->pointerCount_get(flow); n++)
+		{
+			AddPointer(self->pri, flow->Pointer(flow, n));
+		}
+		if(inf->showStats)
+		{
+			self->Report(self, DisAsmDiag_Info, "Dataflow : %lu blocks in %lu routines, %lu visits (%lu bytes)",
+					(ulong)flow->blockCount_get(flow),
+					(ulong)flow->routineCount_get(flow),
+					(ulong)flow->visits_get(flow),
+					(ulong)flow->bytes_get(flow));
+		}
+		delete_MxFlow(&flow);
+	}
+
+	if(0 < self->pri->nameCount)
+	{
+		SeedNames(self, from);
+	}
+	if(NULL != self->pri->cdl)
+	{
+		SeedCdl(self, from);
+	}
+	if(NULL != self->pri->trace)
+	{
+		SeedTrace(self, from);
+	}
+	if(0 < inf->execSteps)
+	{
+		RunExec(self, from);
+	}
+
+	store->Sort(store);
+	delete_InsnStore(&self->pri->scratch);
+	delete_CdlLog(&self->pri->cdl);
+
+	if(NULL != inf->dbPath)
+	{
+		if(false == AnalysisDb_Save(self, inf->dbPath, &key, from, self->pri->entries, self->pri->pointers, result, store))
+		{
+			self->Report(self, DisAsmDiag_Warn, "Can't save the analysis state : %s", inf->dbPath);
+		}
+		if(0 <= restored)
+		{
+			self->Report(self, DisAsmDiag_Info, "Analysis state restored from %s (%d new entries)", inf->dbPath, i - restored);
+		}
+		free(self->pri->pointers);
+		self->pri->pointers = NULL;
+	}
+	return result && traced && logged && named;
+}
+
+static bool RunView(DisAsmContext* self, const RomView* from)
+{
+	List* sinks;
+	DisAsmInf* inf;
+	const uint8* ptr;
+	uint32 address;
+
+	assert(self);
+	sinks = self->pri->sinks;
+	inf = &self->pri->inf;
+
+	ptr = EntryPoint(self, from, &address);
+	if(NULL == ptr)
+	{
 		return false;
 	}
 
 	if(inf->dataCount != 0)
 	{/* data mode */
 		int i;
+		int splits;
+		uint32 pcadr;
 		if(0 != strcmp("", inf->dataLabel))
 		{
-			fasm->Printf(fasm, "%s:\n", inf->dataLabel);
+			PutLabel(sinks, address, inf->dataLabel);
 		}
+		splits = (0 < inf->dataSplits) ? inf->dataSplits : 1;
+		pcadr = from->Snes2PcAdr(from, address);
 		for(i=0; i<inf->dataCount; i++)
 		{
-			int j;
-			fasm->Printf(fasm, "\t.db\t");
-			for(j=0; j<inf->dataSplits-1; j++)
-			{
-				fasm->Printf(fasm, "$%02x, ", (ptr++)[0]);
-			}
-			fasm->Printf(fasm, "$%02x\n", (ptr++)[0]);
+			PutData(sinks, address, pcadr, ptr, (size_t)splits);
+			ptr += splits;
+			address += (uint32)splits;
+			pcadr += (uint32)splits;
 		}
-		return true;
+		return PutEnd(sinks);
 	}
 
 
 	{/* disasm mode */
 		bool result;
-		List* opStructList;
-		SnesRegisters regs = {0};
-		regs.psw = 0x30;
+		Arena* arena;
+		InsnStore* store;
+		const char** names = NULL;
 
-		if(-1 == inf->progCounter)
+		/* the work data of pass1 is released with the arena */
+		arena = new_Arena(0);
+		store = new_InsnStore((uint32)from->size_get(from));
+		assert(store);
+		self->pri->arena = arena;
+		self->pri->store = store;
+
+		/* output header */
+		PutBegin(sinks, from);
+
+		/* Pass1 : Generate disassemble list */
+		result = RunPass1(self, from, address);
+
+		/* Export analysis results */
+		if(NULL != inf->exportBinPath)
 		{
-			regs.callFrom = 0xfffc;
+			if(false == ExportBin_Write(self, inf->exportBinPath, from, store))
+			{
+				self->Report(self, DisAsmDiag_Error, "Export failed : %s", inf->exportBinPath);
+				result = false;
+			}
 		}
-		else
+		if(NULL != inf->cfgPath)
 		{
-			regs.callFrom = (uint32)inf->progCounter;
+			if(false == WriteCfg(self, inf->cfgPath, from, store))
+			{
+				self->Report(self, DisAsmDiag_Error, "Cfg output failed : %s", inf->cfgPath);
+				result = false;
+			}
 		}
 
-		opStructList = new_List(NULL, OpStructCleaner);
-		assert(opStructList);
-		
-		if(inf->accum16bits) regs.psw = (uint16)(regs.psw & (0x20 ^ 0xff));
-		if(inf->index16bits) regs.psw = (uint16)(regs.psw & (0x10 ^ 0xff));
-
-		regs.pc = address;
-		regs.db = (uint8)(address >> 16);
-
-		/* output asm header */
-		fasm->Printf(fasm, ";-------------------------------------------------\n");
-		fasm->Printf(fasm, ";  File : %s\n", fasm->super.path_get(&fasm->super));
-		fasm->Printf(fasm, ";  From : %s\n", from->super.path_get(&from->super));
-		fasm->Printf(fasm, ";  Map  : %s\n", GetMapModeString(from));
-		fasm->Printf(fasm, ";-------------------------------------------------\n");
+		/* Name the known routines(not with the broken names) */
+		if((NULL != inf->fingerprintPath) && ((NULL == inf->namesPath) || (0 < self->pri->nameCount)))
+		{
+			names = NameRoutines(self, from, store);
+			result &= (NULL != names);
+		}
 
-		/* Pass1 : Generate disassemble list */
-		result = true;
-		if(Pass1_NoError != DisAsm_Pass1(from, &regs, opStructList, 0, inf->depthMax))
+		/* Pass2 : Write to output sinks */
+		if(inf->fullListing)
 		{
-			result = false;
+			result &= DisAsm_Pass2Full(from, sinks, store, self->pri->trace, names,
+					(0 < inf->dataSplits) ? inf->dataSplits : 16);
 		}
+		else
+		{
+			result &= DisAsm_Pass2(from, sinks, store, self->pri->trace, names);
+		}
+		result &= PutEnd(sinks);
 
-		/* Pass2 : Write to asm file */
-		result &= DisAsm_Pass2(fasm, opStructList, inf->enableUpper);
+		if(inf->showStats)
+		{
+			self->Report(self, DisAsmDiag_Info, "Arena : %lu allocations in %lu heap blocks (%lu bytes)",
+					(ulong)arena->allocs_get(arena),
+					(ulong)arena->blocks_get(arena),
+					(ulong)arena->bytes_get(arena));
+			self->Report(self, DisAsmDiag_Info, "Store : %lu instructions in %lu groups (%lu bytes)",
+					(ulong)store->count_get(store),
+					(ulong)store->groupCount_get(store),
+					(ulong)store->bytes_get(store));
+			if(NULL != self->pri->banks)
+			{
+				self->Report(self, DisAsmDiag_Info, "Bank store : %lu hits, %lu misses",
+						self->pri->banks->hits_get(self->pri->banks),
+						self->pri->banks->misses_get(self->pri->banks));
+			}
+		}
 
 		/* clean */
-		delete_List(&opStructList);
+		free(names);
+		delete_Fingerprint(&self->pri->fp);
+		FreeNames(self->pri);
+		delete_TraceLog(&self->pri->trace);
+		delete_InsnStore(&store);
+		delete_Arena(&arena);
+		self->pri->arena = NULL;
+		self->pri->store = NULL;
 		return result;
 	}
 }
+
+static Analysis* Analyze(DisAsmContext* self, const RomView* from)
+{
+	Arena* arena;
+	InsnStore* store;
+	uint32 address;
+
+	assert(self);
+	assert(from);
+
+	if(NULL == EntryPoint(self, from, &address))
+	{
+		return NULL;
+	}
+
+	/* only the store is kept in the result */
+	arena = new_Arena(0);
+	store = new_InsnStore((uint32)from->size_get(from));
+	assert(store);
+	self->pri->arena = arena;
+	self->pri->store = store;
+
+	RunPass1(self, from, address);
+
+	FreeNames(self->pri);
+	delete_TraceLog(&self->pri->trace);
+	delete_Arena(&arena);
+	self->pri->arena = NULL;
+	self->pri->store = NULL;
+	return new_Analysis(from, store);
+}
+
+static bool Run(DisAsmContext* self, RomFile* rom)
+{
+	RomView* view;
+	bool result;
+
+	assert(self);
+	assert(rom);
+
+	view = new_RomView(rom);
+	result = RunView(self, view);
+	delete_RomView(&view);
+	return result;
+}
+
+
+/*--------------- context methods ---------------*/
+
+static void AddSink(DisAsmContext* self, Sink* sink)
+{
+	assert(self);
+	assert(sink);
+	self->pri->sinks->push(self->pri->sinks, sink);
+}
+
+static void AddEntry(DisAsmContext* self, const uint32 snesadr, const uint16 psw)
+{
+	DisAsmEntry* entry;
+
+	assert(self);
+	entry = malloc(sizeof(DisAsmEntry));
+	assert(entry);
+	entry->snesadr = snesadr;
+	entry->psw = psw;
+	self->pri->entries->push(self->pri->entries, entry);
+}
+
+static void UseBankStore(DisAsmContext* self, BankStore* banks)
+{
+	assert(self);
+	self->pri->banks = banks;
+}
+
+static void Report(DisAsmContext* self, const DisAsmDiagLevel level, const char* fmt, ...)
+{
+	DisAsmDiag* d;
+	char buf[DiagLen];
+	va_list vl;
+
+	assert(self);
+
+	va_start(vl, fmt);
+	vsnprintf(buf, DiagLen, fmt, vl);
+	va_end(vl);
+	buf[DiagLen-1] = '\0';
+
+	d = malloc(sizeof(DisAsmDiag));
+	assert(d);
+	d->level = level;
+	d->message = Str_copy(buf);
+	self->pri->diags->push(self->pri->diags, d);
+}
+
+static uint32 diagCount_get(DisAsmContext* self)
+{
+	assert(self);
+	return (uint32)self->pri->diags->length(self->pri->diags);
+}
+
+static const DisAsmDiag* Diag(DisAsmContext* self, const uint32 inx)
+{
+	assert(self);
+	return (const DisAsmDiag*)self->pri->diags->index(self->pri->diags, inx);
+}
+
+static void PrintDiags(DisAsmContext* self)
+{
+	DisAsmDiag* d;
+
+	assert(self);
+	d = self->pri->diags->dequeue(self->pri->diags);
+	while(NULL != d)
+	{
+		switch(d->level)
+		{
+			case DisAsmDiag_Info:
+				putinfo("%s", d->message);
+				break;
+			case DisAsmDiag_Warn:
+				putwarn("%s", d->message);
+				break;
+			default:
+				puterror("%s", d->message);
+				break;
+		}
+		DiagCleaner(d);
+		d = self->pri->diags->dequeue(self->pri->diags);
+	}
+}
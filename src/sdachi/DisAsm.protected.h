@@ -0,0 +1,98 @@
+#pragma once
+/**
+ * DisAsm.protected.h
+ */
+
+typedef struct _SnesRegisters {
+	uint8		db;
+	uint16		d;
+	uint32		pc;
+	uint16		a;
+	uint16		x;
+	uint16		y;
+	uint16		psw;
+	uint16		sp;
+	ConstProp	consts;		/* known values(the indirect jumps) */
+
+	/* stack info */
+	uint32		callFrom;
+	int		depth;
+} SnesRegisters;
+
+/**
+ * additional entry point
+ */
+typedef struct _DisAsmEntry {
+	uint32		snesadr;
+	uint16		psw;
+} DisAsmEntry;
+
+/**
+ * Write columnar binary export from the pass1 store
+ *   (ExportBin.c)
+ */
+bool ExportBin_Write(DisAsmContext*, const char*, const RomView*, InsnStore*);
+
+/**
+ * Make the result from the sorted store
+ *   (Analysis.c)
+ */
+Analysis* new_Analysis(const RomView*, InsnStore*);
+
+/**
+ * The sorted store of the result(owned by the result)
+ *   (Analysis.c)
+ */
+InsnStore* Analysis_Store(Analysis*);
+
+/**
+ * block size of the persisted pass1 state(4KB)
+ *   The rom changes and the pointers read by pass1 are checked in the blocks.
+ */
+#define AnalysisDb_BlockShift	12
+
+/**
+ * key of the persisted pass1 state
+ *   The state is reused only if all of them are the same.
+ */
+typedef struct _AnalysisDbKey {
+	uint32		romHash;
+	uint32		romSize;
+	uint32		entry;		/* main entry point */
+	uint32		callFrom;
+	uint16		psw;
+	uint16		romMap;		/* rom type(8) and map mode(8) */
+	int		depthMax;
+	int		execSteps;
+	bool		dataflow;	/* the M/X flags by the dataflow */
+	uint32		traceHash;	/* the trace log, or 0 */
+	uint32		cdlHash;	/* the code / data log, or 0 */
+	uint32		namesHash;	/* the named routines, or 0 */
+} AnalysisDbKey;
+
+/**
+ * Hash of the rom data(FNV-1a)
+ *   (AnalysisDb.c)
+ */
+uint32 AnalysisDb_Hash(const RomView*);
+
+/**
+ * Save the pass1 state(the sorted store, the entries and the diagnostics)
+ *   (AnalysisDb.c)
+ *   args: AnalysisDb_Save(ctx, path, key, from, entries, pointers, pass1ok, store)
+ *     pointers - the blocks of the pointers read by pass1(1 byte per block)
+ */
+bool AnalysisDb_Save(DisAsmContext*, const char*, const AnalysisDbKey*, const RomView*, List*, const uint8*, const bool, InsnStore*);
+
+/**
+ * Restore the pass1 state into the empty store
+ *   (AnalysisDb.c)
+ *   args: AnalysisDb_Load(ctx, path, key, from, entries, pointers, store, pass1ok)
+ *     pointers - the blocks of the saved pointers are flagged
+ *   If the rom is changed out of the analyzed instructions and the
+ *   pointers, the state is reused.
+ *   return:
+ *     the number of the entries which are already analyzed in the state,
+ *     or -1 if the state can't be reused. (The store isn't changed.)
+ */
+int AnalysisDb_Load(DisAsmContext*, const char*, const AnalysisDbKey*, const RomView*, List*, uint8*, InsnStore*, bool*);
@@ -0,0 +1,354 @@
+/**
+ * ExportBin.c
+ *   columnar binary export writer / reader
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#if defined(WIN32) || defined(_WIN32)
+#else
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#endif
+#include "common/puts.h"
+#include "common/ReadWrite.h"
+#include "common/List.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/ExportBin.h"
+#include "ConstProp.protected.h"
+#include "DisAsm.protected.h"
+
+#define StageSize 4096
+
+/* column element size */
+static const uint32 columnSize[] = {
+	4,	/* ExportBin_Snes */
+	4,	/* ExportBin_Pc */
+	1,	/* ExportBin_Op */
+	3,	/* ExportBin_Arg */
+	1,	/* ExportBin_Len */
+	1,	/* ExportBin_Psw */
+	4,	/* ExportBin_Target */
+	4,	/* ExportBin_Group */
+	4,	/* ExportBin_GroupFrom */
+	2,	/* ExportBin_GroupDepth */
+	1,	/* ExportBin_GroupPsw */
+};
+
+static uint32 Align8(const uint32 v)
+{
+	return (v + 7) & ~(uint32)7;
+}
+
+static uint32 ColumnCount(const ExportBinColumn col, const uint32 insns, const uint32 groups)
+{
+	if(ExportBin_Group <= col) return groups;
+	return insns;
+}
+
+
+/*--------------- writer ---------------*/
+
+typedef struct _ColumnWriter {
+	TextFile*	out;
+	uint8		stage[StageSize];
+	size_t		inx;
+	uint32		pos;
+	bool		failed;
+} ColumnWriter;
+
+static void Flush(ColumnWriter* w)
+{
+	if(0 == w->inx) return;
+	if(false == w->out->Write(w->out, w->stage, w->inx))
+	{
+		w->failed = true;
+	}
+	w->inx = 0;
+}
+
+static void PutBytes(ColumnWriter* w, const uint8* data, const size_t len)
+{
+	size_t i;
+
+	for(i=0; i<len; i++)
+	{
+		if(StageSize == w->inx) Flush(w);
+		w->stage[w->inx++] = data[i];
+	}
+	w->pos += (uint32)len;
+}
+
+static void Put8(ColumnWriter* w, const uint8 v)
+{
+	PutBytes(w, &v, 1);
+}
+
+static void Put16(ColumnWriter* w, const uint16 v)
+{
+	uint8 b[2];
+	write16(b, v);
+	PutBytes(w, b, 2);
+}
+
+static void Put32(ColumnWriter* w, const uint32 v)
+{
+	uint8 b[4];
+	write32(b, v);
+	PutBytes(w, b, 4);
+}
+
+static void PutAlign(ColumnWriter* w)
+{
+	while(0 != (w->pos & 7)) Put8(w, 0);
+}
+
+static uint32 TargetIndex(const RomView* from, InsnStore* store, const Instruction* ins)
+{
+	uint32 target;
+	uint32 pca;
+	uint32 inx;
+
+	if(false == Opcode_Target(ins, &target)) return ExportBin_NoTarget;
+
+	pca = from->Snes2PcAdr(from, target);
+	if(ROMADDRESS_NULL == pca) return ExportBin_NoTarget;
+	inx = store->Search(store, pca);
+	if(InsnStore_NotFound == inx) return ExportBin_NoTarget;
+	return inx;
+}
+
+bool ExportBin_Write(DisAsmContext* ctx, const char* path, const RomView* from, InsnStore* store)
+{
+	ColumnWriter* w;
+	TextFile* out;
+	const InsnRec* rec;
+	const GroupRec* grp;
+	Instruction ins;
+	uint32 insns;
+	uint32 groups;
+	uint32 ofs[ExportBin_ColumnMax];
+	uint32 i;
+	uint32 g;
+	int col;
+	bool result;
+
+	insns = store->count_get(store);
+	groups = store->groupCount_get(store);
+
+	/* column layout */
+	ofs[0] = Align8(ExportBin_HeaderSize);
+	for(col = 1; col < ExportBin_ColumnMax; col++)
+	{
+		ofs[col] = Align8(ofs[col-1] + columnSize[col-1] * ColumnCount((ExportBinColumn)(col-1), insns, groups));
+	}
+
+	out = new_TextFile(path);
+	if(FileOpen_NoError != out->Open2(out, "wb"))
+	{
+		ctx->Report(ctx, DisAsmDiag_Error, "Can't open \"%s\".", path);
+		delete_TextFile(&out);
+		return false;
+	}
+	w = malloc(sizeof(ColumnWriter));
+	assert(w);
+	w->out = out;
+	w->inx = 0;
+	w->pos = 0;
+	w->failed = false;
+
+	/* header */
+	PutBytes(w, (const uint8*)ExportBin_Magic, 8);
+	Put16(w, ExportBin_Version);
+	Put16(w, ExportBin_HeaderSize);
+	Put32(w, insns);
+	Put32(w, groups);
+	Put32(w, (uint32)from->mapmode_get(from));
+	for(col = 0; col < ExportBin_ColumnMax; col++)
+	{
+		Put32(w, ofs[col]);
+	}
+
+	/* instruction columns */
+	for(col = ExportBin_Snes; col <= ExportBin_Target; col++)
+	{
+		PutAlign(w);
+		assert(w->pos == ofs[col]);
+		for(i = 0; i < insns; i++)
+		{
+			InsnRec_Decode(store->Record(store, i), from, &ins);
+			switch(col)
+			{
+				case ExportBin_Snes:
+					Put32(w, ins.snesadr);
+					break;
+				case ExportBin_Pc:
+					Put32(w, ins.pcadr);
+					break;
+				case ExportBin_Op:
+					Put8(w, ins.op);
+					break;
+				case ExportBin_Arg:
+					PutBytes(w, ins.arg, 3);
+					break;
+				case ExportBin_Len:
+					Put8(w, (uint8)ins.arglen);
+					break;
+				case ExportBin_Psw:
+					Put8(w, (uint8)ins.psw);
+					break;
+				default:
+					Put32(w, TargetIndex(from, store, &ins));
+					break;
+			}
+		}
+	}
+
+	/* group columns */
+	for(col = ExportBin_Group; col < ExportBin_ColumnMax; col++)
+	{
+		PutAlign(w);
+		assert(w->pos == ofs[col]);
+		for(i = 0, g = 0; i < insns; i++)
+		{
+			rec = store->Record(store, i);
+			if(0 == (rec->flags & InsnRec_GroupHead)) continue;
+			grp = store->Group(store, g++);
+			switch(col)
+			{
+				case ExportBin_Group:
+					Put32(w, i);
+					break;
+				case ExportBin_GroupFrom:
+					Put32(w, grp->callFrom);
+					break;
+				case ExportBin_GroupDepth:
+					Put16(w, (uint16)grp->depth);
+					break;
+				default:
+					Put8(w, rec->psw);
+					break;
+			}
+		}
+	}
+	Flush(w);
+
+	result = !w->failed;
+	free(w);
+	result &= out->Close(out);
+	delete_TextFile(&out);
+	return result;
+}
+
+
+/*--------------- reader ---------------*/
+
+static bool Validate(ExportBin* v)
+{
+	const uint8* b = v->base;
+	uint32 ofs;
+	uint32 len;
+	int col;
+
+	if(ExportBin_HeaderSize > v->size) return false;
+	if(0 != memcmp(b, ExportBin_Magic, 8)) return false;
+	if(ExportBin_Version != ExportBin_Read16(&b[8])) return false;
+	if(ExportBin_HeaderSize != ExportBin_Read16(&b[10])) return false;
+
+	v->insnCount = ExportBin_Read32(&b[12]);
+	v->groupCount = ExportBin_Read32(&b[16]);
+	v->mapMode = ExportBin_Read32(&b[20]);
+	for(col = 0; col < ExportBin_ColumnMax; col++)
+	{
+		ofs = ExportBin_Read32(&b[24 + 4*col]);
+		len = columnSize[col] * ColumnCount((ExportBinColumn)col, v->insnCount, v->groupCount);
+		if(ofs > v->size || len > v->size - ofs) return false;
+		v->col[col] = &b[ofs];
+	}
+	return true;
+}
+
+ExportBin* ExportBin_Open(const char* path)
+{
+	ExportBin* v;
+#if defined(WIN32) || defined(_WIN32)
+	FILE* fp;
+	long len;
+	uint8* buf;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return NULL;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	buf = malloc((size_t)len + 1);
+	assert(buf);
+	if((size_t)len != fread(buf, 1, (size_t)len, fp))
+	{
+		fclose(fp);
+		free(buf);
+		return NULL;
+	}
+	fclose(fp);
+
+	v = calloc(1, sizeof(ExportBin));
+	assert(v);
+	v->base = buf;
+	v->size = (size_t)len;
+	v->handle = buf;
+#else
+	int fd;
+	struct stat st;
+	void* map;
+
+	fd = open(path, O_RDONLY);
+	if(0 > fd) return NULL;
+	if(0 != fstat(fd, &st) || 0 == st.st_size)
+	{
+		close(fd);
+		return NULL;
+	}
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(MAP_FAILED == map) return NULL;
+
+	v = calloc(1, sizeof(ExportBin));
+	assert(v);
+	v->base = (const uint8*)map;
+	v->size = (size_t)st.st_size;
+	v->handle = map;
+#endif
+
+	if(false == Validate(v))
+	{
+		ExportBin_Close(&v);
+		return NULL;
+	}
+	return v;
+}
+
+void ExportBin_Close(ExportBin** v)
+{
+	assert(v);
+	if(NULL == (*v)) return;
+#if defined(WIN32) || defined(_WIN32)
+	free((*v)->handle);
+#else
+	munmap((*v)->handle, (*v)->size);
+#endif
+	free(*v);
+	(*v) = NULL;
+}
@@ -0,0 +1,490 @@
+/**
+ * Fingerprint.c
+ *   routine fingerprint database
+ */
+#include "common/types.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Fingerprint.h"
+
+#define Fingerprint_Magic	"SDACHIFP"
+#define Fingerprint_Version	1
+#define HeaderSize		20
+#define EntrySize		16
+#define InitialEntries		256
+#define InitialNames		4096
+
+#define FNV_Offset	(((uint64)0xcbf29ce4 << 32) | 0x84222325)
+#define FNV_Prime	(((uint64)0x00000100 << 32) | 0x000001b3)
+
+/**
+ * database entry
+ */
+typedef struct _FpEntry {
+	uint64		hash;
+	uint32		insns;
+	uint32		name;		/* offset in the names */
+} FpEntry;
+
+/**
+ * Fingerprint private members
+ */
+struct _Fingerprint_private {
+	FpEntry*	entries;
+	uint32		count;
+	uint32		capacity;
+	char*		names;
+	uint32		namesSize;
+	uint32		namesCapacity;
+	bool		sorted;
+	uint32		conflicts;
+};
+
+/* prototypes */
+static bool Load(Fingerprint*, const char*);
+static bool Save(Fingerprint*, const char*);
+static bool Add(Fingerprint*, const FingerprintHash*, const char*);
+static const char* Find(Fingerprint*, const FingerprintHash*);
+static uint32 count_get(Fingerprint*);
+static uint32 conflicts_get(Fingerprint*);
+static size_t bytes_get(Fingerprint*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Fingerprint object
+ *
+ * @return the pointer of object
+ */
+Fingerprint* new_Fingerprint(void)
+{
+	Fingerprint* self;
+	Fingerprint_private* pri;
+
+	/* make objects */
+	self = malloc(sizeof(Fingerprint));
+	pri = malloc(sizeof(Fingerprint_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->entries = NULL;
+	pri->count = 0;
+	pri->capacity = 0;
+	pri->names = NULL;
+	pri->namesSize = 0;
+	pri->namesCapacity = 0;
+	pri->sorted = true;
+	pri->conflicts = 0;
+
+	/*--- set public member ---*/
+	self->Load = Load;
+	self->Save = Save;
+	self->Add = Add;
+	self->Find = Find;
+	self->count_get = count_get;
+	self->conflicts_get = conflicts_get;
+	self->bytes_get = bytes_get;
+
+	/* init Fingerprint object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Fingerprint object
+ *
+ * @param the pointer of object
+ */
+void delete_Fingerprint(Fingerprint** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	free((*self)->pri->entries);
+	free((*self)->pri->names);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- routines ---------------*/
+
+/* the hardware registers($2100-$21ff, $4000-$43ff) are same in all roms */
+static bool IsRegister(const uint32 adr)
+{
+	return (0x2100 == (adr & 0xff00)) || (0x4000 == (adr & 0xfc00));
+}
+
+static uint64 HashInsn(uint64 hash, const Instruction* ins)
+{
+	uint8 buf[2 + InsnRec_MaxLength];
+	size_t len = 0;
+	int i;
+
+	buf[len++] = ins->op;
+	buf[len++] = (uint8)ins->arglen;
+	switch(Opcode_AdrMode(ins->op))
+	{
+	case Adr_abs:
+	case Adr_abx:
+	case Adr_aby:
+	case Adr_ind:
+	case Adr_iax:
+		if(false == IsRegister(read16(ins->arg))) break;
+		buf[len++] = ins->arg[0];
+		buf[len++] = ins->arg[1];
+		break;
+	case Adr_abl:
+	case Adr_alx:
+		/* the banks which have the registers */
+		if((0 != (ins->arg[2] & 0x40)) || (false == IsRegister(read16(ins->arg)))) break;
+		buf[len++] = ins->arg[0];
+		buf[len++] = ins->arg[1];
+		break;
+	case Adr_ial:
+	case Adr_bm:
+		break;
+	default:
+		for(i=0; i<ins->arglen; i++)
+		{
+			buf[len++] = ins->arg[i];
+		}
+		break;
+	}
+
+	for(i=0; i<(int)len; i++)
+	{
+		hash = (hash ^ buf[i]) * FNV_Prime;
+	}
+	return hash;
+}
+
+void Fingerprint_Routines(const RomView* from, InsnStore* store, FingerprintHash* hashes)
+{
+	FingerprintHash* cur = NULL;
+	const InsnRec* rec;
+	Instruction ins;
+	uint32 group = 0;
+	uint32 next = 0;
+	uint32 pcadr;
+	uint32 i;
+
+	assert(from);
+	assert(store);
+	assert(hashes);
+
+	for(i=0; i<store->count_get(store); i++)
+	{
+		rec = store->Record(store, i);
+		pcadr = InsnRec_Pc(rec);
+		if(0 != (rec->flags & InsnRec_GroupHead))
+		{
+			cur = &hashes[group++];
+			cur->hash = FNV_Offset;
+			cur->insns = 0;
+		}
+		else if(pcadr != next)
+		{
+			/* the routine ends at the gap */
+			cur = NULL;
+		}
+
+		InsnRec_Decode(rec, from, &ins);
+		if(NULL != cur)
+		{
+			cur->hash = HashInsn(cur->hash, &ins);
+			cur->insns++;
+		}
+		next = pcadr + 1 + (uint32)ins.arglen;
+	}
+}
+
+
+/*--------------- index ---------------*/
+
+/* by the hash, and the older one first */
+static int EntryCompare(const void* a, const void* b)
+{
+	const FpEntry* x = (const FpEntry*)a;
+	const FpEntry* y = (const FpEntry*)b;
+
+	if(x->hash != y->hash) return (x->hash < y->hash) ? -1 : 1;
+	if(x->name != y->name) return (x->name < y->name) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Sort the entries, and keep the first name of each fingerprint
+ *   The names are appended, so the older entry has the smaller offset.
+ */
+static void Sort(Fingerprint_private* pri)
+{
+	uint32 keep = 0;
+	uint32 i;
+
+	if(pri->sorted) return;
+	qsort(pri->entries, pri->count, sizeof(FpEntry), EntryCompare);
+	for(i=0; i<pri->count; i++)
+	{
+		if((0 < keep) && (pri->entries[keep-1].hash == pri->entries[i].hash))
+		{
+			if(0 != strcmp(&pri->names[pri->entries[keep-1].name], &pri->names[pri->entries[i].name]))
+			{
+				pri->conflicts++;
+			}
+			continue;
+		}
+		pri->entries[keep++] = pri->entries[i];
+	}
+	pri->count = keep;
+	pri->sorted = true;
+}
+
+static void AddEntry(Fingerprint_private* pri, const uint64 hash, const uint32 insns, const uint32 name)
+{
+	FpEntry* e;
+
+	if(pri->capacity <= pri->count)
+	{
+		pri->capacity = (0 == pri->capacity) ? InitialEntries : pri->capacity * 2;
+		pri->entries = realloc(pri->entries, sizeof(FpEntry) * pri->capacity);
+		assert(pri->entries);
+	}
+	e = &pri->entries[pri->count++];
+	e->hash = hash;
+	e->insns = insns;
+	e->name = name;
+	if((1 < pri->count) && (pri->entries[pri->count-2].hash >= e->hash)) pri->sorted = false;
+}
+
+static uint32 AddName(Fingerprint_private* pri, const char* name, const size_t len)
+{
+	uint32 offset = pri->namesSize;
+
+	while(pri->namesCapacity < pri->namesSize + len + 1)
+	{
+		pri->namesCapacity = (0 == pri->namesCapacity) ? InitialNames : pri->namesCapacity * 2;
+		pri->names = realloc(pri->names, pri->namesCapacity);
+		assert(pri->names);
+	}
+	memcpy(&pri->names[offset], name, len);
+	pri->names[offset + len] = '\0';
+	pri->namesSize += (uint32)(len + 1);
+	return offset;
+}
+
+static uint64 read64(const uint8* p)
+{
+	return ((uint64)read32(&p[4]) << 32) | read32(p);
+}
+
+static void write64(uint8* p, const uint64 v)
+{
+	write32(p, (uint32)v);
+	write32(&p[4], (uint32)(v >> 32));
+}
+
+
+/*--------------- methods ---------------*/
+
+static bool Load(Fingerprint* self, const char* path)
+{
+	Fingerprint_private* pri;
+	FILE* fp;
+	uint8* data;
+	const uint8* p;
+	long len;
+	uint32 count;
+	uint32 namesSize;
+	uint32 base;
+	uint32 name;
+	uint32 i;
+	bool result = false;
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return false;
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	if(len < HeaderSize)
+	{
+		fclose(fp);
+		return false;
+	}
+	data = malloc((size_t)len);
+	assert(data);
+	if((size_t)len != fread(data, 1, (size_t)len, fp))
+	{
+		free(data);
+		fclose(fp);
+		return false;
+	}
+	fclose(fp);
+
+	count = read32(&data[12]);
+	namesSize = read32(&data[16]);
+	if((0 != memcmp(data, Fingerprint_Magic, 8))
+	|| (Fingerprint_Version != read16(&data[8]))
+	|| (count > ((ulong)len - HeaderSize) / EntrySize)
+	|| ((ulong)len != HeaderSize + (ulong)count * EntrySize + namesSize)
+	|| ((0 < namesSize) && ('\0' != data[len - 1])))
+	{
+		goto End;
+	}
+	for(i=0; i<count; i++)
+	{
+		if(namesSize <= read32(&data[HeaderSize + i * EntrySize + 12])) goto End;
+	}
+
+	/* the names keep the offsets */
+	base = pri->namesSize;
+	if(0 < namesSize)
+	{
+		AddName(pri, (const char*)&data[HeaderSize + count * EntrySize], namesSize - 1);
+	}
+	for(i=0; i<count; i++)
+	{
+		p = &data[HeaderSize + i * EntrySize];
+		name = read32(&p[12]);
+		AddEntry(pri, read64(p), read32(&p[8]), base + name);
+	}
+	result = true;
+
+End:
+	free(data);
+	return result;
+}
+
+static bool Save(Fingerprint* self, const char* path)
+{
+	Fingerprint_private* pri;
+	FILE* fp;
+	uint8* data;
+	uint8* p;
+	size_t len;
+	size_t nameLen;
+	uint32 namesSize = 0;
+	uint32 i;
+	bool result;
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+	Sort(pri);
+
+	/* only the names of the entries are written */
+	for(i=0; i<pri->count; i++)
+	{
+		namesSize += (uint32)strlen(&pri->names[pri->entries[i].name]) + 1;
+	}
+	len = HeaderSize + (size_t)pri->count * EntrySize + namesSize;
+	data = malloc(len);
+	assert(data);
+
+	memcpy(data, Fingerprint_Magic, 8);
+	write16(&data[8], Fingerprint_Version);
+	write16(&data[10], 0);
+	write32(&data[12], pri->count);
+	write32(&data[16], namesSize);
+	namesSize = 0;
+	for(i=0; i<pri->count; i++)
+	{
+		p = &data[HeaderSize + i * EntrySize];
+		write64(p, pri->entries[i].hash);
+		write32(&p[8], pri->entries[i].insns);
+		write32(&p[12], namesSize);
+		nameLen = strlen(&pri->names[pri->entries[i].name]) + 1;
+		memcpy(&data[HeaderSize + pri->count * EntrySize + namesSize], &pri->names[pri->entries[i].name], nameLen);
+		namesSize += (uint32)nameLen;
+	}
+
+	fp = fopen(path, "wb");
+	if(NULL == fp)
+	{
+		free(data);
+		return false;
+	}
+	result = (len == fwrite(data, 1, len, fp));
+	result &= (0 == fclose(fp));
+	free(data);
+	return result;
+}
+
+static bool Add(Fingerprint* self, const FingerprintHash* fp, const char* name)
+{
+	Fingerprint_private* pri;
+
+	assert(self);
+	assert(fp);
+	assert(name);
+	pri = self->pri;
+
+	if(fp->insns < Fingerprint_MinInsns) return false;
+	AddEntry(pri, fp->hash, fp->insns, AddName(pri, name, strlen(name)));
+	return true;
+}
+
+static const char* Find(Fingerprint* self, const FingerprintHash* fp)
+{
+	Fingerprint_private* pri;
+	uint32 lo = 0;
+	uint32 hi;
+	uint32 mid;
+
+	assert(self);
+	assert(fp);
+	pri = self->pri;
+
+	if(fp->insns < Fingerprint_MinInsns) return NULL;
+	Sort(pri);
+	hi = pri->count;
+	while(lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if(pri->entries[mid].hash < fp->hash) lo = mid + 1;
+		else hi = mid;
+	}
+	if((lo < pri->count) && (pri->entries[lo].hash == fp->hash) && (pri->entries[lo].insns == fp->insns))
+	{
+		return &pri->names[pri->entries[lo].name];
+	}
+	return NULL;
+}
+
+static uint32 count_get(Fingerprint* self)
+{
+	assert(self);
+	Sort(self->pri);
+	return self->pri->count;
+}
+
+static uint32 conflicts_get(Fingerprint* self)
+{
+	assert(self);
+	Sort(self->pri);
+	return self->pri->conflicts;
+}
+
+static size_t bytes_get(Fingerprint* self)
+{
+	assert(self);
+	return sizeof(Fingerprint) + sizeof(Fingerprint_private)
+		+ sizeof(FpEntry) * self->pri->capacity
+		+ self->pri->namesCapacity;
+}
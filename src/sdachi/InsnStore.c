@@ -0,0 +1,375 @@
+/**
+ * InsnStore.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <memory.h>
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+
+#define InitialRecords	4096
+#define InitialGroups	256
+
+/* start bitmap (1 bit per rom byte) */
+#define Start_Test(map, i)	(0 != ((map)[(i)>>3] & (1u << ((i)&7))))
+#define Start_Set(map, i)	((map)[(i)>>3] = (uint8)((map)[(i)>>3] | (1u << ((i)&7))))
+
+/**
+ * InsnStore private members
+ */
+struct _InsnStore_private {
+	uint32		romSize;
+	uint8*		start;
+	InsnRec*	recs;
+	uint32		count;
+	uint32		size;
+	GroupRec*	groups;
+	uint32		groupCount;
+	uint32		groupSize;
+};
+
+/* prototypes */
+static bool Add(InsnStore*, const uint32, const uint32, const uint8);
+static void AddGroup(InsnStore*, const uint32, const int);
+static bool Has(InsnStore*, const uint32);
+static void Clear(InsnStore*);
+static void Sort(InsnStore*);
+static uint32 Search(InsnStore*, const uint32);
+static uint32 LowerBound(InsnStore*, const uint32);
+static const InsnRec* Record(InsnStore*, const uint32);
+static const GroupRec* Group(InsnStore*, const uint32);
+static uint32 count_get(InsnStore*);
+static uint32 groupCount_get(InsnStore*);
+static size_t bytes_get(InsnStore*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create InsnStore object
+ *
+ * @return the pointer of object
+ */
+InsnStore* new_InsnStore(const uint32 romSize)
+{
+	InsnStore* self;
+	InsnStore_private* pri;
+
+	/* make objects */
+	self = malloc(sizeof(InsnStore));
+	pri = malloc(sizeof(InsnStore_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->romSize = romSize;
+	pri->start = calloc((size_t)(romSize/8 + 1), sizeof(uint8));
+	assert(pri->start);
+	pri->recs = NULL;
+	pri->count = 0;
+	pri->size = 0;
+	pri->groups = NULL;
+	pri->groupCount = 0;
+	pri->groupSize = 0;
+
+	/*--- set public member ---*/
+	self->Add = Add;
+	self->AddGroup = AddGroup;
+	self->Has = Has;
+	self->Clear = Clear;
+	self->Sort = Sort;
+	self->Search = Search;
+	self->LowerBound = LowerBound;
+	self->Record = Record;
+	self->Group = Group;
+	self->count_get = count_get;
+	self->groupCount_get = groupCount_get;
+	self->bytes_get = bytes_get;
+
+	/* init InsnStore object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete InsnStore object
+ *
+ * @param the pointer of object
+ */
+void delete_InsnStore(InsnStore** self)
+{
+	InsnStore_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	free(pri->start);
+	free(pri->recs);
+	free(pri->groups);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- record accessors ---------------*/
+
+uint32 InsnRec_Pc(const InsnRec* rec)
+{
+	return read24(rec->pcadr);
+}
+
+uint32 InsnRec_Snes(const InsnRec* rec)
+{
+	return read24(rec->snesadr);
+}
+
+void InsnRec_Decode(const InsnRec* rec, const RomView* from, Instruction* ins)
+{
+	const uint8* ptr;
+	uint32 rest;
+	int len;
+
+	memset(ins, 0, sizeof(Instruction));
+	ins->snesadr = InsnRec_Snes(rec);
+	ins->pcadr = InsnRec_Pc(rec);
+	ins->psw = rec->psw;
+	ins->numeric = false;
+
+	ptr = from->GetPcPtr(from, ins->pcadr);
+	assert(ptr);
+	ins->op = ptr[0];
+	ins->arglen = Opcode_ArgLength(ins->op, rec->psw);
+
+	/* the operand at the end of the rom is cut */
+	rest = (uint32)from->size_get(from) - ins->pcadr - 1;
+	len = ins->arglen;
+	if((uint32)len > rest) len = (int)rest;
+	memcpy(ins->arg, &ptr[1], (size_t)len);
+}
+
+uint32 InsnRec_Length(const InsnRec* rec, const RomView* from)
+{
+	const uint8* ptr;
+
+	ptr = from->GetPcPtr(from, InsnRec_Pc(rec));
+	assert(ptr);
+	return 1 + (uint32)Opcode_ArgLength(ptr[0], rec->psw);
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static bool Add(InsnStore* self, const uint32 snesadr, const uint32 pcadr, const uint8 psw)
+{
+	InsnStore_private* pri;
+	InsnRec* rec;
+
+	assert(self);
+	pri = self->pri;
+
+	/* dup check */
+	if(pri->romSize <= pcadr) return false;
+	if(Start_Test(pri->start, pcadr)) return false;
+	Start_Set(pri->start, pcadr);
+
+	if(pri->count == pri->size)
+	{
+		pri->size = (0 == pri->size) ? InitialRecords : pri->size * 2;
+		rec = realloc(pri->recs, sizeof(InsnRec) * pri->size);
+		assert(rec);
+		pri->recs = rec;
+	}
+
+	rec = &pri->recs[pri->count++];
+	write24(rec->pcadr, pcadr);
+	write24(rec->snesadr, snesadr);
+	rec->psw = psw;
+	rec->flags = 0;
+	return true;
+}
+
+static void AddGroup(InsnStore* self, const uint32 callFrom, const int depth)
+{
+	InsnStore_private* pri;
+	InsnRec* rec;
+	GroupRec* grp;
+
+	assert(self);
+	pri = self->pri;
+	assert(0 != pri->count);
+
+	rec = &pri->recs[pri->count-1];
+	rec->flags = (uint8)(rec->flags | InsnRec_GroupHead);
+
+	if(pri->groupCount == pri->groupSize)
+	{
+		pri->groupSize = (0 == pri->groupSize) ? InitialGroups : pri->groupSize * 2;
+		grp = realloc(pri->groups, sizeof(GroupRec) * pri->groupSize);
+		assert(grp);
+		pri->groups = grp;
+	}
+
+	grp = &pri->groups[pri->groupCount++];
+	grp->pcadr = InsnRec_Pc(rec);
+	grp->callFrom = callFrom;
+	grp->depth = depth;
+}
+
+static bool Has(InsnStore* self, const uint32 pcadr)
+{
+	assert(self);
+	if(self->pri->romSize <= pcadr) return false;
+	return Start_Test(self->pri->start, pcadr);
+}
+
+static void Clear(InsnStore* self)
+{
+	InsnStore_private* pri;
+	uint32 pca;
+	uint32 i;
+
+	assert(self);
+	pri = self->pri;
+	for(i=0; i<pri->count; i++)
+	{
+		pca = InsnRec_Pc(&pri->recs[i]);
+		pri->start[pca>>3] = 0;
+	}
+	pri->count = 0;
+	pri->groupCount = 0;
+}
+
+static int CompareInsnRec(const void* a, const void* b)
+{
+	const uint32 pca = InsnRec_Pc((const InsnRec*)a);
+	const uint32 pcb = InsnRec_Pc((const InsnRec*)b);
+
+	if(pca < pcb) return -1;
+	if(pca > pcb) return 1;
+	return 0;
+}
+
+static int CompareGroupRec(const void* a, const void* b)
+{
+	const uint32 pca = ((const GroupRec*)a)->pcadr;
+	const uint32 pcb = ((const GroupRec*)b)->pcadr;
+
+	if(pca < pcb) return -1;
+	if(pca > pcb) return 1;
+	return 0;
+}
+
+static void Sort(InsnStore* self)
+{
+	InsnStore_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	if(0 != pri->count)
+	{
+		qsort(pri->recs, pri->count, sizeof(InsnRec), CompareInsnRec);
+	}
+	if(0 != pri->groupCount)
+	{
+		qsort(pri->groups, pri->groupCount, sizeof(GroupRec), CompareGroupRec);
+	}
+}
+
+static uint32 Search(InsnStore* self, const uint32 pcadr)
+{
+	InsnStore_private* pri;
+	uint32 lo = 0;
+	uint32 hi;
+	uint32 mid;
+	uint32 pca;
+
+	assert(self);
+	pri = self->pri;
+	if(pri->romSize <= pcadr) return InsnStore_NotFound;
+	if(false == Start_Test(pri->start, pcadr)) return InsnStore_NotFound;
+
+	hi = pri->count;
+	while(lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		pca = InsnRec_Pc(&pri->recs[mid]);
+		if(pca == pcadr) return mid;
+		if(pca < pcadr)
+		{
+			lo = mid+1;
+			continue;
+		}
+		hi = mid;
+	}
+	return InsnStore_NotFound;
+}
+
+static uint32 LowerBound(InsnStore* self, const uint32 pcadr)
+{
+	InsnStore_private* pri;
+	uint32 lo = 0;
+	uint32 hi;
+	uint32 mid;
+
+	assert(self);
+	pri = self->pri;
+
+	hi = pri->count;
+	while(lo < hi)
+	{
+		mid = lo + (hi-lo)/2;
+		if(InsnRec_Pc(&pri->recs[mid]) < pcadr)
+		{
+			lo = mid+1;
+			continue;
+		}
+		hi = mid;
+	}
+	return lo;
+}
+
+static const InsnRec* Record(InsnStore* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return NULL;
+	return &self->pri->recs[inx];
+}
+
+static const GroupRec* Group(InsnStore* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->groupCount <= inx) return NULL;
+	return &self->pri->groups[inx];
+}
+
+static uint32 count_get(InsnStore* self)
+{
+	assert(self);
+	return self->pri->count;
+}
+
+static uint32 groupCount_get(InsnStore* self)
+{
+	assert(self);
+	return self->pri->groupCount;
+}
+
+static size_t bytes_get(InsnStore* self)
+{
+	InsnStore_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	return (size_t)(pri->romSize/8 + 1)
+		+ sizeof(InsnRec) * pri->size
+		+ sizeof(GroupRec) * pri->groupSize;
+}
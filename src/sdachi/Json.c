@@ -0,0 +1,271 @@
+/**
+ * Json.c
+ *   flat JSON object parser
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <ctype.h>
+#include <assert.h>
+#include "common/Str.h"
+#include "Json.protected.h"
+
+static char* SkipSpace(char* p)
+{
+	while((' ' == *p) || ('\t' == *p) || ('\r' == *p) || ('\n' == *p)) p++;
+	return p;
+}
+
+static int HexValue(const char c)
+{
+	if(('0' <= c) && ('9' >= c)) return c - '0';
+	if(('a' <= c) && ('f' >= c)) return c - 'a' + 10;
+	if(('A' <= c) && ('F' >= c)) return c - 'A' + 10;
+	return -1;
+}
+
+/**
+ * Decode the string in place
+ *   The decoded string is never longer than the escaped one.
+ */
+static char* ParseString(char** cur)
+{
+	char* src = *cur;
+	char* dst;
+	char* str;
+	uint32 code;
+	int i;
+	int h;
+
+	if('"' != *src) return NULL;
+	str = dst = ++src;
+	for(;;)
+	{
+		if('\0' == *src) return NULL;
+		if('"' == *src) break;
+		if('\\' != *src)
+		{
+			*dst++ = *src++;
+			continue;
+		}
+
+		src++;
+		switch(*src++)
+		{
+			case '"':	*dst++ = '"'; break;
+			case '\\':	*dst++ = '\\'; break;
+			case '/':	*dst++ = '/'; break;
+			case 'b':	*dst++ = '\b'; break;
+			case 'f':	*dst++ = '\f'; break;
+			case 'n':	*dst++ = '\n'; break;
+			case 'r':	*dst++ = '\r'; break;
+			case 't':	*dst++ = '\t'; break;
+			case 'u':
+				code = 0;
+				for(i=0; i<4; i++)
+				{
+					h = HexValue(*src++);
+					if(0 > h) return NULL;
+					code = (code << 4) | (uint32)h;
+				}
+				/* utf-8 (the surrogates aren't supported) */
+				if(0x80 > code)
+				{
+					*dst++ = (char)code;
+				}
+				else if(0x800 > code)
+				{
+					*dst++ = (char)(0xc0 | (code >> 6));
+					*dst++ = (char)(0x80 | (code & 0x3f));
+				}
+				else
+				{
+					*dst++ = (char)(0xe0 | (code >> 12));
+					*dst++ = (char)(0x80 | ((code >> 6) & 0x3f));
+					*dst++ = (char)(0x80 | (code & 0x3f));
+				}
+				break;
+			default:
+				return NULL;
+		}
+	}
+	(*cur) = src + 1;
+	*dst = '\0';
+	return str;
+}
+
+static bool ParseValue(char** cur, JsonMember* m)
+{
+	char* p = *cur;
+	char* end;
+
+	if('"' == *p)
+	{
+		m->type = JsonType_String;
+		m->str = ParseString(&p);
+		if(NULL == m->str) return false;
+	}
+	else if(('-' == *p) || isdigit((uint8)*p))
+	{
+		m->type = JsonType_Number;
+		m->num = strtol(p, &end, 10);
+		if(end == p) return false;
+		p = end;
+	}
+	else if(0 == strncmp(p, "true", 4))
+	{
+		m->type = JsonType_Bool;
+		m->b = true;
+		p += 4;
+	}
+	else if(0 == strncmp(p, "false", 5))
+	{
+		m->type = JsonType_Bool;
+		m->b = false;
+		p += 5;
+	}
+	else if(0 == strncmp(p, "null", 4))
+	{
+		m->type = JsonType_Null;
+		p += 4;
+	}
+	else
+	{
+		/* the nested objects / arrays aren't used */
+		return false;
+	}
+
+	(*cur) = p;
+	return true;
+}
+
+bool Json_Parse(JsonObject* obj, const char* text)
+{
+	JsonMember* m;
+	char* p;
+
+	obj->buf = Str_copy(text);
+	obj->count = 0;
+	assert(obj->buf);
+
+	p = SkipSpace(obj->buf);
+	if('{' != *p) return false;
+	p = SkipSpace(p+1);
+	if('}' == *p) return ('\0' == *SkipSpace(p+1));
+
+	for(;;)
+	{
+		if(JsonMembers <= obj->count) return false;
+		m = &obj->members[obj->count++];
+
+		m->key = ParseString(&p);
+		if(NULL == m->key) return false;
+		p = SkipSpace(p);
+		if(':' != *p) return false;
+		p = SkipSpace(p+1);
+		if(false == ParseValue(&p, m)) return false;
+		p = SkipSpace(p);
+		if(',' == *p)
+		{
+			p = SkipSpace(p+1);
+			continue;
+		}
+		if('}' == *p) break;
+		return false;
+	}
+	return ('\0' == *SkipSpace(p+1));
+}
+
+JsonMember* Json_Get(JsonObject* obj, const char* key)
+{
+	int i;
+
+	for(i=0; i<obj->count; i++)
+	{
+		if(0 == strcmp(key, obj->members[i].key)) return &obj->members[i];
+	}
+	return NULL;
+}
+
+const char* Json_GetString(JsonObject* obj, const char* key)
+{
+	JsonMember* m = Json_Get(obj, key);
+
+	if((NULL == m) || (JsonType_String != m->type)) return NULL;
+	return m->str;
+}
+
+/**
+ * Get the address(number, "$8000", "0x8000" or "32768")
+ */
+bool Json_GetAddress(JsonObject* obj, const char* key, uint32* adr)
+{
+	JsonMember* m = Json_Get(obj, key);
+	const char* s;
+	char* end;
+	int base = 10;
+
+	if(NULL == m) return false;
+	if(JsonType_Number == m->type)
+	{
+		if(0 > m->num) return false;
+		(*adr) = (uint32)m->num;
+		return true;
+	}
+	if(JsonType_String != m->type) return false;
+
+	s = m->str;
+	if('$' == s[0])
+	{
+		s++;
+		base = 16;
+	}
+	else if(('0' == s[0]) && (('x' == s[1]) || ('X' == s[1])))
+	{
+		s += 2;
+		base = 16;
+	}
+	if(('\0' == *s) || !isxdigit((uint8)*s)) return false;
+	(*adr) = (uint32)strtoul(s, &end, base);
+	return ('\0' == *end);
+}
+
+bool Json_ParseNext(JsonObject* obj, const char** cur)
+{
+	char* p = SkipSpace((char*)*cur);
+	char* start;
+	char* text;
+	bool quoted = false;
+	bool result;
+
+	obj->buf = NULL;
+	obj->count = 0;
+
+	/* the end of the object(it isn't nested) */
+	if('{' != *p) return false;
+	for(start = p; '\0' != *p; p++)
+	{
+		if(quoted)
+		{
+			if(('\\' == *p) && ('\0' != p[1])) p++;
+			else if('"' == *p) quoted = false;
+			continue;
+		}
+		if('"' == *p) quoted = true;
+		else if('}' == *p) break;
+	}
+	if('\0' == *p) return false;
+	p++;
+
+	text = malloc((size_t)(p - start) + 1);
+	assert(text);
+	memcpy(text, start, (size_t)(p - start));
+	text[p - start] = '\0';
+	result = Json_Parse(obj, text);
+	free(text);
+
+	/* the separator */
+	p = SkipSpace(p);
+	if(',' == *p) p = SkipSpace(p+1);
+	(*cur) = p;
+	return result;
+}
@@ -0,0 +1,65 @@
+#pragma once
+/**
+ * Json.protected.h
+ *   flat JSON object parser(Server / Batch)
+ *
+ *   Only the objects of the strings, the numbers, true / false and null
+ *   are parsed. The nested objects / arrays aren't supported.
+ */
+
+#define JsonMembers	24
+
+/**
+ * member
+ */
+typedef enum {
+	JsonType_String,
+	JsonType_Number,
+	JsonType_Bool,
+	JsonType_Null
+} JsonType;
+
+typedef struct _JsonMember {
+	const char*	key;
+	JsonType	type;
+	const char*	str;
+	long		num;
+	bool		b;
+} JsonMember;
+
+/**
+ * flat JSON object
+ *   The strings are decoded in the copy of the text(buf).
+ *   Free buf after the use, even if the parse failed.
+ */
+typedef struct _JsonObject {
+	char*		buf;
+	JsonMember	members[JsonMembers];
+	int		count;
+} JsonObject;
+
+/**
+ * Parse the object text(the whole text must be one object)
+ */
+bool Json_Parse(JsonObject*, const char*);
+
+/**
+ * Parse the next object in the array
+ *   args: Json_ParseNext(JsonObject* obj, const char** cur)
+ *     cur - the text after "[" or the last object. It's moved after
+ *           the object and the separator.
+ */
+bool Json_ParseNext(JsonObject*, const char**);
+
+/**
+ * member accessors
+ *   return:
+ *     NULL(false) if the member isn't found or its type is different.
+ */
+JsonMember* Json_Get(JsonObject*, const char*);
+const char* Json_GetString(JsonObject*, const char*);
+
+/**
+ * Get the address(number, "$8000", "0x8000" or "32768")
+ */
+bool Json_GetAddress(JsonObject*, const char*, uint32*);
@@ -0,0 +1,185 @@
+/**
+ * JsonSink.c
+ *   JSON Lines output (one record per line)
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "Sink.protected.h"
+
+/* prototypes */
+static void Begin(Sink*, const RomView*, const char*);
+static void Label(Sink*, const uint32, const char*);
+static void Org(Sink*, const uint32);
+static void Group(Sink*, const GroupInfo*);
+static void Insn(Sink*, const Instruction*);
+static void Data(Sink*, const uint32, const uint32, const uint8*, const size_t);
+
+
+/*--------------- Constructor ---------------*/
+
+/**
+ * @brief Create JsonSink object
+ *
+ * @return the pointer of object
+ */
+Sink* new_JsonSink(TextFile* out)
+{
+	Sink* self;
+
+	assert(out);
+	self = new_Sink(out);
+
+	/*--- override ---*/
+	self->Begin = Begin;
+	self->Label = Label;
+	self->Org = Org;
+	self->Group = Group;
+	self->Insn = Insn;
+	self->Data = Data;
+
+	return self;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void PutString(TextFile* out, const char* s)
+{
+	out->Printf(out, "\"");
+	for(; '\0' != *s; s++)
+	{
+		switch(*s)
+		{
+			case '"':
+				out->Printf(out, "\\\"");
+				break;
+			case '\\':
+				out->Printf(out, "\\\\");
+				break;
+			case '\n':
+				out->Printf(out, "\\n");
+				break;
+			case '\t':
+				out->Printf(out, "\\t");
+				break;
+			default:
+				if(0x20 > (uint8)*s)
+				{
+					out->Printf(out, "\\u%04x", (uint8)*s);
+					break;
+				}
+				out->Printf(out, "%c", *s);
+				break;
+		}
+	}
+	out->Printf(out, "\"");
+}
+
+static void PutBytes(TextFile* out, const uint8* data, const size_t len)
+{
+	size_t i;
+
+	out->Printf(out, "\"");
+	for(i=0; i<len; i++)
+	{
+		out->Printf(out, "%02x", data[i]);
+	}
+	out->Printf(out, "\"");
+}
+
+static void Begin(Sink* self, const RomView* from, const char* map)
+{
+	TextFile* out;
+
+	assert(self);
+	out = self->pro->out;
+	out->Printf(out, "{\"type\":\"rom\",\"path\":");
+	PutString(out, from->path_get(from));
+	out->Printf(out, ",\"map\":");
+	PutString(out, map);
+	out->Printf(out, "}\n");
+}
+
+static void Label(Sink* self, const uint32 snesadr, const char* name)
+{
+	TextFile* out;
+
+	assert(self);
+	out = self->pro->out;
+	out->Printf(out, "{\"type\":\"label\",\"snes\":%lu,\"name\":", (ulong)snesadr);
+	PutString(out, name);
+	out->Printf(out, "}\n");
+}
+
+static void Org(Sink* self, const uint32 snesadr)
+{
+	TextFile* out;
+
+	assert(self);
+	out = self->pro->out;
+	out->Printf(out, "{\"type\":\"org\",\"snes\":%lu}\n", (ulong)snesadr);
+}
+
+static void Group(Sink* self, const GroupInfo* grp)
+{
+	TextFile* out;
+
+	assert(self);
+	out = self->pro->out;
+	out->Printf(out, "{\"type\":\"group\",\"snes\":%lu,\"from\":%lu,\"depth\":%d,\"m\":%d,\"x\":%d",
+			(ulong)grp->snesadr, (ulong)grp->callFrom, grp->depth,
+			(grp->psw & 0x20) ? 8 : 16, (grp->psw & 0x10) ? 8 : 16);
+	if(GroupInfo_NotTraced != grp->hits)
+	{
+		out->Printf(out, ",\"hits\":%lu,\"hitsMax\":%lu", (ulong)grp->hits, (ulong)grp->hitsMax);
+	}
+	out->Printf(out, "}\n");
+}
+
+static void Insn(Sink* self, const Instruction* ins)
+{
+	TextFile* out;
+	char operand[16];
+	uint8 bytes[4];
+	uint32 target;
+
+	assert(self);
+	out = self->pro->out;
+
+	Opcode_Operand(ins, operand);
+	bytes[0] = ins->op;
+	memcpy(&bytes[1], ins->arg, sizeof(ins->arg));
+
+	out->Printf(out, "{\"type\":\"insn\",\"snes\":%lu,\"pc\":%lu,\"bytes\":",
+			(ulong)ins->snesadr, (ulong)ins->pcadr);
+	PutBytes(out, bytes, (size_t)(ins->arglen+1));
+	out->Printf(out, ",\"mnemonic\":\"%s\",\"operand\":", Opcode_Mnemonic(ins->op));
+	PutString(out, operand);
+	out->Printf(out, ",\"text\":\"%s%s%s%s\",\"m\":%d,\"x\":%d",
+			Opcode_Mnemonic(ins->op), Opcode_SizeSuffix(ins),
+			('\0' != operand[0]) ? " " : "", operand,
+			(ins->psw & 0x20) ? 8 : 16, (ins->psw & 0x10) ? 8 : 16);
+	if(Opcode_Target(ins, &target))
+	{
+		out->Printf(out, ",\"target\":%lu", (ulong)target);
+	}
+	out->Printf(out, "}\n");
+}
+
+static void Data(Sink* self, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	TextFile* out;
+
+	assert(self);
+	out = self->pro->out;
+	out->Printf(out, "{\"type\":\"data\",\"snes\":%lu,\"pc\":%lu,\"bytes\":", (ulong)snesadr, (ulong)pcadr);
+	PutBytes(out, data, len);
+	out->Printf(out, "}\n");
+}
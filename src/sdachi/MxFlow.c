@@ -0,0 +1,1083 @@
+/**
+ * MxFlow.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/MxFlow.h"
+#include "ConstProp.protected.h"
+
+#define InitialBlocks	256
+#define InitialSlots	512
+#define InitialRoutines	64
+#define InitialPsws	1024
+#define InitialPointers	16
+#define NotFound	0xffffffff
+
+/**
+ * flag state(the set of the values)
+ */
+#define Val_0		0x1
+#define Val_1		0x2
+#define Val_S		0x4	/* the value at the routine entry */
+#define Val_Top		(Val_0 | Val_1)
+
+typedef enum {
+	Flag_M,
+	Flag_X,
+	Flag_C,
+	Flag_E,
+	Flag_Count
+} MxFlag;
+
+/**
+ * block state
+ *   bit 0-11  : M, X, C, E(3 bits each)
+ *   bit 12-13 : depth of the php stack
+ *   bit 16-   : the stacked M, X, C(9 bits each, the bottom first)
+ */
+typedef uint64 MxState;
+
+#define StackMax		3
+#define State_Flags		((MxState)0xfff)
+#define State_Entry		((MxState)0x924)	/* Val_S of all flags */
+#define State_Get(st, f)	((uint32)((st) >> (3*(f))) & 7)
+#define State_Depth(st)		((uint32)((st) >> 12) & 3)
+#define State_Stacked(st, i)	((uint32)((st) >> (16 + 9*(i))) & 0x1ff)
+
+/* block flags */
+#define Block_Reached	0x01
+#define Block_Decoded	0x02
+#define Block_Head	0x04	/* the group head of the store */
+#define Block_Entry	0x08	/* the entry of the routine */
+#define Block_Queued	0x10
+#define Block_Deferred	0x20
+#define Block_Linked	0x40	/* in the callers of the callee */
+
+/* routine flags */
+#define Routine_Returns		0x01
+#define Routine_Fallback	0x02
+
+typedef struct _MxBlock {
+	uint32		snesadr;
+	uint32		endSnes;	/* after the decoded instructions */
+	uint32		callFrom;	/* the instruction which made the block */
+	uint32		routine;
+	uint32		insn;		/* the first width in the pool */
+	uint32		count;		/* decoded instructions */
+	uint32		nextCaller;	/* the next caller of the same routine */
+	MxState		in;
+	ConstProp	consts;		/* the known values at the start */
+	int		depth;
+	uint8		flags;
+} MxBlock;
+
+/* the block in the address order(Split) */
+typedef struct _MxOrder {
+	uint32		snesadr;
+	uint32		block;
+} MxOrder;
+
+typedef struct _MxRoutine {
+	uint32		entry;		/* block */
+	uint32		callers;	/* the first caller block */
+	MxState		exit;		/* the join of the returns */
+	uint8		concrete;	/* Val_0 / Val_1 of each flag at the entry(2 bits each) */
+	uint8		flags;
+} MxRoutine;
+
+/**
+ * MxFlow private members
+ */
+struct _MxFlow_private {
+	const RomView*	from;
+	int		depthMax;
+
+	MxBlock*	blocks;
+	uint32		blockCount;
+	uint32		blockSize;
+	uint32*		slots;		/* block index + 1(0: empty) */
+	uint32		slotCount;
+
+	MxRoutine*	routines;
+	uint32		routineCount;
+	uint32		routineSize;
+
+	uint8*		psws;		/* the decoded width of each instruction */
+	uint32		pswCount;
+	uint32		pswSize;
+
+	uint32*		work;		/* LIFO */
+	uint32		workCount;
+	uint32*		deferred;	/* the callers of the changed routines */
+	uint32		deferredCount;
+
+	uint8*		starts;		/* decoded instruction(1 bit per rom byte) */
+	uint32*		pointers;	/* the pointer bytes read from the rom(pc) */
+	uint32		pointerCount;
+	uint32		pointerSize;
+	bool		split;
+	uint32		visits;
+
+	bool		invalid;
+	uint32		invalidAdr;
+	uint32		invalidFrom;
+};
+
+/* prototypes */
+static void AddEntry(MxFlow*, const uint32, const uint16, const uint32, const bool);
+static bool Run(MxFlow*);
+static bool Invalid(MxFlow*, uint32*, uint32*);
+static uint32 Emit(MxFlow*, InsnStore*);
+static uint32 blockCount_get(MxFlow*);
+static uint32 routineCount_get(MxFlow*);
+static uint32 visits_get(MxFlow*);
+static uint32 pointerCount_get(MxFlow*);
+static uint32 Pointer(MxFlow*, const uint32);
+static size_t bytes_get(MxFlow*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create MxFlow object
+ *
+ * @param from rom
+ * @param depthMax call depth limit(0: no limit)
+ *
+ * @return the pointer of object
+ */
+MxFlow* new_MxFlow(const RomView* from, const int depthMax)
+{
+	MxFlow* self;
+	MxFlow_private* pri;
+
+	assert(from);
+
+	/* make objects */
+	self = malloc(sizeof(MxFlow));
+	pri = malloc(sizeof(MxFlow_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->depthMax = depthMax;
+	pri->blocks = NULL;
+	pri->blockCount = 0;
+	pri->blockSize = 0;
+	pri->slotCount = InitialSlots;
+	pri->slots = calloc(pri->slotCount, sizeof(uint32));
+	pri->routines = NULL;
+	pri->routineCount = 0;
+	pri->routineSize = 0;
+	pri->psws = NULL;
+	pri->pswCount = 0;
+	pri->pswSize = 0;
+	pri->work = NULL;
+	pri->workCount = 0;
+	pri->deferred = NULL;
+	pri->deferredCount = 0;
+	pri->starts = calloc((size_t)(from->size_get(from)/8 + 1), sizeof(uint8));
+	pri->pointers = NULL;
+	pri->pointerCount = 0;
+	pri->pointerSize = 0;
+	pri->split = false;
+	pri->visits = 0;
+	pri->invalid = false;
+	pri->invalidAdr = 0;
+	pri->invalidFrom = 0;
+	assert(pri->slots);
+	assert(pri->starts);
+
+	/*--- set public member ---*/
+	self->AddEntry = AddEntry;
+	self->Run = Run;
+	self->Invalid = Invalid;
+	self->Emit = Emit;
+	self->blockCount_get = blockCount_get;
+	self->routineCount_get = routineCount_get;
+	self->visits_get = visits_get;
+	self->pointerCount_get = pointerCount_get;
+	self->Pointer = Pointer;
+	self->bytes_get = bytes_get;
+
+	/* init MxFlow object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete MxFlow object
+ *
+ * @param the pointer of object
+ */
+void delete_MxFlow(MxFlow** self)
+{
+	MxFlow_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	free(pri->blocks);
+	free(pri->slots);
+	free(pri->routines);
+	free(pri->psws);
+	free(pri->work);
+	free(pri->deferred);
+	free(pri->starts);
+	free(pri->pointers);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- state ---------------*/
+
+static MxState State_Set(const MxState st, const MxFlag f, const uint32 v)
+{
+	return (st & ~((MxState)7 << (3*f))) | ((MxState)v << (3*f));
+}
+
+static MxState Join(const MxState a, const MxState b)
+{
+	MxState st;
+
+	st = (a | b) & State_Flags;
+	if(State_Depth(a) == State_Depth(b))
+	{
+		/* same stack : join each entry */
+		st |= (a | b) & ~State_Flags;
+	}
+	return st;
+}
+
+/**
+ * The values of the flag at the instruction
+ *   (Val_S is replaced with the values at the entry of the routine.)
+ */
+static uint32 Concrete(const MxRoutine* r, const uint32 v, const MxFlag f)
+{
+	uint32 c;
+
+	c = v & Val_Top;
+	if(0 != (v & Val_S)) c |= (uint32)(r->concrete >> (2*f)) & Val_Top;
+	return (0 == c) ? Val_Top : c;
+}
+
+/**
+ * The state out of the routine(Val_S is replaced)
+ */
+static MxState Desym(const MxRoutine* r, const MxState st)
+{
+	MxState result;
+	uint32 entry;
+	uint32 i;
+	int f;
+
+	result = st;
+	for(f=Flag_M; f<Flag_Count; f++)
+	{
+		result = State_Set(result, (MxFlag)f, Concrete(r, State_Get(st, f), (MxFlag)f));
+	}
+	for(i=0; i<State_Depth(st); i++)
+	{
+		entry = 0;
+		for(f=Flag_M; f<=Flag_C; f++)
+		{
+			entry |= Concrete(r, (State_Stacked(st, i) >> (3*f)) & 7, (MxFlag)f) << (3*f);
+		}
+		result &= ~((MxState)0x1ff << (16 + 9*i));
+		result |= (MxState)entry << (16 + 9*i);
+	}
+	return result;
+}
+
+/**
+ * The state after the call
+ *   The values at the entry of the callee(Val_S) are taken from the caller.
+ */
+static MxState Apply(const MxState exit, const MxState st)
+{
+	MxState result;
+	uint32 v;
+	int f;
+
+	result = st;
+	for(f=Flag_M; f<Flag_Count; f++)
+	{
+		v = State_Get(exit, f);
+		if(0 != (v & Val_S)) v = (v & Val_Top) | State_Get(st, f);
+		result = State_Set(result, (MxFlag)f, v);
+	}
+	return result;
+}
+
+/**
+ * Flags of the instruction
+ */
+static MxState Transfer(const MxRoutine* r, MxState st, const uint8 op, const uint8 imm)
+{
+	const bool emulation = (Val_1 == Concrete(r, State_Get(st, Flag_E), Flag_E));
+	uint32 depth;
+	uint32 v;
+
+	switch(op)
+	{
+		case 0xc2:	/* rep */
+		case 0xe2:	/* sep */
+			v = (0xe2 == op) ? Val_1 : Val_0;
+			if((0 != (imm & 0x20)) && !emulation) st = State_Set(st, Flag_M, v);
+			if((0 != (imm & 0x10)) && !emulation) st = State_Set(st, Flag_X, v);
+			if(0 != (imm & 0x01)) st = State_Set(st, Flag_C, v);
+			break;
+
+		case 0x18:	/* clc */
+			st = State_Set(st, Flag_C, Val_0);
+			break;
+
+		case 0x38:	/* sec */
+			st = State_Set(st, Flag_C, Val_1);
+			break;
+
+		case 0xfb:	/* xce */
+			v = State_Get(st, Flag_C);
+			st = State_Set(st, Flag_C, State_Get(st, Flag_E));
+			st = State_Set(st, Flag_E, v);
+			if(Val_1 == Concrete(r, v, Flag_C))
+			{
+				st = State_Set(st, Flag_M, Val_1);
+				st = State_Set(st, Flag_X, Val_1);
+			}
+			break;
+
+		case 0x08:	/* php */
+			depth = State_Depth(st);
+			if(StackMax == depth)
+			{
+				/* the bottom is dropped */
+				st = (st & State_Flags) | (((st >> 16) >> 9) << 16);
+				depth = StackMax-1;
+			}
+			st |= (st & 0x1ff) << (16 + 9*depth);
+			st = (st & ~((MxState)0x3 << 12)) | ((MxState)(depth+1) << 12);
+			break;
+
+		case 0x28:	/* plp */
+			depth = State_Depth(st);
+			if(0 == depth)
+			{
+				/* pushed out of the routine */
+				v = emulation ? Val_1 : Val_Top;
+				st = State_Set(st, Flag_M, v);
+				st = State_Set(st, Flag_X, v);
+				st = State_Set(st, Flag_C, Val_Top);
+				break;
+			}
+			depth--;
+			st = (st & ~(MxState)0x1ff) | State_Stacked(st, depth);
+			st &= ~((MxState)0x1ff << (16 + 9*depth));
+			st = (st & ~((MxState)0x3 << 12)) | ((MxState)depth << 12);
+			if(emulation)
+			{
+				st = State_Set(st, Flag_M, Val_1);
+				st = State_Set(st, Flag_X, Val_1);
+			}
+			break;
+
+		default:
+			break;
+	}
+	return st;
+}
+
+
+/*--------------- blocks ---------------*/
+
+static uint32 Slot(const uint32* slots, const uint32 slotCount, const MxBlock* blocks, const uint32 snesadr)
+{
+	uint32 i;
+
+	i = (snesadr * 2654435761u) & (slotCount - 1);
+	while((0 != slots[i]) && (blocks[slots[i]-1].snesadr != snesadr))
+	{
+		i = (i + 1) & (slotCount - 1);
+	}
+	return i;
+}
+
+static uint32 Lookup(MxFlow_private* pri, const uint32 snesadr)
+{
+	uint32 i;
+
+	i = Slot(pri->slots, pri->slotCount, pri->blocks, snesadr);
+	return (0 == pri->slots[i]) ? NotFound : pri->slots[i] - 1;
+}
+
+static void Grow(MxFlow_private* pri)
+{
+	uint32* slots;
+	uint32 i;
+
+	slots = calloc((size_t)pri->slotCount * 2, sizeof(uint32));
+	assert(slots);
+	for(i=0; i<pri->slotCount; i++)
+	{
+		if(0 == pri->slots[i]) continue;
+		slots[Slot(slots, pri->slotCount * 2, pri->blocks, pri->blocks[pri->slots[i]-1].snesadr)] = pri->slots[i];
+	}
+	free(pri->slots);
+	pri->slots = slots;
+	pri->slotCount *= 2;
+}
+
+static uint32 NewBlock(MxFlow_private* pri, const uint32 snesadr, const uint32 routine, const uint32 callFrom, const int depth, const uint8 flags)
+{
+	MxBlock* b;
+	uint32 pcadr;
+
+	if(pri->blockCount == pri->blockSize)
+	{
+		pri->blockSize = (0 == pri->blockSize) ? InitialBlocks : pri->blockSize * 2;
+		pri->blocks = realloc(pri->blocks, sizeof(MxBlock) * pri->blockSize);
+		pri->work = realloc(pri->work, sizeof(uint32) * pri->blockSize);
+		pri->deferred = realloc(pri->deferred, sizeof(uint32) * pri->blockSize);
+		assert(pri->blocks);
+		assert(pri->work);
+		assert(pri->deferred);
+	}
+
+	b = &pri->blocks[pri->blockCount];
+	b->snesadr = snesadr;
+	b->endSnes = snesadr;
+	b->callFrom = callFrom;
+	b->routine = routine;
+	b->insn = 0;
+	b->count = 0;
+	b->nextCaller = NotFound;
+	b->in = 0;
+	ConstProp_Init(&b->consts);
+	b->depth = depth;
+	b->flags = flags;
+	pri->slots[Slot(pri->slots, pri->slotCount, pri->blocks, snesadr)] = ++pri->blockCount;
+	if(pri->slotCount < pri->blockCount * 2) Grow(pri);
+
+	/* inside of the decoded block */
+	pcadr = pri->from->Snes2PcAdr(pri->from, snesadr);
+	if((ROMADDRESS_NULL != pcadr) && (0 != (pri->starts[pcadr>>3] & (1u << (pcadr&7)))))
+	{
+		pri->split = true;
+	}
+	return pri->blockCount - 1;
+}
+
+static uint32 NewRoutine(MxFlow_private* pri, const uint32 entry)
+{
+	MxRoutine* r;
+
+	if(pri->routineCount == pri->routineSize)
+	{
+		pri->routineSize = (0 == pri->routineSize) ? InitialRoutines : pri->routineSize * 2;
+		pri->routines = realloc(pri->routines, sizeof(MxRoutine) * pri->routineSize);
+		assert(pri->routines);
+	}
+
+	r = &pri->routines[pri->routineCount];
+	r->entry = entry;
+	r->callers = NotFound;
+	r->exit = 0;
+	r->concrete = 0;
+	r->flags = 0;
+	return pri->routineCount++;
+}
+
+static void Queue(MxFlow_private* pri, const uint32 inx)
+{
+	MxBlock* b = &pri->blocks[inx];
+
+	if(0 != (b->flags & Block_Queued)) return;
+	b->flags |= Block_Queued;
+	pri->work[pri->workCount++] = inx;
+}
+
+static void Defer(MxFlow_private* pri, const uint32 inx)
+{
+	MxBlock* b = &pri->blocks[inx];
+
+	if(0 != (b->flags & Block_Deferred)) return;
+	b->flags |= Block_Deferred;
+	pri->deferred[pri->deferredCount++] = inx;
+}
+
+/**
+ * Join the state(and the known values) into the block
+ */
+static void Reach(MxFlow_private* pri, const uint32 inx, const MxState st, const ConstProp* consts)
+{
+	MxBlock* b = &pri->blocks[inx];
+	MxState j;
+	bool changed;
+
+	if(0 == (b->flags & Block_Reached))
+	{
+		b->flags |= Block_Reached;
+		b->in = st;
+		b->consts = *consts;
+		Queue(pri, inx);
+		return;
+	}
+	j = Join(b->in, st);
+	changed = ConstProp_Meet(&b->consts, consts);
+	if((j != b->in) || changed)
+	{
+		b->in = j;
+		Queue(pri, inx);
+	}
+}
+
+/**
+ * Flow to the branch destination(head) or the next block
+ */
+static void Flow(MxFlow_private* pri, const uint32 src, const uint32 snesadr, const MxState st, const ConstProp* consts, const uint32 callFrom, const bool head)
+{
+	uint32 inx;
+	uint32 routine;
+
+	routine = pri->blocks[src].routine;
+	inx = Lookup(pri, snesadr);
+	if(NotFound == inx)
+	{
+		inx = NewBlock(pri, snesadr, routine, callFrom, pri->blocks[src].depth, head ? Block_Head : 0);
+	}
+
+	if(pri->blocks[inx].routine != routine)
+	{
+		Reach(pri, inx, Desym(&pri->routines[routine], st), consts);
+		return;
+	}
+	Reach(pri, inx, st, consts);
+}
+
+/**
+ * Enter the routine
+ *   return:
+ *     routine index, or NotFound(not traced as a routine)
+ */
+static uint32 Call(MxFlow_private* pri, const uint32 src, const uint32 snesadr, const MxState st, const ConstProp* consts, const uint32 callFrom)
+{
+	const uint32 caller = pri->blocks[src].routine;
+	const int depth = pri->blocks[src].depth + 1;
+	MxRoutine* r;
+	uint32 inx;
+	uint32 routine;
+	int f;
+
+	/* check recursive limit */
+	if((0 != pri->depthMax) && (pri->depthMax <= depth)) return NotFound;
+
+	inx = Lookup(pri, snesadr);
+	if(NotFound == inx)
+	{
+		inx = NewBlock(pri, snesadr, NotFound, callFrom, depth, Block_Head | Block_Entry);
+		routine = NewRoutine(pri, inx);
+		pri->blocks[inx].routine = routine;
+	}
+	else if(0 == (pri->blocks[inx].flags & Block_Entry))
+	{
+		/* the code of the other routine */
+		Flow(pri, src, snesadr, st, consts, callFrom, true);
+		return NotFound;
+	}
+	routine = pri->blocks[inx].routine;
+	Reach(pri, inx, State_Entry, consts);
+
+	r = &pri->routines[routine];
+	for(f=Flag_M; f<Flag_Count; f++)
+	{
+		r->concrete = (uint8)(r->concrete | (Concrete(&pri->routines[caller], State_Get(st, f), (MxFlag)f) << (2*f)));
+	}
+	return routine;
+}
+
+static void Return(MxFlow_private* pri, const uint32 routine, const MxState st)
+{
+	MxRoutine* r = &pri->routines[routine];
+	MxState exit;
+	uint32 c;
+
+	exit = st & State_Flags;
+	if(0 != (r->flags & Routine_Returns))
+	{
+		exit = Join(r->exit, exit) & State_Flags;
+		if(exit == r->exit) return;
+	}
+	r->exit = exit;
+	r->flags |= Routine_Returns;
+
+	/* the callers continue with the new state */
+	for(c=r->callers; NotFound != c; c=pri->blocks[c].nextCaller)
+	{
+		Defer(pri, c);
+	}
+}
+
+/**
+ * Width of the next instruction
+ *   The ambiguous flag is unchanged.
+ */
+static uint8 Width(const MxRoutine* r, const MxState st, uint8 psw)
+{
+	uint32 v;
+
+	if(Val_1 == Concrete(r, State_Get(st, Flag_E), Flag_E)) return 0x30;
+	v = Concrete(r, State_Get(st, Flag_M), Flag_M);
+	if(Val_0 == v) psw = (uint8)(psw & ~0x20);
+	if(Val_1 == v) psw = (uint8)(psw | 0x20);
+	v = Concrete(r, State_Get(st, Flag_X), Flag_X);
+	if(Val_0 == v) psw = (uint8)(psw & ~0x10);
+	if(Val_1 == v) psw = (uint8)(psw | 0x10);
+	return psw;
+}
+
+static void PushPsw(MxFlow_private* pri, const uint8 psw)
+{
+	if(pri->pswCount == pri->pswSize)
+	{
+		pri->pswSize = (0 == pri->pswSize) ? InitialPsws : pri->pswSize * 2;
+		pri->psws = realloc(pri->psws, pri->pswSize);
+		assert(pri->psws);
+	}
+	pri->psws[pri->pswCount++] = psw;
+}
+
+/**
+ * Keep the rom addresses of the pointer bytes(ConstProp_Target)
+ */
+static void AddPointer(MxFlow_private* pri, const uint32* pcadrs)
+{
+	uint32 i;
+	uint32 j;
+
+	for(i=0; i<3; i++)
+	{
+		if(ROMADDRESS_NULL == pcadrs[i]) continue;
+
+		/* the block is visited again */
+		for(j=0; (j<pri->pointerCount) && (pri->pointers[j] != pcadrs[i]); j++);
+		if(j < pri->pointerCount) continue;
+
+		if(pri->pointerCount == pri->pointerSize)
+		{
+			pri->pointerSize = (0 == pri->pointerSize) ? InitialPointers : pri->pointerSize * 2;
+			pri->pointers = realloc(pri->pointers, sizeof(uint32) * pri->pointerSize);
+			assert(pri->pointers);
+		}
+		pri->pointers[pri->pointerCount++] = pcadrs[i];
+	}
+}
+
+/**
+ * Trace the block with its state
+ *   The widths are decoded at the first visit, and reused after that.
+ */
+static void Visit(MxFlow_private* pri, const uint32 inx)
+{
+	const RomView* from = pri->from;
+	MxBlock* b = &pri->blocks[inx];
+	const uint32 routine = b->routine;
+	const bool decode = (0 == (b->flags & Block_Decoded));
+	const uint8* ptr;
+	MxState st;
+	ConstProp consts;
+	uint32 pc;
+	uint32 next;
+	uint32 target;
+	uint32 pointer[3];
+	uint32 callee;
+	uint32 pcadr;
+	uint32 prev;
+	uint32 n = 0;
+	uint8 psw;
+	uint8 op;
+	int arglen;
+
+	st = b->in;
+	consts = b->consts;
+	pc = b->snesadr;
+	prev = b->callFrom;
+	psw = Width(&pri->routines[routine], st, 0x30);
+	if(decode) b->insn = pri->pswCount;
+
+	for(;;)
+	{
+		/* the next block */
+		if((0 != n) && (NotFound != Lookup(pri, pc)))
+		{
+			Flow(pri, inx, pc, st, &consts, prev, false);
+			break;
+		}
+		/* the end of the first decode(invalid pointer / wrap around) */
+		if(!decode && (n == pri->blocks[inx].count)) break;
+
+		ptr = from->GetSnesPtr(from, pc);
+		if(NULL == ptr)
+		{
+			if(false == pri->invalid)
+			{
+				pri->invalid = true;
+				pri->invalidAdr = pc;
+				pri->invalidFrom = prev;
+			}
+			break;
+		}
+		if(decode)
+		{
+			PushPsw(pri, psw);
+			pcadr = from->Snes2PcAdr(from, pc);
+			pri->starts[pcadr>>3] = (uint8)(pri->starts[pcadr>>3] | (1u << (pcadr&7)));
+		}
+		psw = pri->psws[pri->blocks[inx].insn + n];
+		n++;
+
+		op = ptr[0];
+		arglen = Opcode_ArgLength(op, psw);
+		next = pc + 1 + (uint32)arglen;
+		prev = pc;
+		ConstProp_Step(&consts, ptr, psw);
+
+		switch(op)
+		{
+			/* return */
+			case 0x60:	/* rts */
+			case 0x6b:	/* rtl */
+				Return(pri, routine, st);
+				goto End;
+
+			case 0x40:	/* rti */
+				goto End;
+
+			case 0x6c:	/* indirect / index jump */
+			case 0x7c:
+			case 0xdc:
+				if(ConstProp_Target(&consts, from, ptr, pc, &target, pointer))
+				{
+					AddPointer(pri, pointer);
+					Flow(pri, inx, target, st, &consts, pc, true);
+				}
+				goto End;
+
+			/* relative branch */
+			case 0x10:	/* bpl */
+			case 0x30:	/* bmi */
+			case 0x50:	/* bvc */
+			case 0x70:	/* bvs */
+			case 0x90:	/* bcc */
+			case 0xb0:	/* bcs */
+			case 0xd0:	/* bne */
+			case 0xf0:	/* beq */
+				/* (the destination is the head unless it's the next) */
+				if((next & 0xffff) >= (pc & 0xffff)) Flow(pri, inx, next, st, &consts, pc, false);
+				Flow(pri, inx, (uint32)((int32)next + (int8)ptr[1]), st, &consts, pc, true);
+				goto End;
+
+			case 0x80:	/* bra */
+				Flow(pri, inx, (uint32)((int32)next + (int8)ptr[1]), st, &consts, pc, true);
+				goto End;
+
+			case 0x82:	/* brl */
+				Flow(pri, inx, (uint32)((int32)next + (int16)read16(&ptr[1])), st, &consts, pc, true);
+				goto End;
+
+			case 0x4c:	/* jmp */
+				Flow(pri, inx, (next & 0xff0000) + read16(&ptr[1]), st, &consts, pc, true);
+				goto End;
+
+			case 0x5c:	/* jml */
+				Flow(pri, inx, read24(&ptr[1]), st, &consts, pc, true);
+				goto End;
+
+			/* subroutine */
+			case 0x20:	/* jsr */
+			case 0x22:	/* jsl */
+				callee = Call(pri, inx, (0x20 == op) ? (next & 0xff0000) + read16(&ptr[1]) : read24(&ptr[1]), st, &consts, pc);
+				ConstProp_Clear(&consts);
+				if((next & 0xffff) < (pc & 0xffff)) goto End;
+				if(NotFound == callee)
+				{
+					Flow(pri, inx, next, st, &consts, pc, false);
+					goto End;
+				}
+				b = &pri->blocks[inx];
+				if(0 == (b->flags & Block_Linked))
+				{
+					b->flags |= Block_Linked;
+					b->nextCaller = pri->routines[callee].callers;
+					pri->routines[callee].callers = inx;
+				}
+				if(0 != (pri->routines[callee].flags & Routine_Returns))
+				{
+					Flow(pri, inx, next, Apply(pri->routines[callee].exit, st), &consts, pc, false);
+				}
+				goto End;
+
+			default:
+				st = Transfer(&pri->routines[routine], st, op, (0 < arglen) ? ptr[1] : 0);
+				break;
+		}
+
+		/* wrap around in the bank */
+		if((next & 0xffff) < (pc & 0xffff)) break;
+		pc = next;
+		if(decode) psw = Width(&pri->routines[routine], st, psw);
+	}
+	pc = prev;
+End:
+	/* the blocks may be moved by the new blocks */
+	b = &pri->blocks[inx];
+	b->count = n;
+	b->endSnes = b->snesadr;
+	if(0 != n)
+	{
+		b->endSnes = pc + 1 + (uint32)Opcode_ArgLength(from->GetSnesPtr(from, pc)[0], pri->psws[b->insn + n - 1]);
+	}
+	b->flags |= Block_Decoded;
+}
+
+/**
+ * The routines which don't return keep the state of the callers
+ */
+static bool Fallback(MxFlow_private* pri)
+{
+	MxRoutine* r;
+	bool result = false;
+	uint32 c;
+	uint32 i;
+
+	for(i=0; i<pri->routineCount; i++)
+	{
+		r = &pri->routines[i];
+		if(0 != (r->flags & (Routine_Returns | Routine_Fallback))) continue;
+		if(NotFound == r->callers) continue;
+		r->flags |= Routine_Returns | Routine_Fallback;
+		r->exit = State_Entry;
+		for(c=r->callers; NotFound != c; c=pri->blocks[c].nextCaller)
+		{
+			Defer(pri, c);
+		}
+		result = true;
+	}
+	return result;
+}
+
+static int CompareOrder(const void* a, const void* b)
+{
+	uint32 sa = ((const MxOrder*)a)->snesadr;
+	uint32 sb = ((const MxOrder*)b)->snesadr;
+
+	return (sa < sb) ? -1 : ((sa > sb) ? 1 : 0);
+}
+
+/**
+ * Revisit the blocks which contain the start of the other block
+ */
+static bool Split(MxFlow_private* pri)
+{
+	MxOrder* order;
+	const MxBlock* b;
+	bool result = false;
+	uint32 i;
+
+	order = malloc(sizeof(MxOrder) * (pri->blockCount + 1));
+	assert(order);
+	for(i=0; i<pri->blockCount; i++)
+	{
+		order[i].snesadr = pri->blocks[i].snesadr;
+		order[i].block = i;
+	}
+	qsort(order, pri->blockCount, sizeof(MxOrder), CompareOrder);
+
+	for(i=0; i+1<pri->blockCount; i++)
+	{
+		b = &pri->blocks[order[i].block];
+		if(b->endSnes <= order[i+1].snesadr) continue;
+		if(0 == (b->flags & Block_Decoded)) continue;
+		Queue(pri, order[i].block);
+		result = true;
+	}
+	free(order);
+	return result;
+}
+
+
+/*--------------- methods ---------------*/
+
+static void AddEntry(MxFlow* self, const uint32 snesadr, const uint16 psw, const uint32 callFrom, const bool emulation)
+{
+	MxFlow_private* pri;
+	MxRoutine* r;
+	ConstProp consts;
+	uint32 inx;
+
+	assert(self);
+	pri = self->pri;
+
+	inx = Lookup(pri, snesadr);
+	if(NotFound != inx) return;
+
+	inx = NewBlock(pri, snesadr, NotFound, callFrom, 0, Block_Head | Block_Entry);
+	pri->blocks[inx].routine = NewRoutine(pri, inx);
+	r = &pri->routines[pri->blocks[inx].routine];
+	r->concrete = (uint8)(((0 != (psw & 0x20)) ? Val_1 : Val_0) << (2*Flag_M)
+			| ((0 != (psw & 0x10)) ? Val_1 : Val_0) << (2*Flag_X)
+			| Val_Top << (2*Flag_C)
+			| (emulation ? Val_1 : Val_0) << (2*Flag_E));
+	ConstProp_Init(&consts);
+	Reach(pri, inx, State_Entry, &consts);
+}
+
+static bool Run(MxFlow* self)
+{
+	MxFlow_private* pri;
+	uint32 inx;
+	uint32 i;
+
+	assert(self);
+	pri = self->pri;
+
+	for(;;)
+	{
+		while(0 < pri->workCount)
+		{
+			inx = pri->work[--pri->workCount];
+			pri->blocks[inx].flags &= (uint8)~Block_Queued;
+			Visit(pri, inx);
+			pri->visits++;
+		}
+
+		/* the callers, after the callees are traced */
+		if(0 < pri->deferredCount)
+		{
+			for(i=pri->deferredCount; 0 < i; i--)
+			{
+				inx = pri->deferred[i-1];
+				pri->blocks[inx].flags &= (uint8)~Block_Deferred;
+				Queue(pri, inx);
+			}
+			pri->deferredCount = 0;
+			continue;
+		}
+
+		if(Fallback(pri)) continue;
+		if(pri->split)
+		{
+			pri->split = false;
+			if(Split(pri)) continue;
+		}
+		break;
+	}
+	return !pri->invalid;
+}
+
+static bool Invalid(MxFlow* self, uint32* snesadr, uint32* callFrom)
+{
+	assert(self);
+	if(false == self->pri->invalid) return false;
+	if(NULL != snesadr) (*snesadr) = self->pri->invalidAdr;
+	if(NULL != callFrom) (*callFrom) = self->pri->invalidFrom;
+	return true;
+}
+
+static uint32 Emit(MxFlow* self, InsnStore* store)
+{
+	MxFlow_private* pri;
+	const RomView* from;
+	const MxBlock* b;
+	const uint8* ptr;
+	uint32 added = 0;
+	uint32 pc;
+	uint32 i;
+	uint32 n;
+	uint8 psw;
+
+	assert(self);
+	assert(store);
+	pri = self->pri;
+	from = pri->from;
+
+	/* in the trace order */
+	for(i=0; i<pri->blockCount; i++)
+	{
+		b = &pri->blocks[i];
+		pc = b->snesadr;
+		for(n=0; n<b->count; n++)
+		{
+			psw = pri->psws[b->insn + n];
+			ptr = from->GetSnesPtr(from, pc);
+			if(store->Add(store, pc, from->Snes2PcAdr(from, pc), psw))
+			{
+				if((0 == n) && (0 != (b->flags & Block_Head)))
+				{
+					store->AddGroup(store, b->callFrom, b->depth);
+				}
+				added++;
+			}
+			pc += 1 + (uint32)Opcode_ArgLength(ptr[0], psw);
+		}
+	}
+	return added;
+}
+
+static uint32 blockCount_get(MxFlow* self)
+{
+	assert(self);
+	return self->pri->blockCount;
+}
+
+static uint32 routineCount_get(MxFlow* self)
+{
+	assert(self);
+	return self->pri->routineCount;
+}
+
+static uint32 visits_get(MxFlow* self)
+{
+	assert(self);
+	return self->pri->visits;
+}
+
+static uint32 pointerCount_get(MxFlow* self)
+{
+	assert(self);
+	return self->pri->pointerCount;
+}
+
+static uint32 Pointer(MxFlow* self, const uint32 index)
+{
+	assert(self);
+	assert(index < self->pri->pointerCount);
+	return self->pri->pointers[index];
+}
+
+static size_t bytes_get(MxFlow* self)
+{
+	MxFlow_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	return (sizeof(MxBlock) + sizeof(uint32) * 2) * pri->blockSize
+		+ sizeof(uint32) * pri->slotCount
+		+ sizeof(MxRoutine) * pri->routineSize
+		+ pri->pswSize
+		+ sizeof(uint32) * pri->pointerSize
+		+ pri->from->size_get(pri->from)/8 + 1;
+}
@@ -0,0 +1,617 @@
+/**
+ * Opcode.c
+ */
+#include "common/types.h"
+#include <assert.h>
+#include <memory.h>
+#include "common/ReadWrite.h"
+#include "common/Str.h"
+#include "sdachi/Opcode.h"
+
+static const int argLength[] = {
+	1,  /* Adr_imm */
+	-1, /* Adr_immM */
+	-1, /* Adr_immX */
+	1,  /* Adr_sr */
+	1,  /* Adr_dp */
+	1,  /* Adr_dpx */
+	1,  /* Adr_dpy */
+	1,  /* Adr_idp */
+	1,  /* Adr_idx */
+	1,  /* Adr_idy */
+	1,  /* Adr_idl */
+	1,  /* Adr_idly */
+	1,  /* Adr_isy */
+	2,  /* Adr_abs */
+	2,  /* Adr_abx */
+	2,  /* Adr_aby */
+	3,  /* Adr_abl */
+	3,  /* Adr_alx */
+	2,  /* Adr_ind */
+	2,  /* Adr_iax */
+	3,  /* Adr_ial */
+	1,  /* Adr_rel */
+	2,  /* Adr_rell */
+	2,  /* Adr_bm */
+	0,  /* Adr_none */
+};
+
+
+typedef struct _Opcode {
+	const char	*op;
+	AdrMode		mode;
+} Opcode;
+static const Opcode opcodes [] = {
+	/* 0x00 */
+	{ "brk",	Adr_none },	/* 0x00 */
+	{ "ora",	Adr_idx  },	/* 0x01 */
+	{ "cop",	Adr_imm  },	/* 0x02 */
+	{ "ora",	Adr_sr   },	/* 0x03 */
+	{ "tsb",	Adr_dp   },	/* 0x04 */
+	{ "ora",	Adr_dp   },	/* 0x05 */
+	{ "asl",	Adr_dp   },	/* 0x06 */
+	{ "ora",	Adr_idl  },	/* 0x07 */
+	{ "php",	Adr_none },	/* 0x08 */
+	{ "ora",	Adr_immM },	/* 0x09 */
+	{ "asl",	Adr_none },	/* 0x0A */
+	{ "phd",	Adr_none },	/* 0x0B */
+	{ "tsb",	Adr_abs  },	/* 0x0C */
+	{ "ora",	Adr_abs  },	/* 0x0D */
+	{ "asl",	Adr_abs  },	/* 0x0E */
+	{ "ora",	Adr_abl  },	/* 0x0F */
+	/* 0x10 */
+	{ "bpl",	Adr_rel  },	/* 0x10 */
+	{ "ora",	Adr_idy  },	/* 0x11 */
+	{ "ora",	Adr_idp  },	/* 0x12 */
+	{ "ora",	Adr_isy  },	/* 0x13 */
+	{ "trb",	Adr_dp   },	/* 0x14 */
+	{ "ora",	Adr_dpx  },	/* 0x15 */
+	{ "asl",	Adr_dpx  },	/* 0x16 */
+	{ "ora",	Adr_idly },	/* 0x17 */
+	{ "clc",	Adr_none },	/* 0x18 */
+	{ "ora",	Adr_aby  },	/* 0x19 */
+	{ "inc",	Adr_none },	/* 0x1A */
+	{ "tcs",	Adr_none },	/* 0x1B */
+	{ "trb",	Adr_abs  },	/* 0x1C */
+	{ "ora",	Adr_abx  },	/* 0x1D */
+	{ "asl",	Adr_abx  },	/* 0x1E */
+	{ "ora",	Adr_alx  },	/* 0x1F */
+	/* 0x20 */
+	{ "jsr",	Adr_abs  },	/* 0x20 */
+	{ "and",	Adr_idx  },	/* 0x21 */
+	{ "jsl",	Adr_abl  },	/* 0x22 */
+	{ "and",	Adr_sr   },	/* 0x23 */
+	{ "bit",	Adr_dp   },	/* 0x24 */
+	{ "and",	Adr_dp   },	/* 0x25 */
+	{ "rol",	Adr_dp   },	/* 0x26 */
+	{ "and",	Adr_idl  },	/* 0x27 */
+	{ "plp",	Adr_none },	/* 0x28 */
+	{ "and",	Adr_immM },	/* 0x29 */
+	{ "rol",	Adr_none },	/* 0x2A */
+	{ "pld",	Adr_none },	/* 0x2B */
+	{ "bit",	Adr_abs  },	/* 0x2C */
+	{ "and",	Adr_abs  },	/* 0x2D */
+	{ "rol",	Adr_abs  },	/* 0x2E */
+	{ "and",	Adr_abl  },	/* 0x2F */
+	/* 0x30 */
+	{ "bmi",	Adr_rel  },	/* 0x30 */
+	{ "and",	Adr_idy  },	/* 0x31 */
+	{ "and",	Adr_idp  },	/* 0x32 */
+	{ "and",	Adr_isy  },	/* 0x33 */
+	{ "bit",	Adr_dpx  },	/* 0x34 */
+	{ "and",	Adr_dpx  },	/* 0x35 */
+	{ "rol",	Adr_dpx  },	/* 0x36 */
+	{ "and",	Adr_idly },	/* 0x37 */
+	{ "sec",	Adr_none },	/* 0x38 */
+	{ "and",	Adr_aby  },	/* 0x39 */
+	{ "dec",	Adr_none },	/* 0x3A */
+	{ "tsc",	Adr_none },	/* 0x3B */
+	{ "bit",	Adr_abx  },	/* 0x3C */
+	{ "and",	Adr_abx  },	/* 0x3D */
+	{ "rol",	Adr_abx  },	/* 0x3E */
+	{ "and",	Adr_alx  },	/* 0x3F */
+	/* 0x40 */
+	{ "rti",	Adr_none },	/* 0x40 */
+	{ "eor",	Adr_idx  },	/* 0x41 */
+	{ "wdm",	Adr_none },	/* 0x42 */
+	{ "eor",	Adr_sr   },	/* 0x43 */
+	{ "mvp",	Adr_bm   },	/* 0x44 */
+	{ "eor",	Adr_dp   },	/* 0x45 */
+	{ "lsr",	Adr_dp   },	/* 0x46 */
+	{ "eor",	Adr_idl  },	/* 0x47 */
+	{ "pha",	Adr_none },	/* 0x48 */
+	{ "eor",	Adr_immM },	/* 0x49 */
+	{ "lsr",	Adr_none },	/* 0x4A */
+	{ "phk",	Adr_none },	/* 0x4B */
+	{ "jmp",	Adr_abs  },	/* 0x4C */
+	{ "eor",	Adr_abs  },	/* 0x4D */
+	{ "lsr",	Adr_abs  },	/* 0x4E */
+	{ "eor",	Adr_abl  },	/* 0x4F */
+	/* 0x50 */
+	{ "bvc",	Adr_rel  },	/* 0x50 */
+	{ "eor",	Adr_idy  },	/* 0x51 */
+	{ "eor",	Adr_idp  },	/* 0x52 */
+	{ "eor",	Adr_isy  },	/* 0x53 */
+	{ "mvn",	Adr_bm   },	/* 0x54 */
+	{ "eor",	Adr_dpx  },	/* 0x55 */
+	{ "lsr",	Adr_dpx  },	/* 0x56 */
+	{ "eor",	Adr_idly },	/* 0x57 */
+	{ "cli",	Adr_none },	/* 0x58 */
+	{ "eor",	Adr_aby  },	/* 0x59 */
+	{ "phy",	Adr_none },	/* 0x5A */
+	{ "tcd",	Adr_none },	/* 0x5B */
+	{ "jml",	Adr_abl  },	/* 0x5C */
+	{ "eor",	Adr_abx  },	/* 0x5D */
+	{ "lsr",	Adr_abx  },	/* 0x5E */
+	{ "eor",	Adr_alx  },	/* 0x5F */
+	/* 0x60 */
+	{ "rts",	Adr_none },	/* 0x60 */
+	{ "adc",	Adr_idx  },	/* 0x61 */
+	{ "per",	Adr_rell },	/* 0x62 */
+	{ "adc",	Adr_sr   },	/* 0x63 */
+	{ "stz",	Adr_dp   },	/* 0x64 */
+	{ "adc",	Adr_dp   },	/* 0x65 */
+	{ "ror",	Adr_dp   },	/* 0x66 */
+	{ "adc",	Adr_idl  },	/* 0x67 */
+	{ "pla",	Adr_none },	/* 0x68 */
+	{ "adc",	Adr_immM },	/* 0x69 */
+	{ "ror",	Adr_none },	/* 0x6A */
+	{ "rtl",	Adr_none },	/* 0x6B */
+	{ "jmp",	Adr_ind  },	/* 0x6C */
+	{ "adc",	Adr_abs  },	/* 0x6D */
+	{ "ror",	Adr_abs  },	/* 0x6E */
+	{ "adc",	Adr_abl  },	/* 0x6F */
+	/* 0x70 */
+	{ "bvs",	Adr_rel  },	/* 0x70 */
+	{ "adc",	Adr_idy  },	/* 0x71 */
+	{ "adc",	Adr_idp  },	/* 0x72 */
+	{ "adc",	Adr_isy  },	/* 0x73 */
+	{ "stz",	Adr_dpx  },	/* 0x74 */
+	{ "adc",	Adr_dpx  },	/* 0x75 */
+	{ "ror",	Adr_dpx  },	/* 0x76 */
+	{ "adc",	Adr_idly },	/* 0x77 */
+	{ "sei",	Adr_none },	/* 0x78 */
+	{ "adc",	Adr_aby  },	/* 0x79 */
+	{ "ply",	Adr_none },	/* 0x7A */
+	{ "tdc",	Adr_none },	/* 0x7B */
+	{ "jmp",	Adr_ial  },	/* 0x7C */
+	{ "adc",	Adr_abx  },	/* 0x7D */
+	{ "ror",	Adr_abx  },	/* 0x7E */
+	{ "adc",	Adr_alx  },	/* 0x7F */
+	/* 0x80 */
+	{ "bra",	Adr_rel  },	/* 0x80 */
+	{ "sta",	Adr_idx  },	/* 0x81 */
+	{ "brl",	Adr_rell },	/* 0x82 */
+	{ "sta",	Adr_sr   },	/* 0x83 */
+	{ "sty",	Adr_dp   },	/* 0x84 */
+	{ "sta",	Adr_dp   },	/* 0x85 */
+	{ "stx",	Adr_dp   },	/* 0x86 */
+	{ "sta",	Adr_idl  },	/* 0x87 */
+	{ "dey",	Adr_none },	/* 0x88 */
+	{ "bit",	Adr_immM },	/* 0x89 */
+	{ "txa",	Adr_none },	/* 0x8A */
+	{ "phb",	Adr_none },	/* 0x8B */
+	{ "sty",	Adr_abs  },	/* 0x8C */
+	{ "sta",	Adr_abs  },	/* 0x8D */
+	{ "stx",	Adr_abs  },	/* 0x8E */
+	{ "sta",	Adr_abl  },	/* 0x8F */
+	/* 0x90 */
+	{ "bcc",	Adr_rel  },	/* 0x90 */
+	{ "sta",	Adr_idy  },	/* 0x91 */
+	{ "sta",	Adr_idp  },	/* 0x92 */
+	{ "sta",	Adr_isy  },	/* 0x93 */
+	{ "sty",	Adr_dpx  },	/* 0x94 */
+	{ "sta",	Adr_dpx  },	/* 0x95 */
+	{ "stx",	Adr_dpy  },	/* 0x96 */
+	{ "sta",	Adr_idly },	/* 0x97 */
+	{ "tya",	Adr_none },	/* 0x98 */
+	{ "sta",	Adr_aby  },	/* 0x99 */
+	{ "txs",	Adr_none },	/* 0x9A */
+	{ "txy",	Adr_none },	/* 0x9B */
+	{ "stz",	Adr_abs  },	/* 0x9C */
+	{ "sta",	Adr_abx  },	/* 0x9D */
+	{ "stz",	Adr_abx  },	/* 0x9E */
+	{ "sta",	Adr_alx  },	/* 0x9F */
+	/* 0xA0 */
+	{ "ldy",	Adr_immX  },	/* 0xA0 */
+	{ "lda",	Adr_idx  },	/* 0xA1 */
+	{ "ldx",	Adr_immX  },	/* 0xA2 */
+	{ "lda",	Adr_sr   },	/* 0xA3 */
+	{ "ldy",	Adr_dp   },	/* 0xA4 */
+	{ "lda",	Adr_dp   },	/* 0xA5 */
+	{ "ldx",	Adr_dp   },	/* 0xA6 */
+	{ "lda",	Adr_idl  },	/* 0xA7 */
+	{ "tay",	Adr_none },	/* 0xA8 */
+	{ "lda",	Adr_immM  },	/* 0xA9 */
+	{ "tax",	Adr_none },	/* 0xAA */
+	{ "plb",	Adr_none },	/* 0xAB */
+	{ "ldy",	Adr_abs  },	/* 0xAC */
+	{ "lda",	Adr_abs  },	/* 0xAD */
+	{ "ldx",	Adr_abs  },	/* 0xAE */
+	{ "lda",	Adr_abl  },	/* 0xAF */
+	/* 0xB0 */
+	{ "bcs",	Adr_rel  },	/* 0xB0 */
+	{ "lda",	Adr_idy  },	/* 0xB1 */
+	{ "lda",	Adr_idp  },	/* 0xB2 */
+	{ "lda",	Adr_isy  },	/* 0xB3 */
+	{ "ldy",	Adr_dpx  },	/* 0xB4 */
+	{ "lda",	Adr_dpx  },	/* 0xB5 */
+	{ "ldx",	Adr_dpy  },	/* 0xB6 */
+	{ "lda",	Adr_idly },	/* 0xB7 */
+	{ "clv",	Adr_none },	/* 0xB8 */
+	{ "lda",	Adr_aby  },	/* 0xB9 */
+	{ "tsx",	Adr_none },	/* 0xBA */
+	{ "tyx",	Adr_none },	/* 0xBB */
+	{ "ldy",	Adr_abx  },	/* 0xBC */
+	{ "lda",	Adr_abx  },	/* 0xBD */
+	{ "ldx",	Adr_aby  },	/* 0xBE */
+	{ "lda",	Adr_alx  },	/* 0xBF */
+	/* 0xC0 */
+	{ "cpy",	Adr_immX  },	/* 0xC0 */
+	{ "cmp",	Adr_idx  },	/* 0xC1 */
+	{ "rep",	Adr_imm  },	/* 0xC2 */
+	{ "cmp",	Adr_sr   },	/* 0xC3 */
+	{ "cpy",	Adr_dp   },	/* 0xC4 */
+	{ "cmp",	Adr_dp   },	/* 0xC5 */
+	{ "dec",	Adr_dp   },	/* 0xC6 */
+	{ "cmp",	Adr_idl  },	/* 0xC7 */
+	{ "iny",	Adr_none },	/* 0xC8 */
+	{ "cmp",	Adr_immM },	/* 0xC9 */
+	{ "dex",	Adr_none },	/* 0xCA */
+	{ "wai",	Adr_none },	/* 0xCB */
+	{ "cpy",	Adr_abs  },	/* 0xCC */
+	{ "cmp",	Adr_abs  },	/* 0xCD */
+	{ "dec",	Adr_abs  },	/* 0xCE */
+	{ "cmp",	Adr_abl  },	/* 0xCF */
+	/* 0xD0 */
+	{ "bne",	Adr_rel  },	/* 0xD0 */
+	{ "cmp",	Adr_idy  },	/* 0xD1 */
+	{ "cmp",	Adr_idp  },	/* 0xD2 */
+	{ "cmp",	Adr_isy  },	/* 0xD3 */
+	{ "pei",	Adr_idp  },	/* 0xD4 */
+	{ "cmp",	Adr_dpx  },	/* 0xD5 */
+	{ "dec",	Adr_dpx  },	/* 0xD6 */
+	{ "cmp",	Adr_idly },	/* 0xD7 */
+	{ "cld",	Adr_none },	/* 0xD8 */
+	{ "cmp",	Adr_aby  },	/* 0xD9 */
+	{ "phx",	Adr_none },	/* 0xDA */
+	{ "stp",	Adr_none },	/* 0xDB */
+	{ "jmp",	Adr_iax  },	/* 0xDC */
+	{ "cmp",	Adr_abx  },	/* 0xDD */
+	{ "dec",	Adr_abx  },	/* 0xDE */
+	{ "cmp",	Adr_alx  },	/* 0xDF */
+	/* 0xE0 */
+	{ "cpx",	Adr_immX  },	/* 0xE0 */
+	{ "sbc",	Adr_idx  },	/* 0xE1 */
+	{ "sep",	Adr_imm  },	/* 0xE2 */
+	{ "sbc",	Adr_sr   },	/* 0xE3 */
+	{ "cpx",	Adr_dp   },	/* 0xE4 */
+	{ "sbc",	Adr_dp   },	/* 0xE5 */
+	{ "inc",	Adr_dp   },	/* 0xE6 */
+	{ "sbc",	Adr_idl  },	/* 0xE7 */
+	{ "inx",	Adr_none },	/* 0xE8 */
+	{ "sbc",	Adr_immM },	/* 0xE9 */
+	{ "nop",	Adr_none },	/* 0xEA */
+	{ "xba",	Adr_none },	/* 0xEB */
+	{ "cpx",	Adr_abs  },	/* 0xEC */
+	{ "sbc",	Adr_abs  },	/* 0xED */
+	{ "inc",	Adr_abs  },	/* 0xEE */
+	{ "sbc",	Adr_abl  },	/* 0xEF */
+	/* 0xF0 */
+	{ "beq",	Adr_rel  },	/* 0xF0 */
+	{ "sbc",	Adr_idy  },	/* 0xF1 */
+	{ "sbc",	Adr_idp  },	/* 0xF2 */
+	{ "sbc",	Adr_isy  },	/* 0xF3 */
+	{ "pea",	Adr_abs  },	/* 0xF4 */
+	{ "sbc",	Adr_dpx  },	/* 0xF5 */
+	{ "inc",	Adr_dpx  },	/* 0xF6 */
+	{ "sbc",	Adr_idly },	/* 0xF7 */
+	{ "sed",	Adr_none },	/* 0xF8 */
+	{ "sbc",	Adr_aby  },	/* 0xF9 */
+	{ "plx",	Adr_none },	/* 0xFA */
+	{ "xce",	Adr_none },	/* 0xFB */
+	{ "jsr",	Adr_iax  },	/* 0xFC */
+	{ "sbc",	Adr_abx  },	/* 0xFD */
+	{ "inc",	Adr_abx  },	/* 0xFE */
+	{ "sbc",	Adr_alx  },	/* 0xFF */
+};
+
+/*--------------- Opcode table accessors ---------------*/
+
+const char* Opcode_Mnemonic(const uint8 op)
+{
+	return opcodes[op].op;
+}
+
+AdrMode Opcode_AdrMode(const uint8 op)
+{
+	return opcodes[op].mode;
+}
+
+int Opcode_ArgLength(const uint8 op, const uint16 psw)
+{
+	switch(opcodes[op].mode)
+	{
+		case Adr_immM:
+			if(psw & 0x20) return 1;
+			return 2;
+
+		case Adr_immX:
+			if(psw & 0x10) return 1;
+			return 2;
+
+		default:
+			break;
+	}
+	return argLength[opcodes[op].mode];
+}
+
+/*--------------- Render methods ---------------*/
+
+const char* Opcode_SizeSuffix(const Instruction* ins)
+{
+	assert(ins);
+	switch(opcodes[ins->op].mode)
+	{
+		case Adr_immM:
+		case Adr_immX:
+			if(2 == ins->arglen) return ".w";
+			return ".b";
+
+		case Adr_sr:
+		case Adr_dp:
+		case Adr_dpx:
+		case Adr_dpy:
+		case Adr_idp:
+		case Adr_idx:
+		case Adr_idy:
+		case Adr_idl:
+		case Adr_idly:
+		case Adr_isy:
+			return ".b";
+
+		case Adr_abs:
+			switch(ins->op)
+			{
+				case 0x20:	/* jsr */
+				case 0x4c:	/* jmp */
+					if(false == ins->numeric) return "";
+					break;
+				default:
+					break;
+			}
+			return ".w";
+
+		case Adr_abx:
+		case Adr_aby:
+		case Adr_ind:
+		case Adr_iax:
+			return ".w";
+
+		case Adr_abl:
+			switch(ins->op)
+			{
+				case 0x22:	/* jsl */
+				case 0x5c:	/* jml */
+					if(false == ins->numeric) return "";
+					break;
+				default:
+					break;
+			}
+			return ".l";
+
+		case Adr_alx:
+		case Adr_ial:
+			return ".l";
+
+		default:
+			break;
+	}
+	return "";
+}
+
+bool Opcode_Target(const Instruction* ins, uint32* target)
+{
+	assert(ins);
+	switch(opcodes[ins->op].mode)
+	{
+		case Adr_abs:
+			switch(ins->op)
+			{
+				case 0x20:	/* jsr */
+				case 0x4c:	/* jmp */
+					*target = (uint32)((((int32)ins->snesadr+3) & 0xff0000) + read16(&ins->arg[0]));
+					return true;
+				default:
+					break;
+			}
+			return false;
+
+		case Adr_abl:
+			switch(ins->op)
+			{
+				case 0x22:	/* jsl */
+				case 0x5c:	/* jml */
+					*target = read24(&ins->arg[0]);
+					return true;
+				default:
+					break;
+			}
+			return false;
+
+		case Adr_rel:
+			*target = (uint32)((int32)ins->snesadr+2 + (int8)ins->arg[0]);
+			return true;
+
+		case Adr_rell:
+			*target = (uint32)((int32)ins->snesadr+3 + (int16)read16(&ins->arg[0]));
+			return true;
+
+		default:
+			break;
+	}
+	return false;
+}
+
+int Opcode_Operand(const Instruction* ins, char* buf)
+{
+	uint32 target;
+
+	assert(ins);
+	assert(buf);
+
+	/* label operand */
+	if(Opcode_Target(ins, &target))
+	{
+		if(false == ins->numeric)
+		{
+			return sprintf_s(buf, 16, "L%06x", target);
+		}
+		switch(opcodes[ins->op].mode)
+		{
+			case Adr_rel:
+			case Adr_rell:
+				return sprintf_s(buf, 16, "$%04x", target & 0xffff);
+			default:
+				break;
+		}
+	}
+
+	switch(opcodes[ins->op].mode)
+	{
+		case Adr_imm:
+			return sprintf_s(buf, 16, "#$%02x", ins->arg[0]);
+
+		case Adr_immM:
+		case Adr_immX:
+			if(2 == ins->arglen)
+			{
+				return sprintf_s(buf, 16, "#$%04x", read16(&ins->arg[0]));
+			}
+			return sprintf_s(buf, 16, "#$%02x", ins->arg[0]);
+
+		case Adr_sr:
+			return sprintf_s(buf, 16, "$%02x, s", ins->arg[0]);
+
+		case Adr_dp:
+			return sprintf_s(buf, 16, "$%02x", ins->arg[0]);
+
+		case Adr_dpx:
+			return sprintf_s(buf, 16, "$%02x, x", ins->arg[0]);
+
+		case Adr_dpy:
+			return sprintf_s(buf, 16, "$%02x, y", ins->arg[0]);
+
+		case Adr_idp:
+			return sprintf_s(buf, 16, "($%02x)", ins->arg[0]);
+
+		case Adr_idx:
+			return sprintf_s(buf, 16, "($%02x, x)", ins->arg[0]);
+
+		case Adr_idy:
+			return sprintf_s(buf, 16, "($%02x), y", ins->arg[0]);
+
+		case Adr_idl:
+			return sprintf_s(buf, 16, "[$%02x]", ins->arg[0]);
+
+		case Adr_idly:
+			return sprintf_s(buf, 16, "[$%02x], y", ins->arg[0]);
+
+		case Adr_isy:
+			return sprintf_s(buf, 16, "($%02x, s), y", ins->arg[0]);
+
+		case Adr_abs:
+			return sprintf_s(buf, 16, "$%04x", read16(&ins->arg[0]));
+
+		case Adr_abx:
+			return sprintf_s(buf, 16, "$%04x, x", read16(&ins->arg[0]));
+
+		case Adr_aby:
+			return sprintf_s(buf, 16, "$%04x, y", read16(&ins->arg[0]));
+
+		case Adr_abl:
+			return sprintf_s(buf, 16, "$%06x", read24(&ins->arg[0]));
+
+		case Adr_alx:
+			return sprintf_s(buf, 16, "$%06x, x", read24(&ins->arg[0]));
+
+		case Adr_ind:
+			return sprintf_s(buf, 16, "($%04x)", read16(&ins->arg[0]));
+
+		case Adr_iax:
+			return sprintf_s(buf, 16, "($%04x, x)", read16(&ins->arg[0]));
+
+		case Adr_ial:
+			return sprintf_s(buf, 16, "[$%06x]", read24(&ins->arg[0]));
+
+		case Adr_bm:
+			return sprintf_s(buf, 16, "$%02x, $%02x", ins->arg[0], ins->arg[1]);
+
+		default:
+			break;
+	}
+
+	buf[0] = '\0';
+	return 0;
+}
+
+bool Opcode_Decode(const uint8* code, const size_t len, const uint16 psw, Instruction* ins)
+{
+	int arglen;
+
+	assert(code);
+	assert(ins);
+	if(0 == len) return false;
+
+	arglen = Opcode_ArgLength(code[0], psw);
+	if(len < (size_t)(1 + arglen)) return false;
+
+	ins->op = code[0];
+	ins->arglen = arglen;
+	ins->psw = psw;
+	memset(ins->arg, 0, sizeof(ins->arg));
+	memcpy(ins->arg, &code[1], (size_t)arglen);
+	return true;
+}
+
+int Opcode_Format(const Instruction* ins, const bool enableUpper, char* buf, const size_t size)
+{
+	const char* mnemonic;
+	const char* suffix;
+	char operand[16];
+	size_t mlen;
+	size_t slen;
+	size_t olen;
+	size_t len;
+
+	assert(ins);
+	assert(buf);
+
+	mnemonic = Opcode_Mnemonic(ins->op);
+	suffix = Opcode_SizeSuffix(ins);
+	mlen = strlen(mnemonic);
+	slen = strlen(suffix);
+	olen = (size_t)Opcode_Operand(ins, operand);
+
+	/* "lda.b #$01" */
+	len = mlen + slen + ((0 != olen) ? 1 + olen : 0);
+	if(size <= len)
+	{
+		if(0 != size) buf[0] = '\0';
+		return -1;
+	}
+	memcpy(buf, mnemonic, mlen);
+	memcpy(&buf[mlen], suffix, slen);
+	if(0 != olen)
+	{
+		buf[mlen+slen] = ' ';
+		memcpy(&buf[mlen+slen+1], operand, olen);
+	}
+	buf[len] = '\0';
+
+	if(enableUpper)
+	{
+		Str_toupper(buf);
+	}
+	return (int)len;
+}
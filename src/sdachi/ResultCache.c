@@ -0,0 +1,473 @@
+/**
+ * ResultCache.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define CACHE_POSIX
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#ifdef CACHE_POSIX
+#  include <time.h>
+#  include <unistd.h>
+#  include <dirent.h>
+#  include <utime.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+#include "common/Str.h"
+#include "sdachi/ResultCache.h"
+
+#define KeyLen		16
+#define CopyChunk	65536
+
+/* 64bit FNV-1a */
+#define FNV_Offset	(((uint64)0xcbf29ce4 << 32) | 0x84222325)
+#define FNV_Prime	(((uint64)0x00000100 << 32) | 0x000001b3)
+
+/**
+ * ResultCache private members
+ */
+struct _ResultCache_private {
+	char*		dir;
+	ulong		limit;
+	uint64		hash;
+	char		key[KeyLen+1];
+	uint32		serial;		/* temporary name */
+};
+
+/* prototypes */
+static void AddKey(ResultCache*, const void*, const size_t);
+static void AddKeyString(ResultCache*, const char*);
+static bool AddKeyFile(ResultCache*, const char*);
+static const char* key_get(ResultCache*);
+static bool Fetch(ResultCache*, const char* const*, const int);
+static bool Store(ResultCache*, const char* const*, const int);
+static void Evict(ResultCache*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create ResultCache object
+ *
+ * @param dir cache directory
+ * @param limit total size limit(bytes)
+ *
+ * @return the pointer of object
+ */
+ResultCache* new_ResultCache(const char* dir, const ulong limit)
+{
+	ResultCache* self;
+	ResultCache_private* pri;
+
+	assert(dir);
+
+	/* make objects */
+	self = malloc(sizeof(ResultCache));
+	pri = malloc(sizeof(ResultCache_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->dir = Str_copy(dir);
+	pri->limit = limit;
+	pri->hash = FNV_Offset;
+	pri->key[0] = '\0';
+	pri->serial = 0;
+#ifdef CACHE_POSIX
+	mkdir(dir, 0777);
+#endif
+
+	/*--- set public member ---*/
+	self->AddKey = AddKey;
+	self->AddKeyString = AddKeyString;
+	self->AddKeyFile = AddKeyFile;
+	self->key_get = key_get;
+	self->Fetch = Fetch;
+	self->Store = Store;
+	self->Evict = Evict;
+
+	/* init ResultCache object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete ResultCache object
+ *
+ * @param the pointer of object
+ */
+void delete_ResultCache(ResultCache** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	free((*self)->pri->dir);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- key ---------------*/
+
+static void AddKey(ResultCache* self, const void* data, const size_t len)
+{
+	const uint8* p = (const uint8*)data;
+	uint64 hash;
+	size_t i;
+
+	assert(self);
+	hash = self->pri->hash;
+	for(i=0; i<len; i++)
+	{
+		hash = (hash ^ p[i]) * FNV_Prime;
+	}
+	self->pri->hash = hash;
+	self->pri->key[0] = '\0';
+}
+
+static void AddKeyString(ResultCache* self, const char* s)
+{
+	AddKey(self, s, strlen(s)+1);
+}
+
+static bool AddKeyFile(ResultCache* self, const char* path)
+{
+	FILE* fp;
+	uint8* buf;
+	size_t len;
+	bool result;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return false;
+
+	buf = malloc(CopyChunk);
+	assert(buf);
+	while(0 != (len = fread(buf, 1, CopyChunk, fp)))
+	{
+		AddKey(self, buf, len);
+	}
+	result = (0 == ferror(fp));
+	free(buf);
+	fclose(fp);
+	return result;
+}
+
+static const char* key_get(ResultCache* self)
+{
+	ResultCache_private* pri;
+
+	assert(self);
+	pri = self->pri;
+	if('\0' == pri->key[0])
+	{
+		sprintf(pri->key, "%08lx%08lx",
+				(ulong)(pri->hash >> 32), (ulong)(pri->hash & 0xffffffff));
+	}
+	return pri->key;
+}
+
+
+/*--------------- entries ---------------*/
+
+#ifdef CACHE_POSIX
+static char* JoinPath(const char* dir, const char* name)
+{
+	char* path;
+
+	path = malloc(strlen(dir) + strlen(name) + 2);
+	assert(path);
+	sprintf(path, "%s/%s", dir, name);
+	return path;
+}
+
+/* unique name in this process */
+static char* TempName(ResultCache* self, const char* base, const char* prefix)
+{
+	char name[96];
+
+	sprintf(name, "%s%ld-%lu-%p-%lu", prefix, (long)getpid(), (ulong)time(NULL), (void*)self, (ulong)self->pri->serial++);
+	return JoinPath(base, name);
+}
+
+static bool CopyFile(const char* src, const char* dst)
+{
+	FILE* in;
+	FILE* out;
+	uint8* buf;
+	size_t len;
+	bool result = true;
+
+	in = fopen(src, "rb");
+	if(NULL == in) return false;
+	out = fopen(dst, "wb");
+	if(NULL == out)
+	{
+		fclose(in);
+		return false;
+	}
+
+	buf = malloc(CopyChunk);
+	assert(buf);
+	while(0 != (len = fread(buf, 1, CopyChunk, in)))
+	{
+		if(len != fwrite(buf, 1, len, out))
+		{
+			result = false;
+			break;
+		}
+	}
+	result &= (0 == ferror(in));
+	free(buf);
+	fclose(in);
+	result &= (0 == fclose(out));
+	return result;
+}
+
+/* the key-shaped name */
+static bool IsEntryName(const char* name)
+{
+	int i;
+
+	for(i=0; i<KeyLen; i++)
+	{
+		if(!((('0' <= name[i]) && ('9' >= name[i])) || (('a' <= name[i]) && ('f' >= name[i])))) return false;
+	}
+	return ('\0' == name[KeyLen]);
+}
+
+/**
+ * Remove the directory and the files in it
+ */
+static void RemoveDir(const char* path)
+{
+	DIR* d;
+	struct dirent* ent;
+	char* file;
+
+	d = opendir(path);
+	if(NULL != d)
+	{
+		while(NULL != (ent = readdir(d)))
+		{
+			if('.' == ent->d_name[0]) continue;
+			file = JoinPath(path, ent->d_name);
+			remove(file);
+			free(file);
+		}
+		closedir(d);
+	}
+	rmdir(path);
+}
+
+/**
+ * Total size of the files in the directory
+ */
+static ulong DirSize(const char* path)
+{
+	DIR* d;
+	struct dirent* ent;
+	struct stat st;
+	char* file;
+	ulong size = 0;
+
+	d = opendir(path);
+	if(NULL == d) return 0;
+	while(NULL != (ent = readdir(d)))
+	{
+		if('.' == ent->d_name[0]) continue;
+		file = JoinPath(path, ent->d_name);
+		if(0 == stat(file, &st)) size += (ulong)st.st_size;
+		free(file);
+	}
+	closedir(d);
+	return size;
+}
+#endif
+
+static bool Fetch(ResultCache* self, const char* const* paths, const int count)
+{
+#ifdef CACHE_POSIX
+	char* entry;
+	char* src;
+	char* tmp;
+	char name[16];
+	struct stat st;
+	bool result = true;
+	int i;
+
+	assert(self);
+	entry = JoinPath(self->pri->dir, key_get(self));
+	if((0 != stat(entry, &st)) || !S_ISDIR(st.st_mode))
+	{
+		free(entry);
+		return false;
+	}
+
+	/* the output is replaced at once */
+	for(i=0; (i<count) && result; i++)
+	{
+		sprintf(name, "%d", i);
+		src = JoinPath(entry, name);
+		tmp = malloc(strlen(paths[i]) + 96);
+		assert(tmp);
+		sprintf(tmp, "%s.cache%ld-%p-%lu", paths[i], (long)getpid(), (void*)self, (ulong)self->pri->serial++);
+		result = CopyFile(src, tmp) && (0 == rename(tmp, paths[i]));
+		if(false == result) remove(tmp);
+		free(tmp);
+		free(src);
+	}
+
+	/* recently used */
+	if(result) utime(entry, NULL);
+	free(entry);
+	return result;
+#else
+	(void)self;
+	(void)paths;
+	(void)count;
+	return false;
+#endif
+}
+
+static bool Store(ResultCache* self, const char* const* paths, const int count)
+{
+#ifdef CACHE_POSIX
+	char* entry;
+	char* tmp;
+	char* dst;
+	char name[16];
+	bool result = true;
+	int i;
+
+	assert(self);
+	tmp = TempName(self, self->pri->dir, "tmp-");
+	if(0 != mkdir(tmp, 0777))
+	{
+		free(tmp);
+		return false;
+	}
+
+	for(i=0; (i<count) && result; i++)
+	{
+		sprintf(name, "%d", i);
+		dst = JoinPath(tmp, name);
+		result = CopyFile(paths[i], dst);
+		free(dst);
+	}
+
+	/* the other job may store the same entry */
+	entry = JoinPath(self->pri->dir, key_get(self));
+	if(result && (0 != rename(tmp, entry)))
+	{
+		result = (0 == access(entry, F_OK));
+	}
+	RemoveDir(tmp);
+
+	free(entry);
+	free(tmp);
+	return result;
+#else
+	(void)self;
+	(void)paths;
+	(void)count;
+	return false;
+#endif
+}
+
+#ifdef CACHE_POSIX
+typedef struct _CacheEntry {
+	char*		name;
+	ulong		size;
+	time_t		mtime;
+} CacheEntry;
+
+static int CompareEntry(const void* a, const void* b)
+{
+	const CacheEntry* ea = (const CacheEntry*)a;
+	const CacheEntry* eb = (const CacheEntry*)b;
+
+	if(ea->mtime < eb->mtime) return -1;
+	if(ea->mtime > eb->mtime) return 1;
+	return strcmp(ea->name, eb->name);
+}
+#endif
+
+static void Evict(ResultCache* self)
+{
+#ifdef CACHE_POSIX
+	ResultCache_private* pri;
+	CacheEntry* entries = NULL;
+	CacheEntry* tmp;
+	DIR* d;
+	struct dirent* ent;
+	struct stat st;
+	char* path;
+	char* dead;
+	ulong total = 0;
+	size_t count = 0;
+	size_t size = 0;
+	size_t i;
+
+	assert(self);
+	pri = self->pri;
+
+	d = opendir(pri->dir);
+	if(NULL == d) return;
+	while(NULL != (ent = readdir(d)))
+	{
+		if(false == IsEntryName(ent->d_name)) continue;
+		path = JoinPath(pri->dir, ent->d_name);
+		if(0 != stat(path, &st))
+		{
+			free(path);
+			continue;
+		}
+		if(count == size)
+		{
+			size = (0 == size) ? 64 : size * 2;
+			tmp = realloc(entries, sizeof(CacheEntry) * size);
+			assert(tmp);
+			entries = tmp;
+		}
+		entries[count].name = Str_copy(ent->d_name);
+		entries[count].size = DirSize(path);
+		entries[count].mtime = st.st_mtime;
+		total += entries[count].size;
+		count++;
+		free(path);
+	}
+	closedir(d);
+
+	/* the oldest first */
+	if(0 != count)
+	{
+		qsort(entries, count, sizeof(CacheEntry), CompareEntry);
+	}
+	for(i=0; (i<count) && (pri->limit < total); i++)
+	{
+		path = JoinPath(pri->dir, entries[i].name);
+		dead = TempName(self, pri->dir, "del-");
+		if(0 == rename(path, dead))
+		{
+			RemoveDir(dead);
+		}
+		total -= entries[i].size;
+		free(dead);
+		free(path);
+	}
+
+	for(i=0; i<count; i++)
+	{
+		free(entries[i].name);
+	}
+	free(entries);
+#else
+	(void)self;
+#endif
+}
@@ -0,0 +1,702 @@
+/**
+ * RomDiff.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "common/Str.h"
+#include "common/Iterator.h"
+#include "common/List.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/RomDiff.h"
+#include "ConstProp.protected.h"
+#include "DisAsm.protected.h"
+
+#define BlockShift	12
+#define BlockSize	(1 << BlockShift)
+
+/* the changed bytes in this distance are written as one range */
+#define DataGap		16
+
+#define Unchanged	RomDiff_Kinds
+#define NoMatch		0xffffffff
+
+static const char* const KindNames[] = {
+	"changed", "affected", "added", "removed", "data",
+};
+
+/**
+ * routine(group) of the analysis
+ *   The records from the group head to the next head.
+ */
+typedef struct _Routine {
+	uint32		first;		/* record index */
+	uint32		end;		/* record index(exclusive) */
+	uint32		match;		/* routine index of the other rom */
+	RomDiffKind	kind;		/* or Unchanged */
+	uint32		reaches;	/* head of the changed routine(affected) */
+} Routine;
+
+/**
+ * one side of the comparison
+ */
+typedef struct _Side {
+	const RomView*	from;
+	const uint8*	base;
+	uint32		size;
+	Analysis*	result;
+	InsnStore*	store;
+	Routine*	routines;
+	uint32		count;
+} Side;
+
+/**
+ * RomDiff private members
+ */
+struct _RomDiff_private {
+	DisAsmContext*	oldCtx;
+	DisAsmContext*	newCtx;
+	bool		enableUpper;
+	uint8*		blocks;		/* changed blocks */
+	uint32		blockCount;
+	uint32		counts[RomDiff_Kinds];
+};
+
+/* prototypes */
+static void AddEntry(RomDiff*, const uint32, const uint16);
+static bool Run(RomDiff*, const RomView*, const RomView*, TextFile*);
+static uint32 count_get(RomDiff*, const RomDiffKind);
+static void PrintDiags(RomDiff*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create RomDiff object
+ *
+ * @param inf options of the analysis
+ *
+ * @return the pointer of object
+ */
+RomDiff* new_RomDiff(const DisAsmInf* inf)
+{
+	RomDiff* self;
+	RomDiff_private* pri;
+	DisAsmInf sub;
+
+	assert(inf);
+
+	/* make objects */
+	self = malloc(sizeof(RomDiff));
+	pri = malloc(sizeof(RomDiff_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	/* nothing is written by the analyses */
+	memcpy(&sub, inf, sizeof(DisAsmInf));
+	sub.exportBinPath = NULL;
+	sub.cfgPath = NULL;
+	sub.dbPath = NULL;
+	sub.fingerprintPath = NULL;
+	sub.namesPath = NULL;
+	pri->newCtx = new_DisAsmContext(&sub);
+	/* the trace / code data logs are taken from the new rom */
+	sub.tracePath = NULL;
+	sub.cdlPath = NULL;
+	pri->oldCtx = new_DisAsmContext(&sub);
+	pri->enableUpper = inf->enableUpper;
+	pri->blocks = NULL;
+	pri->blockCount = 0;
+	memset(pri->counts, 0, sizeof(pri->counts));
+
+	/*--- set public member ---*/
+	self->AddEntry = AddEntry;
+	self->Run = Run;
+	self->count_get = count_get;
+	self->PrintDiags = PrintDiags;
+
+	/* init RomDiff object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete RomDiff object
+ *
+ * @param the pointer of object
+ */
+void delete_RomDiff(RomDiff** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	delete_DisAsmContext(&(*self)->pri->oldCtx);
+	delete_DisAsmContext(&(*self)->pri->newCtx);
+	free((*self)->pri->blocks);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+/**
+ * Split the sorted store into the routines
+ */
+static void MakeRoutines(Side* side)
+{
+	InsnStore* store = side->store;
+	Routine* r;
+	uint32 i;
+	uint32 n = 0;
+
+	side->count = store->groupCount_get(store);
+	side->routines = malloc(sizeof(Routine) * (side->count + 1));
+	assert(side->routines);
+
+	for(i=0; i<store->count_get(store); i++)
+	{
+		if(0 == (InsnRec_GroupHead & store->Record(store, i)->flags)) continue;
+		assert(n < side->count);
+		if(0 != n) side->routines[n-1].end = i;
+		r = &side->routines[n++];
+		r->first = i;
+		r->end = store->count_get(store);
+		r->match = NoMatch;
+		r->kind = Unchanged;
+		r->reaches = 0;
+	}
+	side->count = n;
+}
+
+/**
+ * Routine of the record
+ */
+static uint32 RoutineOf(const Side* side, const uint32 inx)
+{
+	uint32 lo = 0;
+	uint32 hi = side->count;
+	uint32 mid;
+
+	/* the last routine which starts at or before the record */
+	while(1 < hi - lo)
+	{
+		mid = lo + (hi-lo)/2;
+		if(side->routines[mid].first <= inx)
+		{
+			lo = mid;
+			continue;
+		}
+		hi = mid;
+	}
+	return lo;
+}
+
+static const InsnRec* HeadRecord(const Side* side, const uint32 r)
+{
+	return side->store->Record(side->store, side->routines[r].first);
+}
+
+/**
+ * Compare the roms by blocks
+ */
+static void CompareBlocks(RomDiff_private* pri, const Side* oldSide, const Side* newSide)
+{
+	uint32 start;
+	uint32 len;
+	uint32 i;
+
+	free(pri->blocks);
+	pri->blockCount = (newSide->size + BlockSize - 1) >> BlockShift;
+	pri->blocks = calloc((size_t)pri->blockCount + 1, sizeof(uint8));
+	assert(pri->blocks);
+
+	for(i=0; i<pri->blockCount; i++)
+	{
+		start = i << BlockShift;
+		len = BlockSize;
+		if(newSide->size - start < len) len = newSide->size - start;
+		if((oldSide->size < start + len)
+		|| (0 != memcmp(&newSide->base[start], &oldSide->base[start], len)))
+		{
+			pri->blocks[i] = 1;
+		}
+	}
+}
+
+static bool IsChangedBlock(const RomDiff_private* pri, const uint32 pcadr, const uint32 len)
+{
+	if(pri->blockCount <= ((pcadr + len - 1) >> BlockShift)) return true;
+	return (0 != pri->blocks[pcadr >> BlockShift]) || (0 != pri->blocks[(pcadr + len - 1) >> BlockShift]);
+}
+
+/**
+ * Compare the instructions at the same address
+ */
+static bool IsSameInsn(const RomDiff_private* pri, const Side* oldSide, const InsnRec* o, const Side* newSide, const InsnRec* n)
+{
+	uint32 pca;
+	uint32 len;
+
+	/* only M / X flags change the instruction */
+	if((o->psw & 0x30) != (n->psw & 0x30)) return false;
+	pca = InsnRec_Pc(n);
+	len = InsnRec_Length(n, newSide->from);
+	if(len != InsnRec_Length(o, oldSide->from)) return false;
+
+	/* the bytes are compared only in the changed blocks */
+	if(false == IsChangedBlock(pri, pca, len)) return true;
+	if(oldSide->size < pca + len) return false;
+	return (0 == memcmp(&newSide->base[pca], &oldSide->base[pca], len));
+}
+
+static bool IsSameRoutine(const RomDiff_private* pri, const Side* oldSide, const Routine* o, const Side* newSide, const Routine* n)
+{
+	const InsnRec* orec;
+	const InsnRec* nrec;
+	uint32 i;
+
+	if((o->end - o->first) != (n->end - n->first)) return false;
+	for(i=0; i<n->end - n->first; i++)
+	{
+		orec = oldSide->store->Record(oldSide->store, o->first + i);
+		nrec = newSide->store->Record(newSide->store, n->first + i);
+		if(InsnRec_Pc(orec) != InsnRec_Pc(nrec)) return false;
+		if(false == IsSameInsn(pri, oldSide, orec, newSide, nrec)) return false;
+	}
+	return true;
+}
+
+/**
+ * Match the routines by the head address
+ */
+static void MatchRoutines(RomDiff_private* pri, Side* oldSide, Side* newSide)
+{
+	Routine* o;
+	Routine* n;
+	uint32 opc;
+	uint32 npc;
+	uint32 i = 0;
+	uint32 j = 0;
+
+	while((i < oldSide->count) || (j < newSide->count))
+	{
+		o = &oldSide->routines[i];
+		n = &newSide->routines[j];
+		opc = (i < oldSide->count) ? InsnRec_Pc(HeadRecord(oldSide, i)) : NoMatch;
+		npc = (j < newSide->count) ? InsnRec_Pc(HeadRecord(newSide, j)) : NoMatch;
+		if(opc < npc)
+		{
+			o->kind = RomDiff_Removed;
+			i++;
+			continue;
+		}
+		if(npc < opc)
+		{
+			n->kind = RomDiff_Added;
+			j++;
+			continue;
+		}
+		o->match = j;
+		n->match = i;
+		if(false == IsSameRoutine(pri, oldSide, o, newSide, n))
+		{
+			o->kind = RomDiff_Changed;
+			n->kind = RomDiff_Changed;
+		}
+		i++;
+		j++;
+	}
+}
+
+/**
+ * Flag the routines which reach the changed routines
+ *   The static destinations are followed backward from the changed ones.
+ */
+static void FindAffected(Side* side)
+{
+	InsnStore* store = side->store;
+	Instruction ins;
+	uint32* from;
+	uint32* to;
+	uint32* heads;
+	uint32* callers;
+	uint32* queue;
+	uint32 edges = 0;
+	uint32 target;
+	uint32 pca;
+	uint32 inx;
+	uint32 r;
+	uint32 t;
+	uint32 i;
+	uint32 qhead = 0;
+	uint32 qtail = 0;
+
+	if(0 == side->count) return;
+	from = malloc(sizeof(uint32) * (store->count_get(store) + 1));
+	to = malloc(sizeof(uint32) * (store->count_get(store) + 1));
+	heads = calloc((size_t)side->count + 1, sizeof(uint32));
+	queue = malloc(sizeof(uint32) * side->count);
+	assert(from);
+	assert(to);
+	assert(heads);
+	assert(queue);
+
+	/* the references between the routines */
+	for(r=0; r<side->count; r++)
+	{
+		for(i=side->routines[r].first; i<side->routines[r].end; i++)
+		{
+			InsnRec_Decode(store->Record(store, i), side->from, &ins);
+			if(false == Opcode_Target(&ins, &target)) continue;
+			pca = side->from->Snes2PcAdr(side->from, target);
+			if(ROMADDRESS_NULL == pca) continue;
+			inx = store->Search(store, pca);
+			if(InsnStore_NotFound == inx) continue;
+			t = RoutineOf(side, inx);
+			if(t == r) continue;
+			from[edges] = r;
+			to[edges] = t;
+			heads[t+1]++;
+			edges++;
+		}
+	}
+
+	/* the callers of each routine(CSR) */
+	for(t=0; t<side->count; t++)
+	{
+		heads[t+1] += heads[t];
+	}
+	callers = malloc(sizeof(uint32) * (edges + 1));
+	assert(callers);
+	for(i=0; i<edges; i++)
+	{
+		callers[heads[to[i]]++] = from[i];
+	}
+	for(t=side->count; 0 < t; t--)
+	{
+		heads[t] = heads[t-1];
+	}
+	heads[0] = 0;
+
+	for(r=0; r<side->count; r++)
+	{
+		if((RomDiff_Changed == side->routines[r].kind) || (RomDiff_Added == side->routines[r].kind))
+		{
+			side->routines[r].reaches = InsnRec_Snes(HeadRecord(side, r));
+			queue[qtail++] = r;
+		}
+	}
+	while(qhead < qtail)
+	{
+		t = queue[qhead++];
+		for(i=heads[t]; i<heads[t+1]; i++)
+		{
+			r = callers[i];
+			if(Unchanged != side->routines[r].kind) continue;
+			side->routines[r].kind = RomDiff_Affected;
+			side->routines[r].reaches = side->routines[t].reaches;
+			queue[qtail++] = r;
+		}
+	}
+
+	free(callers);
+	free(queue);
+	free(heads);
+	free(to);
+	free(from);
+}
+
+
+/*--------------- report ---------------*/
+
+/* "+L008000:\tlda.b #$01          ; a9 01 (m8 x8)" */
+static void PutInsn(RomDiff_private* pri, TextFile* out, const char mark, const Side* side, const uint32 inx)
+{
+	Instruction ins;
+	char text[32];
+	char buf[80];
+	int len;
+	int i;
+
+	InsnRec_Decode(side->store->Record(side->store, inx), side->from, &ins);
+	Opcode_Format(&ins, false, text, sizeof(text));
+	len = sprintf(buf, "%cL%06x:\t%-18s ; %02x", mark, ins.snesadr, text, ins.op);
+	for(i=0; i<ins.arglen; i++)
+	{
+		len += sprintf(&buf[len], " %02x", ins.arg[i]);
+	}
+	/* the register status may be the only change */
+	sprintf(&buf[len], " (m%d x%d)", (ins.psw & 0x20) ? 8 : 16, (ins.psw & 0x10) ? 8 : 16);
+	if(pri->enableUpper)
+	{
+		Str_toupper(buf);
+	}
+	out->Printf(out, "%s\n", buf);
+}
+
+static void PutHead(TextFile* out, const Side* side, const uint32 r)
+{
+	const Routine* routine = &side->routines[r];
+	const GroupRec* grp;
+
+	/* the routines are made from the groups in order */
+	grp = side->store->Group(side->store, r);
+	out->Printf(out, "\n%-8s $%06x (call from $%06x)", KindNames[routine->kind],
+			InsnRec_Snes(HeadRecord(side, r)), grp->callFrom);
+	if(RomDiff_Affected == routine->kind)
+	{
+		out->Printf(out, " : reaches $%06x", routine->reaches);
+	}
+	out->Printf(out, "\n");
+}
+
+/**
+ * Write the changed instructions of the matched routines
+ */
+static void PutChanged(RomDiff_private* pri, TextFile* out, const Side* oldSide, const Side* newSide, const uint32 r)
+{
+	const Routine* n = &newSide->routines[r];
+	const Routine* o = &oldSide->routines[n->match];
+	const InsnRec* orec;
+	const InsnRec* nrec;
+	uint32 i = o->first;
+	uint32 j = n->first;
+
+	while((i < o->end) || (j < n->end))
+	{
+		orec = (i < o->end) ? oldSide->store->Record(oldSide->store, i) : NULL;
+		nrec = (j < n->end) ? newSide->store->Record(newSide->store, j) : NULL;
+		if((NULL == nrec) || ((NULL != orec) && (InsnRec_Pc(orec) < InsnRec_Pc(nrec))))
+		{
+			PutInsn(pri, out, '-', oldSide, i++);
+			continue;
+		}
+		if((NULL == orec) || (InsnRec_Pc(nrec) < InsnRec_Pc(orec)))
+		{
+			PutInsn(pri, out, '+', newSide, j++);
+			continue;
+		}
+		if(false == IsSameInsn(pri, oldSide, orec, newSide, nrec))
+		{
+			PutInsn(pri, out, '-', oldSide, i);
+			PutInsn(pri, out, '+', newSide, j);
+		}
+		i++;
+		j++;
+	}
+}
+
+static void PutRoutine(RomDiff_private* pri, TextFile* out, const Side* oldSide, const Side* newSide, const Side* side, const uint32 r)
+{
+	const Routine* routine = &side->routines[r];
+	uint32 i;
+
+	pri->counts[routine->kind]++;
+	PutHead(out, side, r);
+	switch(routine->kind)
+	{
+		case RomDiff_Changed:
+			PutChanged(pri, out, oldSide, newSide, r);
+			break;
+		case RomDiff_Added:
+		case RomDiff_Removed:
+			for(i=routine->first; i<routine->end; i++)
+			{
+				PutInsn(pri, out, (RomDiff_Added == routine->kind) ? '+' : '-', side, i);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Check whether the instructions overlap the pc address range
+ */
+static bool IsCode(const Side* side, const uint32 start, const uint32 end)
+{
+	InsnStore* store = side->store;
+	const InsnRec* rec;
+	uint32 pca;
+	uint32 i;
+
+	i = store->LowerBound(store, (InsnRec_MaxLength <= start) ? start - (InsnRec_MaxLength-1) : 0);
+	for(; i<store->count_get(store); i++)
+	{
+		rec = store->Record(store, i);
+		pca = InsnRec_Pc(rec);
+		if(end <= pca) break;
+		if(start < pca + InsnRec_Length(rec, side->from)) return true;
+	}
+	return false;
+}
+
+static void PutData(RomDiff_private* pri, TextFile* out, const Side* oldSide, const Side* newSide, const uint32 start, const uint32 end)
+{
+	if(IsCode(newSide, start, end) || IsCode(oldSide, start, end)) return;
+
+	pri->counts[RomDiff_Data]++;
+	out->Printf(out, "\n%-8s $%06x-$%06x (%lu bytes)\n", KindNames[RomDiff_Data],
+			newSide->from->Pc2SnesAdr(newSide->from, start),
+			newSide->from->Pc2SnesAdr(newSide->from, end-1), (ulong)(end - start));
+}
+
+/**
+ * Write the changed bytes out of the code
+ */
+static void PutDataRanges(RomDiff_private* pri, TextFile* out, const Side* oldSide, const Side* newSide)
+{
+	uint32 start = NoMatch;
+	uint32 last = 0;
+	uint32 pca;
+	uint32 end;
+	uint32 b;
+
+	for(b=0; b<pri->blockCount; b++)
+	{
+		if(0 == pri->blocks[b]) continue;
+		end = (b + 1) << BlockShift;
+		if(newSide->size < end) end = newSide->size;
+		for(pca = b << BlockShift; pca < end; pca++)
+		{
+			if((pca < oldSide->size) && (newSide->base[pca] == oldSide->base[pca])) continue;
+			if((NoMatch != start) && (last + DataGap < pca))
+			{
+				PutData(pri, out, oldSide, newSide, start, last+1);
+				start = NoMatch;
+			}
+			if(NoMatch == start) start = pca;
+			last = pca;
+		}
+	}
+	if(NoMatch != start)
+	{
+		PutData(pri, out, oldSide, newSide, start, last+1);
+	}
+}
+
+static void PutReport(RomDiff_private* pri, TextFile* out, const Side* oldSide, const Side* newSide)
+{
+	uint32 i = 0;
+	uint32 j = 0;
+	bool old;
+
+	out->Printf(out, ";-------------------------------------------------\n");
+	out->Printf(out, ";  Old  : %s\n", oldSide->from->path_get(oldSide->from));
+	out->Printf(out, ";  New  : %s\n", newSide->from->path_get(newSide->from));
+	out->Printf(out, ";  Map  : %s\n", DisAsm_MapModeString(newSide->from));
+	out->Printf(out, ";-------------------------------------------------\n");
+
+	/* the removed routines are put in the address order */
+	while((i < oldSide->count) || (j < newSide->count))
+	{
+		if((i < oldSide->count) && (RomDiff_Removed != oldSide->routines[i].kind))
+		{
+			i++;
+			continue;
+		}
+		old = (j >= newSide->count)
+			|| ((i < oldSide->count) && (InsnRec_Pc(HeadRecord(oldSide, i)) < InsnRec_Pc(HeadRecord(newSide, j))));
+		if(old)
+		{
+			PutRoutine(pri, out, oldSide, newSide, oldSide, i++);
+			continue;
+		}
+		if(Unchanged != newSide->routines[j].kind)
+		{
+			PutRoutine(pri, out, oldSide, newSide, newSide, j);
+		}
+		j++;
+	}
+	PutDataRanges(pri, out, oldSide, newSide);
+
+	out->Printf(out, "\n; %lu changed, %lu affected, %lu added, %lu removed routines, %lu data ranges\n",
+			(ulong)pri->counts[RomDiff_Changed], (ulong)pri->counts[RomDiff_Affected],
+			(ulong)pri->counts[RomDiff_Added], (ulong)pri->counts[RomDiff_Removed],
+			(ulong)pri->counts[RomDiff_Data]);
+}
+
+static bool Analyze(DisAsmContext* ctx, const RomView* from, Side* side)
+{
+	memset(side, 0, sizeof(Side));
+	side->from = from;
+	side->base = from->GetPcPtr(from, 0);
+	side->size = from->size_get(from);
+	side->result = ctx->Analyze(ctx, from);
+	if((NULL == side->result) || (NULL == side->base)) return false;
+	side->store = Analysis_Store(side->result);
+	MakeRoutines(side);
+	return true;
+}
+
+static void Release(Side* side)
+{
+	free(side->routines);
+	delete_Analysis(&side->result);
+}
+
+
+/*--------------- methods ---------------*/
+
+static void AddEntry(RomDiff* self, const uint32 snesadr, const uint16 psw)
+{
+	assert(self);
+	self->pri->oldCtx->AddEntry(self->pri->oldCtx, snesadr, psw);
+	self->pri->newCtx->AddEntry(self->pri->newCtx, snesadr, psw);
+}
+
+static bool Run(RomDiff* self, const RomView* oldRom, const RomView* newRom, TextFile* out)
+{
+	RomDiff_private* pri;
+	Side oldSide;
+	Side newSide;
+	bool result;
+
+	assert(self);
+	assert(oldRom);
+	assert(newRom);
+	assert(out);
+	pri = self->pri;
+	memset(pri->counts, 0, sizeof(pri->counts));
+
+	result = Analyze(pri->oldCtx, oldRom, &oldSide);
+	result &= Analyze(pri->newCtx, newRom, &newSide);
+	if(result)
+	{
+		CompareBlocks(pri, &oldSide, &newSide);
+		MatchRoutines(pri, &oldSide, &newSide);
+		FindAffected(&newSide);
+		PutReport(pri, out, &oldSide, &newSide);
+	}
+
+	Release(&oldSide);
+	Release(&newSide);
+	return result;
+}
+
+static uint32 count_get(RomDiff* self, const RomDiffKind kind)
+{
+	assert(self);
+	assert(RomDiff_Kinds > kind);
+	return self->pri->counts[kind];
+}
+
+static void PrintDiags(RomDiff* self)
+{
+	assert(self);
+	self->pri->oldCtx->PrintDiags(self->pri->oldCtx);
+	self->pri->newCtx->PrintDiags(self->pri->newCtx);
+}
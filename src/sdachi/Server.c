@@ -0,0 +1,1143 @@
+/**
+ * Server.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define SERVER_SOCKET
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <stdarg.h>
+#include <signal.h>
+#ifdef SERVER_SOCKET
+#  include <errno.h>
+#  include <pthread.h>
+#  include <unistd.h>
+#  include <poll.h>
+#  include <sys/socket.h>
+#  include <sys/un.h>
+#endif
+#include "common/puts.h"
+#include "common/Str.h"
+#include "common/Iterator.h"
+#include "common/List.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/Server.h"
+#include "Json.protected.h"
+
+#if defined(_MSC_VER)
+#  define vsnprintf _vsnprintf
+#endif
+
+#define ErrorLen	256
+#define ReplyFirst	256
+#define QueueSize	64		/* the clients */
+#define PollInterval	200		/* ms */
+#define ReadChunk	4096
+#define LineMax		(1024*1024)
+#define TooMany		"{\"ok\":false,\"error\":\"Too many clients\"}\n"
+
+#ifdef SERVER_SOCKET
+#  define Mutex_Lock(m)		pthread_mutex_lock(m)
+#  define Mutex_Unlock(m)	pthread_mutex_unlock(m)
+#  define Read_Lock(l)		pthread_rwlock_rdlock(l)
+#  define Write_Lock(l)		pthread_rwlock_wrlock(l)
+#  define RW_Unlock(l)		pthread_rwlock_unlock(l)
+#  ifndef MSG_NOSIGNAL
+#    define MSG_NOSIGNAL	0
+#  endif
+#else
+#  define Mutex_Lock(m)
+#  define Mutex_Unlock(m)
+#  define Read_Lock(l)
+#  define Write_Lock(l)
+#  define RW_Unlock(l)
+#endif
+
+/**
+ * response builder
+ */
+typedef struct _Reply {
+	char*		buf;
+	size_t		len;
+	size_t		size;
+} Reply;
+
+/**
+ * entry point added by the client
+ */
+typedef struct _ServerEntry {
+	uint32		snesadr;
+	uint16		psw;
+} ServerEntry;
+
+/**
+ * loaded rom
+ *   The analysis result is replaced by add-entry under the write lock.
+ */
+typedef struct _RomEntry {
+	uint32		id;
+	RomFile*	rom;
+	RomView*	view;
+	Analysis*	result;
+	List*		entries;
+#ifdef SERVER_SOCKET
+	pthread_rwlock_t lock;
+#endif
+} RomEntry;
+
+#ifdef SERVER_SOCKET
+/**
+ * connected client
+ *   One request of the client is handled at a time, so the responses are
+ *   returned in the order of the requests.
+ */
+typedef struct _ServerClient {
+	int		fd;
+	char*		line;		/* the received bytes */
+	size_t		len;
+	size_t		size;
+	bool		busy;		/* the request is on the worker(qlock) */
+	bool		broken;		/* the response couldn't be sent(qlock) */
+	bool		eof;		/* no more requests */
+} ServerClient;
+
+/**
+ * request passed to the worker
+ */
+typedef struct _ServerJob {
+	ServerClient*	client;
+	char*		request;
+} ServerJob;
+#endif
+
+/**
+ * Server private members
+ */
+struct _Server_private {
+	DisAsmInf	inf;
+	int		threads;
+	List*		roms;
+	uint32		nextId;
+	volatile sig_atomic_t stop;
+#ifdef SERVER_SOCKET
+	pthread_mutex_t	lock;		/* roms */
+	pthread_mutex_t	qlock;		/* request queue */
+	pthread_cond_t	qcond;
+	ServerJob	queue[QueueSize];	/* a request per client at most */
+	int		qhead;
+	int		qcount;
+	int		wake[2];	/* pipe to wake up the poll */
+#endif
+};
+
+/* request handler */
+typedef bool (*ServerOp_t)(Server_private*, JsonObject*, Reply*, char*);
+
+/* prototypes */
+static char* Handle(Server*, const char*);
+static bool Serve(Server*, const char*);
+static void Stop(Server*);
+static void RomEntryCleaner(void*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Server object
+ *
+ * @param inf analysis options
+ * @param threads number of the worker threads
+ *
+ * @return the pointer of object
+ */
+Server* new_Server(const DisAsmInf* inf, const int threads)
+{
+	Server* self;
+	Server_private* pri;
+
+	assert(inf);
+
+	/* make objects */
+	self = malloc(sizeof(Server));
+	pri = malloc(sizeof(Server_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	memcpy(&pri->inf, inf, sizeof(DisAsmInf));
+	pri->inf.dataLabel = Str_copy((NULL == inf->dataLabel) ? "" : inf->dataLabel);
+	/* only the analysis is used */
+	pri->inf.dataCount = 0;
+	pri->inf.outputPath = NULL;
+	pri->inf.jsonPath = NULL;
+	pri->inf.csvPath = NULL;
+	pri->inf.binPath = NULL;
+	pri->inf.exportBinPath = NULL;
+	pri->inf.cfgPath = NULL;
+	pri->inf.dbPath = NULL;
+	pri->inf.tracePath = NULL;	/* the roms are various */
+	pri->inf.cdlPath = NULL;
+	pri->inf.fingerprintPath = NULL;
+	pri->inf.namesPath = NULL;
+	pri->inf.showStats = false;
+	pri->threads = (0 < threads) ? threads : 1;
+	pri->roms = new_List(NULL, RomEntryCleaner);
+	assert(pri->roms);
+	pri->nextId = 1;
+	pri->stop = 0;
+#ifdef SERVER_SOCKET
+	pthread_mutex_init(&pri->lock, NULL);
+	pthread_mutex_init(&pri->qlock, NULL);
+	pthread_cond_init(&pri->qcond, NULL);
+	pri->qhead = 0;
+	pri->qcount = 0;
+#endif
+
+	/*--- set public member ---*/
+	self->Handle = Handle;
+	self->Serve = Serve;
+	self->Stop = Stop;
+
+	/* init Server object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete Server object
+ *
+ * @param the pointer of object
+ */
+void delete_Server(Server** self)
+{
+	Server_private* pri;
+
+	assert(self);
+	if(NULL == (*self)) return;
+	pri = (*self)->pri;
+
+	delete_List(&pri->roms);
+	free(pri->inf.dataLabel);
+#ifdef SERVER_SOCKET
+	pthread_mutex_destroy(&pri->lock);
+	pthread_mutex_destroy(&pri->qlock);
+	pthread_cond_destroy(&pri->qcond);
+#endif
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+static void RomEntryCleaner(void* data)
+{
+	RomEntry* entry = (RomEntry*)data;
+
+	delete_Analysis(&entry->result);
+	delete_RomView(&entry->view);
+	delete_RomFile(&entry->rom);
+	delete_List(&entry->entries);
+#ifdef SERVER_SOCKET
+	pthread_rwlock_destroy(&entry->lock);
+#endif
+	free(entry);
+}
+
+
+/*--------------- response builder ---------------*/
+
+static void Reply_Init(Reply* r)
+{
+	r->size = ReplyFirst;
+	r->len = 0;
+	r->buf = malloc(r->size);
+	assert(r->buf);
+	r->buf[0] = '\0';
+}
+
+static void Reply_Put(Reply* r, const char* s, const size_t len)
+{
+	char* tmp;
+
+	if(r->len + len + 1 > r->size)
+	{
+		while(r->len + len + 1 > r->size) r->size *= 2;
+		tmp = realloc(r->buf, r->size);
+		assert(tmp);
+		r->buf = tmp;
+	}
+	memcpy(&r->buf[r->len], s, len);
+	r->len += len;
+	r->buf[r->len] = '\0';
+}
+
+static void Reply_Printf(Reply* r, const char* fmt, ...)
+{
+	va_list args;
+	char tmp[256];
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(tmp, sizeof(tmp), fmt, args);
+	va_end(args);
+	assert((0 <= len) && ((int)sizeof(tmp) > len));
+	Reply_Put(r, tmp, (size_t)len);
+}
+
+static void Reply_String(Reply* r, const char* s)
+{
+	Reply_Put(r, "\"", 1);
+	for(; '\0' != *s; s++)
+	{
+		switch(*s)
+		{
+			case '"':
+				Reply_Put(r, "\\\"", 2);
+				break;
+			case '\\':
+				Reply_Put(r, "\\\\", 2);
+				break;
+			case '\n':
+				Reply_Put(r, "\\n", 2);
+				break;
+			case '\t':
+				Reply_Put(r, "\\t", 2);
+				break;
+			default:
+				if(0x20 > (uint8)*s)
+				{
+					Reply_Printf(r, "\\u%04x", (uint8)*s);
+					break;
+				}
+				Reply_Put(r, s, 1);
+				break;
+		}
+	}
+	Reply_Put(r, "\"", 1);
+}
+
+static void Reply_Bytes(Reply* r, const uint8* data, const size_t len)
+{
+	size_t i;
+
+	Reply_Put(r, "\"", 1);
+	for(i=0; i<len; i++)
+	{
+		Reply_Printf(r, "%02x", data[i]);
+	}
+	Reply_Put(r, "\"", 1);
+}
+
+static void Reply_Insn(Reply* r, const Instruction* ins, const bool enableUpper)
+{
+	char text[40];
+	uint8 bytes[4];
+	uint32 target;
+
+	bytes[0] = ins->op;
+	memcpy(&bytes[1], ins->arg, sizeof(ins->arg));
+	Opcode_Format(ins, enableUpper, text, sizeof(text));
+
+	Reply_Printf(r, "{\"snes\":%lu,\"pc\":%lu,\"bytes\":", (ulong)ins->snesadr, (ulong)ins->pcadr);
+	Reply_Bytes(r, bytes, (size_t)(ins->arglen+1));
+	Reply_Printf(r, ",\"text\":");
+	Reply_String(r, text);
+	Reply_Printf(r, ",\"m\":%d,\"x\":%d", (ins->psw & 0x20) ? 8 : 16, (ins->psw & 0x10) ? 8 : 16);
+	if(Opcode_Target(ins, &target))
+	{
+		Reply_Printf(r, ",\"target\":%lu", (ulong)target);
+	}
+	Reply_Put(r, "}", 1);
+}
+
+static void SetError(char* err, const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(err, ErrorLen, fmt, args);
+	va_end(args);
+	err[ErrorLen-1] = '\0';
+}
+
+
+/*--------------- loaded roms ---------------*/
+
+static RomEntry* FindRom(Server_private* pri, const uint32 id, const char* path)
+{
+	Iterator* it;
+	RomEntry* entry;
+
+	List_Foreach(pri->roms, it)
+	{
+		entry = (RomEntry*)Iterator_Data(it);
+		if(NULL != path)
+		{
+			if(0 == strcmp(path, entry->view->path_get(entry->view))) return entry;
+			continue;
+		}
+		if(id == entry->id) return entry;
+	}
+	return NULL;
+}
+
+static RomEntry* GetRom(Server_private* pri, JsonObject* req, char* err)
+{
+	RomEntry* entry;
+	uint32 id;
+
+	if(false == Json_GetAddress(req, "rom", &id))
+	{
+		SetError(err, "\"rom\" is required");
+		return NULL;
+	}
+
+	Mutex_Lock(&pri->lock);
+	entry = FindRom(pri, id, NULL);
+	Mutex_Unlock(&pri->lock);
+
+	if(NULL == entry)
+	{
+		SetError(err, "Unknown rom : %lu", (ulong)id);
+	}
+	return entry;
+}
+
+/**
+ * Analyze the rom with the entry points
+ *   The diagnostics are written to the reply.
+ */
+static Analysis* AnalyzeRom(Server_private* pri, RomEntry* entry, Reply* body, char* err)
+{
+	DisAsmContext* ctx;
+	Analysis* result;
+	const DisAsmDiag* d;
+	ServerEntry* e;
+	Iterator* it;
+	uint32 i;
+
+	ctx = new_DisAsmContext(&pri->inf);
+	List_Foreach(entry->entries, it)
+	{
+		e = (ServerEntry*)Iterator_Data(it);
+		ctx->AddEntry(ctx, e->snesadr, e->psw);
+	}
+	result = ctx->Analyze(ctx, entry->view);
+
+	if(NULL == result)
+	{
+		d = ctx->Diag(ctx, 0);
+		SetError(err, "%s", (NULL != d) ? d->message : "Analysis failed");
+	}
+	else if(0 != ctx->diagCount_get(ctx))
+	{
+		Reply_Printf(body, ",\"diags\":[");
+		for(i=0; i<ctx->diagCount_get(ctx); i++)
+		{
+			d = ctx->Diag(ctx, i);
+			Reply_Printf(body, "%s{\"level\":\"%s\",\"message\":", (0 == i) ? "" : ",",
+					(DisAsmDiag_Error == d->level) ? "error" : (DisAsmDiag_Warn == d->level) ? "warn" : "info");
+			Reply_String(body, d->message);
+			Reply_Put(body, "}", 1);
+		}
+		Reply_Put(body, "]", 1);
+	}
+
+	delete_DisAsmContext(&ctx);
+	return result;
+}
+
+static RomEntry* LoadRom(Server_private* pri, const char* path, Reply* body, char* err)
+{
+	RomEntry* entry;
+	RomEntry* found;
+
+	/* already loaded */
+	Mutex_Lock(&pri->lock);
+	found = FindRom(pri, 0, path);
+	Mutex_Unlock(&pri->lock);
+	if(NULL != found) return found;
+
+	entry = malloc(sizeof(RomEntry));
+	assert(entry);
+	entry->id = 0;
+	entry->rom = new_RomFile(path);
+	entry->view = NULL;
+	entry->result = NULL;
+	entry->entries = new_List(NULL, free);
+	assert(entry->entries);
+#ifdef SERVER_SOCKET
+	pthread_rwlock_init(&entry->lock, NULL);
+#endif
+
+	if(FileOpen_NoError != entry->rom->Open(entry->rom))
+	{
+		SetError(err, "Can't open \"%s\"", path);
+		RomEntryCleaner(entry);
+		return NULL;
+	}
+	entry->view = new_RomView(entry->rom);
+	entry->result = AnalyzeRom(pri, entry, body, err);
+	if(NULL == entry->result)
+	{
+		RomEntryCleaner(entry);
+		return NULL;
+	}
+
+	/* the other client may load it at the same time */
+	Mutex_Lock(&pri->lock);
+	found = FindRom(pri, 0, path);
+	if(NULL == found)
+	{
+		entry->id = pri->nextId++;
+		pri->roms->push(pri->roms, entry);
+	}
+	Mutex_Unlock(&pri->lock);
+
+	if(NULL != found)
+	{
+		RomEntryCleaner(entry);
+		return found;
+	}
+	return entry;
+}
+
+static void PutRomInfo(Reply* body, RomFile* rom, const RomView* view)
+{
+	Reply_Printf(body, ",\"path\":");
+	Reply_String(body, view->path_get(view));
+	Reply_Printf(body, ",\"map\":\"%s\",\"mapmode\":%d,\"size\":%lu,\"sum\":%u,\"validSum\":%s",
+			DisAsm_MapModeString(view), (int)view->mapmode_get(view),
+			(ulong)view->size_get(view), (uint)rom->sum_get(rom),
+			rom->IsValidSum(rom) ? "true" : "false");
+}
+
+
+/*--------------- request handlers ---------------*/
+
+static bool Op_Load(Server_private* pri, JsonObject* req, Reply* body, char* err)
+{
+	RomEntry* entry;
+	const char* path;
+
+	path = Json_GetString(req, "path");
+	if(NULL == path)
+	{
+		SetError(err, "\"path\" is required");
+		return false;
+	}
+
+	entry = LoadRom(pri, path, body, err);
+	if(NULL == entry) return false;
+
+	Read_Lock(&entry->lock);
+	Reply_Printf(body, ",\"rom\":%lu", (ulong)entry->id);
+	PutRomInfo(body, entry->rom, entry->view);
+	Reply_Printf(body, ",\"instructions\":%lu", (ulong)entry->result->count_get(entry->result));
+	RW_Unlock(&entry->lock);
+	return true;
+}
+
+static bool Op_Identify(Server_private* pri, JsonObject* req, Reply* body, char* err)
+{
+	RomEntry* entry;
+	RomFile* rom;
+	RomView* view;
+	const char* path;
+
+	/* not loaded rom */
+	path = Json_GetString(req, "path");
+	if(NULL != path)
+	{
+		rom = new_RomFile(path);
+		if(FileOpen_NoError != rom->Open(rom))
+		{
+			SetError(err, "Can't open \"%s\"", path);
+			delete_RomFile(&rom);
+			return false;
+		}
+		view = new_RomView(rom);
+		PutRomInfo(body, rom, view);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		return true;
+	}
+
+	entry = GetRom(pri, req, err);
+	if(NULL == entry) return false;
+
+	Read_Lock(&entry->lock);
+	Reply_Printf(body, ",\"rom\":%lu", (ulong)entry->id);
+	PutRomInfo(body, entry->rom, entry->view);
+	Reply_Printf(body, ",\"instructions\":%lu", (ulong)entry->result->count_get(entry->result));
+	RW_Unlock(&entry->lock);
+	return true;
+}
+
+static bool Op_AddEntry(Server_private* pri, JsonObject* req, Reply* body, char* err)
+{
+	RomEntry* entry;
+	ServerEntry* e;
+	Analysis* result;
+	JsonMember* m;
+	uint32 snesadr;
+
+	entry = GetRom(pri, req, err);
+	if(NULL == entry) return false;
+	if(false == Json_GetAddress(req, "snes", &snesadr))
+	{
+		SetError(err, "\"snes\" is required");
+		return false;
+	}
+	if(NULL == entry->view->GetSnesPtr(entry->view, snesadr))
+	{
+		SetError(err, "Invalid snes address : $%06lx", (ulong)snesadr);
+		return false;
+	}
+
+	e = malloc(sizeof(ServerEntry));
+	assert(e);
+	e->snesadr = snesadr;
+	e->psw = 0x30;
+	if(pri->inf.accum16bits) e->psw = (uint16)(e->psw & (0x20 ^ 0xff));
+	if(pri->inf.index16bits) e->psw = (uint16)(e->psw & (0x10 ^ 0xff));
+	m = Json_Get(req, "m");
+	if((NULL != m) && (JsonType_Number == m->type))
+	{
+		e->psw = (uint16)((16 == m->num) ? (e->psw & (0x20 ^ 0xff)) : (e->psw | 0x20));
+	}
+	m = Json_Get(req, "x");
+	if((NULL != m) && (JsonType_Number == m->type))
+	{
+		e->psw = (uint16)((16 == m->num) ? (e->psw & (0x10 ^ 0xff)) : (e->psw | 0x10));
+	}
+
+	/* re-analyze with all entries */
+	Write_Lock(&entry->lock);
+	entry->entries->push(entry->entries, e);
+	result = AnalyzeRom(pri, entry, body, err);
+	if(NULL == result)
+	{
+		free(entry->entries->pop(entry->entries));
+		RW_Unlock(&entry->lock);
+		return false;
+	}
+	delete_Analysis(&entry->result);
+	entry->result = result;
+	Reply_Printf(body, ",\"rom\":%lu,\"instructions\":%lu", (ulong)entry->id, (ulong)result->count_get(result));
+	RW_Unlock(&entry->lock);
+	return true;
+}
+
+/* range / xref visitor */
+typedef struct _InsnList {
+	Reply*		body;
+	bool		enableUpper;
+	uint32		count;
+} InsnList;
+
+static bool PutInsn(void* param, const Instruction* ins)
+{
+	InsnList* list = (InsnList*)param;
+
+	if(0 != list->count++) Reply_Put(list->body, ",", 1);
+	Reply_Insn(list->body, ins, list->enableUpper);
+	return true;
+}
+
+static bool Op_Range(Server_private* pri, JsonObject* req, Reply* body, char* err)
+{
+	RomEntry* entry;
+	InsnList list;
+	uint32 start;
+	uint32 end;
+	uint32 pcs;
+	uint32 pce;
+
+	entry = GetRom(pri, req, err);
+	if(NULL == entry) return false;
+	if((false == Json_GetAddress(req, "start", &start)) || (false == Json_GetAddress(req, "end", &end)))
+	{
+		SetError(err, "\"start\" and \"end\" are required");
+		return false;
+	}
+
+	/* snes range to pc range */
+	pcs = entry->view->Snes2PcAdr(entry->view, start);
+	pce = (start < end) ? entry->view->Snes2PcAdr(entry->view, end-1) : ROMADDRESS_NULL;
+	if((ROMADDRESS_NULL == pcs) || (ROMADDRESS_NULL == pce) || (pce < pcs))
+	{
+		SetError(err, "Invalid range : $%06lx-$%06lx", (ulong)start, (ulong)end);
+		return false;
+	}
+
+	list.body = body;
+	list.enableUpper = pri->inf.enableUpper;
+	list.count = 0;
+	Reply_Printf(body, ",\"lines\":[");
+	Read_Lock(&entry->lock);
+	entry->result->QueryRange(entry->result, pcs, pce+1, PutInsn, &list);
+	RW_Unlock(&entry->lock);
+	Reply_Put(body, "]", 1);
+	return true;
+}
+
+static bool Op_Xref(Server_private* pri, JsonObject* req, Reply* body, char* err)
+{
+	RomEntry* entry;
+	InsnList list;
+	uint32 target;
+
+	entry = GetRom(pri, req, err);
+	if(NULL == entry) return false;
+	if(false == Json_GetAddress(req, "snes", &target))
+	{
+		SetError(err, "\"snes\" is required");
+		return false;
+	}
+
+	list.body = body;
+	list.enableUpper = pri->inf.enableUpper;
+	list.count = 0;
+	Reply_Printf(body, ",\"refs\":[");
+	Read_Lock(&entry->lock);
+	entry->result->QueryXref(entry->result, target, PutInsn, &list);
+	RW_Unlock(&entry->lock);
+	Reply_Put(body, "]", 1);
+	return true;
+}
+
+static const struct {
+	const char*	name;
+	ServerOp_t	func;
+} ops[] = {
+	{ "load", Op_Load },
+	{ "identify", Op_Identify },
+	{ "add-entry", Op_AddEntry },
+	{ "disassemble-range", Op_Range },
+	{ "xref", Op_Xref },
+	/* term */
+	{ NULL, NULL },
+};
+
+
+/*--------------- internal methods ---------------*/
+
+static char* Handle(Server* self, const char* line)
+{
+	JsonObject req;
+	JsonMember* m;
+	Reply head;
+	Reply body;
+	char err[ErrorLen];
+	const char* op;
+	bool result = false;
+	int i;
+
+	assert(self);
+	assert(line);
+	Reply_Init(&head);
+	Reply_Init(&body);
+	err[0] = '\0';
+
+	Reply_Put(&head, "{", 1);
+	if(false == Json_Parse(&req, line))
+	{
+		SetError(err, "Invalid request");
+	}
+	else
+	{
+		/* copy the request id */
+		m = Json_Get(&req, "id");
+		if(NULL != m)
+		{
+			Reply_Printf(&head, "\"id\":");
+			switch(m->type)
+			{
+				case JsonType_String:
+					Reply_String(&head, m->str);
+					break;
+				case JsonType_Number:
+					Reply_Printf(&head, "%ld", m->num);
+					break;
+				case JsonType_Bool:
+					Reply_Printf(&head, "%s", m->b ? "true" : "false");
+					break;
+				default:
+					Reply_Printf(&head, "null");
+					break;
+			}
+			Reply_Put(&head, ",", 1);
+		}
+
+		op = Json_GetString(&req, "op");
+		for(i=0; NULL != ops[i].name; i++)
+		{
+			if((NULL != op) && (0 == strcmp(op, ops[i].name))) break;
+		}
+		if(NULL == ops[i].name)
+		{
+			SetError(err, "Unknown op");
+		}
+		else
+		{
+			result = ops[i].func(self->pri, &req, &body, err);
+		}
+	}
+	free(req.buf);
+
+	if(result)
+	{
+		Reply_Printf(&head, "\"ok\":true");
+		Reply_Put(&head, body.buf, body.len);
+	}
+	else
+	{
+		Reply_Printf(&head, "\"ok\":false,\"error\":");
+		Reply_String(&head, err);
+	}
+	Reply_Put(&head, "}", 1);
+
+	free(body.buf);
+	return head.buf;
+}
+
+static void Stop(Server* self)
+{
+	assert(self);
+	self->pri->stop = 1;
+}
+
+#ifdef SERVER_SOCKET
+static bool SendAll(const int fd, const char* buf, size_t len)
+{
+	ssize_t n;
+
+	while(0 != len)
+	{
+		n = send(fd, buf, len, MSG_NOSIGNAL);
+		if(0 > n)
+		{
+			if(EINTR == errno) continue;
+			return false;
+		}
+		buf += n;
+		len -= (size_t)n;
+	}
+	return true;
+}
+
+static ServerClient* OpenClient(const int fd)
+{
+	ServerClient* c;
+
+	c = malloc(sizeof(ServerClient));
+	assert(c);
+	c->fd = fd;
+	c->size = ReadChunk * 2;
+	c->len = 0;
+	c->line = malloc(c->size);
+	assert(c->line);
+	c->busy = false;
+	c->broken = false;
+	c->eof = false;
+	return c;
+}
+
+static void CloseClient(ServerClient* c)
+{
+	close(c->fd);
+	free(c->line);
+	free(c);
+}
+
+/**
+ * Receive the bytes of the requests
+ *   return:
+ *     If the client is closed, or the line is too long, return false.
+ */
+static bool Receive(ServerClient* c)
+{
+	char* tmp;
+	ssize_t n;
+
+	if(c->size - c->len < ReadChunk)
+	{
+		/* too long line */
+		if(LineMax < c->size) return false;
+		c->size *= 2;
+		tmp = realloc(c->line, c->size);
+		assert(tmp);
+		c->line = tmp;
+	}
+	n = recv(c->fd, &c->line[c->len], c->size - c->len - 1, 0);
+	if(0 > n) return (EINTR == errno);
+	if(0 == n) return false;
+	c->len += (size_t)n;
+	return true;
+}
+
+/**
+ * Take the first request line(the empty lines are skipped)
+ *   return:
+ *     the request(freed by the caller), or NULL if no line is complete
+ */
+static char* TakeLine(ServerClient* c)
+{
+	char* nl;
+	char* req;
+	size_t n;
+
+	for(;;)
+	{
+		nl = memchr(c->line, '\n', c->len);
+		if(NULL == nl) return NULL;
+		n = (size_t)(nl - c->line);
+		*nl = '\0';
+		if((0 != n) && ('\r' == nl[-1])) nl[-1] = '\0';
+		req = ('\0' != c->line[0]) ? Str_copy(c->line) : NULL;
+		memmove(c->line, &nl[1], c->len - n - 1);
+		c->len -= n + 1;
+		if(NULL != req) return req;
+	}
+}
+
+/**
+ * Pass the request of the client to the workers
+ */
+static void Dispatch(Server_private* pri, ServerClient* c, char* request)
+{
+	ServerJob* job;
+
+	Mutex_Lock(&pri->qlock);
+	c->busy = true;
+	job = &pri->queue[(pri->qhead + pri->qcount) % QueueSize];
+	job->client = c;
+	job->request = request;
+	pri->qcount++;
+	pthread_cond_signal(&pri->qcond);
+	Mutex_Unlock(&pri->qlock);
+}
+
+static void* Worker(void* param)
+{
+	Server* self = (Server*)param;
+	Server_private* pri = self->pri;
+	ServerJob job;
+	char* res;
+	bool sent;
+	ssize_t n;
+
+	for(;;)
+	{
+		Mutex_Lock(&pri->qlock);
+		while((0 == pri->qcount) && (0 == pri->stop))
+		{
+			pthread_cond_wait(&pri->qcond, &pri->qlock);
+		}
+		if(0 != pri->stop)
+		{
+			Mutex_Unlock(&pri->qlock);
+			break;
+		}
+		job = pri->queue[pri->qhead];
+		pri->qhead = (pri->qhead + 1) % QueueSize;
+		pri->qcount--;
+		Mutex_Unlock(&pri->qlock);
+
+		res = self->Handle(self, job.request);
+		sent = SendAll(job.client->fd, res, strlen(res)) && SendAll(job.client->fd, "\n", 1);
+		free(res);
+		free(job.request);
+
+		/* the client is passed back to the poll */
+		Mutex_Lock(&pri->qlock);
+		job.client->busy = false;
+		if(false == sent) job.client->broken = true;
+		Mutex_Unlock(&pri->qlock);
+		n = write(pri->wake[1], "", 1);
+		(void)n;	/* the pipe is full of the other wake-ups */
+	}
+	return NULL;
+}
+#endif
+
+static bool Serve(Server* self, const char* path)
+{
+#ifdef SERVER_SOCKET
+	Server_private* pri;
+	struct sockaddr_un addr;
+	struct pollfd pfds[QueueSize + 2];
+	ServerClient* polled[QueueSize + 2];
+	ServerClient* clients[QueueSize];
+	ServerClient* c;
+	pthread_t* workers;
+	char wake[64];
+	char* req;
+	ssize_t n;
+	bool busy;
+	bool broken;
+	int count = 0;
+	int nfds;
+	int fd;
+	int cfd;
+	int i;
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+
+	if(sizeof(addr.sun_path) <= strlen(path))
+	{
+		puterror("Too long socket path : %s", path);
+		return false;
+	}
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	if(0 > fd)
+	{
+		puterror("Can't create the socket.");
+		return false;
+	}
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, path);
+	unlink(path);
+	if((0 != bind(fd, (struct sockaddr*)&addr, sizeof(addr)))
+	|| (0 != listen(fd, QueueSize)))
+	{
+		puterror("Can't listen on \"%s\".", path);
+		close(fd);
+		return false;
+	}
+
+	/* the client may close the socket at any time */
+	signal(SIGPIPE, SIG_IGN);
+	if(0 != pipe(pri->wake))
+	{
+		puterror("Can't create the pipe.");
+		close(fd);
+		unlink(path);
+		return false;
+	}
+
+	pri->stop = 0;
+	workers = malloc(sizeof(pthread_t) * (size_t)pri->threads);
+	assert(workers);
+	for(i=0; i<pri->threads; i++)
+	{
+		if(0 != pthread_create(&workers[i], NULL, Worker, self))
+		{
+			assert(0);
+		}
+	}
+
+	/* the requests are read here, and handled on the workers */
+	while(0 == pri->stop)
+	{
+		pfds[0].fd = fd;
+		pfds[1].fd = pri->wake[0];
+		nfds = 2;
+		for(i=0; i<count; )
+		{
+			c = clients[i];
+			Mutex_Lock(&pri->qlock);
+			busy = c->busy;
+			broken = c->broken;
+			Mutex_Unlock(&pri->qlock);
+			if(busy)
+			{
+				i++;
+				continue;
+			}
+
+			req = broken ? NULL : TakeLine(c);
+			if(NULL != req)
+			{
+				Dispatch(pri, c, req);
+				i++;
+				continue;
+			}
+			if(broken || c->eof)
+			{
+				CloseClient(c);
+				clients[i] = clients[--count];
+				continue;
+			}
+			pfds[nfds].fd = c->fd;
+			polled[nfds] = c;
+			nfds++;
+			i++;
+		}
+		for(i=0; i<nfds; i++)
+		{
+			pfds[i].events = POLLIN;
+			pfds[i].revents = 0;
+		}
+		if(0 >= poll(pfds, (nfds_t)nfds, PollInterval)) continue;
+
+		if(0 != pfds[1].revents)
+		{
+			n = read(pri->wake[0], wake, sizeof(wake));
+			(void)n;
+		}
+		for(i=2; i<nfds; i++)
+		{
+			if(0 == pfds[i].revents) continue;
+			if(false == Receive(polled[i])) polled[i]->eof = true;
+		}
+
+		if(0 == pfds[0].revents) continue;
+		cfd = accept(fd, NULL, NULL);
+		if(0 > cfd) continue;
+		if(QueueSize <= count)
+		{
+			/* busy */
+			SendAll(cfd, TooMany, strlen(TooMany));
+			close(cfd);
+			continue;
+		}
+		clients[count++] = OpenClient(cfd);
+	}
+
+	/* wake up the workers */
+	Mutex_Lock(&pri->qlock);
+	pthread_cond_broadcast(&pri->qcond);
+	Mutex_Unlock(&pri->qlock);
+	for(i=0; i<pri->threads; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+
+	/* the requests that aren't handled */
+	for(; 0 != pri->qcount; pri->qcount--)
+	{
+		free(pri->queue[pri->qhead].request);
+		pri->qhead = (pri->qhead + 1) % QueueSize;
+	}
+	for(i=0; i<count; i++)
+	{
+		CloseClient(clients[i]);
+	}
+	close(pri->wake[0]);
+	close(pri->wake[1]);
+
+	close(fd);
+	unlink(path);
+	return true;
+#else
+	puterror("The server mode isn't supported on this platform.");
+	return false;
+#endif
+}
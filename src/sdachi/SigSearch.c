@@ -0,0 +1,394 @@
+/**
+ * SigSearch.c
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define SIGSEARCH_POSIX
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#ifdef SIGSEARCH_POSIX
+#  include <pthread.h>
+#  include <dirent.h>
+#  include <sys/types.h>
+#  include <sys/stat.h>
+#endif
+#include "common/Str.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Signature.h"
+#include "sdachi/SigSearch.h"
+
+#define InitialRoms	64
+
+#ifdef SIGSEARCH_POSIX
+#  define Mutex_Lock(m)		pthread_mutex_lock(m)
+#  define Mutex_Unlock(m)	pthread_mutex_unlock(m)
+#else
+#  define Mutex_Lock(m)
+#  define Mutex_Unlock(m)
+#endif
+
+/**
+ * SigSearch private members
+ */
+struct _SigSearch_private {
+	Signature*		sigs;
+	int			threads;
+	SigSearchResult*	results;
+	uint32			count;
+	uint32			size;
+	uint32			next;		/* the rom which isn't scanned */
+	ulong			msec;
+#ifdef SIGSEARCH_POSIX
+	pthread_mutex_t		lock;		/* next */
+#endif
+};
+
+/* prototypes */
+static bool AddPath(SigSearch*, const char*);
+static bool Run(SigSearch*);
+static uint32 count_get(SigSearch*);
+static const SigSearchResult* Result(SigSearch*, const uint32);
+static void PrintResults(SigSearch*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create SigSearch object
+ *
+ * @param sigs signature set
+ * @param threads worker threads
+ *
+ * @return the pointer of object
+ */
+SigSearch* new_SigSearch(Signature* sigs, const int threads)
+{
+	SigSearch* self;
+	SigSearch_private* pri;
+
+	assert(sigs);
+
+	/* make objects */
+	self = malloc(sizeof(SigSearch));
+	pri = malloc(sizeof(SigSearch_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->sigs = sigs;
+	pri->threads = (0 < threads) ? threads : 1;
+	pri->results = NULL;
+	pri->count = 0;
+	pri->size = 0;
+	pri->next = 0;
+	pri->msec = 0;
+#ifdef SIGSEARCH_POSIX
+	pthread_mutex_init(&pri->lock, NULL);
+#endif
+
+	/*--- set public member ---*/
+	self->AddPath = AddPath;
+	self->Run = Run;
+	self->count_get = count_get;
+	self->Result = Result;
+	self->PrintResults = PrintResults;
+
+	/* init SigSearch object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete SigSearch object
+ *
+ * @param the pointer of object
+ */
+void delete_SigSearch(SigSearch** self)
+{
+	SigSearch_private* pri;
+	uint32 i;
+
+	assert(self);
+	if(NULL == (*self)) return;
+
+	pri = (*self)->pri;
+	for(i=0; i<pri->count; i++)
+	{
+		free((char*)pri->results[i].rom);
+		free((SignatureMatch*)pri->results[i].matches);
+	}
+#ifdef SIGSEARCH_POSIX
+	pthread_mutex_destroy(&pri->lock);
+#endif
+	free(pri->results);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- roms ---------------*/
+
+static void AddRom(SigSearch_private* pri, char* path)
+{
+	SigSearchResult* r;
+
+	if(pri->size <= pri->count)
+	{
+		pri->size = (0 == pri->size) ? InitialRoms : pri->size * 2;
+		pri->results = realloc(pri->results, sizeof(SigSearchResult) * pri->size);
+		assert(pri->results);
+	}
+	r = &pri->results[pri->count++];
+	r->rom = path;
+	r->ok = false;
+	r->count = 0;
+	r->matches = NULL;
+}
+
+#ifdef SIGSEARCH_POSIX
+static char* JoinPath(const char* dir, const char* name)
+{
+	char* path;
+	size_t len = strlen(dir);
+
+	path = malloc(len + strlen(name) + 2);
+	assert(path);
+	memcpy(path, dir, len);
+	path[len] = '/';
+	strcpy(&path[len + 1], name);
+	return path;
+}
+
+static int NameCompare(const void* a, const void* b)
+{
+	return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+/**
+ * Add the regular files in the directory
+ */
+static bool AddDir(SigSearch_private* pri, const char* dir)
+{
+	DIR* d;
+	struct dirent* ent;
+	struct stat st;
+	char** names = NULL;
+	char* file;
+	uint32 count = 0;
+	uint32 size = 0;
+	uint32 i;
+
+	d = opendir(dir);
+	if(NULL == d) return false;
+	while(NULL != (ent = readdir(d)))
+	{
+		if('.' == ent->d_name[0]) continue;
+		file = JoinPath(dir, ent->d_name);
+		if((0 != stat(file, &st)) || !S_ISREG(st.st_mode))
+		{
+			free(file);
+			continue;
+		}
+		if(size <= count)
+		{
+			size = (0 == size) ? InitialRoms : size * 2;
+			names = realloc(names, sizeof(char*) * size);
+			assert(names);
+		}
+		names[count++] = file;
+	}
+	closedir(d);
+
+	if(1 < count) qsort(names, count, sizeof(char*), NameCompare);
+	for(i=0; i<count; i++)
+	{
+		AddRom(pri, names[i]);
+	}
+	free(names);
+	return true;
+}
+#endif
+
+
+/*--------------- run ---------------*/
+
+/* monotonic time(msec) */
+static ulong Now(void)
+{
+#ifdef SIGSEARCH_POSIX
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (ulong)ts.tv_sec * 1000 + (ulong)(ts.tv_nsec / 1000000);
+#else
+	return (ulong)((double)clock() * 1000 / CLOCKS_PER_SEC);
+#endif
+}
+
+static void ScanRom(Signature* sigs, SigSearchResult* r)
+{
+	SignatureMatch* matches = NULL;
+	RomFile* rom;
+	RomView* view;
+
+	rom = new_RomFile(r->rom);
+	if(FileOpen_NoError == rom->Open(rom))
+	{
+		view = new_RomView(rom);
+		r->count = sigs->Scan(sigs, view, &matches);
+		r->matches = matches;
+		r->ok = true;
+		delete_RomView(&view);
+	}
+	delete_RomFile(&rom);
+}
+
+static void* Worker(void* arg)
+{
+	SigSearch_private* pri = (SigSearch_private*)arg;
+	SigSearchResult* r;
+
+	for(;;)
+	{
+		Mutex_Lock(&pri->lock);
+		r = (pri->next < pri->count) ? &pri->results[pri->next++] : NULL;
+		Mutex_Unlock(&pri->lock);
+		if(NULL == r) break;
+
+		ScanRom(pri->sigs, r);
+	}
+	return NULL;
+}
+
+
+/*--------------- methods ---------------*/
+
+static bool AddPath(SigSearch* self, const char* path)
+{
+#ifdef SIGSEARCH_POSIX
+	struct stat st;
+#endif
+
+	assert(self);
+	assert(path);
+
+#ifdef SIGSEARCH_POSIX
+	if((0 == stat(path, &st)) && S_ISDIR(st.st_mode))
+	{
+		return AddDir(self->pri, path);
+	}
+#endif
+	AddRom(self->pri, Str_copy(path));
+	return true;
+}
+
+static bool Run(SigSearch* self)
+{
+	SigSearch_private* pri;
+	ulong start;
+	uint32 i;
+	bool result = true;
+#ifdef SIGSEARCH_POSIX
+	pthread_t* workers;
+	int started = 0;
+	int n;
+#endif
+
+	assert(self);
+	pri = self->pri;
+	start = Now();
+
+	/* the automaton is shared by the workers */
+	pri->sigs->Compile(pri->sigs);
+	for(i=0; i<pri->count; i++)
+	{
+		free((SignatureMatch*)pri->results[i].matches);
+		pri->results[i].matches = NULL;
+		pri->results[i].count = 0;
+		pri->results[i].ok = false;
+	}
+	pri->next = 0;
+
+#ifdef SIGSEARCH_POSIX
+	n = ((uint32)pri->threads < pri->count) ? pri->threads : (int)pri->count;
+	workers = malloc(sizeof(pthread_t) * (size_t)(n + 1));
+	assert(workers);
+	for(started=0; started<n; started++)
+	{
+		if(0 != pthread_create(&workers[started], NULL, Worker, pri)) break;
+	}
+	/* no worker thread, the roms are scanned on this thread */
+	if(0 == started) Worker(pri);
+	for(i=0; i<(uint32)started; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+	free(workers);
+#else
+	Worker(pri);
+#endif
+
+	for(i=0; i<pri->count; i++)
+	{
+		result &= pri->results[i].ok;
+	}
+	pri->msec = Now() - start;
+	return result;
+}
+
+static uint32 count_get(SigSearch* self)
+{
+	assert(self);
+	return self->pri->count;
+}
+
+static const SigSearchResult* Result(SigSearch* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return NULL;
+	return &self->pri->results[inx];
+}
+
+static void PrintResults(SigSearch* self)
+{
+	SigSearch_private* pri;
+	Signature* sigs;
+	const SigSearchResult* r;
+	const SignatureMatch* m;
+	uint32 failed = 0;
+	ulong total = 0;
+	uint32 i;
+	uint32 j;
+
+	assert(self);
+	pri = self->pri;
+	sigs = pri->sigs;
+
+	for(i=0; i<pri->count; i++)
+	{
+		r = &pri->results[i];
+		if(false == r->ok)
+		{
+			printf("%s\tNG : Can't open\n", r->rom);
+			failed++;
+			continue;
+		}
+		for(j=0; j<r->count; j++)
+		{
+			m = &r->matches[j];
+			printf("%s\t$%06lx\t%06lx\t%s\n", r->rom, (ulong)m->snesadr, (ulong)m->pcadr, sigs->Name(sigs, m->sig));
+		}
+		total += r->count;
+	}
+	printf("%lu roms(%lu failed), %lu matches of %lu signatures (%lu states, %lu ms)\n",
+			(ulong)pri->count, (ulong)failed, total,
+			(ulong)sigs->count_get(sigs), (ulong)sigs->stateCount_get(sigs), pri->msec);
+}
@@ -0,0 +1,592 @@
+/**
+ * Signature.c
+ *   multi-pattern byte signature search
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <stdarg.h>
+#include <assert.h>
+#include "common/Str.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Signature.h"
+
+#if defined(_MSC_VER)
+#  define vsnprintf _vsnprintf
+#endif
+
+#define ErrorLen	256
+#define MaxAnchor	8
+#define InitialSigs	64
+#define InitialMatches	64
+#define NoState		0xffffffff
+#define NoSig		0xffffffff
+
+/**
+ * compiled signature
+ */
+typedef struct _SigPattern {
+	char*		name;
+	uint8*		bytes;		/* masked */
+	uint8*		mask;
+	uint32		length;
+	uint32		anchor;		/* offset of the anchor */
+	uint32		anchorLen;
+	uint32		nextOut;	/* the next signature which ends at the same state */
+} SigPattern;
+
+/**
+ * Signature private members
+ */
+struct _Signature_private {
+	SigPattern*	sigs;
+	uint32		count;
+	uint32		capacity;
+	/* automaton */
+	uint32*		next;		/* [state * 256 + byte] */
+	uint32*		out;		/* the first signature of the state, or NoSig */
+	uint32*		report;		/* the state itself or its longest suffix with the signatures, or 0 */
+	uint32*		chain;		/* the longest proper suffix with the signatures, or 0 */
+	uint32		states;
+	bool		compiled;
+	char		error[ErrorLen];
+};
+
+/* prototypes */
+static bool Add(Signature*, const char*, const char*);
+static bool Load(Signature*, const char*);
+static void Compile(Signature*);
+static uint32 Scan(Signature*, const RomView*, SignatureMatch**);
+static uint32 count_get(Signature*);
+static const char* Name(Signature*, const uint32);
+static uint32 Length(Signature*, const uint32);
+static const char* error_get(Signature*);
+static uint32 stateCount_get(Signature*);
+static size_t bytes_get(Signature*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Signature object
+ *
+ * @return the pointer of object
+ */
+Signature* new_Signature(void)
+{
+	Signature* self;
+	Signature_private* pri;
+
+	/* make objects */
+	self = malloc(sizeof(Signature));
+	pri = malloc(sizeof(Signature_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->sigs = NULL;
+	pri->count = 0;
+	pri->capacity = 0;
+	pri->next = NULL;
+	pri->out = NULL;
+	pri->report = NULL;
+	pri->chain = NULL;
+	pri->states = 0;
+	pri->compiled = false;
+	pri->error[0] = '\0';
+
+	/*--- set public member ---*/
+	self->Add = Add;
+	self->Load = Load;
+	self->Compile = Compile;
+	self->Scan = Scan;
+	self->count_get = count_get;
+	self->Name = Name;
+	self->Length = Length;
+	self->error_get = error_get;
+	self->stateCount_get = stateCount_get;
+	self->bytes_get = bytes_get;
+
+	/* init Signature object */
+	self->pri = pri;
+	return self;
+}
+
+static void FreeAutomaton(Signature_private* pri)
+{
+	free(pri->next);
+	free(pri->out);
+	free(pri->report);
+	free(pri->chain);
+	pri->next = NULL;
+	pri->out = NULL;
+	pri->report = NULL;
+	pri->chain = NULL;
+	pri->states = 0;
+	pri->compiled = false;
+}
+
+/**
+ * @brief Delete Signature object
+ *
+ * @param the pointer of object
+ */
+void delete_Signature(Signature** self)
+{
+	Signature_private* pri;
+	uint32 i;
+
+	assert(self);
+	if(NULL == (*self)) return;
+
+	pri = (*self)->pri;
+	for(i=0; i<pri->count; i++)
+	{
+		free(pri->sigs[i].name);
+		free(pri->sigs[i].bytes);
+		free(pri->sigs[i].mask);
+	}
+	free(pri->sigs);
+	FreeAutomaton(pri);
+	free(pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- pattern ---------------*/
+
+static void SetError(Signature_private* pri, const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vsnprintf(pri->error, ErrorLen, fmt, args);
+	va_end(args);
+	pri->error[ErrorLen-1] = '\0';
+}
+
+/**
+ * Value of the hex digit(-1: "?", -2: not a digit)
+ */
+static int Nibble(const char c)
+{
+	if(('0' <= c) && (c <= '9')) return c - '0';
+	if(('a' <= c) && (c <= 'f')) return c - 'a' + 10;
+	if(('A' <= c) && (c <= 'F')) return c - 'A' + 10;
+	if('?' == c) return -1;
+	return -2;
+}
+
+/**
+ * Parse the pattern into the bytes and the masks
+ *   return: the length, or 0 if it's broken
+ */
+static uint32 ParsePattern(const char* pattern, uint8* bytes, uint8* mask)
+{
+	uint32 len = 0;
+	uint32 digits = 0;
+	int n;
+
+	for(; '\0' != *pattern; pattern++)
+	{
+		if(' ' == *pattern || '\t' == *pattern) continue;
+		n = Nibble(*pattern);
+		if(-2 == n) return 0;
+		if(0 == (digits & 1))
+		{
+			bytes[len] = 0;
+			mask[len] = 0;
+		}
+		bytes[len] = (uint8)((bytes[len] << 4) | ((0 <= n) ? n : 0));
+		mask[len] = (uint8)((mask[len] << 4) | ((0 <= n) ? 0xf : 0));
+		digits++;
+		if(0 == (digits & 1)) len++;
+	}
+	if(0 != (digits & 1)) return 0;
+	return len;
+}
+
+/**
+ * The longest run of the fixed bytes(the first one of the same length)
+ */
+static void FindAnchor(SigPattern* p)
+{
+	uint32 run = 0;
+	uint32 i;
+
+	p->anchor = 0;
+	p->anchorLen = 0;
+	for(i=0; i<p->length; i++)
+	{
+		run = (0xff == p->mask[i]) ? run + 1 : 0;
+		if(p->anchorLen < run)
+		{
+			p->anchorLen = run;
+			p->anchor = i + 1 - run;
+		}
+	}
+	if(MaxAnchor < p->anchorLen) p->anchorLen = MaxAnchor;
+}
+
+
+/*--------------- automaton ---------------*/
+
+/**
+ * Build the trie of the anchors, and resolve the failures into the
+ * transitions by the breadth first order
+ */
+static void Build(Signature_private* pri)
+{
+	SigPattern* p;
+	uint32* fail;
+	uint32* queue;
+	uint32 head = 0;
+	uint32 tail = 0;
+	uint32 max = 1;
+	uint32 s;
+	uint32 t;
+	uint32 i;
+	uint32 c;
+
+	FreeAutomaton(pri);
+	for(i=0; i<pri->count; i++)
+	{
+		max += pri->sigs[i].anchorLen;
+	}
+	pri->next = malloc(sizeof(uint32) * 256 * max);
+	pri->out = malloc(sizeof(uint32) * max);
+	pri->report = malloc(sizeof(uint32) * max);
+	pri->chain = malloc(sizeof(uint32) * max);
+	fail = malloc(sizeof(uint32) * max);
+	queue = malloc(sizeof(uint32) * max);
+	assert(pri->next);
+	assert(pri->out);
+	assert(pri->report);
+	assert(pri->chain);
+	assert(fail);
+	assert(queue);
+	memset(pri->next, 0xff, sizeof(uint32) * 256 * max);
+	memset(pri->out, 0xff, sizeof(uint32) * max);
+	pri->states = 1;
+
+	/* trie */
+	for(i=0; i<pri->count; i++)
+	{
+		p = &pri->sigs[i];
+		s = 0;
+		for(c=0; c<p->anchorLen; c++)
+		{
+			t = pri->next[s * 256 + p->bytes[p->anchor + c]];
+			if(NoState == t)
+			{
+				t = pri->states++;
+				pri->next[s * 256 + p->bytes[p->anchor + c]] = t;
+			}
+			s = t;
+		}
+		p->nextOut = pri->out[s];
+		pri->out[s] = i;
+	}
+
+	/* the root */
+	fail[0] = 0;
+	pri->report[0] = 0;
+	pri->chain[0] = 0;
+	for(c=0; c<256; c++)
+	{
+		t = pri->next[c];
+		if(NoState == t)
+		{
+			pri->next[c] = 0;
+			continue;
+		}
+		fail[t] = 0;
+		queue[tail++] = t;
+	}
+
+	/* the failure of the state is resolved before its children */
+	while(head < tail)
+	{
+		s = queue[head++];
+		pri->report[s] = (NoSig != pri->out[s]) ? s : pri->report[fail[s]];
+		pri->chain[s] = pri->report[fail[s]];
+		for(c=0; c<256; c++)
+		{
+			t = pri->next[s * 256 + c];
+			if(NoState == t)
+			{
+				pri->next[s * 256 + c] = pri->next[fail[s] * 256 + c];
+				continue;
+			}
+			fail[t] = pri->next[fail[s] * 256 + c];
+			queue[tail++] = t;
+		}
+	}
+
+	free(fail);
+	free(queue);
+	pri->next = realloc(pri->next, sizeof(uint32) * 256 * pri->states);
+	pri->out = realloc(pri->out, sizeof(uint32) * pri->states);
+	pri->report = realloc(pri->report, sizeof(uint32) * pri->states);
+	pri->chain = realloc(pri->chain, sizeof(uint32) * pri->states);
+	assert(pri->next);
+	assert(pri->out);
+	assert(pri->report);
+	assert(pri->chain);
+	pri->compiled = true;
+}
+
+/**
+ * Compare the whole signature at the anchor which ends at the position
+ */
+static bool Verify(const SigPattern* p, const uint8* data, const uint32 size, const uint32 end, uint32* pcadr)
+{
+	uint32 start;
+	uint32 i;
+
+	if(end + 1 < p->anchor + p->anchorLen) return false;
+	start = end + 1 - p->anchorLen - p->anchor;
+	if(size - start < p->length) return false;
+
+	for(i=0; i<p->length; i++)
+	{
+		if(p->bytes[i] != (data[start + i] & p->mask[i])) return false;
+	}
+	(*pcadr) = start;
+	return true;
+}
+
+static int MatchCompare(const void* a, const void* b)
+{
+	const SignatureMatch* x = (const SignatureMatch*)a;
+	const SignatureMatch* y = (const SignatureMatch*)b;
+
+	if(x->pcadr != y->pcadr) return (x->pcadr < y->pcadr) ? -1 : 1;
+	if(x->sig != y->sig) return (x->sig < y->sig) ? -1 : 1;
+	return 0;
+}
+
+
+/*--------------- methods ---------------*/
+
+static bool Add(Signature* self, const char* name, const char* pattern)
+{
+	Signature_private* pri;
+	SigPattern* p;
+	size_t len;
+
+	assert(self);
+	assert(name);
+	assert(pattern);
+	pri = self->pri;
+
+	if(pri->capacity <= pri->count)
+	{
+		pri->capacity = (0 == pri->capacity) ? InitialSigs : pri->capacity * 2;
+		pri->sigs = realloc(pri->sigs, sizeof(SigPattern) * pri->capacity);
+		assert(pri->sigs);
+	}
+	p = &pri->sigs[pri->count];
+
+	len = strlen(pattern) / 2 + 1;
+	p->bytes = malloc(len);
+	p->mask = malloc(len);
+	assert(p->bytes);
+	assert(p->mask);
+	p->length = ParsePattern(pattern, p->bytes, p->mask);
+	FindAnchor(p);
+	if(0 == p->anchorLen)
+	{
+		SetError(pri, "%s : %s", name, (0 == p->length) ? "broken pattern" : "no fixed byte");
+		free(p->bytes);
+		free(p->mask);
+		return false;
+	}
+	p->name = Str_copy(name);
+	pri->count++;
+	pri->compiled = false;
+	return true;
+}
+
+static bool Load(Signature* self, const char* path)
+{
+	Signature_private* pri;
+	FILE* fp;
+	char* buf;
+	char* line;
+	char* name;
+	char* q;
+	char reason[ErrorLen];
+	long len;
+	ulong lineNo = 0;
+	bool result = true;
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp)
+	{
+		SetError(pri, "Can't read \"%s\"", path);
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	buf = malloc((size_t)((0 < len) ? len : 0) + 1);
+	assert(buf);
+	len = (long)fread(buf, 1, (size_t)((0 < len) ? len : 0), fp);
+	fclose(fp);
+	buf[len] = '\0';
+
+	for(line = buf; (NULL != line) && result; line = q)
+	{
+		lineNo++;
+		q = strchr(line, '\n');
+		if(NULL != q) *(q++) = '\0';
+
+		/* comment, and the name */
+		if(NULL != strchr(line, '#')) *strchr(line, '#') = '\0';
+		while((' ' == *line) || ('\t' == *line)) line++;
+		name = line;
+		while(('\0' != *line) && (' ' != *line) && ('\t' != *line) && ('\r' != *line)) line++;
+		if(name == line) continue;
+		if('\0' != *line) *(line++) = '\0';
+		if(NULL != strchr(line, '\r')) *strchr(line, '\r') = '\0';
+
+		if(false == Add(self, name, line))
+		{
+			strcpy(reason, pri->error);
+			SetError(pri, "%s(%lu) : %s", path, lineNo, reason);
+			result = false;
+		}
+	}
+	free(buf);
+	return result;
+}
+
+static void Compile(Signature* self)
+{
+	assert(self);
+	if(self->pri->compiled) return;
+	Build(self->pri);
+}
+
+static uint32 Scan(Signature* self, const RomView* from, SignatureMatch** matches)
+{
+	Signature_private* pri;
+	const uint32* next;
+	const uint32* report;
+	const uint8* data;
+	SignatureMatch* m = NULL;
+	uint32 count = 0;
+	uint32 capacity = 0;
+	uint32 size;
+	uint32 state = 0;
+	uint32 r;
+	uint32 inx;
+	uint32 pcadr;
+	uint32 i;
+
+	assert(self);
+	assert(from);
+	assert(matches);
+	Compile(self);
+	pri = self->pri;
+	next = pri->next;
+	report = pri->report;
+
+	size = from->size_get(from);
+	data = from->GetPcPtr(from, 0);
+	if(NULL == data) size = 0;
+
+	for(i=0; i<size; i++)
+	{
+		state = next[state * 256 + data[i]];
+		if(0 == report[state]) continue;
+
+		/* the anchors which end here */
+		for(r = report[state]; 0 != r; r = pri->chain[r])
+		{
+			for(inx = pri->out[r]; NoSig != inx; inx = pri->sigs[inx].nextOut)
+			{
+				if(false == Verify(&pri->sigs[inx], data, size, i, &pcadr)) continue;
+				if(capacity <= count)
+				{
+					capacity = (0 == capacity) ? InitialMatches : capacity * 2;
+					m = realloc(m, sizeof(SignatureMatch) * capacity);
+					assert(m);
+				}
+				m[count].sig = inx;
+				m[count].pcadr = pcadr;
+				m[count].snesadr = from->Pc2SnesAdr(from, pcadr);
+				count++;
+			}
+		}
+	}
+
+	if(1 < count) qsort(m, count, sizeof(SignatureMatch), MatchCompare);
+	(*matches) = m;
+	return count;
+}
+
+static uint32 count_get(Signature* self)
+{
+	assert(self);
+	return self->pri->count;
+}
+
+static const char* Name(Signature* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return NULL;
+	return self->pri->sigs[inx].name;
+}
+
+static uint32 Length(Signature* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return 0;
+	return self->pri->sigs[inx].length;
+}
+
+static const char* error_get(Signature* self)
+{
+	assert(self);
+	return self->pri->error;
+}
+
+static uint32 stateCount_get(Signature* self)
+{
+	assert(self);
+	Compile(self);
+	return self->pri->states;
+}
+
+static size_t bytes_get(Signature* self)
+{
+	Signature_private* pri;
+	size_t bytes;
+	uint32 i;
+
+	assert(self);
+	pri = self->pri;
+	bytes = sizeof(Signature) + sizeof(Signature_private) + sizeof(SigPattern) * pri->capacity;
+	for(i=0; i<pri->count; i++)
+	{
+		bytes += pri->sigs[i].length * 2 + strlen(pri->sigs[i].name) + 1;
+	}
+	if(pri->compiled)
+	{
+		bytes += sizeof(uint32) * (256 + 3) * pri->states;
+	}
+	return bytes;
+}
@@ -0,0 +1,120 @@
+/**
+ * Sink.c
+ */
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+
+/* this header isn't read from anything other */
+/* than inherited object.                     */
+#include "Sink.protected.h"
+
+/* prototypes */
+static void Begin(Sink*, const RomView*, const char*);
+static void Label(Sink*, const uint32, const char*);
+static void Org(Sink*, const uint32);
+static void Group(Sink*, const GroupInfo*);
+static void Insn(Sink*, const Instruction*);
+static void Data(Sink*, const uint32, const uint32, const uint8*, const size_t);
+static bool End(Sink*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create Sink object
+ *
+ * @return the pointer of object
+ */
+Sink* new_Sink(TextFile* out)
+{
+	Sink* self;
+	Sink_protected* pro;
+
+	/* make objects */
+	self = malloc(sizeof(Sink));
+	pro = malloc(sizeof(Sink_protected));
+
+	/* check whether object creatin succeeded */
+	assert(pro);
+	assert(self);
+
+	/*--- set protected member ---*/
+	pro->out = out;
+	pro->enableUpper = false;
+	pro->headed = false;
+	pro->failed = false;
+
+	/*--- set public member ---*/
+	self->Begin = Begin;
+	self->Label = Label;
+	self->Org = Org;
+	self->Group = Group;
+	self->Insn = Insn;
+	self->Data = Data;
+	self->End = End;
+
+	/* init Sink object */
+	self->pro = pro;
+	return self;
+}
+
+/**
+ * @brief Delete Sink object
+ *
+ * @param the pointer of object
+ */
+void delete_Sink(Sink** self)
+{
+	/* This is the template that default destractor. */
+	assert(self);
+	if(NULL == (*self)) return;
+	free((*self)->pro);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- internal methods ---------------*/
+
+static void Begin(Sink* self, const RomView* from, const char* map)
+{
+	return;
+}
+
+static void Label(Sink* self, const uint32 snesadr, const char* name)
+{
+	return;
+}
+
+static void Org(Sink* self, const uint32 snesadr)
+{
+	return;
+}
+
+static void Group(Sink* self, const GroupInfo* grp)
+{
+	return;
+}
+
+static void Insn(Sink* self, const Instruction* ins)
+{
+	return;
+}
+
+static void Data(Sink* self, const uint32 snesadr, const uint32 pcadr, const uint8* data, const size_t len)
+{
+	return;
+}
+
+static bool End(Sink* self)
+{
+	assert(self);
+	return !self->pro->failed;
+}
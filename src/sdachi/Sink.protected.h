@@ -0,0 +1,24 @@
+#pragma once
+/**
+ * Sink.protected.h
+ */
+
+/**
+ * Sink main instance
+ */
+struct _Sink_protected {
+	/* output file */
+	TextFile* out;
+	/* upper case output */
+	bool enableUpper;
+	/* header row / record has been written */
+	bool headed;
+	/* write error */
+	bool failed;
+};
+
+/**
+ * Base constructor for inherited sinks
+ *   All methods are set to do nothing.
+ */
+Sink* new_Sink(TextFile*);
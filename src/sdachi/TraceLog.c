@@ -0,0 +1,708 @@
+/**
+ * TraceLog.c
+ *   execution trace log import
+ */
+#if !defined(WIN32) && !defined(_WIN32)
+#  define _POSIX_C_SOURCE 200112L
+#  define TRACELOG_POSIX
+#endif
+#include "common/types.h"
+#include <stdlib.h>
+#include <assert.h>
+#ifdef TRACELOG_POSIX
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <pthread.h>
+#  include <sys/stat.h>
+#  include <sys/mman.h>
+#endif
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/TraceLog.h"
+
+#define MaxThreads	16
+#define MinChunk	0x100000	/* smaller chunk isn't split */
+#define StreamBlock	0x400000	/* read block without the mapping */
+#define InitialTable	4096
+#define InitialHits	1024
+#define EmptyKey	0xffffffff
+
+/* the key of the table : snes address(24) and M / X(bit 24-25) */
+#define Key_Make(adr, psw)	(((adr) & 0xffffff) | ((uint32)((psw) & 0x30) << 20))
+#define Key_Adr(key)		((key) & 0xffffff)
+#define Key_Psw(key)		((uint8)(((key) >> 20) & 0x30))
+
+/**
+ * the counts of the (address, flags) pairs(open addressing)
+ */
+typedef struct _TraceTable {
+	uint32*		keys;
+	uint32*		counts;
+	uint32		size;		/* power of 2 */
+	uint32		used;
+} TraceTable;
+
+/**
+ * the part of the log parsed on a thread
+ */
+typedef struct _TraceChunk {
+	const char*	begin;
+	const char*	end;
+	TraceTable	table;
+	ulong		lines;
+	ulong		skipped;
+} TraceChunk;
+
+/**
+ * TraceLog private members
+ */
+struct _TraceLog_private {
+	const RomView*	from;
+	TraceHit*	hits;
+	uint32		count;
+	uint32		size;
+	uint32		hash;
+	ulong		lines;
+	ulong		skipped;
+};
+
+/* prototypes */
+static bool Load(TraceLog*, const char*, const int);
+static uint32 count_get(TraceLog*);
+static const TraceHit* Hit(TraceLog*, const uint32);
+static uint32 Hits(TraceLog*, const uint32);
+static uint32 Hash(TraceLog*);
+static ulong lines_get(TraceLog*);
+static ulong skipped_get(TraceLog*);
+static size_t bytes_get(TraceLog*);
+
+
+/*--------------- Constructor / Destructor ---------------*/
+
+/**
+ * @brief Create TraceLog object
+ *
+ * @param from rom
+ *
+ * @return the pointer of object
+ */
+TraceLog* new_TraceLog(const RomView* from)
+{
+	TraceLog* self;
+	TraceLog_private* pri;
+
+	assert(from);
+
+	/* make objects */
+	self = malloc(sizeof(TraceLog));
+	pri = malloc(sizeof(TraceLog_private));
+
+	/* check whether object creatin succeeded */
+	assert(pri);
+	assert(self);
+
+	/*--- set private member ---*/
+	pri->from = from;
+	pri->hits = NULL;
+	pri->count = 0;
+	pri->size = 0;
+	pri->hash = 0x811c9dc5;
+	pri->lines = 0;
+	pri->skipped = 0;
+
+	/*--- set public member ---*/
+	self->Load = Load;
+	self->count_get = count_get;
+	self->Hit = Hit;
+	self->Hits = Hits;
+	self->Hash = Hash;
+	self->lines_get = lines_get;
+	self->skipped_get = skipped_get;
+	self->bytes_get = bytes_get;
+
+	/* init TraceLog object */
+	self->pri = pri;
+	return self;
+}
+
+/**
+ * @brief Delete TraceLog object
+ *
+ * @param the pointer of object
+ */
+void delete_TraceLog(TraceLog** self)
+{
+	assert(self);
+	if(NULL == (*self)) return;
+
+	free((*self)->pri->hits);
+	free((*self)->pri);
+	free(*self);
+	(*self) = NULL;
+}
+
+
+/*--------------- table ---------------*/
+
+static void Table_Init(TraceTable* t, const uint32 size)
+{
+	t->keys = malloc(sizeof(uint32) * size);
+	t->counts = malloc(sizeof(uint32) * size);
+	assert(t->keys);
+	assert(t->counts);
+	memset(t->keys, 0xff, sizeof(uint32) * size);
+	t->size = size;
+	t->used = 0;
+}
+
+static void Table_Free(TraceTable* t)
+{
+	free(t->keys);
+	free(t->counts);
+	t->keys = NULL;
+	t->counts = NULL;
+}
+
+static uint32 Table_Slot(const TraceTable* t, const uint32 key)
+{
+	uint32 i = (key * 0x9e3779b1u) & (t->size - 1);
+
+	while((EmptyKey != t->keys[i]) && (key != t->keys[i]))
+	{
+		i = (i + 1) & (t->size - 1);
+	}
+	return i;
+}
+
+static void Table_Add(TraceTable* t, const uint32 key, const uint32 count)
+{
+	TraceTable old;
+	uint32 i;
+
+	/* grow at the half */
+	if(t->size <= t->used * 2)
+	{
+		old = *t;
+		Table_Init(t, old.size * 2);
+		for(i=0; i<old.size; i++)
+		{
+			if(EmptyKey == old.keys[i]) continue;
+			Table_Add(t, old.keys[i], old.counts[i]);
+		}
+		Table_Free(&old);
+	}
+
+	i = Table_Slot(t, key);
+	if(EmptyKey == t->keys[i])
+	{
+		t->keys[i] = key;
+		t->counts[i] = count;
+		t->used++;
+		return;
+	}
+	t->counts[i] = (0xffffffff - t->counts[i] < count) ? 0xffffffff : t->counts[i] + count;
+}
+
+
+/*--------------- parser ---------------*/
+
+static bool IsSpace(const char c)
+{
+	return (' ' == c) || ('\t' == c) || ('\r' == c);
+}
+
+static int HexDigit(const char c)
+{
+	if(('0' <= c) && ('9' >= c)) return c - '0';
+	if(('a' <= c) && ('f' >= c)) return c - 'a' + 10;
+	if(('A' <= c) && ('F' >= c)) return c - 'A' + 10;
+	return -1;
+}
+
+static bool IsWord(const char c)
+{
+	return (0 <= HexDigit(c)) || (('g' <= c) && ('z' >= c)) || (('G' <= c) && ('Z' >= c)) || ('_' == c);
+}
+
+/**
+ * Read the hex digits
+ *   return:
+ *     the number of the digits
+ */
+static int ReadHex(const char** p, const char* end, uint32* v)
+{
+	const char* q = *p;
+	int n = 0;
+	int d;
+
+	(*v) = 0;
+	while((q < end) && (8 > n) && (0 <= (d = HexDigit(*q))))
+	{
+		(*v) = ((*v) << 4) | (uint32)d;
+		q++;
+		n++;
+	}
+	(*p) = q;
+	return n;
+}
+
+/**
+ * "008000" / "00:8000" / "00/8000" at the head of the line
+ */
+static bool ParseAddress(const char** p, const char* end, uint32* snesadr)
+{
+	const char* q = *p;
+	uint32 hi;
+	uint32 lo;
+	int n;
+
+	while((q < end) && IsSpace(*q)) q++;
+	if((q < end) && ('$' == *q)) q++;
+
+	n = ReadHex(&q, end, &hi);
+	if(6 == n)
+	{
+		(*snesadr) = hi;
+	}
+	else if((2 == n) && (q < end) && (('/' == *q) || (':' == *q)))
+	{
+		q++;
+		if(4 != ReadHex(&q, end, &lo)) return false;
+		(*snesadr) = (hi << 16) | lo;
+	}
+	else
+	{
+		return false;
+	}
+	if((q < end) && IsWord(*q)) return false;
+
+	(*p) = q;
+	return true;
+}
+
+/**
+ * "nvMXdIzc" / "envMXdIzc"(the upper case is set)
+ */
+static bool ParseLetters(const char* q, const char* end, uint8* psw)
+{
+	static const char letters[] = "nvmxdizc";
+	uint8 v = 0;
+	int len = 0;
+	int i;
+
+	while((q + len < end) && !IsSpace(q[len])) len++;
+	if((9 == len) && (('e' == q[0]) || ('E' == q[0])))
+	{
+		q++;
+		len--;
+	}
+	if(8 != len) return false;
+
+	for(i=0; i<8; i++)
+	{
+		if(('.' == q[i]) || ('-' == q[i]) || (letters[i] == q[i])) continue;
+		if((letters[i] - 'a' + 'A') == q[i])
+		{
+			v = (uint8)(v | (0x80 >> i));
+			continue;
+		}
+		/* the break flag of the emulation mode */
+		if(3 == i && ('b' == q[i])) continue;
+		if(3 == i && ('B' == q[i]))
+		{
+			v |= 0x10;
+			continue;
+		}
+		return false;
+	}
+	(*psw) = (uint8)(v & 0x30);
+	return true;
+}
+
+/**
+ * "P:34" / "P:nvMXdIzc" / "nvMXdIzc" in the columns
+ */
+static bool ParseFlags(const char* q, const char* end, uint8* psw)
+{
+	const char* s;
+	uint32 v;
+
+	while(q < end)
+	{
+		while((q < end) && IsSpace(*q)) q++;
+		if(q >= end) break;
+
+		if((q + 2 < end) && (('P' == q[0]) || ('p' == q[0])) && (':' == q[1]))
+		{
+			s = q + 2;
+			if((2 == ReadHex(&s, end, &v)) && ((s == end) || IsSpace(*s)))
+			{
+				(*psw) = (uint8)(v & 0x30);
+				return true;
+			}
+			if(ParseLetters(q + 2, end, psw)) return true;
+		}
+		else if(ParseLetters(q, end, psw))
+		{
+			return true;
+		}
+		while((q < end) && !IsSpace(*q)) q++;
+	}
+	return false;
+}
+
+/**
+ * Count the lines in the chunk
+ */
+static void ParseChunk(TraceChunk* c)
+{
+	const char* p = c->begin;
+	const char* line;
+	const char* eol;
+	uint32 snesadr;
+	uint8 psw;
+
+	while(p < c->end)
+	{
+		eol = memchr(p, '\n', (size_t)(c->end - p));
+		if(NULL == eol) eol = c->end;
+		line = p;
+		p = eol + 1;
+
+		/* the blank line isn't counted */
+		while((line < eol) && IsSpace(*line)) line++;
+		if(line == eol) continue;
+
+		c->lines++;
+		if(ParseAddress(&line, eol, &snesadr) && ParseFlags(line, eol, &psw))
+		{
+			Table_Add(&c->table, Key_Make(snesadr, psw), 1);
+		}
+		else
+		{
+			c->skipped++;
+		}
+	}
+}
+
+#ifdef TRACELOG_POSIX
+static void* ChunkWorker(void* arg)
+{
+	ParseChunk((TraceChunk*)arg);
+	return NULL;
+}
+#endif
+
+
+/*--------------- load ---------------*/
+
+static int HitCompare(const void* a, const void* b)
+{
+	const TraceHit* x = (const TraceHit*)a;
+	const TraceHit* y = (const TraceHit*)b;
+
+	if(x->pcadr != y->pcadr) return (x->pcadr < y->pcadr) ? -1 : 1;
+	if(x->psw != y->psw) return (x->psw < y->psw) ? -1 : 1;
+	if(x->snesadr != y->snesadr) return (x->snesadr < y->snesadr) ? -1 : 1;
+	return 0;
+}
+
+/**
+ * Add the counts of the chunk to the hits
+ */
+static void MergeChunk(TraceLog_private* pri, TraceChunk* c)
+{
+	const RomView* from = pri->from;
+	TraceHit* h;
+	uint32 pcadr;
+	uint32 i;
+
+	pri->lines += c->lines;
+	pri->skipped += c->skipped;
+	for(i=0; i<c->table.size; i++)
+	{
+		if(EmptyKey == c->table.keys[i]) continue;
+
+		/* the code in RAM */
+		pcadr = from->Snes2PcAdr(from, Key_Adr(c->table.keys[i]));
+		if((ROMADDRESS_NULL == pcadr) || (NULL == from->GetSnesPtr(from, Key_Adr(c->table.keys[i]))))
+		{
+			pri->skipped += c->table.counts[i];
+			continue;
+		}
+
+		if(pri->count == pri->size)
+		{
+			pri->size = (0 == pri->size) ? InitialHits : pri->size * 2;
+			pri->hits = realloc(pri->hits, sizeof(TraceHit) * pri->size);
+			assert(pri->hits);
+		}
+		h = &pri->hits[pri->count++];
+		h->pcadr = pcadr;
+		h->snesadr = Key_Adr(c->table.keys[i]);
+		h->count = c->table.counts[i];
+		h->psw = Key_Psw(c->table.keys[i]);
+	}
+}
+
+/**
+ * Sort the hits, and merge the same (address, flags)
+ */
+static void SortHits(TraceLog_private* pri)
+{
+	TraceHit* h = pri->hits;
+	uint32 n = 0;
+	uint32 i;
+
+	if(0 == pri->count) return;
+	qsort(h, pri->count, sizeof(TraceHit), HitCompare);
+	for(i=1; i<pri->count; i++)
+	{
+		if((h[n].pcadr == h[i].pcadr) && (h[n].psw == h[i].psw))
+		{
+			h[n].count = (0xffffffff - h[n].count < h[i].count) ? 0xffffffff : h[n].count + h[i].count;
+			continue;
+		}
+		h[++n] = h[i];
+	}
+	pri->count = n + 1;
+
+	/* FNV-1a */
+	pri->hash = 0x811c9dc5;
+	for(i=0; i<pri->count; i++)
+	{
+		pri->hash = (pri->hash ^ h[i].pcadr) * 0x01000193;
+		pri->hash = (pri->hash ^ h[i].psw) * 0x01000193;
+	}
+}
+
+/**
+ * Read the log by the blocks(without the mapping)
+ */
+static bool ReadStream(TraceLog_private* pri, const char* path)
+{
+	TraceChunk c;
+	FILE* fp;
+	char* buf;
+	size_t keep = 0;
+	size_t len;
+	size_t total;
+	size_t last;
+
+	fp = fopen(path, "rb");
+	if(NULL == fp) return false;
+	buf = malloc(StreamBlock);
+	assert(buf);
+	memset(&c, 0, sizeof(c));
+	Table_Init(&c.table, InitialTable);
+
+	for(;;)
+	{
+		len = fread(&buf[keep], 1, StreamBlock - keep, fp);
+		total = keep + len;
+		if(0 == len)
+		{
+			/* the last line */
+			c.begin = buf;
+			c.end = &buf[total];
+			ParseChunk(&c);
+			break;
+		}
+
+		for(last=total; 0 < last; last--)
+		{
+			if('\n' == buf[last-1]) break;
+		}
+		if(0 == last)
+		{
+			/* too long line */
+			if(StreamBlock == total) last = total;
+			keep = total - last;
+			if(0 != keep) continue;
+		}
+
+		c.begin = buf;
+		c.end = &buf[last];
+		ParseChunk(&c);
+		keep = total - last;
+		memmove(buf, &buf[last], keep);
+	}
+
+	fclose(fp);
+	free(buf);
+	MergeChunk(pri, &c);
+	Table_Free(&c.table);
+	return true;
+}
+
+#ifdef TRACELOG_POSIX
+/**
+ * Parse the mapped log on the threads
+ */
+static void ParseMapped(TraceLog_private* pri, const char* base, const size_t size, int threads)
+{
+	TraceChunk* chunks;
+	pthread_t* workers;
+	const char* p;
+	int started = 0;
+	int i;
+
+	if(0 >= threads)
+	{
+#ifdef _SC_NPROCESSORS_ONLN
+		threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		if(0 >= threads) threads = 1;
+	}
+	if(MaxThreads < threads) threads = MaxThreads;
+	if((size_t)threads > size / MinChunk) threads = (int)(size / MinChunk);
+	if(0 >= threads) threads = 1;
+
+	chunks = calloc((size_t)threads, sizeof(TraceChunk));
+	workers = malloc(sizeof(pthread_t) * (size_t)threads);
+	assert(chunks);
+	assert(workers);
+
+	/* split at the line breaks */
+	p = base;
+	for(i=0; i<threads; i++)
+	{
+		chunks[i].begin = p;
+		p = base + size / (size_t)threads * (size_t)(i + 1);
+		if(threads - 1 == i) p = base + size;
+		if(p < chunks[i].begin) p = chunks[i].begin;
+		while((p < base + size) && ('\n' != p[-1])) p++;
+		chunks[i].end = p;
+		Table_Init(&chunks[i].table, InitialTable);
+	}
+
+	for(started=1; started<threads; started++)
+	{
+		if(0 != pthread_create(&workers[started], NULL, ChunkWorker, &chunks[started])) break;
+	}
+	/* the first chunk on this thread, and the ones which aren't started */
+	ParseChunk(&chunks[0]);
+	for(i=started; i<threads; i++)
+	{
+		ParseChunk(&chunks[i]);
+	}
+	for(i=1; i<started; i++)
+	{
+		pthread_join(workers[i], NULL);
+	}
+
+	for(i=0; i<threads; i++)
+	{
+		MergeChunk(pri, &chunks[i]);
+		Table_Free(&chunks[i].table);
+	}
+	free(workers);
+	free(chunks);
+}
+#endif
+
+
+/*--------------- methods ---------------*/
+
+static bool Load(TraceLog* self, const char* path, const int threads)
+{
+	TraceLog_private* pri;
+#ifdef TRACELOG_POSIX
+	struct stat st;
+	void* map;
+	int fd;
+#endif
+
+	assert(self);
+	assert(path);
+	pri = self->pri;
+
+#ifdef TRACELOG_POSIX
+	fd = open(path, O_RDONLY);
+	if(0 > fd) return false;
+	if((0 == fstat(fd, &st)) && (0 < st.st_size) && S_ISREG(st.st_mode))
+	{
+		map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if(MAP_FAILED != map)
+		{
+			close(fd);
+			posix_madvise(map, (size_t)st.st_size, POSIX_MADV_SEQUENTIAL);
+			ParseMapped(pri, (const char*)map, (size_t)st.st_size, threads);
+			munmap(map, (size_t)st.st_size);
+			SortHits(pri);
+			return true;
+		}
+	}
+	close(fd);
+#else
+	(void)threads;
+#endif
+
+	if(false == ReadStream(pri, path)) return false;
+	SortHits(pri);
+	return true;
+}
+
+static uint32 count_get(TraceLog* self)
+{
+	assert(self);
+	return self->pri->count;
+}
+
+static const TraceHit* Hit(TraceLog* self, const uint32 inx)
+{
+	assert(self);
+	if(self->pri->count <= inx) return NULL;
+	return &self->pri->hits[inx];
+}
+
+static uint32 Hits(TraceLog* self, const uint32 pcadr)
+{
+	const TraceHit* h;
+	uint32 lo = 0;
+	uint32 hi;
+	uint32 mid;
+	uint32 sum = 0;
+
+	assert(self);
+	h = self->pri->hits;
+	hi = self->pri->count;
+
+	/* the first one of the address */
+	while(lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		if(h[mid].pcadr < pcadr) lo = mid + 1;
+		else hi = mid;
+	}
+	for(; (lo < self->pri->count) && (h[lo].pcadr == pcadr); lo++)
+	{
+		sum = (0xffffffff - sum < h[lo].count) ? 0xffffffff : sum + h[lo].count;
+	}
+	return sum;
+}
+
+static uint32 Hash(TraceLog* self)
+{
+	assert(self);
+	return self->pri->hash;
+}
+
+static ulong lines_get(TraceLog* self)
+{
+	assert(self);
+	return self->pri->lines;
+}
+
+static ulong skipped_get(TraceLog* self)
+{
+	assert(self);
+	return self->pri->skipped;
+}
+
+static size_t bytes_get(TraceLog* self)
+{
+	assert(self);
+	return sizeof(TraceLog) + sizeof(TraceLog_private) + sizeof(TraceHit) * self->pri->size;
+}
@@ -0,0 +1,75 @@
+/**
+ * TestFixture.cpp
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+}
+
+#include "tests/TestFixture.h"
+
+#define MinRomSize 0x8000
+
+const uint8 Fixture_Code[] = {
+	0x20, 0x10, 0x80,	/* jsr $8010 */
+	0xc2, 0x20,		/* rep #$20 */
+	0xa9, 0x34, 0x12,	/* lda #$1234 */
+	0xd0, 0x02,		/* bne $800c */
+	0xea,			/* nop */
+	0xea,			/* nop */
+	0x60,			/* rts */
+	0x00, 0x00, 0x00,
+	0xa9, 0x01,		/* lda #$01 */
+	0x60,			/* rts */
+};
+const uint32 Fixture_CodeSize = sizeof(Fixture_Code);
+
+uint8* Fixture_NewRom(const uint32 size, const bool header)
+{
+	uint8* rom;
+	uint8 sizeBits;
+
+	rom = (uint8*)calloc(size, 1);
+	if(!header) return rom;
+
+	rom[0x7fd5] = 0x20;	/* mapmode */
+	if(MinRomSize < size)
+	{
+		/* rom size(1KB << n), left 0 in the minimal image */
+		for(sizeBits = 0; (0x400u << sizeBits) < size; sizeBits++);
+		rom[0x7fd7] = sizeBits;
+	}
+	rom[0x7fdc] = 0xff;	/* sum complement */
+	rom[0x7fdd] = 0xff;
+	rom[0x7ffc] = 0x00;	/* reset vector */
+	rom[0x7ffd] = 0x80;
+
+	return rom;
+}
+
+void Fixture_SaveRom(const char* path, uint8* rom, const uint32 size)
+{
+	FILE* f;
+
+	f = fopen(path, "wb");
+	fwrite(rom, 1, size, f);
+	fclose(f);
+	free(rom);
+}
+
+void Fixture_InitInf(DisAsmInf* inf)
+{
+	DisAsm_InitInf(inf);
+	inf->depthMax = 0;
+}
@@ -0,0 +1,37 @@
+#pragma once
+/**
+ * TestFixture.h
+ *   the rom images and the options shared by the tests
+ *
+ *   include "common/types.h" before this file
+ */
+
+struct _DisAsmInf;
+
+/**
+ * the routine at $8000 of the test roms :
+ *   $8000 jsr $8010 / rep #$20 / lda #$1234 / bne $800c / nop / nop / rts
+ *   $8010 lda #$01 / rts
+ */
+extern const uint8 Fixture_Code[];
+extern const uint32 Fixture_CodeSize;
+
+/**
+ * Create the zero filled LoROM image
+ *   args: Fixture_NewRom(const uint32 size, const bool header)
+ *     header : write the mapmode, the checksum and the reset vector($8000)
+ *   return: the image(release it by Fixture_SaveRom or free)
+ */
+uint8* Fixture_NewRom(const uint32, const bool);
+
+/**
+ * Write the image to the file and release it
+ *   args: Fixture_SaveRom(const char* path, uint8* rom, const uint32 size)
+ */
+void Fixture_SaveRom(const char*, uint8*, const uint32);
+
+/**
+ * Set the default options(no recursion)
+ *   args: Fixture_InitInf(DisAsmInf* inf)
+ */
+void Fixture_InitInf(struct _DisAsmInf*);
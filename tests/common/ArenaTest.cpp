@@ -0,0 +1,135 @@
+/**
+ * ArenaTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "common/Arena.h"
+#include "common/List.h"
+}
+
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Arena)
+{
+	/* test target */
+	Arena* target;
+
+	void setup()
+	{
+		target = new_Arena(256);
+	}
+
+	void teardown()
+	{
+		delete_Arena(&target);
+	}
+};
+
+/**
+ * Check object create
+ */
+TEST(Arena, new)
+{
+	CHECK(NULL != target);
+	LONGS_EQUAL(0, target->allocs_get(target));
+	LONGS_EQUAL(0, target->blocks_get(target));
+	LONGS_EQUAL(0, target->bytes_get(target));
+}
+
+/**
+ * Check object delete
+ */
+TEST(Arena, delete)
+{
+	delete_Arena(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check Alloc method
+ */
+TEST(Arena, Alloc)
+{
+	uint8* p1;
+	uint8* p2;
+	double* d;
+	int i;
+
+	p1 = (uint8*)target->Alloc(target, 3);
+	p2 = (uint8*)target->Alloc(target, 3);
+	CHECK(NULL != p1);
+	CHECK(NULL != p2);
+	CHECK(p1 != p2);
+	LONGS_EQUAL(1, target->blocks_get(target));
+
+	/* aligned */
+	d = (double*)target->Alloc(target, sizeof(double));
+	LONGS_EQUAL(0, ((size_t)d) % sizeof(double));
+	*d = 1.5;
+
+	/* next block */
+	for(i=0; i<64; i++)
+	{
+		memset(target->Alloc(target, 16), 0xff, 16);
+	}
+	LONGS_EQUAL(67, target->allocs_get(target));
+	CHECK(1 < target->blocks_get(target));
+
+	/* larger than a block */
+	p1 = (uint8*)target->Alloc(target, 1000);
+	memset(p1, 0, 1000);
+	CHECK(1000 <= target->bytes_get(target));
+}
+
+/**
+ * Check Calloc method
+ */
+TEST(Arena, Calloc)
+{
+	uint8* p;
+	int i;
+
+	memset(target->Alloc(target, 64), 0xff, 64);
+	p = (uint8*)target->Calloc(target, 64);
+	for(i=0; i<64; i++)
+	{
+		LONGS_EQUAL(0, p[i]);
+	}
+}
+
+/**
+ * Check list nodes from the arena
+ */
+TEST(Arena, List)
+{
+	List* list;
+	Iterator* it;
+	int data[100];
+	int i;
+
+	delete_Arena(&target);
+	target = new_Arena(0);
+	list = new_ListEx(NULL, NULL, target);
+
+	for(i=0; i<100; i++)
+	{
+		data[i] = i;
+		list->push(list, &data[i]);
+	}
+	/* insert */
+	it = list->begin(list);
+	it = it->next(it);
+	it->insert(it, &data[50]);
+
+	/* nodes are allocated by the chunk, in one heap block */
+	LONGS_EQUAL(5, target->allocs_get(target));
+	LONGS_EQUAL(1, target->blocks_get(target));
+
+	POINTERS_EQUAL(&data[0], list->dequeue(list));
+	POINTERS_EQUAL(&data[50], list->dequeue(list));
+	POINTERS_EQUAL(&data[1], list->dequeue(list));
+
+	delete_List(&list);
+}
@@ -0,0 +1,102 @@
+/**
+ * DeflateTest.cpp
+ */
+extern "C"
+{
+#include "common/types.h"
+#include "common/Deflate.h"
+}
+
+#include "CppUTest/TestHarness.h"
+
+static bool CountOutput(void* param, const uint8* data, const size_t len)
+{
+	(*(size_t*)param) += len;
+	return true;
+}
+
+static bool FailOutput(void* param, const uint8* data, const size_t len)
+{
+	return false;
+}
+
+TEST_GROUP(Deflate)
+{
+	Deflate* target;
+	size_t outlen;
+
+	void setup()
+	{
+		outlen = 0;
+		target = new_Deflate(CountOutput, &outlen);
+	}
+
+	void teardown()
+	{
+		delete_Deflate(&target);
+	}
+};
+
+/**
+ * Check object create
+ */
+TEST(Deflate, new)
+{
+	CHECK(NULL != target);
+	CHECK(NULL != target->Put);
+	CHECK(NULL != target->Finish);
+}
+
+/**
+ * Check CRC-32
+ */
+TEST(Deflate, Crc32)
+{
+	LONGS_EQUAL(0, Deflate_Crc32(0, (const uint8*)"", 0));
+	LONGS_EQUAL(0xcbf43926, Deflate_Crc32(0, (const uint8*)"123456789", 9));
+
+	/* continuous */
+	LONGS_EQUAL(0xcbf43926, Deflate_Crc32(Deflate_Crc32(0, (const uint8*)"1234", 4), (const uint8*)"56789", 5));
+}
+
+/**
+ * Check compression
+ */
+TEST(Deflate, Compress)
+{
+	static uint8 data[200000];
+	size_t i;
+
+	for(i=0; i<sizeof(data); i++)
+	{
+		data[i] = (uint8)"L008000:\tnop\n"[i % 13];
+	}
+
+	CHECK(target->Put(target, data, sizeof(data)));
+	CHECK(target->Finish(target));
+	CHECK(0 < outlen);
+	CHECK(sizeof(data)/10 > outlen);
+}
+
+/**
+ * Check empty stream
+ */
+TEST(Deflate, Empty)
+{
+	CHECK(target->Finish(target));
+	CHECK(0 < outlen);
+}
+
+/**
+ * Check output error
+ */
+TEST(Deflate, Fail)
+{
+	static uint8 data[200000];
+
+	delete_Deflate(&target);
+	target = new_Deflate(FailOutput, NULL);
+	memset(data, 0x55, sizeof(data));
+	target->Put(target, data, sizeof(data));
+	CHECK_FALSE(target->Finish(target));
+}
@@ -342,3 +342,100 @@ TEST(List, searchex)
 	CHECK(NULL != it);
 	CHECK(NULL == target->searchex(target, &vvv, MatchInt, it->next(it), false));
 }
+
+/**
+ * insert / remove by iterator and the index table check
+ */
+TEST(List, insert_remove)
+{
+	int vvv;
+	int i;
+	Iterator* it;
+
+	for(i=0; i<200; i++)
+	{
+		CHECK(target->push(target, iClone(&i)));
+	}
+	LONGS_EQUAL(100, *((int*)target->index(target, 100)));
+
+	/* insert before 100 */
+	vvv = -1;
+	it = target->begin(target);
+	for(i=0; i<100; i++) it = Iterator_Next(it);
+	CHECK(it->insert(it, iClone(&vvv)));
+	LONGS_EQUAL(201, target->length(target));
+	LONGS_EQUAL(-1, *((int*)target->index(target, 100)));
+	LONGS_EQUAL(100, *((int*)target->index(target, 101)));
+
+	/* insert before top */
+	vvv = -2;
+	it = target->begin(target);
+	CHECK(it->insert(it, iClone(&vvv)));
+	LONGS_EQUAL(202, target->length(target));
+	POINTERS_EQUAL(Iterator_Prev(it), target->begin(target));
+	LONGS_EQUAL(-2, *((int*)target->index(target, 0)));
+
+	/* remove */
+	it = target->begin(target);
+	it->remove(it, false);
+	LONGS_EQUAL(201, target->length(target));
+	LONGS_EQUAL(0, *((int*)target->index(target, 0)));
+	it = target->end(target);
+	it->remove(it, false);
+	LONGS_EQUAL(200, target->length(target));
+	LONGS_EQUAL(198, *((int*)Iterator_Data(target->end(target))));
+	POINTERS_EQUAL(NULL, Iterator_Next(target->end(target)));
+}
+
+/**
+ * links after pop check
+ */
+TEST(List, pop_links)
+{
+	int i;
+	int* v;
+
+	for(i=0; i<3; i++)
+	{
+		CHECK(target->push(target, iClone(&i)));
+	}
+	LONGS_EQUAL(1, *((int*)target->index(target, 1)));
+
+	v = (int*)target->dequeue(target);
+	LONGS_EQUAL(0, *v);
+	free(v);
+	POINTERS_EQUAL(NULL, Iterator_Prev(target->begin(target)));
+	LONGS_EQUAL(1, *((int*)target->index(target, 0)));
+
+	/* the index table follows enqueue after dequeue */
+	i = 3;
+	CHECK(target->enqueue(target, iClone(&i)));
+	LONGS_EQUAL(3, *((int*)target->index(target, 2)));
+
+	v = (int*)target->pop(target);
+	LONGS_EQUAL(3, *v);
+	free(v);
+	POINTERS_EQUAL(NULL, Iterator_Next(target->end(target)));
+	POINTERS_EQUAL(NULL, target->index(target, 2));
+}
+
+/**
+ * List_Foreach macro check
+ */
+TEST(List, foreach)
+{
+	int i;
+	int sum;
+	Iterator* it;
+
+	for(i=1; i<=100; i++)
+	{
+		CHECK(target->push(target, iClone(&i)));
+	}
+	sum = 0;
+	List_Foreach(target, it)
+	{
+		sum += *((int*)Iterator_Data(it));
+	}
+	LONGS_EQUAL(5050, sum);
+}
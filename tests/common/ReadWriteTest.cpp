@@ -14,6 +14,7 @@ TEST_GROUP(ReadWrite)
 		testarr[0] = 0x12;
 		testarr[1] = 0x34;
 		testarr[2] = 0x56;
+		testarr[3] = 0x78;
 	}
 
 	void teardown()
@@ -32,6 +33,11 @@ TEST(ReadWrite, read24)
 	LONGS_EQUAL(0x563412, read24(&testarr[0]));
 }
 
+TEST(ReadWrite, read32)
+{
+	LONGS_EQUAL(0x78563412, read32(&testarr[0]));
+}
+
 TEST(ReadWrite, write16)
 {
 	write16(&testarr[0], 0x1122);
@@ -44,3 +50,11 @@ TEST(ReadWrite, write24)
 	LONGS_EQUAL(0x334566, read24(&testarr[0]));
 }
 
+
+TEST(ReadWrite, write32)
+{
+	write32(&testarr[0], 0x89abcdef);
+	UNSIGNED_LONGS_EQUAL(0x89abcdef, read32(&testarr[0]));
+	LONGS_EQUAL(0xef, testarr[0]);
+	LONGS_EQUAL(0x89, testarr[3]);
+}
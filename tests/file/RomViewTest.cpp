@@ -0,0 +1,136 @@
+/**
+ * RomViewTest.cpp
+ */
+#include <assert.h>
+#include <unistd.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestFile "view.sfc"
+
+static void MakeRom(const uint32 size, const uint8 map)
+{
+	uint8* rom;
+
+	rom = Fixture_NewRom(size, false);
+	rom[size-1] = map;	/* dummy data */
+	rom[0x7fd5] = map;	/* mapmode */
+	rom[0x7fdc] = 0xff;	/* dummy sum */
+	rom[0x7fdd] = 0xff;
+	Fixture_SaveRom(TestRoot TestFile, rom, size);
+}
+
+TEST_GROUP(RomView)
+{
+	/* test target */
+	RomView* target;
+	RomFile* rom;
+
+	void setup()
+	{
+		target = NULL;
+		MakeRom(0x80000, 0x20);
+		rom = new_RomFile(TestRoot TestFile);
+	}
+
+	void teardown()
+	{
+		delete_RomView(&target);
+		delete_RomFile(&rom);
+		remove(TestRoot TestFile);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(RomView, new)
+{
+	/* not opened */
+	target = new_RomView(rom);
+	CHECK(NULL != target);
+	LONGS_EQUAL(0, target->size_get(target));
+	LONGS_EQUAL(RomType_Unknown, target->type_get(target));
+	LONGS_EQUAL(ROMADDRESS_NULL, target->Snes2PcAdr(target, 0x8000));
+	LONGS_EQUAL(ROMADDRESS_NULL, target->Pc2SnesAdr(target, 0x0000));
+	POINTERS_EQUAL(NULL, target->GetSnesPtr(target, 0x8000));
+	POINTERS_EQUAL(NULL, target->GetPcPtr(target, 0));
+
+	delete_RomView(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the rom info and the conversion
+ */
+TEST(RomView, LoRom)
+{
+	uint32 ad;
+
+	LONGS_EQUAL(FileOpen_NoError, rom->Open(rom));
+	target = new_RomView(rom);
+
+	STRCMP_EQUAL(TestRoot TestFile, target->path_get(target));
+	LONGS_EQUAL(0x80000, target->size_get(target));
+	LONGS_EQUAL(RomType_LoRom, target->type_get(target));
+	LONGS_EQUAL(MapMode_20, target->mapmode_get(target));
+
+	LONGS_EQUAL(0x0000, target->Snes2PcAdr(target, 0x008000));
+	LONGS_EQUAL(0x7fff, target->Snes2PcAdr(target, 0x80ffff));
+	LONGS_EQUAL(0x8000, target->Snes2PcAdr(target, 0x018000));
+	LONGS_EQUAL(ROMADDRESS_NULL, target->Snes2PcAdr(target, 0x007fff));
+	LONGS_EQUAL(ROMADDRESS_NULL, target->Snes2PcAdr(target, 0x108000));
+	LONGS_EQUAL(0x808000, target->Pc2SnesAdr(target, 0x0000));
+	LONGS_EQUAL(0x8fffff, target->Pc2SnesAdr(target, 0x7ffff));
+	LONGS_EQUAL(ROMADDRESS_NULL, target->Pc2SnesAdr(target, 0x80000));
+
+	/* same as RomFile */
+	for(ad=0; ad<0x1000000; ad+=0x1234)
+	{
+		LONGS_EQUAL(rom->Snes2PcAdr(rom, ad), target->Snes2PcAdr(target, ad));
+		LONGS_EQUAL(rom->Pc2SnesAdr(rom, ad), target->Pc2SnesAdr(target, ad));
+		POINTERS_EQUAL(rom->GetSnesPtr(rom, ad), target->GetSnesPtr(target, ad));
+		POINTERS_EQUAL(rom->GetPcPtr(rom, ad), target->GetPcPtr(target, ad));
+	}
+	LONGS_EQUAL(0x20, target->GetPcPtr(target, 0x7ffff)[0]);
+}
+
+/**
+ * Check the SA-1 map of each view
+ */
+TEST(RomView, SA1)
+{
+	RomView* hiview;
+
+	MakeRom(0x200000, 0x23);
+	LONGS_EQUAL(FileOpen_NoError, rom->Open(rom));
+	target = new_RomView(rom);
+	hiview = new_RomViewSA1(rom, true);
+
+	/* the rom object isn't changed */
+	LONGS_EQUAL(0x008000, rom->Pc2SnesAdr(rom, 0x0000));
+	LONGS_EQUAL(0x008000, target->Pc2SnesAdr(target, 0x0000));
+	LONGS_EQUAL(0xc00000, hiview->Pc2SnesAdr(hiview, 0x0000));
+	LONGS_EQUAL(0xd01234, hiview->Pc2SnesAdr(hiview, 0x101234));
+
+	/* the snes address is the same in both map */
+	LONGS_EQUAL(0x0000, target->Snes2PcAdr(target, 0x008000));
+	LONGS_EQUAL(0x0000, hiview->Snes2PcAdr(hiview, 0xc00000));
+	LONGS_EQUAL(0x100000, hiview->Snes2PcAdr(hiview, 0x208000));
+
+	/* the view is a snapshot */
+	rom->UseHiRomMapSA1(rom, true);
+	LONGS_EQUAL(0xc00000, rom->Pc2SnesAdr(rom, 0x0000));
+	LONGS_EQUAL(0x008000, target->Pc2SnesAdr(target, 0x0000));
+
+	delete_RomView(&hiview);
+}
@@ -5,6 +5,8 @@
 extern "C"
 {
 #include "common/types.h"
+#include "common/ReadWrite.h"
+#include "common/Deflate.h"
 #include "file/File.h"
 #include "file/TextFile.h"
 }
@@ -198,3 +200,68 @@ TEST(TextFile2, Printf)
 
 	reader->super.Close(&reader->super);
 }
+
+/**
+ * Check Write method
+ */
+TEST(TextFile2, Write)
+{
+	const char* line;
+
+	/* Create new file */
+	LONGS_EQUAL(FileOpen_NoError, target->Open2(target, "w"));
+
+	/* write blocks */
+	CHECK(target->Write(target, "123", 3));
+	CHECK(target->Write(target, "45\n", 3));
+	CHECK(target->Write(target, "", 0));
+
+	target->super.Close(&target->super);
+
+	/* check file read */
+	LONGS_EQUAL(FileOpen_NoError, reader->Open(reader));
+
+	line = reader->GetLine(reader);
+	CHECK(NULL != line);
+	STRCMP_EQUAL(WriteLine1, line);
+
+	POINTERS_EQUAL(NULL, reader->GetLine(reader));
+
+	reader->super.Close(&reader->super);
+}
+
+/**
+ * Check compressed output
+ */
+TEST(TextFile2, Compress)
+{
+	FILE* fp;
+	uint8 buf[16];
+	long len;
+
+	/* Create new file */
+	target->compress_set(target, true);
+	LONGS_EQUAL(FileOpen_NoError, target->Open2(target, "w"));
+
+	target->Printf(target, WriteLine1 "\n");
+	CHECK(target->Write(target, "123", 3));
+	CHECK(target->Close(target));
+
+	/* gzip header / trailer */
+	fp = fopen(TestRoot WriteFile, "rb");
+	CHECK(NULL != fp);
+	LONGS_EQUAL(10, fread(buf, 1, 10, fp));
+	LONGS_EQUAL(0x1f, buf[0]);
+	LONGS_EQUAL(0x8b, buf[1]);
+	LONGS_EQUAL(0x08, buf[2]);
+
+	fseek(fp, -8, SEEK_END);
+	len = ftell(fp);
+	CHECK(10 < len);
+	LONGS_EQUAL(8, fread(buf, 1, 8, fp));
+	fclose(fp);
+
+	/* crc32("12345\n123"), length */
+	LONGS_EQUAL(Deflate_Crc32(0, (const uint8*)"12345\n123", 9), read32(&buf[0]));
+	LONGS_EQUAL(9, read32(&buf[4]));
+}
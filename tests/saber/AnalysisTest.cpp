@@ -0,0 +1,377 @@
+/**
+ * AnalysisTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestRom "analysis.sfc"
+
+static void MakeRom(const char* path)
+{
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x8000, true);
+	memcpy(rom, Fixture_Code, Fixture_CodeSize);
+	rom[0x20] = 0xa9;	/* lda #$02 (not reached from the reset vector) */
+	rom[0x21] = 0x02;
+	rom[0x22] = 0x60;	/* rts */
+	Fixture_SaveRom(path, rom, 0x8000);
+}
+
+typedef struct _Visited {
+	uint32 pcadr[16];
+	uint32 count;
+	uint32 limit;
+} Visited;
+
+static bool Visit(void* param, const Instruction* ins)
+{
+	Visited* v = (Visited*)param;
+
+	v->pcadr[v->count++] = ins->pcadr;
+	return (v->count < v->limit);
+}
+
+TEST_GROUP(Analysis)
+{
+	/* test target */
+	Analysis* target;
+	DisAsmContext* ctx;
+	RomFile* rom;
+	RomView* view;
+
+	void setup()
+	{
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		MakeRom(TestRoot TestRom);
+		rom = new_RomFile(TestRoot TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		ctx = new_DisAsmContext(&inf);
+		target = ctx->Analyze(ctx, view);
+	}
+
+	void teardown()
+	{
+		delete_Analysis(&target);
+		delete_DisAsmContext(&ctx);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRoot TestRom);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Analysis, new)
+{
+	CHECK(NULL != target);
+	LONGS_EQUAL(0, ctx->diagCount_get(ctx));
+	LONGS_EQUAL(9, target->count_get(target));
+	POINTERS_EQUAL(view, target->view_get(target));
+
+	delete_Analysis(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check Decode method
+ */
+TEST(Analysis, Decode)
+{
+	Instruction ins;
+	char text[32];
+
+	/* bne */
+	CHECK(target->Decode(target, 0x0008, &ins));
+	LONGS_EQUAL(0x008008, ins.snesadr);
+	LONGS_EQUAL(0xd0, ins.op);
+	CHECK_FALSE(ins.numeric);
+	Opcode_Format(&ins, false, text, sizeof(text));
+	STRCMP_EQUAL("bne L00800c", text);
+
+	/* the register status of the analysis */
+	CHECK(target->Decode(target, 0x0005, &ins));
+	LONGS_EQUAL(2, ins.arglen);
+	Opcode_Format(&ins, false, text, sizeof(text));
+	STRCMP_EQUAL("lda.w #$1234", text);
+
+	/* not the head of instruction */
+	CHECK_FALSE(target->Decode(target, 0x0006, &ins));
+	CHECK_FALSE(target->Decode(target, 0x0100, &ins));
+}
+
+/**
+ * Check QueryRange method
+ */
+TEST(Analysis, QueryRange)
+{
+	Visited v;
+
+	/* the overlapping instruction is included */
+	v.count = 0;
+	v.limit = 16;
+	LONGS_EQUAL(3, target->QueryRange(target, 0x0006, 0x000b, Visit, &v));
+	LONGS_EQUAL(0x0005, v.pcadr[0]);
+	LONGS_EQUAL(0x0008, v.pcadr[1]);
+	LONGS_EQUAL(0x000a, v.pcadr[2]);
+
+	/* whole */
+	v.count = 0;
+	LONGS_EQUAL(9, target->QueryRange(target, 0, 0x8000, Visit, &v));
+	LONGS_EQUAL(0x0012, v.pcadr[8]);
+
+	/* stopped by the visitor */
+	v.count = 0;
+	v.limit = 2;
+	LONGS_EQUAL(2, target->QueryRange(target, 0, 0x8000, Visit, &v));
+
+	/* empty */
+	v.count = 0;
+	LONGS_EQUAL(0, target->QueryRange(target, 0x0013, 0x8000, Visit, &v));
+}
+
+/**
+ * Check QueryXref method
+ */
+TEST(Analysis, QueryXref)
+{
+	Visited v;
+
+	v.count = 0;
+	v.limit = 16;
+	LONGS_EQUAL(1, target->QueryXref(target, 0x008010, Visit, &v));
+	LONGS_EQUAL(0x0000, v.pcadr[0]);
+	LONGS_EQUAL(1, target->QueryXref(target, 0x00800c, Visit, &v));
+	LONGS_EQUAL(0x0008, v.pcadr[1]);
+
+	/* not referred */
+	LONGS_EQUAL(0, target->QueryXref(target, 0x008005, Visit, &v));
+	LONGS_EQUAL(2, v.count);
+}
+
+/**
+ * Check the additional entry point
+ */
+TEST(Analysis, AddEntry)
+{
+	Visited v;
+
+	delete_Analysis(&target);
+	ctx->AddEntry(ctx, 0x008020, 0x30);
+	ctx->AddEntry(ctx, 0x7e0000, 0x30);
+	target = ctx->Analyze(ctx, view);
+
+	CHECK(NULL != target);
+	LONGS_EQUAL(11, target->count_get(target));
+	LONGS_EQUAL(1, ctx->diagCount_get(ctx));
+	LONGS_EQUAL(DisAsmDiag_Warn, ctx->Diag(ctx, 0)->level);
+
+	v.count = 0;
+	v.limit = 16;
+	LONGS_EQUAL(2, target->QueryRange(target, 0x0020, 0x8000, Visit, &v));
+	LONGS_EQUAL(0x0022, v.pcadr[1]);
+}
+
+/**
+ * Check the restored analysis state
+ */
+TEST(Analysis, Restore)
+{
+	DisAsmInf inf;
+	DisAsmContext* sub;
+	Analysis* restored;
+	Visited v;
+	Visited ref;
+	FILE* f;
+
+	Fixture_InitInf(&inf);
+	inf.dbPath = TestRoot "analysis.sdb";
+	remove(inf.dbPath);
+
+	/* saved */
+	sub = new_DisAsmContext(&inf);
+	restored = sub->Analyze(sub, view);
+	LONGS_EQUAL(9, restored->count_get(restored));
+	LONGS_EQUAL(0, sub->diagCount_get(sub));
+	delete_Analysis(&restored);
+	delete_DisAsmContext(&sub);
+
+	/* only the new entry is analyzed */
+	sub = new_DisAsmContext(&inf);
+	sub->AddEntry(sub, 0x008020, 0x30);
+	restored = sub->Analyze(sub, view);
+	LONGS_EQUAL(11, restored->count_get(restored));
+	LONGS_EQUAL(1, sub->diagCount_get(sub));
+	LONGS_EQUAL(DisAsmDiag_Info, sub->Diag(sub, 0)->level);
+	CHECK(NULL != strstr(sub->Diag(sub, 0)->message, "(1 new entries)"));
+
+	/* same as the full analysis */
+	delete_Analysis(&target);
+	ctx->AddEntry(ctx, 0x008020, 0x30);
+	target = ctx->Analyze(ctx, view);
+	ref.count = 0;
+	ref.limit = 16;
+	v.count = 0;
+	v.limit = 16;
+	LONGS_EQUAL(11, target->QueryRange(target, 0, 0x8000, Visit, &ref));
+	LONGS_EQUAL(11, restored->QueryRange(restored, 0, 0x8000, Visit, &v));
+	MEMCMP_EQUAL(ref.pcadr, v.pcadr, sizeof(uint32) * 11);
+	delete_Analysis(&restored);
+	delete_DisAsmContext(&sub);
+
+	/* the other options */
+	inf.depthMax = 3;
+	sub = new_DisAsmContext(&inf);
+	sub->AddEntry(sub, 0x008020, 0x30);
+	restored = sub->Analyze(sub, view);
+	LONGS_EQUAL(11, restored->count_get(restored));
+	LONGS_EQUAL(0, sub->diagCount_get(sub));
+	delete_Analysis(&restored);
+	delete_DisAsmContext(&sub);
+	inf.dataflow = true;
+	sub = new_DisAsmContext(&inf);
+	sub->AddEntry(sub, 0x008020, 0x30);
+	restored = sub->Analyze(sub, view);
+	LONGS_EQUAL(11, restored->count_get(restored));
+	LONGS_EQUAL(0, sub->diagCount_get(sub));
+	delete_Analysis(&restored);
+	delete_DisAsmContext(&sub);
+
+	/* broken file */
+	f = fopen(inf.dbPath, "ab");
+	fputc(0x01, f);
+	fclose(f);
+	sub = new_DisAsmContext(&inf);
+	sub->AddEntry(sub, 0x008020, 0x30);
+	restored = sub->Analyze(sub, view);
+	LONGS_EQUAL(11, restored->count_get(restored));
+	LONGS_EQUAL(0, sub->diagCount_get(sub));
+	delete_Analysis(&restored);
+	delete_DisAsmContext(&sub);
+
+	remove(inf.dbPath);
+}
+
+static void PatchRom(const char* path, const long pcadr, const uint8 value)
+{
+	FILE* f;
+
+	f = fopen(path, "rb+");
+	fseek(f, pcadr, SEEK_SET);
+	fputc(value, f);
+	fclose(f);
+}
+
+static uint32 AnalyzeFile(const DisAsmInf* inf, const char* path, uint32* diags)
+{
+	DisAsmContext* sub;
+	Analysis* result;
+	RomFile* file;
+	RomView* fview;
+	uint32 count;
+
+	file = new_RomFile(path);
+	file->Open(file);
+	fview = new_RomView(file);
+	sub = new_DisAsmContext(inf);
+	result = sub->Analyze(sub, fview);
+	count = result->count_get(result);
+	(*diags) = sub->diagCount_get(sub);
+	delete_Analysis(&result);
+	delete_DisAsmContext(&sub);
+	delete_RomView(&fview);
+	delete_RomFile(&file);
+	return count;
+}
+
+/**
+ * Check the saved state of the changed rom
+ */
+TEST(Analysis, RestoreChanged)
+{
+	DisAsmInf inf;
+	uint32 diags;
+
+	Fixture_InitInf(&inf);
+	inf.dbPath = TestRoot "analysis.sdb";
+	remove(inf.dbPath);
+	LONGS_EQUAL(9, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+
+	/* the data out of the code is changed */
+	PatchRom(TestRoot TestRom, 0x1000, 0x55);
+	LONGS_EQUAL(9, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(1, diags);
+
+	/* the operand of "jsr $8010" is changed */
+	PatchRom(TestRoot TestRom, 0x0001, 0x20);
+	LONGS_EQUAL(9, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+	LONGS_EQUAL(9, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(1, diags);
+
+	remove(inf.dbPath);
+}
+
+/**
+ * Check the saved state depends on the pointers read from the rom
+ */
+TEST(Analysis, RestorePointer)
+{
+	DisAsmInf inf;
+	uint32 diags;
+
+	Fixture_InitInf(&inf);
+	inf.dbPath = TestRoot "analysis.sdb";
+	remove(inf.dbPath);
+	PatchRom(TestRoot TestRom, 0x7ffc, 0x30);	/* reset vector : $8030 */
+	PatchRom(TestRoot TestRom, 0x0030, 0x6c);	/* jmp ($9000) */
+	PatchRom(TestRoot TestRom, 0x0031, 0x00);
+	PatchRom(TestRoot TestRom, 0x0032, 0x90);
+	PatchRom(TestRoot TestRom, 0x1000, 0x20);	/* $9000 : $8020 */
+	PatchRom(TestRoot TestRom, 0x1001, 0x80);
+	PatchRom(TestRoot TestRom, 0x0040, 0xea);	/* nop */
+	PatchRom(TestRoot TestRom, 0x0041, 0xea);	/* nop */
+	PatchRom(TestRoot TestRom, 0x0042, 0x60);	/* rts */
+	LONGS_EQUAL(3, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+
+	/* the pointer is changed */
+	PatchRom(TestRoot TestRom, 0x1000, 0x40);	/* $9000 : $8040 */
+	LONGS_EQUAL(4, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+
+	/* the data out of the code and the pointer is changed */
+	PatchRom(TestRoot TestRom, 0x2000, 0x55);
+	LONGS_EQUAL(4, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(1, diags);
+
+	/* by the dataflow */
+	inf.dataflow = true;
+	LONGS_EQUAL(4, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+	PatchRom(TestRoot TestRom, 0x1000, 0x20);	/* $9000 : $8020 */
+	LONGS_EQUAL(3, AnalyzeFile(&inf, TestRoot TestRom, &diags));
+	LONGS_EQUAL(0, diags);
+
+	remove(inf.dbPath);
+}
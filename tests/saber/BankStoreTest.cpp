@@ -0,0 +1,269 @@
+/**
+ * BankStoreTest.cpp
+ */
+#include <assert.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <string>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/BankStore.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestDir TestRoot "banks"
+#define TestRom TestRoot "banks.sfc"
+
+static BankTrace* MakeTrace(const uint32 snesadr)
+{
+	BankTrace* trace;
+
+	trace = new_BankTrace(2, 1, 1);
+	trace->recs[0].snesadr = snesadr;
+	trace->recs[0].psw = 0x30;
+	trace->recs[0].flags = InsnRec_GroupHead;
+	trace->recs[1].snesadr = snesadr + 2;
+	trace->recs[1].psw = 0x20;
+	trace->recs[1].flags = 0;
+	trace->groups[0].callFrom = BankTrace_Entry;
+	trace->groups[0].depth = 1;
+	trace->exits[0].snesadr = 0x818000;
+	trace->exits[0].callFrom = snesadr + 2;
+	trace->exits[0].psw = 0x20;
+	trace->exits[0].depth = 2;
+	return trace;
+}
+
+/**
+ * bank 0 : jsl $818000 / rts,  bank 1 : lda #$01 / rtl
+ */
+static void MakeRom(const char* path, const uint8 imm)
+{
+	static const uint8 code[] = {
+		0x22, 0x00, 0x80, 0x81,	/* jsl $818000 */
+		0x60,			/* rts */
+	};
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x10000, true);
+	memcpy(rom, code, sizeof(code));
+	rom[0x8000] = 0xa9;	/* lda #imm */
+	rom[0x8001] = imm;
+	rom[0x8002] = 0x6b;	/* rtl */
+	Fixture_SaveRom(path, rom, 0x10000);
+}
+
+static void RemoveDir(const char* path)
+{
+	DIR* d;
+	struct dirent* ent;
+	std::string file;
+
+	d = opendir(path);
+	if(NULL == d) return;
+	while(NULL != (ent = readdir(d)))
+	{
+		if('.' == ent->d_name[0]) continue;
+		file = std::string(path) + "/" + ent->d_name;
+		remove(file.c_str());
+	}
+	closedir(d);
+	rmdir(path);
+}
+
+TEST_GROUP(BankStore)
+{
+	/* test target */
+	BankStore* target;
+
+	void setup()
+	{
+		target = new_BankStore(NULL);
+	}
+
+	void teardown()
+	{
+		delete_BankStore(&target);
+		RemoveDir(TestDir);
+		remove(TestRom);
+	}
+
+	uint32 Analyze(BankStore* banks)
+	{
+		RomFile* rom;
+		RomView* view;
+		DisAsmContext* ctx;
+		Analysis* result;
+		uint32 count;
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		ctx = new_DisAsmContext(&inf);
+		ctx->UseBankStore(ctx, banks);
+		result = ctx->Analyze(ctx, view);
+		count = (NULL == result) ? 0 : result->count_get(result);
+		delete_Analysis(&result);
+		delete_DisAsmContext(&ctx);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		return count;
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(BankStore, new)
+{
+	CHECK(NULL != target);
+	LONGS_EQUAL(0, target->hits_get(target));
+	LONGS_EQUAL(0, target->misses_get(target));
+
+	delete_BankStore(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check Add / Find in memory
+ */
+TEST(BankStore, AddFind)
+{
+	BankTrace* trace;
+	const BankTrace* stored;
+	uint64 key;
+	uint32 i;
+
+	POINTERS_EQUAL(NULL, target->Find(target, 1));
+	LONGS_EQUAL(1, target->misses_get(target));
+
+	/* over the initial table */
+	for(i=0; i<1000; i++)
+	{
+		key = BankStore_Hash(BankStore_HashInit, &i, sizeof(i));
+		trace = MakeTrace(0x808000 + i);
+		POINTERS_EQUAL(trace, target->Add(target, key, trace));
+	}
+	for(i=0; i<1000; i++)
+	{
+		key = BankStore_Hash(BankStore_HashInit, &i, sizeof(i));
+		stored = target->Find(target, key);
+		CHECK(NULL != stored);
+		LONGS_EQUAL(0x808000 + i, stored->recs[0].snesadr);
+	}
+	LONGS_EQUAL(1000, target->hits_get(target));
+
+	/* the first one is kept */
+	i = 0;
+	key = BankStore_Hash(BankStore_HashInit, &i, sizeof(i));
+	stored = target->Add(target, key, MakeTrace(0x909000));
+	LONGS_EQUAL(0x808000, stored->recs[0].snesadr);
+}
+
+/**
+ * Check the trace files
+ */
+TEST(BankStore, Files)
+{
+	BankStore* other;
+	const BankTrace* t;
+
+	delete_BankStore(&target);
+	target = new_BankStore(TestDir);
+	target->Add(target, 0x123456789abcULL, MakeTrace(0x808000));
+
+	/* the other run */
+	other = new_BankStore(TestDir);
+	t = other->Find(other, 0x123456789abcULL);
+	CHECK(NULL != t);
+	LONGS_EQUAL(2, t->recCount);
+	LONGS_EQUAL(1, t->groupCount);
+	LONGS_EQUAL(1, t->exitCount);
+	LONGS_EQUAL(0x808002, t->recs[1].snesadr);
+	LONGS_EQUAL(0x20, t->recs[1].psw);
+	LONGS_EQUAL(InsnRec_GroupHead, t->recs[0].flags);
+	LONGS_EQUAL(BankTrace_Entry, t->groups[0].callFrom);
+	LONGS_EQUAL(1, t->groups[0].depth);
+	LONGS_EQUAL(0x818000, t->exits[0].snesadr);
+	LONGS_EQUAL(0x808002, t->exits[0].callFrom);
+	LONGS_EQUAL(2, t->exits[0].depth);
+	POINTERS_EQUAL(NULL, other->Find(other, 0x123456789abdULL));
+	LONGS_EQUAL(1, other->hits_get(other));
+	delete_BankStore(&other);
+}
+
+/**
+ * Check the traces are reused for the same banks
+ */
+TEST(BankStore, Analyze)
+{
+	MakeRom(TestRom, 0x01);
+	LONGS_EQUAL(4, Analyze(target));
+	LONGS_EQUAL(0, target->hits_get(target));
+	LONGS_EQUAL(2, target->misses_get(target));
+
+	/* same rom */
+	LONGS_EQUAL(4, Analyze(target));
+	LONGS_EQUAL(2, target->hits_get(target));
+
+	/* bank 1 is changed */
+	MakeRom(TestRom, 0x02);
+	LONGS_EQUAL(4, Analyze(target));
+	LONGS_EQUAL(3, target->hits_get(target));
+	LONGS_EQUAL(3, target->misses_get(target));
+}
+
+/**
+ * Check the trace which reads the pointer out of the bank isn't shared
+ */
+TEST(BankStore, Pointer)
+{
+	static const uint8 code[] = {
+		0x6c, 0x00, 0x90,	/* jmp ($9000) : the pointer in bank 0 */
+	};
+	static const uint8 dest[] = {
+		0xa9, 0x01,		/* $818100 : lda #$01 */
+		0x6b,			/* rtl */
+		0xea,			/* $818200 : nop */
+		0xea,			/* nop */
+		0x6b,			/* rtl */
+	};
+	FILE* f;
+
+	MakeRom(TestRom, 0x01);
+	f = fopen(TestRom, "rb+");
+	fseek(f, 0x1000, SEEK_SET);
+	fputc(0x00, f);		/* $9000 : $8100 */
+	fputc(0x81, f);
+	fseek(f, 0x8000, SEEK_SET);
+	fwrite(code, 1, sizeof(code), f);
+	fseek(f, 0x8100, SEEK_SET);
+	fwrite(&dest[0], 1, 3, f);
+	fseek(f, 0x8200, SEEK_SET);
+	fwrite(&dest[3], 1, 3, f);
+	fclose(f);
+	LONGS_EQUAL(5, Analyze(target));
+
+	/* only the pointer is changed */
+	f = fopen(TestRom, "rb+");
+	fseek(f, 0x1001, SEEK_SET);
+	fputc(0x82, f);		/* $9000 : $8200 */
+	fclose(f);
+	LONGS_EQUAL(6, Analyze(target));
+	LONGS_EQUAL(0, target->hits_get(target));
+}
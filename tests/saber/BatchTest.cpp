@@ -0,0 +1,200 @@
+/**
+ * BatchTest.cpp
+ */
+#include <assert.h>
+#include <string>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/Batch.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestRom TestRoot "batch.sfc"
+#define Manifest TestRoot "batch.json"
+#define OutCode TestRoot "batch-code.asm"
+#define OutData TestRoot "batch-data.asm"
+#define OutJson TestRoot "batch.jsonl"
+#define OutDefault TestRoot "batch.asm"
+
+static void MakeRom(const char* path)
+{
+	static const uint8 code[] = {
+		0x20, 0x10, 0x80,	/* jsr $8010 */
+		0x60,			/* rts */
+	};
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x8000, true);
+	memcpy(rom, code, sizeof(code));
+	rom[0x10] = 0xa9;	/* lda #$01 */
+	rom[0x11] = 0x01;
+	rom[0x12] = 0x60;	/* rts */
+	Fixture_SaveRom(path, rom, 0x8000);
+}
+
+static void WriteText(const char* path, const char* text)
+{
+	FILE* f;
+
+	f = fopen(path, "wb");
+	fputs(text, f);
+	fclose(f);
+}
+
+static std::string ReadText(const char* path)
+{
+	std::string text;
+	char buf[256];
+	FILE* f;
+	size_t len;
+
+	f = fopen(path, "rb");
+	if(NULL == f) return text;
+	while(0 != (len = fread(buf, 1, sizeof(buf), f)))
+	{
+		text.append(buf, len);
+	}
+	fclose(f);
+	return text;
+}
+
+TEST_GROUP(Batch)
+{
+	/* test target */
+	Batch* target;
+
+	void setup()
+	{
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		target = new_Batch(&inf, 2);
+	}
+
+	void teardown()
+	{
+		delete_Batch(&target);
+		remove(TestRom);
+		remove(Manifest);
+		remove(OutCode);
+		remove(OutData);
+		remove(OutJson);
+		remove(OutDefault);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Batch, new)
+{
+	CHECK(NULL != target);
+
+	delete_Batch(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the jobs sharing the rom, and the failed job
+ */
+TEST(Batch, Run)
+{
+	const BatchResult* r;
+	std::string text;
+	std::string rom;
+	std::string output;
+
+	MakeRom(TestRom);
+	WriteText(Manifest,
+			"[\n"
+			"  {\"rom\":\"" TestRom "\", \"output\":\"" OutCode "\", \"json\":\"" OutJson "\", \"entry\":\"$808010\"},\n"
+			"  {\"rom\":\"" TestRoot "none.sfc\"},\n"
+			"  {\"rom\":\"" TestRom "\", \"output\":\"" OutData "\", \"pc\":\"$8000\", \"count\":2, \"label\":\"DAT\"},\n"
+			"  {\"rom\":\"" TestRom "\", \"depth\":1}\n"
+			"]\n");
+
+	CHECK(target->Load(target, Manifest));
+	LONGS_EQUAL(4, target->count_get(target));
+	CHECK_FALSE(target->Run(target));
+
+	/* in the manifest order */
+	r = target->Result(target, 0);
+	CHECK(r->ok);
+	rom = r->rom;
+	output = r->output;
+	STRCMP_EQUAL(TestRom, rom.c_str());
+	STRCMP_EQUAL(OutCode, output.c_str());
+
+	r = target->Result(target, 1);
+	CHECK_FALSE(r->ok);
+	CHECK(NULL != r->message);
+
+	r = target->Result(target, 2);
+	CHECK(r->ok);
+	r = target->Result(target, 3);
+	CHECK(r->ok);
+	output = r->output;
+	STRCMP_EQUAL(OutDefault, output.c_str());
+	POINTERS_EQUAL(NULL, target->Result(target, 4));
+
+	text = ReadText(OutCode);
+	CHECK(std::string::npos != text.find("jsr"));
+	CHECK(std::string::npos != text.find("lda"));
+	CHECK(0 != ReadText(OutJson).size());
+	text = ReadText(OutData);
+	CHECK(std::string::npos != text.find("DAT"));
+	CHECK(0 != ReadText(OutDefault).size());
+}
+
+/**
+ * Check the invalid manifests
+ */
+TEST(Batch, Invalid)
+{
+	DisAsmInf inf;
+
+	/* not found */
+	CHECK_FALSE(target->Load(target, Manifest));
+
+	/* not an array */
+	WriteText(Manifest, "{\"rom\":\"a.sfc\"}");
+	CHECK_FALSE(target->Load(target, Manifest));
+
+	/* no rom */
+	WriteText(Manifest, "[{\"output\":\"a.asm\"}]");
+	CHECK_FALSE(target->Load(target, Manifest));
+
+	/* unknown member */
+	WriteText(Manifest, "[{\"rom\":\"a.sfc\", \"dpeth\":1}]");
+	CHECK_FALSE(target->Load(target, Manifest));
+
+	/* invalid entry point */
+	WriteText(Manifest, "[{\"rom\":\"a.sfc\", \"entry\":\"$808000,zz\"}]");
+	CHECK_FALSE(target->Load(target, Manifest));
+
+	/* unterminated */
+	WriteText(Manifest, "[{\"rom\":\"a.sfc\"}");
+	CHECK_FALSE(target->Load(target, Manifest));
+	LONGS_EQUAL(1, target->count_get(target));
+
+	/* empty */
+	delete_Batch(&target);
+	Fixture_InitInf(&inf);
+	target = new_Batch(&inf, 2);
+	WriteText(Manifest, " [ ]\n");
+	CHECK(target->Load(target, Manifest));
+	LONGS_EQUAL(0, target->count_get(target));
+	CHECK(target->Run(target));
+}
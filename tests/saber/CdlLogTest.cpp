@@ -0,0 +1,163 @@
+/**
+ * CdlLogTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/CdlLog.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/cdllog.sfc"
+#define TestLog "testdata/file/cdllog.cdl"
+#define RomSize 0x10000
+
+TEST_GROUP(CdlLog)
+{
+	/* test target */
+	CdlLog* target;
+	RomFile* rom;
+	RomView* view;
+	uint8 flags[RomSize];
+
+	void setup()
+	{
+		uint8* data;
+
+		data = Fixture_NewRom(RomSize, true);
+		Fixture_SaveRom(TestRom, data, RomSize);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		target = new_CdlLog(view);
+		memset(flags, 0, sizeof(flags));
+	}
+
+	void teardown()
+	{
+		delete_CdlLog(&target);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+		remove(TestLog);
+	}
+
+	void Write(const char* header, const size_t size)
+	{
+		FILE* f;
+
+		f = fopen(TestLog, "wb");
+		if(NULL != header) fwrite(header, 1, 9, f);
+		fwrite(flags, 1, size, f);
+		fclose(f);
+	}
+
+	void Fill(const uint32 pcadr, const uint32 size, const uint8 f)
+	{
+		memset(&flags[pcadr], f, size);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(CdlLog, new)
+{
+	LONGS_EQUAL(0, target->regionCount_get(target));
+	POINTERS_EQUAL(NULL, target->Region(target, 0));
+	LONGS_EQUAL(0, target->Flags(target, 0));
+	CHECK(0 < target->bytes_get(target));
+
+	delete_CdlLog(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the regions of the code and the data
+ */
+TEST(CdlLog, Regions)
+{
+	const CdlRegion* r;
+
+	/* the code(with the jump target in it), the data, and the code read as the data */
+	Fill(0x0003, 0x25, CdlLog_Code | CdlLog_M8 | CdlLog_X8);
+	flags[0x0003] |= CdlLog_SubEntry;
+	flags[0x0011] = CdlLog_Code | CdlLog_JumpTarget;
+	Fill(0x0028, 0x11, CdlLog_Data);
+	Fill(0x1000, 0x7, CdlLog_Code | CdlLog_Data);
+	Fill(0xffff, 0x1, CdlLog_Data);
+	Write(NULL, RomSize);
+	CHECK(target->Load(target, TestLog));
+
+	LONGS_EQUAL(5, target->regionCount_get(target));
+	LONGS_EQUAL(0x25 + 0x7, target->codeBytes_get(target));
+	LONGS_EQUAL(0x11 + 0x1, target->dataBytes_get(target));
+
+	r = target->Region(target, 0);
+	LONGS_EQUAL(0x0003, r->pcadr);
+	LONGS_EQUAL(0x0e, r->size);
+	LONGS_EQUAL(CdlLog_Code | CdlLog_M8 | CdlLog_X8, r->flags);
+
+	r = target->Region(target, 1);
+	LONGS_EQUAL(0x0011, r->pcadr);
+	LONGS_EQUAL(0x17, r->size);
+	LONGS_EQUAL(CdlLog_Code, r->flags);
+
+	r = target->Region(target, 2);
+	LONGS_EQUAL(0x0028, r->pcadr);
+	LONGS_EQUAL(0x11, r->size);
+	LONGS_EQUAL(CdlLog_Data, r->flags);
+
+	r = target->Region(target, 3);
+	LONGS_EQUAL(0x1000, r->pcadr);
+	LONGS_EQUAL(0x7, r->size);
+	LONGS_EQUAL(CdlLog_Code, r->flags);
+
+	r = target->Region(target, 4);
+	LONGS_EQUAL(0xffff, r->pcadr);
+	LONGS_EQUAL(0x1, r->size);
+
+	CHECK(CdlLog_IsData(target->Flags(target, 0x0030)));
+	CHECK_FALSE(CdlLog_IsData(target->Flags(target, 0x1000)));
+	LONGS_EQUAL(0, target->Flags(target, RomSize));
+}
+
+/**
+ * Check the file with the header, and the size
+ */
+TEST(CdlLog, Header)
+{
+	uint32 hash;
+
+	Fill(0x8000, 0x100, CdlLog_Code);
+	Write("CDLv2\x12\x34\x56\x78", RomSize);
+	CHECK(target->Load(target, TestLog));
+	LONGS_EQUAL(1, target->regionCount_get(target));
+	LONGS_EQUAL(0x8000, target->Region(target, 0)->pcadr);
+	hash = target->Hash(target);
+
+	/* the same flags without the header */
+	Write(NULL, RomSize);
+	CHECK(target->Load(target, TestLog));
+	LONGS_EQUAL(1, target->regionCount_get(target));
+	LONGS_EQUAL(hash, target->Hash(target));
+
+	flags[0x8100] = CdlLog_Code;
+	Write(NULL, RomSize);
+	CHECK(target->Load(target, TestLog));
+	CHECK(hash != target->Hash(target));
+
+	/* the other rom, or the other header */
+	Write(NULL, RomSize / 2);
+	CHECK_FALSE(target->Load(target, TestLog));
+	Write("CDLv1\x12\x34\x56\x78", RomSize);
+	CHECK_FALSE(target->Load(target, TestLog));
+	CHECK_FALSE(target->Load(target, "testdata/file/none.cdl"));
+}
@@ -0,0 +1,204 @@
+/**
+ * CfgTest.cpp
+ */
+#include <assert.h>
+#include <string>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Cfg.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestRom TestRoot "cfg.sfc"
+#define TestOut TestRoot "cfg.out"
+
+/**
+ * $8000 jsr $8008 / beq $8007 / lda #$01 / rts,  $8008 lda #$02 / rts
+ */
+static void MakeRom(const char* path)
+{
+	static const uint8 code[] = {
+		0x20, 0x08, 0x80,	/* jsr $8008 */
+		0xf0, 0x02,		/* beq $8007 */
+		0xa9, 0x01,		/* lda #$01 */
+		0x60,			/* rts */
+		0xa9, 0x02,		/* lda #$02 */
+		0x60,			/* rts */
+	};
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x10000, true);
+	memcpy(rom, code, sizeof(code));
+	Fixture_SaveRom(path, rom, 0x10000);
+}
+
+static std::string ReadAll(const char* path)
+{
+	std::string s;
+	char buf[256];
+	size_t n;
+	FILE* f;
+
+	f = fopen(path, "rb");
+	if(NULL == f) return s;
+	while(0 < (n = fread(buf, 1, sizeof(buf), f)))
+	{
+		s.append(buf, n);
+	}
+	fclose(f);
+	return s;
+}
+
+TEST_GROUP(Cfg)
+{
+	/* test target */
+	Cfg* target;
+	RomFile* rom;
+	RomView* view;
+	InsnStore* store;
+
+	void setup()
+	{
+		MakeRom(TestRom);
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+
+		/* like pass1 : the entry, the callee, and the branch target */
+		store = new_InsnStore(0x10000);
+		store->Add(store, 0x008000, 0x0000, 0x30);
+		store->AddGroup(store, 0xffffffff, 0);
+		store->Add(store, 0x008008, 0x0008, 0x30);
+		store->AddGroup(store, 0x008000, 1);
+		store->Add(store, 0x00800a, 0x000a, 0x30);
+		store->Add(store, 0x008003, 0x0003, 0x30);
+		store->Add(store, 0x008005, 0x0005, 0x30);
+		store->Add(store, 0x008007, 0x0007, 0x30);
+		store->AddGroup(store, 0x008003, 1);
+		store->Sort(store);
+
+		target = new_Cfg(view, store);
+	}
+
+	void teardown()
+	{
+		delete_Cfg(&target);
+		delete_InsnStore(&store);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+		remove(TestOut);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Cfg, new)
+{
+	CHECK(NULL != target);
+	CHECK(0 < target->bytes_get(target));
+
+	delete_Cfg(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the blocks and the edges
+ */
+TEST(Cfg, Blocks)
+{
+	const CfgBlock* b;
+	const uint32* list;
+
+	/* [jsr, beq] [lda] [rts] [lda, rts] */
+	LONGS_EQUAL(4, target->blockCount_get(target));
+	b = target->Block(target, 0);
+	LONGS_EQUAL(0, b->first);
+	LONGS_EQUAL(2, b->count);
+	LONGS_EQUAL(0x008000, b->snesadr);
+	LONGS_EQUAL(0x008005, b->endSnes);
+	b = target->Block(target, 2);
+	LONGS_EQUAL(0x008007, b->snesadr);
+	LONGS_EQUAL(CfgBlock_Return, b->flags);
+	POINTERS_EQUAL(NULL, target->Block(target, 4));
+
+	LONGS_EQUAL(0, target->BlockOf(target, 0x0003));
+	LONGS_EQUAL(3, target->BlockOf(target, 0x000a));
+	LONGS_EQUAL(Cfg_NotFound, target->BlockOf(target, 0x0004));
+
+	/* the fall through and the branch */
+	LONGS_EQUAL(2, target->Successors(target, 0, &list));
+	LONGS_EQUAL(1, list[0]);
+	LONGS_EQUAL(2, list[1]);
+	LONGS_EQUAL(2, target->Predecessors(target, 2, &list));
+	LONGS_EQUAL(0, list[0]);
+	LONGS_EQUAL(1, list[1]);
+	LONGS_EQUAL(0, target->Successors(target, 3, &list));
+	LONGS_EQUAL(0, target->Predecessors(target, 3, &list));
+}
+
+/**
+ * Check the routines
+ */
+TEST(Cfg, Routines)
+{
+	const uint32* list;
+
+	/* the entry, and the callee(the branch target isn't the head) */
+	LONGS_EQUAL(2, target->routineCount_get(target));
+	LONGS_EQUAL(3, target->RoutineBlocks(target, 0, &list));
+	LONGS_EQUAL(0, list[0]);
+	LONGS_EQUAL(1, list[1]);
+	LONGS_EQUAL(2, list[2]);
+	LONGS_EQUAL(1, target->RoutineBlocks(target, 1, &list));
+	LONGS_EQUAL(3, list[0]);
+	LONGS_EQUAL(CfgBlock_RoutineHead | CfgBlock_Return, target->Block(target, 3)->flags);
+	LONGS_EQUAL(0, target->Block(target, 2)->routine);
+	LONGS_EQUAL(0, target->RoutineBlocks(target, 2, &list));
+}
+
+/**
+ * Check WriteJson / WriteDot
+ */
+TEST(Cfg, Write)
+{
+	TextFile* out;
+	std::string s;
+
+	out = new_TextFile(TestOut);
+	out->Open2(out, "w");
+	CHECK(target->WriteJson(target, out));
+	out->Close(out);
+	delete_TextFile(&out);
+	s = ReadAll(TestOut);
+	std::string expectJson =
+		"{\"routine\":\"$008000\",\"blocks\":["
+		"{\"id\":0,\"start\":\"$008000\",\"end\":\"$008005\",\"insns\":2,\"succ\":[1,2],\"pred\":[],\"calls\":[\"$008008\"]},"
+		"{\"id\":1,\"start\":\"$008005\",\"end\":\"$008007\",\"insns\":1,\"succ\":[2],\"pred\":[0],\"calls\":[]},"
+		"{\"id\":2,\"start\":\"$008007\",\"end\":\"$008008\",\"insns\":1,\"succ\":[],\"pred\":[0,1],\"calls\":[]}]}\n"
+		"{\"routine\":\"$008008\",\"blocks\":["
+		"{\"id\":3,\"start\":\"$008008\",\"end\":\"$00800b\",\"insns\":2,\"succ\":[],\"pred\":[],\"calls\":[]}]}\n";
+	STRCMP_EQUAL(expectJson.c_str(), s.c_str());
+
+	out = new_TextFile(TestOut);
+	out->Open2(out, "w");
+	CHECK(target->WriteDot(target, out));
+	out->Close(out);
+	delete_TextFile(&out);
+	s = ReadAll(TestOut);
+	CHECK(0 == s.find("digraph cfg {\n"));
+	CHECK(std::string::npos != s.find("subgraph \"cluster_L008008\" {\n"));
+	CHECK(std::string::npos != s.find("\tb0 -> b2;\n"));
+	CHECK(std::string::npos != s.find("\tb0 -> b3 [style=dashed];\n"));
+}
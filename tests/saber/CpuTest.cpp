@@ -0,0 +1,273 @@
+/**
+ * CpuTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Cpu.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/cpu.sfc"
+
+TEST_GROUP(Cpu)
+{
+	/* test target */
+	Cpu* target;
+	RomFile* rom;
+	RomView* view;
+	InsnStore* store;
+	CpuRegs regs;
+
+	void setup()
+	{
+		target = NULL;
+		rom = NULL;
+		view = NULL;
+		store = NULL;
+	}
+
+	void teardown()
+	{
+		delete_Cpu(&target);
+		delete_InsnStore(&store);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+	}
+
+	/**
+	 * Make the rom(the reset vector is $8000, and NMI is $8100 / stp by default)
+	 */
+	void Load(const uint8* code, const size_t len, const uint8* nmi, const size_t nmiLen)
+	{
+		uint8* data;
+
+		data = Fixture_NewRom(0x10000, true);
+		memcpy(data, code, len);
+		data[0x100] = 0xdb;	/* stp */
+		if(NULL != nmi) memcpy(&data[0x100], nmi, nmiLen);
+		data[0x7fea] = 0x00;	/* NMI(native) */
+		data[0x7feb] = 0x81;
+		Fixture_SaveRom(TestRom, data, 0x10000);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		target = new_Cpu(view);
+	}
+
+	/**
+	 * psw of the stored instruction(or 0xff)
+	 */
+	uint32 Psw(const uint32 pcadr)
+	{
+		uint32 inx;
+
+		inx = store->Search(store, pcadr);
+		if(InsnStore_NotFound == inx) return 0xff;
+		return store->Record(store, inx)->psw & 0x30;
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Cpu, new)
+{
+	static const uint8 code[] = { 0xdb };	/* stp */
+
+	Load(code, sizeof(code), NULL, 0);
+	target->Registers(target, &regs);
+	LONGS_EQUAL(0x008000, regs.pc);
+	LONGS_EQUAL(0x01ff, regs.s);
+	CHECK(regs.e);
+	LONGS_EQUAL(0, target->logCount_get(target));
+	CHECK(0 < target->bytes_get(target));
+
+	delete_Cpu(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the registers after the arithmetic
+ */
+TEST(Cpu, Arithmetic)
+{
+	static const uint8 code[] = {
+		0x18,			/* clc */
+		0xfb,			/* xce */
+		0xc2, 0x30,		/* rep #$30 */
+		0x18,			/* clc */
+		0xa9, 0xff, 0x12,	/* lda #$12ff */
+		0x69, 0x01, 0x00,	/* adc #$0001 */
+		0xa2, 0x34, 0x12,	/* ldx #$1234 */
+		0xe2, 0x29,		/* sep #$29(M / D / C) */
+		0xa0, 0x00, 0x00,	/* ldy #$0000 */
+		0x88,			/* dey */
+		0xa9, 0x19,		/* lda #$19 */
+		0x69, 0x29,		/* adc #$29(decimal + carry) */
+		0xdb,			/* stp */
+	};
+
+	Load(code, sizeof(code), NULL, 0);
+	LONGS_EQUAL(12, target->Run(target, 12));
+	target->Registers(target, &regs);
+	CHECK_FALSE(regs.e);
+	LONGS_EQUAL(0x1349, regs.a);
+	LONGS_EQUAL(0x1234, regs.x);
+	LONGS_EQUAL(0xffff, regs.y);
+	LONGS_EQUAL(0x28, regs.p & 0x39);
+	LONGS_EQUAL(0x008018, regs.pc);
+	CHECK_FALSE(target->Stopped(target, NULL));
+	LONGS_EQUAL(12, target->steps_get(target));
+}
+
+/**
+ * Check the computed jump through the index in RAM
+ */
+TEST(Cpu, ComputedJump)
+{
+	static const uint8 code[] = {
+		0xa9, 0x04,		/* lda #$04 */
+		0x8d, 0x00, 0x02,	/* sta $0200 */
+		0x0a,			/* asl */
+		0xae, 0x00, 0x02,	/* ldx $0200 */
+		0x7c, 0x20, 0x80,	/* jmp ($8020,x) */
+		0xdb,			/* stp */
+	};
+	uint8 all[0x30];
+	uint32 stop;
+
+	memset(all, 0xdb, sizeof(all));
+	memcpy(all, code, sizeof(code));
+	all[0x24] = 0x28;		/* $8028 */
+	all[0x25] = 0x80;
+	all[0x28] = 0xe8;		/* inx */
+
+	Load(all, sizeof(all), NULL, 0);
+	LONGS_EQUAL(8, target->Run(target, 100));
+	target->Registers(target, &regs);
+	LONGS_EQUAL(0x05, regs.x);
+	LONGS_EQUAL(0x08, regs.a);
+
+	/* stopped at $8029, and restarted from NMI */
+	CHECK(target->Stopped(target, &stop));
+	LONGS_EQUAL(0x008100, stop);
+	LONGS_EQUAL(8, target->logCount_get(target));
+	LONGS_EQUAL(0x008028, target->Log(target, 5)->snesadr);
+	LONGS_EQUAL(CpuLog_Head, target->Log(target, 5)->flags);
+	LONGS_EQUAL(0x008009, target->Log(target, 5)->callFrom);
+	LONGS_EQUAL(0x30, target->Log(target, 5)->psw);
+	LONGS_EQUAL(0x008029, target->Log(target, 6)->snesadr);
+	LONGS_EQUAL(0, target->Log(target, 6)->flags);
+	LONGS_EQUAL(0x008100, target->Log(target, 7)->snesadr);
+	POINTERS_EQUAL(NULL, target->Log(target, 8));
+}
+
+/**
+ * Check the restart from the NMI vector, and the executed code
+ */
+TEST(Cpu, Nmi)
+{
+	static const uint8 code[] = {
+		0xdb,			/* stp */
+	};
+	static const uint8 nmi[] = {
+		0xc2, 0x20,		/* rep #$20 */
+		0xa9, 0x00, 0x10,	/* lda #$1000 */
+		0x20, 0x10, 0x81,	/* jsr $8110 */
+		0xdb,			/* stp */
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x1a,			/* inc(at $8110) */
+		0x60,			/* rts */
+	};
+
+	Load(code, sizeof(code), nmi, sizeof(nmi));
+	LONGS_EQUAL(7, target->Run(target, 100));
+	CHECK(target->Stopped(target, NULL));
+	target->Registers(target, &regs);
+	LONGS_EQUAL(0x1001, regs.a);
+	CHECK_FALSE(regs.e);
+
+	/* the call */
+	LONGS_EQUAL(0x008110, target->Log(target, 4)->snesadr);
+	LONGS_EQUAL(CpuLog_Head | CpuLog_Call, target->Log(target, 4)->flags);
+	LONGS_EQUAL(0x008105, target->Log(target, 4)->callFrom);
+	LONGS_EQUAL(1, target->Log(target, 4)->depth);
+	LONGS_EQUAL(0x10, target->Log(target, 4)->psw);
+	LONGS_EQUAL(0, target->Log(target, 6)->depth);
+
+	/* the executed code is stored with its flags */
+	store = new_InsnStore(0x10000);
+	LONGS_EQUAL(7, target->Emit(target, store));
+	LONGS_EQUAL(0, target->Emit(target, store));
+	store->Sort(store);
+	LONGS_EQUAL(7, store->count_get(store));
+	LONGS_EQUAL(4, store->groupCount_get(store));
+	LONGS_EQUAL(0x30, Psw(0x0000));
+	LONGS_EQUAL(0x10, Psw(0x0102));
+	LONGS_EQUAL(0x10, Psw(0x0110));
+	LONGS_EQUAL(0xff, Psw(0x0109));
+}
+
+/**
+ * Check the stubbed registers(the APU port and the multiplier)
+ */
+TEST(Cpu, Registers)
+{
+	static const uint8 code[] = {
+		0xa9, 0xaa,		/* lda #$aa */
+		0xcd, 0x40, 0x21,	/* cmp $2140 */
+		0xd0, 0xf9,		/* bne $8000 */
+		0xa9, 0x07,		/* lda #$07 */
+		0x8d, 0x02, 0x42,	/* sta $4202 */
+		0xa9, 0x06,		/* lda #$06 */
+		0x8d, 0x03, 0x42,	/* sta $4203 */
+		0xad, 0x16, 0x42,	/* lda $4216 */
+		0x2c, 0x12, 0x42,	/* bit $4212 */
+		0x10, 0xfb,		/* bpl */
+		0xdb,			/* stp */
+	};
+
+	Load(code, sizeof(code), NULL, 0);
+	LONGS_EQUAL(10, target->Run(target, 10));
+	target->Registers(target, &regs);
+	LONGS_EQUAL(42, regs.a);
+	LONGS_EQUAL(0x008019, regs.pc);
+}
+
+/**
+ * Check the absolute indexed operand(adc abs,y) under 8 bits M
+ */
+TEST(Cpu, AbsoluteIndexed)
+{
+	static const uint8 code[] = {
+		0xa9, 0x22,		/* lda #$22 */
+		0x8d, 0x03, 0x10,	/* sta $1003 */
+		0xa0, 0x03,		/* ldy #$03 */
+		0x18,			/* clc */
+		0x79, 0x00, 0x10,	/* adc $1000,y */
+		0xea,			/* nop */
+		0xdb,			/* stp */
+	};
+
+	Load(code, sizeof(code), NULL, 0);
+	LONGS_EQUAL(6, target->Run(target, 6));
+	target->Registers(target, &regs);
+	LONGS_EQUAL(0x44, regs.a & 0xff);
+	LONGS_EQUAL(0x00800c, regs.pc);
+
+	/* the operand isn't executed */
+	LONGS_EQUAL(6, target->logCount_get(target));
+	LONGS_EQUAL(0x008008, target->Log(target, 4)->snesadr);
+	LONGS_EQUAL(0x00800b, target->Log(target, 5)->snesadr);
+}
@@ -1,13 +1,23 @@
+#include <pthread.h>
 extern "C"
 {
 #include "common/types.h"
 #include "file/File.h"
 #include "file/RomFile.h"
+#include "file/RomView.h"
 #include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
 #include "sdachi/DisAsm.h"
 }
 
 #include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestRom "wdisasm.sfc"
+#define Threads 4
 
 TEST_GROUP(DisAsm)
 {
@@ -25,3 +35,238 @@ TEST(DisAsm, Create)
 	FAIL("Start here");
 }
 
+/**
+ * DisAsmContext test
+ */
+static void MakeRom(const char* path, const bool valid)
+{
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x8000, valid);
+	memcpy(rom, Fixture_Code, Fixture_CodeSize);
+	Fixture_SaveRom(path, rom, 0x8000);
+}
+
+static long ReadAll(const char* path, char* buf, const long size)
+{
+	FILE* f;
+	long len;
+
+	f = fopen(path, "rb");
+	if(NULL == f) return -1;
+	len = (long)fread(buf, 1, (size_t)size, f);
+	fclose(f);
+	return len;
+}
+
+typedef struct _RunArg {
+	char path[64];
+	bool result;
+	uint32 diags;
+	const RomView* view;	/* shared view, or NULL */
+} RunArg;
+
+static void* RunThread(void* param)
+{
+	RunArg* arg = (RunArg*)param;
+	DisAsmContext* ctx;
+	RomFile* rom;
+	TextFile* out;
+	DisAsmInf inf;
+	int i;
+
+	Fixture_InitInf(&inf);
+
+	/* repeat to overlap the runs */
+	for(i=0; i<20; i++)
+	{
+		rom = NULL;
+		if(NULL == arg->view)
+		{
+			rom = new_RomFile(TestRoot TestRom);
+			rom->Open(rom);
+		}
+		out = new_TextFile(arg->path);
+		out->Open2(out, "w");
+
+		ctx = new_DisAsmContext(&inf);
+		ctx->AddSink(ctx, new_AsmSink(out, false));
+		if(NULL == arg->view)
+		{
+			arg->result = ctx->Run(ctx, rom);
+		}
+		else
+		{
+			arg->result = ctx->RunView(ctx, arg->view);
+		}
+		arg->diags = ctx->diagCount_get(ctx);
+		delete_DisAsmContext(&ctx);
+
+		out->Close(out);
+		delete_TextFile(&out);
+		delete_RomFile(&rom);
+	}
+	return NULL;
+}
+
+TEST_GROUP(DisAsmContext)
+{
+	/* test target */
+	DisAsmContext* target;
+
+	void setup()
+	{
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		target = new_DisAsmContext(&inf);
+	}
+
+	void teardown()
+	{
+		delete_DisAsmContext(&target);
+		remove(TestRoot TestRom);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(DisAsmContext, new)
+{
+	CHECK(NULL != target);
+	LONGS_EQUAL(0, target->diagCount_get(target));
+	POINTERS_EQUAL(NULL, target->Diag(target, 0));
+
+	delete_DisAsmContext(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check diagnostics collection
+ */
+TEST(DisAsmContext, Report)
+{
+	const DisAsmDiag* d;
+
+	target->Report(target, DisAsmDiag_Warn, "test %d : $%06x", 1, 0x8000);
+	target->Report(target, DisAsmDiag_Error, "second");
+	LONGS_EQUAL(2, target->diagCount_get(target));
+
+	d = target->Diag(target, 0);
+	LONGS_EQUAL(DisAsmDiag_Warn, d->level);
+	STRCMP_EQUAL("test 1 : $008000", d->message);
+	d = target->Diag(target, 1);
+	LONGS_EQUAL(DisAsmDiag_Error, d->level);
+	STRCMP_EQUAL("second", d->message);
+}
+
+/**
+ * Check that the errors are kept in the context
+ */
+TEST(DisAsmContext, RunError)
+{
+	RomFile* rom;
+
+	MakeRom(TestRoot TestRom, false);
+	rom = new_RomFile(TestRoot TestRom);
+	rom->Open(rom);
+
+	CHECK_FALSE(target->Run(target, rom));
+	LONGS_EQUAL(1, target->diagCount_get(target));
+	LONGS_EQUAL(DisAsmDiag_Error, target->Diag(target, 0)->level);
+
+	delete_RomFile(&rom);
+}
+
+/**
+ * Check the runs on the threads
+ */
+TEST(DisAsmContext, Threads)
+{
+	pthread_t th[Threads];
+	RunArg args[Threads];
+	static char ref[0x4000];
+	static char buf[0x4000];
+	const char* code;
+	int i;
+
+	MakeRom(TestRoot TestRom, true);
+	for(i=0; i<Threads; i++)
+	{
+		sprintf(args[i].path, TestRoot "wdisasm%d.asm", i);
+		args[i].result = false;
+		args[i].diags = 0xffffffff;
+		args[i].view = NULL;
+		pthread_create(&th[i], NULL, RunThread, &args[i]);
+	}
+	for(i=0; i<Threads; i++)
+	{
+		pthread_join(th[i], NULL);
+	}
+
+	/* the same listing except the file name */
+	CHECK(0 < ReadAll(args[0].path, ref, sizeof(ref)-1));
+	code = strstr(ref, "L008000:");
+	CHECK(NULL != code);
+	CHECK(NULL != strstr(code, "lda.w #$1234"));
+	for(i=0; i<Threads; i++)
+	{
+		CHECK(args[i].result);
+		LONGS_EQUAL(0, args[i].diags);
+		memset(buf, 0, sizeof(buf));
+		CHECK(0 < ReadAll(args[i].path, buf, sizeof(buf)-1));
+		CHECK(NULL != strstr(buf, "L008000:"));
+		STRCMP_EQUAL(code, strstr(buf, "L008000:"));
+		remove(args[i].path);
+	}
+}
+
+/**
+ * Check the runs sharing one rom view
+ */
+TEST(DisAsmContext, SharedView)
+{
+	pthread_t th[Threads];
+	RunArg args[Threads];
+	static char ref[0x4000];
+	static char buf[0x4000];
+	RomFile* rom;
+	RomView* view;
+	const char* code;
+	int i;
+
+	MakeRom(TestRoot TestRom, true);
+	rom = new_RomFile(TestRoot TestRom);
+	rom->Open(rom);
+	view = new_RomView(rom);
+
+	for(i=0; i<Threads; i++)
+	{
+		sprintf(args[i].path, TestRoot "wdisasm%d.asm", i);
+		args[i].result = false;
+		args[i].diags = 0xffffffff;
+		args[i].view = view;
+		pthread_create(&th[i], NULL, RunThread, &args[i]);
+	}
+	for(i=0; i<Threads; i++)
+	{
+		pthread_join(th[i], NULL);
+	}
+	delete_RomView(&view);
+	delete_RomFile(&rom);
+
+	CHECK(0 < ReadAll(args[0].path, ref, sizeof(ref)-1));
+	code = strstr(ref, "L008000:");
+	CHECK(NULL != code);
+	CHECK(NULL != strstr(code, "lda.w #$1234"));
+	for(i=0; i<Threads; i++)
+	{
+		CHECK(args[i].result);
+		LONGS_EQUAL(0, args[i].diags);
+		memset(buf, 0, sizeof(buf));
+		CHECK(0 < ReadAll(args[i].path, buf, sizeof(buf)-1));
+		STRCMP_EQUAL(code, strstr(buf, "L008000:"));
+		remove(args[i].path);
+	}
+}
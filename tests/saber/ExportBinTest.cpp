@@ -0,0 +1,250 @@
+/**
+ * ExportBinTest.cpp
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+extern "C"
+{
+#include "common/types.h"
+#include "common/ReadWrite.h"
+#include "common/List.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/ExportBin.h"
+#include "src/sdachi/ConstProp.protected.h"
+#include "src/sdachi/DisAsm.protected.h"
+}
+
+#define TestRoot "testdata/file/"
+#define WriteFile "wexport.sdb"
+#define WriteRom "wexport.sfc"
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+TEST_GROUP(ExportBin)
+{
+	/* test target */
+	ExportBin* target;
+	uint8 buf[256];
+	size_t len;
+
+	void setup()
+	{
+		uint32 ofs;
+		int col;
+
+		target = NULL;
+		remove(TestRoot WriteFile);
+
+		/* 2 insns, 1 group */
+		memset(buf, 0, sizeof(buf));
+		memcpy(buf, ExportBin_Magic, 8);
+		write16(&buf[8], ExportBin_Version);
+		write16(&buf[10], ExportBin_HeaderSize);
+		write32(&buf[12], 2);
+		write32(&buf[16], 1);
+		write32(&buf[20], 1);
+		ofs = (ExportBin_HeaderSize + 7) & ~7u;
+		for(col = 0; col < ExportBin_ColumnMax; col++)
+		{
+			write32(&buf[24 + 4*col], ofs);
+			switch(col)
+			{
+				case ExportBin_Snes:
+					write32(&buf[ofs], 0x008000);
+					write32(&buf[ofs+4], 0x008002);
+					break;
+				case ExportBin_Pc:
+					write32(&buf[ofs], 0x000000);
+					write32(&buf[ofs+4], 0x000002);
+					break;
+				case ExportBin_Op:
+					buf[ofs] = 0x80;	/* bra */
+					buf[ofs+1] = 0x60;	/* rts */
+					break;
+				case ExportBin_Arg:
+					buf[ofs] = 0x00;
+					break;
+				case ExportBin_Len:
+					buf[ofs] = 1;
+					buf[ofs+1] = 0;
+					break;
+				case ExportBin_Psw:
+					buf[ofs] = 0x30;
+					buf[ofs+1] = 0x30;
+					break;
+				case ExportBin_Target:
+					write32(&buf[ofs], 1);
+					write32(&buf[ofs+4], ExportBin_NoTarget);
+					break;
+				case ExportBin_Group:
+					write32(&buf[ofs], 0);
+					break;
+				case ExportBin_GroupFrom:
+					write32(&buf[ofs], 0x00fffc);
+					break;
+				case ExportBin_GroupDepth:
+					write16(&buf[ofs], 2);
+					break;
+				default:
+					buf[ofs] = 0x30;
+					break;
+			}
+			ofs = (ofs + 8 + 7) & ~7u;
+		}
+		len = ofs;
+	}
+
+	void teardown()
+	{
+		ExportBin_Close(&target);
+		remove(TestRoot WriteFile);
+		remove(TestRoot WriteRom);
+	}
+
+	void WriteBuf(const size_t n)
+	{
+		FILE* fp;
+		fp = fopen(TestRoot WriteFile, "wb");
+		assert(fp);
+		fwrite(buf, 1, n, fp);
+		fclose(fp);
+	}
+};
+
+/**
+ * Check open/accessors
+ */
+TEST(ExportBin, Open)
+{
+	WriteBuf(len);
+	target = ExportBin_Open(TestRoot WriteFile);
+	CHECK(NULL != target);
+
+	LONGS_EQUAL(2, target->insnCount);
+	LONGS_EQUAL(1, target->groupCount);
+	LONGS_EQUAL(1, target->mapMode);
+
+	LONGS_EQUAL(0x008000, ExportBin_SnesAt(target, 0));
+	LONGS_EQUAL(0x008002, ExportBin_SnesAt(target, 1));
+	LONGS_EQUAL(0x000002, ExportBin_PcAt(target, 1));
+	LONGS_EQUAL(0x80, ExportBin_OpAt(target, 0));
+	LONGS_EQUAL(0x60, ExportBin_OpAt(target, 1));
+	LONGS_EQUAL(0x00, ExportBin_ArgAt(target, 0)[0]);
+	LONGS_EQUAL(1, ExportBin_LenAt(target, 0));
+	LONGS_EQUAL(0x30, ExportBin_PswAt(target, 1));
+	LONGS_EQUAL(1, ExportBin_TargetAt(target, 0));
+	LONGS_EQUAL(ExportBin_NoTarget, ExportBin_TargetAt(target, 1));
+
+	LONGS_EQUAL(0, ExportBin_GroupAt(target, 0));
+	LONGS_EQUAL(0x00fffc, ExportBin_GroupFromAt(target, 0));
+	LONGS_EQUAL(2, ExportBin_GroupDepthAt(target, 0));
+	LONGS_EQUAL(0x30, ExportBin_GroupPswAt(target, 0));
+
+	ExportBin_Close(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check broken files
+ */
+TEST(ExportBin, Broken)
+{
+	/* not exist */
+	target = ExportBin_Open(TestRoot WriteFile);
+	POINTERS_EQUAL(NULL, target);
+
+	/* truncated column */
+	WriteBuf(len - 8);
+	target = ExportBin_Open(TestRoot WriteFile);
+	POINTERS_EQUAL(NULL, target);
+
+	/* bad magic */
+	buf[0] = 'X';
+	WriteBuf(len);
+	target = ExportBin_Open(TestRoot WriteFile);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the file written from the pass1 store
+ */
+TEST(ExportBin, Write)
+{
+	DisAsmContext* ctx;
+	DisAsmInf inf;
+	RomFile* rom;
+	RomView* view;
+	InsnStore* store;
+	uint8* data;
+
+	data = Fixture_NewRom(0x8000, true);
+	memcpy(data, Fixture_Code, Fixture_CodeSize);
+	Fixture_SaveRom(TestRoot WriteRom, data, 0x8000);
+	rom = new_RomFile(TestRoot WriteRom);
+	LONGS_EQUAL(FileOpen_NoError, rom->Open(rom));
+	view = new_RomView(rom);
+
+	/* jsr $8010 from the reset vector, and lda #$01 / rts */
+	store = new_InsnStore(0x8000);
+	CHECK(store->Add(store, 0x008000, 0x0000, 0x30));
+	store->AddGroup(store, 0x00fffc, 0);
+	CHECK(store->Add(store, 0x008010, 0x0010, 0x30));
+	store->AddGroup(store, 0x008000, 1);
+	CHECK(store->Add(store, 0x008012, 0x0012, 0x30));
+	store->Sort(store);
+
+	Fixture_InitInf(&inf);
+	ctx = new_DisAsmContext(&inf);
+	CHECK(ExportBin_Write(ctx, TestRoot WriteFile, view, store));
+	delete_DisAsmContext(&ctx);
+
+	target = ExportBin_Open(TestRoot WriteFile);
+	CHECK(NULL != target);
+
+	/* header */
+	LONGS_EQUAL(0, memcmp(target->base, ExportBin_Magic, 8));
+	LONGS_EQUAL(ExportBin_Version, ExportBin_Read16(&target->base[8]));
+	LONGS_EQUAL(ExportBin_HeaderSize, ExportBin_Read16(&target->base[10]));
+	LONGS_EQUAL(3, target->insnCount);
+	LONGS_EQUAL(2, target->groupCount);
+	LONGS_EQUAL(view->mapmode_get(view), target->mapMode);
+
+	/* instructions */
+	LONGS_EQUAL(0x008000, ExportBin_SnesAt(target, 0));
+	LONGS_EQUAL(0x000010, ExportBin_PcAt(target, 1));
+	LONGS_EQUAL(0x008012, ExportBin_SnesAt(target, 2));
+	LONGS_EQUAL(0x20, ExportBin_OpAt(target, 0));
+	LONGS_EQUAL(0xa9, ExportBin_OpAt(target, 1));
+	LONGS_EQUAL(0x60, ExportBin_OpAt(target, 2));
+	LONGS_EQUAL(0x10, ExportBin_ArgAt(target, 0)[0]);
+	LONGS_EQUAL(0x80, ExportBin_ArgAt(target, 0)[1]);
+	LONGS_EQUAL(0x01, ExportBin_ArgAt(target, 1)[0]);
+	LONGS_EQUAL(2, ExportBin_LenAt(target, 0));
+	LONGS_EQUAL(1, ExportBin_LenAt(target, 1));
+	LONGS_EQUAL(0, ExportBin_LenAt(target, 2));
+	LONGS_EQUAL(0x30, ExportBin_PswAt(target, 1));
+	LONGS_EQUAL(1, ExportBin_TargetAt(target, 0));
+	LONGS_EQUAL(ExportBin_NoTarget, ExportBin_TargetAt(target, 1));
+
+	/* groups */
+	LONGS_EQUAL(0, ExportBin_GroupAt(target, 0));
+	LONGS_EQUAL(1, ExportBin_GroupAt(target, 1));
+	LONGS_EQUAL(0x00fffc, ExportBin_GroupFromAt(target, 0));
+	LONGS_EQUAL(0x008000, ExportBin_GroupFromAt(target, 1));
+	LONGS_EQUAL(1, ExportBin_GroupDepthAt(target, 1));
+	LONGS_EQUAL(0x30, ExportBin_GroupPswAt(target, 1));
+
+	delete_InsnStore(&store);
+	delete_RomView(&view);
+	delete_RomFile(&rom);
+}
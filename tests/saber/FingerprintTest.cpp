@@ -0,0 +1,211 @@
+/**
+ * FingerprintTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/Fingerprint.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/fingerprint.sfc"
+#define TestDb "testdata/file/fingerprint.db"
+
+TEST_GROUP(Fingerprint)
+{
+	/* test target */
+	Fingerprint* target;
+	RomFile* rom;
+	RomView* view;
+	InsnStore* store;
+
+	void setup()
+	{
+		target = new_Fingerprint();
+		rom = NULL;
+		view = NULL;
+		store = NULL;
+	}
+
+	void teardown()
+	{
+		delete_Fingerprint(&target);
+		delete_InsnStore(&store);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+		remove(TestDb);
+	}
+
+	/**
+	 * Make the rom(LoROM 64KB) with the routines at the pc addresses
+	 */
+	void Load(const uint32* pcadrs, const uint8* const* codes, const size_t* lens, const int count)
+	{
+		uint8* data;
+		int i;
+
+		data = Fixture_NewRom(0x10000, true);
+		for(i=0; i<count; i++)
+		{
+			memcpy(&data[pcadrs[i]], codes[i], lens[i]);
+		}
+		Fixture_SaveRom(TestRom, data, 0x10000);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		store = new_InsnStore(0x10000);
+	}
+
+	/**
+	 * Add the instructions from the pc address(8 bits registers)
+	 */
+	void AddRoutine(uint32 pcadr, const uint32 len, bool head)
+	{
+		const uint8* ptr;
+		const uint32 end = pcadr + len;
+
+		while(pcadr < end)
+		{
+			store->Add(store, view->Pc2SnesAdr(view, pcadr), pcadr, 0x30);
+			if(head) store->AddGroup(store, 0x808000, 1);
+			head = false;
+			ptr = view->GetPcPtr(view, pcadr);
+			pcadr += 1 + (uint32)Opcode_ArgLength(ptr[0], 0x30);
+		}
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Fingerprint, new)
+{
+	FingerprintHash fp = { 1, Fingerprint_MinInsns };
+
+	LONGS_EQUAL(0, target->count_get(target));
+	LONGS_EQUAL(0, target->conflicts_get(target));
+	POINTERS_EQUAL(NULL, target->Find(target, &fp));
+	CHECK(0 < target->bytes_get(target));
+
+	delete_Fingerprint(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the masked addresses, the kept operands and the end of the routines
+ */
+TEST(Fingerprint, Routines)
+{
+	static const uint8 base[] = {
+		0xad, 0x34, 0x12,	/* lda $1234 */
+		0x8d, 0x00, 0x21,	/* sta $2100 */
+		0x20, 0x00, 0x90,	/* jsr $9000 */
+		0xa9, 0x05,		/* lda #$05 */
+		0xd0, 0x02,		/* bne +2 */
+		0x60,			/* rts */
+	};
+	static const uint8 moved[] = {
+		0xad, 0x78, 0x56,	/* lda $5678 */
+		0x8d, 0x00, 0x21,	/* sta $2100 */
+		0x20, 0x00, 0xa0,	/* jsr $a000 */
+		0xa9, 0x05,		/* lda #$05 */
+		0xd0, 0x02,		/* bne +2 */
+		0x60,			/* rts */
+	};
+	static const uint8 reg[] = {
+		0xad, 0x34, 0x12,	/* lda $1234 */
+		0x8d, 0x01, 0x21,	/* sta $2101 */
+		0x20, 0x00, 0x90,	/* jsr $9000 */
+		0xa9, 0x05,		/* lda #$05 */
+		0xd0, 0x02,		/* bne +2 */
+		0x60,			/* rts */
+	};
+	static const uint8 imm[] = {
+		0xad, 0x34, 0x12,	/* lda $1234 */
+		0x8d, 0x00, 0x21,	/* sta $2100 */
+		0x20, 0x00, 0x90,	/* jsr $9000 */
+		0xa9, 0x06,		/* lda #$06 */
+		0xd0, 0x02,		/* bne +2 */
+		0x60,			/* rts */
+	};
+	static const uint32 pcadrs[] = { 0x0000, 0x0100, 0x0200, 0x0300, 0x0400 };
+	static const uint8* const codes[] = { base, moved, reg, imm, base };
+	static const size_t lens[] = { sizeof(base), sizeof(moved), sizeof(reg), sizeof(imm), sizeof(base) };
+	FingerprintHash hashes[5];
+
+	Load(pcadrs, codes, lens, 5);
+	AddRoutine(0x0000, sizeof(base), true);
+	AddRoutine(0x0100, sizeof(moved), true);
+	AddRoutine(0x0200, sizeof(reg), true);
+	AddRoutine(0x0300, sizeof(imm), true);
+	/* the gap ends the routine */
+	AddRoutine(0x0400, 6, true);
+	AddRoutine(0x0409, 5, false);
+	store->Sort(store);
+	LONGS_EQUAL(5, store->groupCount_get(store));
+
+	Fingerprint_Routines(view, store, hashes);
+	LONGS_EQUAL(6, hashes[0].insns);
+	CHECK(hashes[0].hash == hashes[1].hash);
+	CHECK(hashes[0].hash != hashes[2].hash);
+	CHECK(hashes[0].hash != hashes[3].hash);
+	LONGS_EQUAL(2, hashes[4].insns);
+}
+
+/**
+ * Check the names, and the database file
+ */
+TEST(Fingerprint, Database)
+{
+	FingerprintHash a = { 0x1234567890abcdefULL, 8 };
+	FingerprintHash b = { 0x0000000000000010ULL, 4 };
+	FingerprintHash c = { 0xfedcba0987654321ULL, 12 };
+	FingerprintHash shortFp = { 0x0000000000000020ULL, Fingerprint_MinInsns - 1 };
+	FILE* f;
+
+	CHECK(target->Add(target, &a, "decompress"));
+	CHECK(target->Add(target, &b, "upload_spc"));
+	CHECK_FALSE(target->Add(target, &shortFp, "tiny"));
+	STRCMP_EQUAL("decompress", target->Find(target, &a));
+	STRCMP_EQUAL("upload_spc", target->Find(target, &b));
+	POINTERS_EQUAL(NULL, target->Find(target, &c));
+	POINTERS_EQUAL(NULL, target->Find(target, &shortFp));
+
+	/* the first name is kept */
+	CHECK(target->Add(target, &a, "lz_decode"));
+	CHECK(target->Add(target, &b, "upload_spc"));
+	STRCMP_EQUAL("decompress", target->Find(target, &a));
+	LONGS_EQUAL(2, target->count_get(target));
+	LONGS_EQUAL(1, target->conflicts_get(target));
+
+	/* the loaded fingerprints are added */
+	CHECK(target->Save(target, TestDb));
+	delete_Fingerprint(&target);
+	target = new_Fingerprint();
+	CHECK(target->Add(target, &c, "mul16"));
+	CHECK(target->Add(target, &a, "lz_decode"));
+	CHECK(target->Load(target, TestDb));
+	LONGS_EQUAL(3, target->count_get(target));
+	STRCMP_EQUAL("lz_decode", target->Find(target, &a));
+	STRCMP_EQUAL("upload_spc", target->Find(target, &b));
+	STRCMP_EQUAL("mul16", target->Find(target, &c));
+
+	/* broken files */
+	CHECK_FALSE(target->Load(target, "testdata/file/none.db"));
+	f = fopen(TestDb, "r+b");
+	fseek(f, 16, SEEK_SET);
+	fputc(0xff, f);		/* names size */
+	fclose(f);
+	CHECK_FALSE(target->Load(target, TestDb));
+	LONGS_EQUAL(3, target->count_get(target));
+}
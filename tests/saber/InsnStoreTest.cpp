@@ -0,0 +1,134 @@
+/**
+ * InsnStoreTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+}
+
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(InsnStore)
+{
+	/* test target */
+	InsnStore* target;
+
+	void setup()
+	{
+		target = new_InsnStore(0x10000);
+	}
+
+	void teardown()
+	{
+		delete_InsnStore(&target);
+	}
+};
+
+/**
+ * Check object create
+ */
+TEST(InsnStore, new)
+{
+	CHECK(NULL != target);
+	LONGS_EQUAL(8, sizeof(InsnRec));
+	LONGS_EQUAL(0, target->count_get(target));
+	LONGS_EQUAL(0, target->groupCount_get(target));
+	POINTERS_EQUAL(NULL, target->Record(target, 0));
+	LONGS_EQUAL(InsnStore_NotFound, target->Search(target, 0));
+}
+
+/**
+ * Check Add method
+ */
+TEST(InsnStore, Add)
+{
+	const InsnRec* rec;
+
+	CHECK(target->Add(target, 0x808000, 0x0000, 0x30));
+	CHECK(target->Add(target, 0x808002, 0x0002, 0x20));
+
+	/* dup / out of rom */
+	CHECK_FALSE(target->Add(target, 0x008000, 0x0000, 0x30));
+	CHECK_FALSE(target->Add(target, 0x818000, 0x10000, 0x30));
+	LONGS_EQUAL(2, target->count_get(target));
+
+	rec = target->Record(target, 1);
+	LONGS_EQUAL(0x808002, InsnRec_Snes(rec));
+	LONGS_EQUAL(0x0002, InsnRec_Pc(rec));
+	LONGS_EQUAL(0x20, rec->psw);
+	LONGS_EQUAL(0, rec->flags);
+}
+
+/**
+ * Check groups, Sort and Search method
+ */
+TEST(InsnStore, Sort)
+{
+	const InsnRec* rec;
+	const GroupRec* grp;
+	uint32 i;
+
+	/* out of order, like pass1 */
+	CHECK(target->Add(target, 0x008100, 0x0100, 0x30));
+	target->AddGroup(target, 0xfffc, 0);
+	CHECK(target->Add(target, 0x008102, 0x0102, 0x30));
+	CHECK(target->Add(target, 0x008050, 0x0050, 0x30));
+	target->AddGroup(target, 0x008102, 1);
+	for(i=0; i<5000; i++)
+	{
+		CHECK(target->Add(target, 0x018000+i, 0x8000+i, 0x30));
+	}
+	target->Sort(target);
+
+	LONGS_EQUAL(5003, target->count_get(target));
+	LONGS_EQUAL(2, target->groupCount_get(target));
+	rec = target->Record(target, 0);
+	LONGS_EQUAL(0x0050, InsnRec_Pc(rec));
+	LONGS_EQUAL(InsnRec_GroupHead, rec->flags);
+	rec = target->Record(target, 2);
+	LONGS_EQUAL(0x0102, InsnRec_Pc(rec));
+	LONGS_EQUAL(0, rec->flags);
+
+	grp = target->Group(target, 0);
+	LONGS_EQUAL(0x0050, grp->pcadr);
+	LONGS_EQUAL(0x008102, grp->callFrom);
+	LONGS_EQUAL(1, grp->depth);
+	grp = target->Group(target, 1);
+	LONGS_EQUAL(0x0100, grp->pcadr);
+	LONGS_EQUAL(0xfffc, grp->callFrom);
+
+	LONGS_EQUAL(1, target->Search(target, 0x0100));
+	LONGS_EQUAL(4003, target->Search(target, 0x8000+4000));
+	LONGS_EQUAL(InsnStore_NotFound, target->Search(target, 0x0101));
+}
+
+/**
+ * Check Has and Clear method
+ */
+TEST(InsnStore, Clear)
+{
+	CHECK(target->Add(target, 0x008000, 0x0000, 0x30));
+	target->AddGroup(target, 0xfffc, 0);
+	CHECK(target->Add(target, 0x008001, 0x0001, 0x30));
+	CHECK(target->Add(target, 0x00ffff, 0x7fff, 0x30));
+	CHECK(target->Has(target, 0x0001));
+	CHECK_FALSE(target->Has(target, 0x0002));
+	CHECK_FALSE(target->Has(target, 0x10000));
+
+	target->Clear(target);
+	LONGS_EQUAL(0, target->count_get(target));
+	LONGS_EQUAL(0, target->groupCount_get(target));
+	CHECK_FALSE(target->Has(target, 0x0000));
+	CHECK_FALSE(target->Has(target, 0x7fff));
+
+	/* reusable */
+	CHECK(target->Add(target, 0x008001, 0x0001, 0x20));
+	LONGS_EQUAL(1, target->count_get(target));
+	LONGS_EQUAL(0x20, target->Record(target, 0)->psw);
+}
@@ -0,0 +1,276 @@
+/**
+ * MxFlowTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/InsnStore.h"
+#include "sdachi/MxFlow.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/mxflow.sfc"
+
+TEST_GROUP(MxFlow)
+{
+	/* test target */
+	MxFlow* target;
+	RomFile* rom;
+	RomView* view;
+	InsnStore* store;
+
+	void setup()
+	{
+		target = NULL;
+		rom = NULL;
+		view = NULL;
+		store = NULL;
+	}
+
+	void teardown()
+	{
+		delete_MxFlow(&target);
+		delete_InsnStore(&store);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+	}
+
+	/**
+	 * Trace the code at $8000(and the routine at $8010) from $8000
+	 */
+	void Trace(const uint8* code, const size_t len, const uint8* sub, const size_t subLen, const bool emulation)
+	{
+		uint8* data;
+
+		data = Fixture_NewRom(0x10000, true);
+		memcpy(data, code, len);
+		if(NULL != sub) memcpy(&data[0x10], sub, subLen);
+		Fixture_SaveRom(TestRom, data, 0x10000);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		target = new_MxFlow(view, 0);
+		target->AddEntry(target, 0x008000, 0x30, 0xfffc, emulation);
+		CHECK(target->Run(target));
+		store = new_InsnStore(0x10000);
+		target->Emit(target, store);
+		store->Sort(store);
+	}
+
+	/**
+	 * psw of the instruction(or 0xff)
+	 */
+	uint32 Psw(const uint32 pcadr)
+	{
+		uint32 inx;
+
+		inx = store->Search(store, pcadr);
+		if(InsnStore_NotFound == inx) return 0xff;
+		return store->Record(store, inx)->psw & 0x30;
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(MxFlow, new)
+{
+	static const uint8 code[] = { 0x60 };
+
+	Trace(code, sizeof(code), NULL, 0, false);
+	LONGS_EQUAL(1, target->blockCount_get(target));
+	LONGS_EQUAL(1, target->routineCount_get(target));
+	LONGS_EQUAL(1, target->visits_get(target));
+	CHECK(0 < target->bytes_get(target));
+	CHECK_FALSE(target->Invalid(target, NULL, NULL));
+
+	delete_MxFlow(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the exit state of the callee
+ */
+TEST(MxFlow, ExitState)
+{
+	static const uint8 code[] = {
+		0xc2, 0x30,		/* rep #$30 */
+		0x20, 0x10, 0x80,	/* jsr $8010 */
+		0xa9, 0x01,		/* lda #$01 */
+		0xa2, 0x00, 0x10,	/* ldx #$1000 */
+		0x60,			/* rts */
+	};
+	static const uint8 sub[] = {
+		0xe2, 0x20,		/* sep #$20 */
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x00, Psw(0x0002));
+	LONGS_EQUAL(0x00, Psw(0x0010));
+	LONGS_EQUAL(0x20, Psw(0x0005));
+	LONGS_EQUAL(0x20, Psw(0x0007));
+	LONGS_EQUAL(0x20, Psw(0x000a));
+	LONGS_EQUAL(2, target->routineCount_get(target));
+	LONGS_EQUAL(2, store->groupCount_get(store));
+}
+
+/**
+ * Check php / plp
+ */
+TEST(MxFlow, PhpPlp)
+{
+	static const uint8 code[] = {
+		0xc2, 0x30,		/* rep #$30 */
+		0x20, 0x10, 0x80,	/* jsr $8010 */
+		0xa9, 0x34, 0x12,	/* lda #$1234 */
+		0x60,			/* rts */
+	};
+	static const uint8 sub[] = {
+		0x08,			/* php */
+		0xe2, 0x30,		/* sep #$30 */
+		0xa9, 0x01,		/* lda #$01 */
+		0x28,			/* plp */
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x30, Psw(0x0013));
+	LONGS_EQUAL(0x00, Psw(0x0005));
+	LONGS_EQUAL(0x00, Psw(0x0008));
+}
+
+/**
+ * Check the emulation mode
+ */
+TEST(MxFlow, Emulation)
+{
+	static const uint8 code[] = {
+		0xc2, 0x30,		/* rep #$30(no effect) */
+		0xa9, 0x01,		/* lda #$01 */
+		0x18,			/* clc */
+		0xfb,			/* xce */
+		0xc2, 0x20,		/* rep #$20 */
+		0xa9, 0x34, 0x12,	/* lda #$1234 */
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), NULL, 0, true);
+	LONGS_EQUAL(0x30, Psw(0x0002));
+	LONGS_EQUAL(0x10, Psw(0x0008));
+	LONGS_EQUAL(0x10, Psw(0x000b));
+}
+
+/**
+ * Check the callee which doesn't return, and the join of the branch
+ */
+TEST(MxFlow, Fallback)
+{
+	static const uint8 code[] = {
+		0xc2, 0x10,		/* rep #$10 */
+		0x20, 0x10, 0x80,	/* jsr $8010 */
+		0xf0, 0x02,		/* beq $8009 */
+		0xe2, 0x10,		/* sep #$10 */
+		0xc2, 0x20,		/* rep #$20 */
+		0xa9, 0x34, 0x12,	/* lda #$1234 */
+		0x60,			/* rts */
+	};
+	static const uint8 sub[] = {
+		0x6c, 0x00, 0x00,	/* jmp ($0000) */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x20, Psw(0x0005));
+	LONGS_EQUAL(0x20, Psw(0x0009));
+	LONGS_EQUAL(0x00, Psw(0x000b) & 0x20);
+	LONGS_EQUAL(0x00, Psw(0x000e) & 0x20);
+}
+
+/**
+ * Check the pointer which is stored from the immediate values
+ */
+TEST(MxFlow, ConstPointer)
+{
+	static const uint8 code[] = {
+		0xa9, 0x10,		/* lda #$10 */
+		0x85, 0x00,		/* sta $00 */
+		0xa9, 0x80,		/* lda #$80 */
+		0x85, 0x01,		/* sta $01 */
+		0x64, 0x02,		/* stz $02 */
+		0xdc, 0x00, 0x00,	/* jml [$0000] */
+	};
+	static const uint8 sub[] = {
+		0xc2, 0x20,		/* rep #$20 */
+		0xa9, 0x1b, 0x80,	/* lda #$801b */
+		0x8d, 0x00, 0x01,	/* sta $0100 */
+		0x6c, 0x00, 0x01,	/* jmp ($0100) */
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x30, Psw(0x0010));
+	LONGS_EQUAL(0x10, Psw(0x0012));
+	LONGS_EQUAL(0x10, Psw(0x001b));
+	LONGS_EQUAL(1, target->routineCount_get(target));
+
+	/* the pointers in the low RAM */
+	LONGS_EQUAL(0, target->pointerCount_get(target));
+}
+
+/**
+ * Check the jump table with the known index
+ */
+TEST(MxFlow, ConstTable)
+{
+	static const uint8 code[] = {
+		0xa2, 0x02,		/* ldx #$02 */
+		0x7c, 0x10, 0x80,	/* jmp ($8010,x) */
+	};
+	static const uint8 sub[] = {
+		0x00, 0x00, 0x18, 0x80,	/* .dw $0000, $8018 */
+		0x00, 0x00, 0x00, 0x00,
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x30, Psw(0x0018));
+	LONGS_EQUAL(0xff, Psw(0x0010));
+
+	/* the pointer in the rom */
+	LONGS_EQUAL(2, target->pointerCount_get(target));
+	LONGS_EQUAL(0x0012, target->Pointer(target, 0));
+	LONGS_EQUAL(0x0013, target->Pointer(target, 1));
+}
+
+/**
+ * Check the values are forgotten after the call
+ */
+TEST(MxFlow, ConstCall)
+{
+	static const uint8 code[] = {
+		0xa9, 0x18,		/* lda #$18 */
+		0x85, 0x00,		/* sta $00 */
+		0xa9, 0x80,		/* lda #$80 */
+		0x85, 0x01,		/* sta $01 */
+		0x20, 0x10, 0x80,	/* jsr $8010 */
+		0x6c, 0x00, 0x00,	/* jmp ($0000) */
+	};
+	static const uint8 sub[] = {
+		0x60,			/* rts */
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		0x60,			/* rts */
+	};
+
+	Trace(code, sizeof(code), sub, sizeof(sub), false);
+	LONGS_EQUAL(0x30, Psw(0x000b));
+	LONGS_EQUAL(0xff, Psw(0x0018));
+}
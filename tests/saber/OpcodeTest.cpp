@@ -0,0 +1,237 @@
+/**
+ * OpcodeTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "sdachi/Opcode.h"
+}
+
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Opcode)
+{
+	/* test target */
+	Instruction ins;
+	char buf[16];
+
+	void setup()
+	{
+		memset(&ins, 0, sizeof(Instruction));
+		ins.snesadr = 0x008000;
+		ins.psw = 0x30;
+	}
+
+	void teardown()
+	{
+	}
+};
+
+/**
+ * Check table accessors
+ */
+TEST(Opcode, table)
+{
+	STRCMP_EQUAL("brk", Opcode_Mnemonic(0x00));
+	STRCMP_EQUAL("lda", Opcode_Mnemonic(0xa9));
+	STRCMP_EQUAL("sbc", Opcode_Mnemonic(0xff));
+	LONGS_EQUAL(Adr_immM, Opcode_AdrMode(0xa9));
+	LONGS_EQUAL(Adr_none, Opcode_AdrMode(0xea));
+}
+
+/**
+ * Check ArgLength
+ */
+TEST(Opcode, ArgLength)
+{
+	/* register width dependent */
+	LONGS_EQUAL(1, Opcode_ArgLength(0xa9, 0x30));
+	LONGS_EQUAL(2, Opcode_ArgLength(0xa9, 0x10));
+	LONGS_EQUAL(1, Opcode_ArgLength(0xa2, 0x30));
+	LONGS_EQUAL(2, Opcode_ArgLength(0xa2, 0x20));
+
+	/* fixed */
+	LONGS_EQUAL(0, Opcode_ArgLength(0xea, 0x00));
+	LONGS_EQUAL(1, Opcode_ArgLength(0xc2, 0x00));
+	LONGS_EQUAL(2, Opcode_ArgLength(0x20, 0x00));
+	LONGS_EQUAL(3, Opcode_ArgLength(0x22, 0x00));
+}
+
+/**
+ * Check Operand rendering
+ */
+TEST(Opcode, Operand)
+{
+	/* imm(8bit) */
+	ins.op = 0xa9;
+	ins.arg[0] = 0x12;
+	ins.arglen = 1;
+	LONGS_EQUAL(4, Opcode_Operand(&ins, buf));
+	STRCMP_EQUAL("#$12", buf);
+	STRCMP_EQUAL(".b", Opcode_SizeSuffix(&ins));
+
+	/* imm(16bit) */
+	ins.arg[1] = 0x34;
+	ins.arglen = 2;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("#$3412", buf);
+	STRCMP_EQUAL(".w", Opcode_SizeSuffix(&ins));
+
+	/* stack relative indirect indexed */
+	ins.op = 0x13;
+	ins.arglen = 1;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("($12, s), y", buf);
+
+	/* block move */
+	ins.op = 0x54;
+	ins.arglen = 2;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("$12, $34", buf);
+	STRCMP_EQUAL("", Opcode_SizeSuffix(&ins));
+
+	/* implied */
+	ins.op = 0xea;
+	ins.arglen = 0;
+	LONGS_EQUAL(0, Opcode_Operand(&ins, buf));
+	STRCMP_EQUAL("", buf);
+}
+
+/**
+ * Check Target
+ */
+TEST(Opcode, Target)
+{
+	uint32 target;
+
+	/* jsr */
+	ins.op = 0x20;
+	ins.arg[0] = 0x20;
+	ins.arg[1] = 0x90;
+	ins.arglen = 2;
+	CHECK(Opcode_Target(&ins, &target));
+	LONGS_EQUAL(0x009020, target);
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("L009020", buf);
+
+	/* bra (backward) */
+	ins.op = 0x80;
+	ins.arg[0] = 0xfe;
+	ins.arglen = 1;
+	CHECK(Opcode_Target(&ins, &target));
+	LONGS_EQUAL(0x008000, target);
+
+	/* brl */
+	ins.op = 0x82;
+	ins.arg[0] = 0x00;
+	ins.arg[1] = 0x01;
+	ins.arglen = 2;
+	CHECK(Opcode_Target(&ins, &target));
+	LONGS_EQUAL(0x008103, target);
+
+	/* jml */
+	ins.op = 0x5c;
+	ins.arg[0] = 0x56;
+	ins.arg[1] = 0x34;
+	ins.arg[2] = 0x12;
+	ins.arglen = 3;
+	CHECK(Opcode_Target(&ins, &target));
+	LONGS_EQUAL(0x123456, target);
+
+	/* indirect jump hasn't static destination */
+	ins.op = 0x6c;
+	ins.arglen = 2;
+	CHECK_FALSE(Opcode_Target(&ins, &target));
+
+	/* lda long isn't a jump */
+	ins.op = 0xaf;
+	ins.arglen = 3;
+	CHECK_FALSE(Opcode_Target(&ins, &target));
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("$123456", buf);
+	STRCMP_EQUAL(".l", Opcode_SizeSuffix(&ins));
+}
+
+/**
+ * Check numeric destination
+ */
+TEST(Opcode, Numeric)
+{
+	ins.numeric = true;
+
+	/* jsr */
+	ins.op = 0x20;
+	ins.arg[0] = 0x20;
+	ins.arg[1] = 0x90;
+	ins.arglen = 2;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("$9020", buf);
+	STRCMP_EQUAL(".w", Opcode_SizeSuffix(&ins));
+
+	/* jsl */
+	ins.op = 0x22;
+	ins.arg[2] = 0x01;
+	ins.arglen = 3;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("$019020", buf);
+	STRCMP_EQUAL(".l", Opcode_SizeSuffix(&ins));
+
+	/* bra */
+	ins.op = 0x80;
+	ins.arg[0] = 0x10;
+	ins.arglen = 1;
+	Opcode_Operand(&ins, buf);
+	STRCMP_EQUAL("$8012", buf);
+	STRCMP_EQUAL("", Opcode_SizeSuffix(&ins));
+}
+
+/**
+ * Check Decode
+ */
+TEST(Opcode, Decode)
+{
+	static const uint8 code[] = {0xa9, 0x34, 0x12};
+
+	/* register width dependent */
+	CHECK(Opcode_Decode(code, 3, 0x10, &ins));
+	LONGS_EQUAL(0xa9, ins.op);
+	LONGS_EQUAL(2, ins.arglen);
+	LONGS_EQUAL(0x34, ins.arg[0]);
+	LONGS_EQUAL(0x12, ins.arg[1]);
+	LONGS_EQUAL(0x10, ins.psw);
+	LONGS_EQUAL(0x008000, ins.snesadr);
+
+	CHECK(Opcode_Decode(code, 3, 0x30, &ins));
+	LONGS_EQUAL(1, ins.arglen);
+	LONGS_EQUAL(0, ins.arg[1]);
+
+	/* the operand is cut */
+	CHECK_FALSE(Opcode_Decode(code, 2, 0x10, &ins));
+	CHECK_FALSE(Opcode_Decode(code, 0, 0x30, &ins));
+}
+
+/**
+ * Check Format
+ */
+TEST(Opcode, Format)
+{
+	static const uint8 code[] = {0xa9, 0x34, 0x12};
+	char text[16];
+
+	CHECK(Opcode_Decode(code, 3, 0x10, &ins));
+	LONGS_EQUAL(12, Opcode_Format(&ins, false, text, sizeof(text)));
+	STRCMP_EQUAL("lda.w #$1234", text);
+	LONGS_EQUAL(12, Opcode_Format(&ins, true, text, sizeof(text)));
+	STRCMP_EQUAL("LDA.W #$1234", text);
+
+	/* too small buffer */
+	LONGS_EQUAL(-1, Opcode_Format(&ins, false, text, 12));
+	STRCMP_EQUAL("", text);
+
+	/* implied */
+	ins.op = 0xea;
+	ins.arglen = 0;
+	LONGS_EQUAL(3, Opcode_Format(&ins, false, text, 4));
+	STRCMP_EQUAL("nop", text);
+}
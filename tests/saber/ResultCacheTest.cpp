@@ -0,0 +1,198 @@
+/**
+ * ResultCacheTest.cpp
+ */
+#include <assert.h>
+#include <unistd.h>
+#include <utime.h>
+extern "C"
+{
+#include "common/types.h"
+#include "sdachi/ResultCache.h"
+}
+
+#include "CppUTest/TestHarness.h"
+
+#define TestRoot "testdata/file/"
+#define TestDir TestRoot "cache"
+#define TestOut1 TestRoot "cache1.txt"
+#define TestOut2 TestRoot "cache2.txt"
+
+static void WriteText(const char* path, const char* text)
+{
+	FILE* f;
+
+	f = fopen(path, "wb");
+	fputs(text, f);
+	fclose(f);
+}
+
+static void ReadText(const char* path, char* buf, const size_t size)
+{
+	FILE* f;
+	size_t len = 0;
+
+	buf[0] = '\0';
+	f = fopen(path, "rb");
+	if(NULL == f) return;
+	len = fread(buf, 1, size-1, f);
+	buf[len] = '\0';
+	fclose(f);
+}
+
+static void RemoveEntry(const char* key)
+{
+	char path[256];
+
+	sprintf(path, TestDir "/%s/0", key);
+	remove(path);
+	sprintf(path, TestDir "/%s/1", key);
+	remove(path);
+	sprintf(path, TestDir "/%s", key);
+	rmdir(path);
+}
+
+TEST_GROUP(ResultCache)
+{
+	/* test target */
+	ResultCache* target;
+
+	void setup()
+	{
+		target = new_ResultCache(TestDir, 1024);
+	}
+
+	void teardown()
+	{
+		delete_ResultCache(&target);
+		remove(TestOut1);
+		remove(TestOut2);
+		rmdir(TestDir);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(ResultCache, new)
+{
+	CHECK(NULL != target);
+	CHECK(0 == access(TestDir, F_OK));
+
+	delete_ResultCache(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the key
+ */
+TEST(ResultCache, Key)
+{
+	ResultCache* other;
+
+	/* FNV-1a of the empty data */
+	STRCMP_EQUAL("cbf29ce484222325", target->key_get(target));
+	target->AddKey(target, "a", 1);
+	STRCMP_EQUAL("af63dc4c8601ec8c", target->key_get(target));
+
+	/* the string is separated by its terminator */
+	other = new_ResultCache(TestDir, 1024);
+	target->AddKeyString(target, "bc");
+	other->AddKeyString(other, "ab");
+	other->AddKeyString(other, "c");
+	CHECK(0 != strcmp(target->key_get(target), other->key_get(other)));
+	delete_ResultCache(&other);
+
+	/* the file contents */
+	WriteText(TestOut1, "a");
+	other = new_ResultCache(TestDir, 1024);
+	CHECK(other->AddKeyFile(other, TestOut1));
+	STRCMP_EQUAL("af63dc4c8601ec8c", other->key_get(other));
+	CHECK_FALSE(other->AddKeyFile(other, TestRoot "none.txt"));
+	delete_ResultCache(&other);
+}
+
+/**
+ * Check Store / Fetch methods
+ */
+TEST(ResultCache, StoreFetch)
+{
+	const char* paths[] = { TestOut1, TestOut2 };
+	char buf[64];
+
+	target->AddKeyString(target, "store");
+	CHECK_FALSE(target->Fetch(target, paths, 2));
+
+	WriteText(TestOut1, "first");
+	WriteText(TestOut2, "second");
+	CHECK(target->Store(target, paths, 2));
+	/* already stored */
+	CHECK(target->Store(target, paths, 2));
+
+	remove(TestOut1);
+	WriteText(TestOut2, "changed");
+	CHECK(target->Fetch(target, paths, 2));
+	ReadText(TestOut1, buf, sizeof(buf));
+	STRCMP_EQUAL("first", buf);
+	ReadText(TestOut2, buf, sizeof(buf));
+	STRCMP_EQUAL("second", buf);
+
+	/* broken entry */
+	sprintf(buf, TestDir "/%s/1", target->key_get(target));
+	remove(buf);
+	CHECK_FALSE(target->Fetch(target, paths, 2));
+
+	RemoveEntry(target->key_get(target));
+}
+
+/**
+ * Check Evict method
+ */
+TEST(ResultCache, Evict)
+{
+	const char* paths[] = { TestOut1 };
+	ResultCache* old;
+	ResultCache* used;
+	struct utimbuf t;
+	char data[601];
+	char path[256];
+
+	/* 600 bytes entries in the 1024 bytes cache */
+	memset(data, 'x', 600);
+	data[600] = '\0';
+	WriteText(TestOut1, data);
+
+	old = new_ResultCache(TestDir, 1024);
+	old->AddKeyString(old, "old");
+	CHECK(old->Store(old, paths, 1));
+	sprintf(path, TestDir "/%s", old->key_get(old));
+	t.actime = t.modtime = 1000;
+	utime(path, &t);
+
+	used = new_ResultCache(TestDir, 1024);
+	used->AddKeyString(used, "used");
+	CHECK(used->Store(used, paths, 1));
+	sprintf(path, TestDir "/%s", used->key_get(used));
+	t.actime = t.modtime = 2000;
+	utime(path, &t);
+
+	target->AddKeyString(target, "new");
+	CHECK(target->Store(target, paths, 1));
+	sprintf(path, TestDir "/%s", target->key_get(target));
+	t.actime = t.modtime = 3000;
+	utime(path, &t);
+
+	/* the hit makes it the most recently used */
+	CHECK(used->Fetch(used, paths, 1));
+	target->Evict(target);
+
+	sprintf(path, TestDir "/%s", old->key_get(old));
+	LONGS_EQUAL(-1, access(path, F_OK));
+	sprintf(path, TestDir "/%s", target->key_get(target));
+	LONGS_EQUAL(-1, access(path, F_OK));
+	sprintf(path, TestDir "/%s", used->key_get(used));
+	LONGS_EQUAL(0, access(path, F_OK));
+
+	RemoveEntry(used->key_get(used));
+	delete_ResultCache(&old);
+	delete_ResultCache(&used);
+}
@@ -0,0 +1,189 @@
+/**
+ * RomDiffTest.cpp
+ */
+#include <assert.h>
+#include <string>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/RomDiff.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define OldRom TestRoot "diff-old.sfc"
+#define NewRom TestRoot "diff-new.sfc"
+#define TestOut TestRoot "diff.txt"
+
+static void MakeRom(const char* path, const uint8 imm, const uint8 data)
+{
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x8000, true);
+	memcpy(rom, Fixture_Code, Fixture_CodeSize);
+	rom[0x11] = imm;
+	rom[0x1000] = data;
+	Fixture_SaveRom(path, rom, 0x8000);
+}
+
+static std::string ReadReport()
+{
+	std::string text;
+	char buf[256];
+	FILE* f;
+	size_t len;
+
+	f = fopen(TestOut, "rb");
+	if(NULL == f) return text;
+	while(0 != (len = fread(buf, 1, sizeof(buf), f)))
+	{
+		text.append(buf, len);
+	}
+	fclose(f);
+	return text;
+}
+
+TEST_GROUP(RomDiff)
+{
+	/* test target */
+	RomDiff* target;
+
+	void setup()
+	{
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		target = new_RomDiff(&inf);
+	}
+
+	void teardown()
+	{
+		delete_RomDiff(&target);
+		remove(OldRom);
+		remove(NewRom);
+		remove(TestOut);
+	}
+
+	bool Compare()
+	{
+		RomFile* oldRom;
+		RomFile* newRom;
+		RomView* oldView;
+		RomView* newView;
+		TextFile* out;
+		bool result;
+
+		oldRom = new_RomFile(OldRom);
+		newRom = new_RomFile(NewRom);
+		oldRom->Open(oldRom);
+		newRom->Open(newRom);
+		oldView = new_RomView(oldRom);
+		newView = new_RomView(newRom);
+		out = new_TextFile(TestOut);
+		out->Open2(out, "w");
+
+		result = target->Run(target, oldView, newView, out);
+
+		out->Close(out);
+		delete_TextFile(&out);
+		delete_RomView(&oldView);
+		delete_RomView(&newView);
+		delete_RomFile(&oldRom);
+		delete_RomFile(&newRom);
+		return result;
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(RomDiff, new)
+{
+	CHECK(NULL != target);
+
+	delete_RomDiff(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the same roms
+ */
+TEST(RomDiff, Same)
+{
+	std::string report;
+
+	MakeRom(OldRom, 0x01, 0x00);
+	MakeRom(NewRom, 0x01, 0x00);
+	CHECK(Compare());
+
+	LONGS_EQUAL(0, target->count_get(target, RomDiff_Changed));
+	LONGS_EQUAL(0, target->count_get(target, RomDiff_Affected));
+	LONGS_EQUAL(0, target->count_get(target, RomDiff_Data));
+	report = ReadReport();
+	CHECK(std::string::npos == report.find("\nL"));
+	CHECK(std::string::npos != report.find("; 0 changed, 0 affected, 0 added, 0 removed routines, 0 data ranges\n"));
+}
+
+/**
+ * Check the changed routine, its caller and the data
+ */
+TEST(RomDiff, Changed)
+{
+	std::string report;
+
+	MakeRom(OldRom, 0x01, 0x00);
+	MakeRom(NewRom, 0x05, 0x55);
+	CHECK(Compare());
+
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Changed));
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Affected));
+	LONGS_EQUAL(0, target->count_get(target, RomDiff_Added));
+	LONGS_EQUAL(0, target->count_get(target, RomDiff_Removed));
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Data));
+
+	report = ReadReport();
+	CHECK(std::string::npos != report.find(
+				"\naffected $008000 (call from $00fffc) : reaches $008010\n"
+				"\nchanged  $008010 (call from $008000)\n"
+				"-L008010:\tlda.b #$01         ; a9 01 (m8 x8)\n"
+				"+L008010:\tlda.b #$05         ; a9 05 (m8 x8)\n"
+				"\ndata     $809000-$809000 (1 bytes)\n"));
+	/* the unchanged instructions aren't written */
+	CHECK(std::string::npos == report.find("rts"));
+}
+
+/**
+ * Check the added / removed routines
+ */
+TEST(RomDiff, AddedRemoved)
+{
+	std::string report;
+
+	/* "jsr $8010" is changed to "jsr $8020" */
+	MakeRom(OldRom, 0x01, 0x00);
+	MakeRom(NewRom, 0x01, 0x00);
+	{
+		FILE* f = fopen(NewRom, "rb+");
+		fseek(f, 0x01, SEEK_SET);
+		fputc(0x20, f);
+		fclose(f);
+	}
+	CHECK(Compare());
+
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Changed));
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Added));
+	LONGS_EQUAL(1, target->count_get(target, RomDiff_Removed));
+	report = ReadReport();
+	CHECK(std::string::npos != report.find("\nremoved  $008010 (call from $008000)\n-L008010:"));
+	CHECK(std::string::npos != report.find("\nadded    $008020 (call from $008000)\n+L008020:\tbrk"));
+}
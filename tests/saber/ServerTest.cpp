@@ -0,0 +1,307 @@
+/**
+ * ServerTest.cpp
+ */
+#include <assert.h>
+#include <string>
+#include <algorithm>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/time.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "file/TextFile.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+#include "sdachi/Analysis.h"
+#include "sdachi/DisAsm.h"
+#include "sdachi/Server.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRoot "testdata/file/"
+#define TestRom "server.sfc"
+#define TestSocket "testdata/file/server.sock"
+
+static void MakeRom(const char* path)
+{
+	uint8* rom;
+
+	rom = Fixture_NewRom(0x8000, true);
+	memcpy(rom, Fixture_Code, Fixture_CodeSize);
+	rom[0x20] = 0xa9;	/* lda #$0002 (not reached from the reset vector) */
+	rom[0x21] = 0x02;
+	rom[0x22] = 0x00;
+	rom[0x23] = 0x60;	/* rts */
+	Fixture_SaveRom(path, rom, 0x8000);
+}
+
+static void* ServeThread(void* param)
+{
+	Server* server = (Server*)param;
+
+	server->Serve(server, TestSocket);
+	return NULL;
+}
+
+/**
+ * Connect to the server(the reads time out in 5 sec)
+ */
+static int Connect(void)
+{
+	struct sockaddr_un addr;
+	struct timeval tv = { 5, 0 };
+	int fd;
+	int i;
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, TestSocket);
+	for(i=0; i<100; i++)
+	{
+		if(0 == connect(fd, (struct sockaddr*)&addr, sizeof(addr))) return fd;
+		usleep(10000);
+	}
+	close(fd);
+	return -1;
+}
+
+/**
+ * Send the request, and read the response line
+ */
+static std::string Call(const int fd, const char* req)
+{
+	std::string line;
+	char c;
+
+	if((ssize_t)strlen(req) != write(fd, req, strlen(req))) return line;
+	while((1 == read(fd, &c, 1)) && ('\n' != c))
+	{
+		line += c;
+	}
+	return line;
+}
+
+TEST_GROUP(Server)
+{
+	/* test target */
+	Server* target;
+	char* res;
+
+	void setup()
+	{
+		DisAsmInf inf;
+
+		Fixture_InitInf(&inf);
+		MakeRom(TestRoot TestRom);
+		target = new_Server(&inf, 2);
+		res = NULL;
+	}
+
+	void teardown()
+	{
+		free(res);
+		delete_Server(&target);
+		remove(TestRoot TestRom);
+	}
+
+	const char* Request(const char* req)
+	{
+		free(res);
+		res = target->Handle(target, req);
+		return res;
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Server, new)
+{
+	CHECK(NULL != target);
+
+	delete_Server(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check load / identify requests
+ */
+TEST(Server, Load)
+{
+	const std::string info = "\"path\":\"" TestRoot TestRom "\",\"map\":\"LoRom\",\"mapmode\":32,"
+		"\"size\":32768,\"sum\":2618,\"validSum\":false";
+	std::string expected;
+
+	expected = "{\"id\":7,\"ok\":true,\"rom\":1," + info + ",\"instructions\":9}";
+	STRCMP_EQUAL(expected.c_str(), Request("{\"id\":7,\"op\":\"load\",\"path\":\"" TestRoot TestRom "\"}"));
+
+	/* already loaded */
+	expected = "{\"ok\":true,\"rom\":1," + info + ",\"instructions\":9}";
+	STRCMP_EQUAL(expected.c_str(), Request(" { \"path\" : \"testdata\\/file\\/server.sfc\", \"op\" : \"load\" } "));
+
+	expected = "{\"id\":\"a\",\"ok\":true,\"rom\":1," + info + ",\"instructions\":9}";
+	STRCMP_EQUAL(expected.c_str(), Request("{\"op\":\"identify\",\"rom\":1,\"id\":\"a\"}"));
+	expected = "{\"ok\":true," + info + "}";
+	STRCMP_EQUAL(expected.c_str(), Request("{\"op\":\"identify\",\"path\":\"" TestRoot TestRom "\"}"));
+
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Can't open \\\"" TestRoot "none.sfc\\\"\"}",
+			Request("{\"op\":\"load\",\"path\":\"" TestRoot "none.sfc\"}"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Unknown rom : 2\"}",
+			Request("{\"op\":\"identify\",\"rom\":2}"));
+}
+
+/**
+ * Check disassemble-range / xref requests
+ */
+TEST(Server, Query)
+{
+	Request("{\"op\":\"load\",\"path\":\"" TestRoot TestRom "\"}");
+
+	STRCMP_EQUAL("{\"ok\":true,\"lines\":["
+			"{\"snes\":32773,\"pc\":5,\"bytes\":\"a93412\",\"text\":\"lda.w #$1234\",\"m\":16,\"x\":8},"
+			"{\"snes\":32776,\"pc\":8,\"bytes\":\"d002\",\"text\":\"bne L00800c\",\"m\":16,\"x\":8,\"target\":32780}"
+			"]}",
+			Request("{\"op\":\"disassemble-range\",\"rom\":1,\"start\":\"$8006\",\"end\":\"0x800a\"}"));
+	STRCMP_EQUAL("{\"ok\":true,\"lines\":[]}",
+			Request("{\"op\":\"disassemble-range\",\"rom\":1,\"start\":32800,\"end\":32900}"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid range : $007000-$008000\"}",
+			Request("{\"op\":\"disassemble-range\",\"rom\":1,\"start\":\"$7000\",\"end\":\"$8000\"}"));
+
+	STRCMP_EQUAL("{\"ok\":true,\"refs\":["
+			"{\"snes\":32768,\"pc\":0,\"bytes\":\"201080\",\"text\":\"jsr L008010\",\"m\":8,\"x\":8,\"target\":32784}"
+			"]}",
+			Request("{\"op\":\"xref\",\"rom\":1,\"snes\":\"$8010\"}"));
+	STRCMP_EQUAL("{\"ok\":true,\"refs\":[]}",
+			Request("{\"op\":\"xref\",\"rom\":1,\"snes\":\"$8020\"}"));
+}
+
+/**
+ * Check add-entry request
+ */
+TEST(Server, AddEntry)
+{
+	Request("{\"op\":\"load\",\"path\":\"" TestRoot TestRom "\"}");
+
+	STRCMP_EQUAL("{\"ok\":true,\"rom\":1,\"instructions\":11}",
+			Request("{\"op\":\"add-entry\",\"rom\":1,\"snes\":\"$8020\",\"m\":16}"));
+	STRCMP_EQUAL("{\"ok\":true,\"lines\":["
+			"{\"snes\":32800,\"pc\":32,\"bytes\":\"a90200\",\"text\":\"lda.w #$0002\",\"m\":16,\"x\":8},"
+			"{\"snes\":32803,\"pc\":35,\"bytes\":\"60\",\"text\":\"rts\",\"m\":16,\"x\":8}"
+			"]}",
+			Request("{\"op\":\"disassemble-range\",\"rom\":1,\"start\":\"$8020\",\"end\":\"$8030\"}"));
+
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid snes address : $7e0000\"}",
+			Request("{\"op\":\"add-entry\",\"rom\":1,\"snes\":\"$7e0000\"}"));
+	CHECK(NULL != strstr(Request("{\"op\":\"identify\",\"rom\":1}"), ",\"instructions\":11}"));
+}
+
+/**
+ * Check the invalid requests
+ */
+TEST(Server, Invalid)
+{
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid request\"}", Request(""));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid request\"}", Request("{\"op\":\"load\""));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid request\"}", Request("{\"op\":[1]}"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Invalid request\"}", Request("{\"op\":\"load\"} x"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"Unknown op\"}", Request("{}"));
+	STRCMP_EQUAL("{\"id\":null,\"ok\":false,\"error\":\"Unknown op\"}", Request("{\"id\":null,\"op\":\"\\u0041\"}"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"\\\"path\\\" is required\"}", Request("{\"op\":\"load\"}"));
+	STRCMP_EQUAL("{\"ok\":false,\"error\":\"\\\"rom\\\" is required\"}", Request("{\"op\":\"xref\",\"snes\":1}"));
+}
+
+/**
+ * Check the requests over the socket
+ */
+TEST(Server, Serve)
+{
+	struct sockaddr_un addr;
+	pthread_t th;
+	char buf[512];
+	size_t len = 0;
+	ssize_t n;
+	int fd;
+	int i;
+
+	remove(TestSocket);
+	pthread_create(&th, NULL, ServeThread, target);
+
+	fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strcpy(addr.sun_path, TestSocket);
+	for(i=0; i<100; i++)
+	{
+		if(0 == connect(fd, (struct sockaddr*)&addr, sizeof(addr))) break;
+		usleep(10000);
+	}
+	CHECK(100 > i);
+
+	/* two requests in one write */
+	const char* req = "{\"id\":1,\"op\":\"load\",\"path\":\"" TestRoot TestRom "\"}\r\n"
+		"{\"id\":2,\"op\":\"xref\",\"rom\":1,\"snes\":32784}\n";
+	LONGS_EQUAL(strlen(req), write(fd, req, strlen(req)));
+	while((len < sizeof(buf)-1) && (2 > std::count(buf, buf+len, '\n')))
+	{
+		n = read(fd, &buf[len], sizeof(buf)-1-len);
+		if(0 >= n) break;
+		len += (size_t)n;
+	}
+	buf[len] = '\0';
+	close(fd);
+
+	target->Stop(target);
+	pthread_join(th, NULL);
+
+	LONGS_EQUAL(0, strncmp("{\"id\":1,\"ok\":true,\"rom\":1,", buf, 26));
+	CHECK(NULL != strstr(buf, "\n{\"id\":2,\"ok\":true,\"refs\":[{\"snes\":32768,"));
+	LONGS_EQUAL(-1, access(TestSocket, F_OK));
+}
+
+/**
+ * Check the clients more than the workers are served together
+ */
+TEST(Server, ServeClients)
+{
+	pthread_t th;
+	std::string res;
+	char req[128];
+	int fds[5];
+	int i;
+
+	remove(TestSocket);
+	pthread_create(&th, NULL, ServeThread, target);
+
+	/* the connections are kept open */
+	for(i=0; i<5; i++)
+	{
+		fds[i] = Connect();
+		CHECK(0 <= fds[i]);
+	}
+	for(i=4; 0<=i; i--)
+	{
+		sprintf(req, "{\"id\":%d,\"op\":\"load\",\"path\":\"" TestRoot TestRom "\"}\n", i);
+		res = Call(fds[i], req);
+		sprintf(req, "{\"id\":%d,\"ok\":true,", i);
+		LONGS_EQUAL(0, strncmp(req, res.c_str(), strlen(req)));
+	}
+	for(i=0; i<5; i++)
+	{
+		res = Call(fds[i], "{\"op\":\"xref\",\"rom\":1,\"snes\":32784}\n");
+		LONGS_EQUAL(0, strncmp("{\"ok\":true,\"refs\":", res.c_str(), 18));
+		close(fds[i]);
+	}
+
+	target->Stop(target);
+	pthread_join(th, NULL);
+}
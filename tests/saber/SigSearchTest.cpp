@@ -0,0 +1,117 @@
+/**
+ * SigSearchTest.cpp
+ */
+#include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Signature.h"
+#include "sdachi/SigSearch.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestDir "testdata/file/sigroms"
+#define TestRom1 TestDir "/b.sfc"
+#define TestRom2 TestDir "/a.sfc"
+
+/**
+ * Make the rom(LoROM 64KB) with the code at the pc address
+ */
+static void WriteRom(const char* path, const uint32 pcadr, const uint8* code, const size_t len)
+{
+	uint8* data;
+
+	data = Fixture_NewRom(0x10000, true);
+	memcpy(&data[pcadr], code, len);
+	Fixture_SaveRom(path, data, 0x10000);
+}
+
+TEST_GROUP(SigSearch)
+{
+	/* test target */
+	SigSearch* target;
+	Signature* sigs;
+
+	void setup()
+	{
+		static const uint8 code1[] = { 0xc2, 0x30, 0xa9, 0x00, 0x80 };
+		static const uint8 code2[] = { 0xa9, 0x00, 0x80, 0xa9, 0x01, 0x80 };
+
+		mkdir(TestDir, 0777);
+		WriteRom(TestRom1, 0x0010, code1, sizeof(code1));
+		WriteRom(TestRom2, 0x8000, code2, sizeof(code2));
+
+		sigs = new_Signature();
+		sigs->Add(sigs, "rep", "c2 30");
+		sigs->Add(sigs, "lda", "a9 ?? 80");
+		target = new_SigSearch(sigs, 2);
+	}
+
+	void teardown()
+	{
+		delete_SigSearch(&target);
+		delete_Signature(&sigs);
+		remove(TestRom1);
+		remove(TestRom2);
+		rmdir(TestDir);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(SigSearch, new)
+{
+	LONGS_EQUAL(0, target->count_get(target));
+	POINTERS_EQUAL(NULL, target->Result(target, 0));
+	CHECK(target->Run(target));
+
+	delete_SigSearch(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the roms in the directory(in the order of the name), and the rom
+ * which can't be opened
+ */
+TEST(SigSearch, Run)
+{
+	const SigSearchResult* r;
+
+	CHECK(target->AddPath(target, TestDir));
+	CHECK(target->AddPath(target, TestDir "/none.sfc"));
+	LONGS_EQUAL(3, target->count_get(target));
+	CHECK_FALSE(target->Run(target));
+
+	r = target->Result(target, 0);
+	STRCMP_EQUAL(TestRom2, r->rom);
+	CHECK(r->ok);
+	LONGS_EQUAL(2, r->count);
+	LONGS_EQUAL(1, r->matches[0].sig);
+	LONGS_EQUAL(0x8000, r->matches[0].pcadr);
+	LONGS_EQUAL(0x818000, r->matches[0].snesadr);
+	LONGS_EQUAL(0x8003, r->matches[1].pcadr);
+
+	r = target->Result(target, 1);
+	STRCMP_EQUAL(TestRom1, r->rom);
+	CHECK(r->ok);
+	LONGS_EQUAL(2, r->count);
+	LONGS_EQUAL(0, r->matches[0].sig);
+	LONGS_EQUAL(0x0010, r->matches[0].pcadr);
+	LONGS_EQUAL(0x0012, r->matches[1].pcadr);
+
+	r = target->Result(target, 2);
+	CHECK_FALSE(r->ok);
+	LONGS_EQUAL(0, r->count);
+
+	/* run again */
+	CHECK_FALSE(target->Run(target));
+	LONGS_EQUAL(2, target->Result(target, 1)->count);
+}
@@ -0,0 +1,186 @@
+/**
+ * SignatureTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Signature.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/signature.sfc"
+#define TestSigs "testdata/file/signature.txt"
+
+TEST_GROUP(Signature)
+{
+	/* test target */
+	Signature* target;
+	RomFile* rom;
+	RomView* view;
+	SignatureMatch* matches;
+
+	void setup()
+	{
+		target = new_Signature();
+		rom = NULL;
+		view = NULL;
+		matches = NULL;
+	}
+
+	void teardown()
+	{
+		free(matches);
+		delete_Signature(&target);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+		remove(TestSigs);
+	}
+
+	/**
+	 * Make the rom(LoROM 64KB) with the code at the pc address
+	 */
+	void Load(const uint32 pcadr, const uint8* code, const size_t len)
+	{
+		uint8* data;
+
+		data = Fixture_NewRom(0x10000, true);
+		memcpy(&data[pcadr], code, len);
+		Fixture_SaveRom(TestRom, data, 0x10000);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(Signature, new)
+{
+	LONGS_EQUAL(0, target->count_get(target));
+	POINTERS_EQUAL(NULL, target->Name(target, 0));
+	STRCMP_EQUAL("", target->error_get(target));
+	CHECK(0 < target->bytes_get(target));
+
+	delete_Signature(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the patterns
+ */
+TEST(Signature, Add)
+{
+	CHECK(target->Add(target, "lda", "a9 ?? 8d 0? 21"));
+	CHECK(target->Add(target, "packed", "C230A9??"));
+	LONGS_EQUAL(2, target->count_get(target));
+	STRCMP_EQUAL("lda", target->Name(target, 0));
+	LONGS_EQUAL(5, target->Length(target, 0));
+	LONGS_EQUAL(4, target->Length(target, 1));
+
+	CHECK_FALSE(target->Add(target, "odd", "a9 0"));
+	STRCMP_EQUAL("odd : broken pattern", target->error_get(target));
+	CHECK_FALSE(target->Add(target, "wild", "?? 0? ?1"));
+	STRCMP_EQUAL("wild : no fixed byte", target->error_get(target));
+	CHECK_FALSE(target->Add(target, "text", "lda #$00"));
+	CHECK_FALSE(target->Add(target, "empty", ""));
+	LONGS_EQUAL(2, target->count_get(target));
+}
+
+/**
+ * Check the matches of the wildcards, the anchors in the other anchors,
+ * and the edges of the rom
+ */
+TEST(Signature, Scan)
+{
+	static const uint8 code[] = {
+		0xc2, 0x30,		/* rep #$30 */
+		0xa9, 0x00, 0x80,	/* lda #$8000 */
+		0x8d, 0x04, 0x21,	/* sta $2104 */
+		0xa9, 0x12, 0x00,	/* lda #$0012 */
+		0x8d, 0x05, 0x21,	/* sta $2105 */
+	};
+	uint32 count;
+
+	Load(0x0000, code, sizeof(code));
+	CHECK(target->Add(target, "sta21", "8d 0? 21"));
+	CHECK(target->Add(target, "lda", "a9 ?? ?? 8d"));
+	CHECK(target->Add(target, "rep", "c2 30 a9"));
+	CHECK(target->Add(target, "head", "?? ?? ?? c2 30"));	/* before the rom */
+	CHECK(target->Add(target, "tail", "00 00 ??"));	/* the end of the rom */
+	CHECK(target->Add(target, "none", "8d 06 21"));
+	CHECK(target->Add(target, "a9", "a9"));
+
+	count = target->Scan(target, view, &matches);
+	CHECK(target->stateCount_get(target) <= 14);	/* the root and the anchors */
+
+	/* the zeros after the code match "tail" */
+	CHECK(7 < count);
+	LONGS_EQUAL(2, matches[0].sig);		/* rep */
+	LONGS_EQUAL(0x0000, matches[0].pcadr);
+	LONGS_EQUAL(0x808000, matches[0].snesadr);
+	LONGS_EQUAL(1, matches[1].sig);		/* lda */
+	LONGS_EQUAL(0x0002, matches[1].pcadr);
+	LONGS_EQUAL(6, matches[2].sig);		/* a9 */
+	LONGS_EQUAL(0x0002, matches[2].pcadr);
+	LONGS_EQUAL(0, matches[3].sig);		/* sta21 */
+	LONGS_EQUAL(0x0005, matches[3].pcadr);
+	LONGS_EQUAL(1, matches[4].sig);
+	LONGS_EQUAL(0x0008, matches[4].pcadr);
+	LONGS_EQUAL(6, matches[5].sig);
+	LONGS_EQUAL(0, matches[6].sig);
+	LONGS_EQUAL(0x000b, matches[6].pcadr);
+	LONGS_EQUAL(0x80800b, matches[6].snesadr);
+
+	/* the last one ends at the end of the rom */
+	LONGS_EQUAL(4, matches[count - 1].sig);
+	LONGS_EQUAL(0xfffd, matches[count - 1].pcadr);
+	LONGS_EQUAL(0x81fffd, matches[count - 1].snesadr);
+}
+
+/**
+ * Check the signature file
+ */
+TEST(Signature, Load)
+{
+	FILE* f;
+	uint32 count;
+
+	f = fopen(TestSigs, "wb");
+	fputs("# known routines\r\n", f);
+	fputs("\r\n", f);
+	fputs("  rep16   c2 30   # rep #$30\r\n", f);
+	fputs("sta2104\t8d 04 21\n", f);
+	fclose(f);
+
+	CHECK(target->Load(target, TestSigs));
+	LONGS_EQUAL(2, target->count_get(target));
+	STRCMP_EQUAL("rep16", target->Name(target, 0));
+	LONGS_EQUAL(2, target->Length(target, 0));
+	STRCMP_EQUAL("sta2104", target->Name(target, 1));
+
+	/* the signatures are added, and compiled again */
+	static const uint8 code[] = { 0xc2, 0x30, 0x8d, 0x04, 0x21, 0xe2, 0x20 };
+	Load(0x0100, code, sizeof(code));
+	LONGS_EQUAL(2, target->Scan(target, view, &matches));
+	CHECK(target->Add(target, "sep", "e2 20"));
+	free(matches);
+	count = target->Scan(target, view, &matches);
+	LONGS_EQUAL(3, count);
+	LONGS_EQUAL(0x0105, matches[2].pcadr);
+
+	f = fopen(TestSigs, "wb");
+	fputs("ok a9 00\nbroken a9 0\n", f);
+	fclose(f);
+	CHECK_FALSE(target->Load(target, TestSigs));
+	STRCMP_EQUAL(TestSigs "(2) : broken : broken pattern", target->error_get(target));
+	CHECK_FALSE(target->Load(target, "testdata/file/none.txt"));
+}
@@ -0,0 +1,291 @@
+/**
+ * SinkTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "common/ReadWrite.h"
+#include "file/File.h"
+#include "file/TextFile.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/Opcode.h"
+#include "sdachi/Sink.h"
+}
+
+#define TestRoot "testdata/file/"
+#define WriteFile "wsink.txt"
+
+#include "CppUTest/TestHarness.h"
+
+TEST_GROUP(Sink)
+{
+	/* test target */
+	TextFile* out;
+	TextFile* reader;
+	Sink* target;
+	Instruction ins;
+	GroupInfo grp;
+
+	void setup()
+	{
+		out = new_TextFile(TestRoot WriteFile);
+		reader = new_TextFile(TestRoot WriteFile);
+		target = NULL;
+		remove(TestRoot WriteFile);
+
+		/* lda.w #$1234 */
+		ins.snesadr = 0x008005;
+		ins.pcadr = 0x000005;
+		ins.op = 0xa9;
+		ins.arg[0] = 0x34;
+		ins.arg[1] = 0x12;
+		ins.arg[2] = 0x00;
+		ins.arglen = 2;
+		ins.psw = 0x10;
+		ins.numeric = false;
+
+		grp.snesadr = 0x008000;
+		grp.callFrom = 0x00fffc;
+		grp.depth = 0;
+		grp.psw = 0x30;
+		grp.hits = GroupInfo_NotTraced;
+		grp.hitsMax = 0;
+	}
+
+	void teardown()
+	{
+		delete_Sink(&target);
+		delete_TextFile(&out);
+		delete_TextFile(&reader);
+		remove(TestRoot WriteFile);
+	}
+
+	const char* Run(Sink* s)
+	{
+		target = s;
+		target->Group(target, &grp);
+		target->Insn(target, &ins);
+		CHECK(target->End(target));
+		out->super.Close(&out->super);
+
+		LONGS_EQUAL(FileOpen_NoError, reader->Open(reader));
+		return reader->GetLine(reader);
+	}
+};
+
+/**
+ * Check asm listing
+ */
+TEST(Sink, Asm)
+{
+	const char* line;
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	line = Run(new_AsmSink(out, false));
+
+	/* group info */
+	STRCMP_EQUAL("", line);
+	STRCMP_EQUAL(";-----------------------------", reader->GetLine(reader));
+	STRCMP_EQUAL(";   call depth   : 0", reader->GetLine(reader));
+	STRCMP_EQUAL(";   call from    : $00fffc", reader->GetLine(reader));
+	STRCMP_EQUAL(";   A register   : 8 bit", reader->GetLine(reader));
+	STRCMP_EQUAL(";   X/Y register : 8 bit", reader->GetLine(reader));
+	STRCMP_EQUAL(";-----------------------------", reader->GetLine(reader));
+
+	/* instruction */
+	STRCMP_EQUAL("L008005:\tlda.w #$1234       ; a9 34 12", reader->GetLine(reader));
+	POINTERS_EQUAL(NULL, reader->GetLine(reader));
+}
+
+/**
+ * Check the hit counts of the trace log
+ */
+TEST(Sink, AsmHits)
+{
+	const char* line;
+	int i;
+
+	grp.hits = 3;
+	grp.hitsMax = 1200;
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	line = Run(new_AsmSink(out, false));
+
+	STRCMP_EQUAL("", line);
+	for(i=0; i<5; i++) reader->GetLine(reader);
+	STRCMP_EQUAL(";   hit count    : 3 (max 1200)", reader->GetLine(reader));
+	STRCMP_EQUAL(";-----------------------------", reader->GetLine(reader));
+}
+
+/**
+ * Check upper case asm listing
+ */
+TEST(Sink, AsmUpper)
+{
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	target = new_AsmSink(out, true);
+	target->Insn(target, &ins);
+	CHECK(target->End(target));
+	out->super.Close(&out->super);
+
+	LONGS_EQUAL(FileOpen_NoError, reader->Open(reader));
+	STRCMP_EQUAL("L008005:\tLDA.W #$1234       ; A9 34 12", reader->GetLine(reader));
+}
+
+/**
+ * Check asm org / data lines
+ */
+TEST(Sink, AsmData)
+{
+	uint8 data[400];
+	const char* line;
+	size_t i;
+
+	for(i=0; i<sizeof(data); i++) data[i] = (uint8)i;
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	target = new_AsmSink(out, false);
+	target->Org(target, 0x018000);
+	target->Data(target, 0x018000, 0x008000, data, 3);
+	target->Data(target, 0x018003, 0x008003, data, sizeof(data));
+	CHECK(target->End(target));
+	out->super.Close(&out->super);
+
+	LONGS_EQUAL(FileOpen_NoError, reader->Open(reader));
+	STRCMP_EQUAL("", reader->GetLine(reader));
+	STRCMP_EQUAL("\torg\t$018000", reader->GetLine(reader));
+	STRCMP_EQUAL("\t.db\t$00, $01, $02", reader->GetLine(reader));
+
+	/* long line is written over the buffer */
+	line = reader->GetLine(reader);
+	CHECK(NULL != line);
+	LONGS_EQUAL(5 + 5*sizeof(data) - 2, strlen(line));
+	LONGS_EQUAL(0, strncmp("$8f, $90", &line[5 + 5*0x8f], 8));
+	POINTERS_EQUAL(NULL, reader->GetLine(reader));
+}
+
+/**
+ * Check JSON Lines output
+ */
+TEST(Sink, Json)
+{
+	const char* line;
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	line = Run(new_JsonSink(out));
+
+	STRCMP_EQUAL("{\"type\":\"group\",\"snes\":32768,\"from\":65532,\"depth\":0,\"m\":8,\"x\":8}", line);
+	STRCMP_EQUAL("{\"type\":\"insn\",\"snes\":32773,\"pc\":5,\"bytes\":\"a93412\",\"mnemonic\":\"lda\",\"operand\":\"#$1234\",\"text\":\"lda.w #$1234\",\"m\":16,\"x\":8}", reader->GetLine(reader));
+	POINTERS_EQUAL(NULL, reader->GetLine(reader));
+}
+
+/**
+ * Check the hit counts in JSON Lines
+ */
+TEST(Sink, JsonHits)
+{
+	grp.hits = 0;
+	grp.hitsMax = 7;
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	STRCMP_EQUAL("{\"type\":\"group\",\"snes\":32768,\"from\":65532,\"depth\":0,\"m\":8,\"x\":8,\"hits\":0,\"hitsMax\":7}",
+			Run(new_JsonSink(out)));
+}
+
+/**
+ * Check CSV output
+ */
+TEST(Sink, Csv)
+{
+	const char* line;
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "w"));
+	line = Run(new_CsvSink(out));
+
+	STRCMP_EQUAL("type,snes,pc,bytes,text,m,x,target,depth,from", line);
+	STRCMP_EQUAL("group,008000,,,,8,8,,0,00fffc", reader->GetLine(reader));
+	STRCMP_EQUAL("insn,008005,000005,a93412,\"lda.w #$1234\",16,8,,,", reader->GetLine(reader));
+	POINTERS_EQUAL(NULL, reader->GetLine(reader));
+}
+
+/**
+ * Check binary record output
+ */
+TEST(Sink, Bin)
+{
+	FILE* fp;
+	uint8 buf[BinSink_RecordSize*4];
+	size_t len;
+	static const uint8 data[6] = { 1, 2, 3, 4, 5, 6 };
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "wb"));
+	target = new_BinSink(out);
+	target->Insn(target, &ins);
+	target->Data(target, 0x008100, 0x000100, data, sizeof(data));
+	CHECK(target->End(target));
+	out->super.Close(&out->super);
+
+	fp = fopen(TestRoot WriteFile, "rb");
+	CHECK(NULL != fp);
+	len = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+
+	/* header + insn + data * 2 */
+	LONGS_EQUAL(BinSink_RecordSize*4, len);
+	MEMCMP_EQUAL(BinSink_Magic, buf, 8);
+	LONGS_EQUAL(BinSink_Version, read16(&buf[8]));
+	LONGS_EQUAL(BinSink_RecordSize, read16(&buf[10]));
+
+	/* insn */
+	LONGS_EQUAL(BinRecord_Insn, buf[16]);
+	LONGS_EQUAL(3, buf[17]);
+	LONGS_EQUAL(0x10, buf[18]);
+	LONGS_EQUAL(0x008005, read32(&buf[20]));
+	LONGS_EQUAL(0x000005, read32(&buf[24]));
+	LONGS_EQUAL(0xa9, buf[28]);
+	LONGS_EQUAL(0x1234, read16(&buf[29]));
+
+	/* data is split into 4 bytes records */
+	LONGS_EQUAL(BinRecord_Data, buf[32]);
+	LONGS_EQUAL(4, buf[33]);
+	LONGS_EQUAL(0x008100, read32(&buf[36]));
+	LONGS_EQUAL(BinRecord_Data, buf[48]);
+	LONGS_EQUAL(2, buf[49]);
+	LONGS_EQUAL(0x008104, read32(&buf[52]));
+	LONGS_EQUAL(5, buf[60]);
+	LONGS_EQUAL(6, buf[61]);
+}
+
+/**
+ * Check binary label records
+ */
+TEST(Sink, BinLabel)
+{
+	FILE* fp;
+	uint8 buf[BinSink_RecordSize*4];
+	size_t len;
+
+	LONGS_EQUAL(FileOpen_NoError, out->Open2(out, "wb"));
+	target = new_BinSink(out);
+	target->Label(target, 0x008000, "Decompress");
+	CHECK(target->End(target));
+	out->super.Close(&out->super);
+
+	fp = fopen(TestRoot WriteFile, "rb");
+	CHECK(NULL != fp);
+	len = fread(buf, 1, sizeof(buf), fp);
+	fclose(fp);
+
+	/* header + label * 3 */
+	LONGS_EQUAL(BinSink_RecordSize*4, len);
+	LONGS_EQUAL(BinRecord_Label, buf[16]);
+	LONGS_EQUAL(4, buf[17]);
+	LONGS_EQUAL(0x008000, read32(&buf[20]));
+	LONGS_EQUAL(0, read32(&buf[24]));
+	MEMCMP_EQUAL("Deco", &buf[28], 4);
+	LONGS_EQUAL(BinRecord_Label, buf[48]);
+	LONGS_EQUAL(2, buf[49]);
+	LONGS_EQUAL(0x008000, read32(&buf[52]));
+	LONGS_EQUAL(8, read32(&buf[56]));
+	MEMCMP_EQUAL("ss", &buf[60], 2);
+}
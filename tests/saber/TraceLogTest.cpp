@@ -0,0 +1,189 @@
+/**
+ * TraceLogTest.cpp
+ */
+#include <assert.h>
+extern "C"
+{
+#include "common/types.h"
+#include "file/File.h"
+#include "file/RomFile.h"
+#include "file/RomView.h"
+#include "sdachi/TraceLog.h"
+}
+
+#include "CppUTest/TestHarness.h"
+#include "tests/TestFixture.h"
+
+#define TestRom "testdata/file/tracelog.sfc"
+#define TestLog "testdata/file/tracelog.log"
+
+TEST_GROUP(TraceLog)
+{
+	/* test target */
+	TraceLog* target;
+	RomFile* rom;
+	RomView* view;
+
+	void setup()
+	{
+		uint8* data;
+
+		data = Fixture_NewRom(0x10000, true);
+		Fixture_SaveRom(TestRom, data, 0x10000);
+
+		rom = new_RomFile(TestRom);
+		rom->Open(rom);
+		view = new_RomView(rom);
+		target = new_TraceLog(view);
+	}
+
+	void teardown()
+	{
+		delete_TraceLog(&target);
+		delete_RomView(&view);
+		delete_RomFile(&rom);
+		remove(TestRom);
+		remove(TestLog);
+	}
+
+	void Write(const char* text)
+	{
+		FILE* f;
+
+		f = fopen(TestLog, "wb");
+		fputs(text, f);
+		fclose(f);
+	}
+};
+
+/**
+ * Check object create / delete
+ */
+TEST(TraceLog, new)
+{
+	LONGS_EQUAL(0, target->count_get(target));
+	POINTERS_EQUAL(NULL, target->Hit(target, 0));
+	LONGS_EQUAL(0, target->Hits(target, 0));
+	CHECK(0 < target->bytes_get(target));
+
+	delete_TraceLog(&target);
+	POINTERS_EQUAL(NULL, target);
+}
+
+/**
+ * Check the formats of the emulators
+ */
+TEST(TraceLog, Formats)
+{
+	const TraceHit* h;
+
+	Write(
+		/* bsnes */
+		"008000 sei                    A:0000 X:0000 Y:0000 S:01ff D:0000 B:00 nvMXdIzc\n"
+		/* Mesen */
+		"00:8001 C2 30    rep #$30     A:0000 X:0000 Y:0000 S:01FF D:0000 DB:00 P:nvMXdIzc\r\n"
+		/* snes9x */
+		"$00/8003 A9 00 00 LDA #$0000  A:0000 X:0000 Y:0000 D:0000 DB:00 S:01FF P:envmxdIzc\n"
+		/* hex flags, the mirror */
+		"808003 lda #$0000 P:04\n"
+		"\n"
+		/* the code in RAM, the line without the flags, and the other line */
+		"7e0000 nop nvMXdIzc\n"
+		"008006 nop A:0000\n"
+		"--- frame 1 ---\n"
+		"  00/8003 lda nv..dizc"
+	);
+	CHECK(target->Load(target, TestLog, 1));
+
+	LONGS_EQUAL(8, target->lines_get(target));
+	LONGS_EQUAL(3, target->skipped_get(target));
+	LONGS_EQUAL(3, target->count_get(target));
+
+	h = target->Hit(target, 0);
+	LONGS_EQUAL(0x0000, h->pcadr);
+	LONGS_EQUAL(0x008000, h->snesadr);
+	LONGS_EQUAL(0x30, h->psw);
+	LONGS_EQUAL(1, h->count);
+
+	h = target->Hit(target, 1);
+	LONGS_EQUAL(0x0001, h->pcadr);
+	LONGS_EQUAL(0x30, h->psw);
+
+	/* the mirrors are merged */
+	h = target->Hit(target, 2);
+	LONGS_EQUAL(0x0003, h->pcadr);
+	LONGS_EQUAL(0x008003, h->snesadr);
+	LONGS_EQUAL(0x00, h->psw);
+	LONGS_EQUAL(3, h->count);
+	LONGS_EQUAL(3, target->Hits(target, 0x0003));
+	LONGS_EQUAL(0, target->Hits(target, 0x0002));
+}
+
+/**
+ * Check the counts of the flags, and the load of the other log
+ */
+TEST(TraceLog, Counts)
+{
+	uint32 hash;
+
+	Write(
+		"008010 lda P:30\n"
+		"008010 lda P:20\n"
+		"008010 lda P:20\n"
+	);
+	CHECK(target->Load(target, TestLog, 0));
+	LONGS_EQUAL(2, target->count_get(target));
+	LONGS_EQUAL(0x20, target->Hit(target, 0)->psw);
+	LONGS_EQUAL(2, target->Hit(target, 0)->count);
+	LONGS_EQUAL(0x30, target->Hit(target, 1)->psw);
+	LONGS_EQUAL(3, target->Hits(target, 0x0010));
+
+	/* the counts aren't hashed */
+	hash = target->Hash(target);
+	CHECK(target->Load(target, TestLog, 0));
+	LONGS_EQUAL(2, target->count_get(target));
+	LONGS_EQUAL(6, target->Hits(target, 0x0010));
+	LONGS_EQUAL(hash, target->Hash(target));
+
+	Write("008011 inc P:30\n");
+	CHECK(target->Load(target, TestLog, 0));
+	CHECK(hash != target->Hash(target));
+
+	CHECK_FALSE(target->Load(target, "testdata/file/none.log", 0));
+}
+
+/**
+ * Check the log parsed on the threads
+ */
+TEST(TraceLog, Threads)
+{
+	TraceLog* single;
+	FILE* f;
+	uint32 i;
+
+	/* about 4MB */
+	f = fopen(TestLog, "wb");
+	for(i=0; i<100000; i++)
+	{
+		fprintf(f, "00%04x %-24s A:0000 X:0000 Y:0000 S:01ff D:0000 DB:00 P:%02x\n",
+				(unsigned)(0x8000 + (i % 1000)), "lda #$00", (0 == (i % 3)) ? 0x30 : 0x10);
+	}
+	fclose(f);
+
+	single = new_TraceLog(view);
+	CHECK(single->Load(single, TestLog, 1));
+	CHECK(target->Load(target, TestLog, 4));
+
+	LONGS_EQUAL(100000, target->lines_get(target));
+	LONGS_EQUAL(0, target->skipped_get(target));
+	LONGS_EQUAL(2000, target->count_get(target));
+	LONGS_EQUAL(single->count_get(single), target->count_get(target));
+	LONGS_EQUAL(single->Hash(single), target->Hash(target));
+	for(i=0; i<1000; i++)
+	{
+		LONGS_EQUAL(100, target->Hits(target, i));
+	}
+	LONGS_EQUAL(34, target->Hit(target, 1)->count);
+
+	delete_TraceLog(&single);
+}